@@ -1,3 +0,0 @@
-~/Downloads/VulkanSDK/1.3.290.0/x86_64/bin/glslc ./shaders/src/shader.vert -o ./shaders/build/vert.spv
-~/Downloads/VulkanSDK/1.3.290.0/x86_64/bin/glslc ./shaders/src/shader.frag -o ./shaders/build/frag.spv
-~/Downloads/VulkanSDK/1.3.290.0/x86_64/bin/glslc ./shaders/src/shader.comp -o ./shaders/build/comp.spv
\ No newline at end of file
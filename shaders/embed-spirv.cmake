@@ -0,0 +1,31 @@
+# Writes a SPIR-V module to a header as a constexpr array of its words
+#
+# Usage: cmake -DSPIRV_FILE=<module> -DHEADER_FILE=<header> -DARRAY_NAME=<name> -DSOURCE_NAME=<source> -P embed-spirv.cmake
+
+file(READ ${SPIRV_FILE} SPIRV_HEX HEX)
+string(LENGTH "${SPIRV_HEX}" HEX_LENGTH)
+math(EXPR WORD_REMAINDER "${HEX_LENGTH} % 8")
+if (HEX_LENGTH LESS 40 OR NOT WORD_REMAINDER EQUAL 0)
+    message(FATAL_ERROR "${SPIRV_FILE} is not a SPIR-V module, it is not a whole number of words")
+endif()
+
+# SPIR-V is stored little endian, so the magic number 0x07230203 reads as 03022307
+string(SUBSTRING "${SPIRV_HEX}" 0 8 SPIRV_MAGIC)
+if (NOT SPIRV_MAGIC STREQUAL "03022307")
+    message(FATAL_ERROR "${SPIRV_FILE} is not a SPIR-V module, its magic number is ${SPIRV_MAGIC}")
+endif()
+
+# Reverse the bytes of each word into a literal, eight words to a line
+string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1U, " SPIRV_WORDS "${SPIRV_HEX}")
+string(REGEX REPLACE "((0x........U, )(0x........U, )(0x........U, )(0x........U, )(0x........U, )(0x........U, )(0x........U, )(0x........U, ))" "\\1\n    " SPIRV_WORDS "${SPIRV_WORDS}")
+string(REPLACE ", \n" ",\n" SPIRV_WORDS "${SPIRV_WORDS}")
+string(REGEX REPLACE "[ \n]+$" "" SPIRV_WORDS "${SPIRV_WORDS}")
+
+file(WRITE ${HEADER_FILE} "#pragma once
+#include <cstdint>
+
+// Generated from ${SOURCE_NAME} by shaders/embed-spirv.cmake
+inline constexpr uint32_t ${ARRAY_NAME}[] = {
+    ${SPIRV_WORDS}
+};
+")
@@ -0,0 +1,108 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Must match maxLightCount in app-config.h
+#define MAX_LIGHTS 4
+
+// Set per material from the pipeline permutation it is drawn with, the branches on them are removed when it is
+// compiled. Materials without a normal map are lit by their vertex normals alone and never sample the normal texture,
+// and textures that are not streamed into a clamped lod range are sampled at the level the hardware picks
+layout(constant_id = 0) const uint LIGHT_COUNT = 1u;
+layout(constant_id = 1) const bool NORMAL_MAPPING = true;
+layout(constant_id = 2) const bool LOD_CLAMP = true;
+
+// Must match VSUniformBuffer in app-config.h
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 world;
+    mat4 view;
+    mat4 proj;
+    vec4 lightDirections[MAX_LIGHTS];
+} ubo;
+
+// Every texture array, indexed by the slots stored in materials
+layout(set = 1, binding = 0) uniform sampler2DArray textures[];
+
+// Must match BindlessMaterial in app-config.h
+struct Material {
+    uint albedoTexture;
+    uint albedoLayer;
+    uint normalTexture;
+    uint normalLayer;
+    float albedoMinLod;
+    float normalMinLod;
+    float albedoBaseLevel;
+    float normalBaseLevel;
+    uint albedoFeedbackId;
+    uint normalFeedbackId;
+};
+
+layout(std430, set = 1, binding = 1) readonly buffer Materials {
+    Material materials[];
+};
+
+#ifdef TEXTURE_FEEDBACK
+// Compiled to frag-bindless-feedback.spv with -DTEXTURE_FEEDBACK, the finest level each texture was sampled at this frame
+layout(std430, set = 2, binding = 0) buffer Feedback {
+    uint requestedLevels[];
+};
+
+// Feedback is only written by one pixel of every 8x8 tile, which is enough to find the levels in use
+void writeFeedback(uint feedbackId, float lod, float baseLevel) {
+    if (feedbackId == 0xFFFFFFFFu || any(notEqual(uvec2(gl_FragCoord.xy) & 7u, uvec2(0u)))) return;
+    atomicMin(requestedLevels[feedbackId], uint(max(lod + baseLevel, 0.f)));
+}
+#endif
+
+layout(push_constant) uniform PushConstants {
+    int albedoIndex;
+    int normalIndex;
+    uint materialIndex;
+    float albedoMinLod;
+    float normalMinLod;
+} pc;
+
+
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in mat4 tnbMatrix;
+layout(location = 6) in float outVertexLightValue;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    Material material = materials[pc.materialIndex];
+
+    // Levels finer than the min lod have not been streamed in yet, so the lod the sampler would pick is clamped to them
+    float albedoQueryLod = textureQueryLod(textures[nonuniformEXT(material.albedoTexture)], texCoord).y;
+    float albedoLod = LOD_CLAMP ? max(albedoQueryLod, material.albedoMinLod) : albedoQueryLod;
+
+#ifdef TEXTURE_FEEDBACK
+    // The query is relative to the image, which starts at the texture's base level when only resident levels are kept
+    writeFeedback(material.albedoFeedbackId, albedoQueryLod, material.albedoBaseLevel);
+#endif
+
+    // The slots are uniform within a draw today, nonuniformEXT keeps sampling correct once draws of different materials are batched
+    vec3 albedo = textureLod(textures[nonuniformEXT(material.albedoTexture)], vec3(texCoord, material.albedoLayer), albedoLod).xyz;
+
+    float lightStrength = outVertexLightValue;
+    if (NORMAL_MAPPING) {
+        float normalQueryLod = textureQueryLod(textures[nonuniformEXT(material.normalTexture)], texCoord).y;
+        float normalLod = LOD_CLAMP ? max(normalQueryLod, material.normalMinLod) : normalQueryLod;
+
+#ifdef TEXTURE_FEEDBACK
+        writeFeedback(material.normalFeedbackId, normalQueryLod, material.normalBaseLevel);
+#endif
+
+        vec2 normalXY = textureLod(textures[nonuniformEXT(material.normalTexture)], vec3(texCoord, material.normalLayer), normalLod).xy * 2.f - 1.f;
+        float normalZ = sqrt(max(1.f - dot(normalXY, normalXY), 0.f));
+        vec4 sampledNormal = vec4(normalXY, normalZ, 0.f);
+        vec4 objectSpaceNormal = tnbMatrix * sampledNormal;
+
+        float pixelLightValue = 0.f;
+        for (uint light = 0u ; light < LIGHT_COUNT ; light++) {
+            pixelLightValue += dot(-ubo.lightDirections[light], objectSpaceNormal);
+        }
+        float vertexNormalInfluence = 0.3f;
+        lightStrength = pixelLightValue * (1.f - vertexNormalInfluence) + (outVertexLightValue * vertexNormalInfluence);
+    }
+    outColor = vec4(lightStrength * albedo, 1.f);
+}
\ No newline at end of file
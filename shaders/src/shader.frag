@@ -1,14 +1,35 @@
 #version 450
 
+// Must match maxLightCount in app-config.h
+#define MAX_LIGHTS 4
+
+// Set per material from the pipeline permutation it is drawn with, the branches on them are removed when it is
+// compiled. Materials without a normal map are lit by their vertex normals alone and never sample the normal texture,
+// and textures that are not streamed into a clamped lod range are sampled at the level the hardware picks
+layout(constant_id = 0) const uint LIGHT_COUNT = 1u;
+layout(constant_id = 1) const bool NORMAL_MAPPING = true;
+layout(constant_id = 2) const bool LOD_CLAMP = true;
+
+// Must match VSUniformBuffer in app-config.h
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 world;
+    mat4 view;
+    mat4 proj;
+    vec4 lightDirections[MAX_LIGHTS];
+} ubo;
+
 layout(binding = 1) uniform sampler2DArray albedoSampler;
 layout(binding = 2) uniform sampler2DArray normalSampler;
 
 layout(push_constant) uniform PushConstants {
-    int textureIndex;
+    int albedoIndex;
+    int normalIndex;
+    uint materialIndex;
+    float albedoMinLod;
+    float normalMinLod;
 } pc;
 
 
-layout(location = 0) in vec4 lightDir;
 layout(location = 1) in vec2 texCoord;
 layout(location = 2) in mat4 tnbMatrix;
 layout(location = 6) in float outVertexLightValue;
@@ -16,9 +37,28 @@ layout(location = 6) in float outVertexLightValue;
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    vec4 sampledNormal = vec4(texture(normalSampler, vec3(texCoord, pc.textureIndex)).xyz, 0.f);
-    vec4 objectSpaceNormal = tnbMatrix * sampledNormal;
-    float vertexNormalInfluence = 0.3f;
-    float lightStrength = dot(-lightDir, objectSpaceNormal) * (1.f - vertexNormalInfluence) + (outVertexLightValue * vertexNormalInfluence);
-    outColor = vec4(lightStrength * texture(albedoSampler, vec3(texCoord, pc.textureIndex)).xyz, 1.f);
+    // Levels finer than the min lod have not been streamed in yet, so the lod the sampler would pick is clamped to them
+    float albedoLod = textureQueryLod(albedoSampler, texCoord).y;
+    if (LOD_CLAMP) albedoLod = max(albedoLod, pc.albedoMinLod);
+    vec3 albedo = textureLod(albedoSampler, vec3(texCoord, pc.albedoIndex), albedoLod).xyz;
+
+    float lightStrength = outVertexLightValue;
+    if (NORMAL_MAPPING) {
+        float normalLod = textureQueryLod(normalSampler, texCoord).y;
+        if (LOD_CLAMP) normalLod = max(normalLod, pc.normalMinLod);
+
+        // Normal maps are BC5 compressed and only store x and y, z is reconstructed from the unit length of the normal
+        vec2 normalXY = textureLod(normalSampler, vec3(texCoord, pc.normalIndex), normalLod).xy * 2.f - 1.f;
+        float normalZ = sqrt(max(1.f - dot(normalXY, normalXY), 0.f));
+        vec4 sampledNormal = vec4(normalXY, normalZ, 0.f);
+        vec4 objectSpaceNormal = tnbMatrix * sampledNormal;
+
+        float pixelLightValue = 0.f;
+        for (uint light = 0u ; light < LIGHT_COUNT ; light++) {
+            pixelLightValue += dot(-ubo.lightDirections[light], objectSpaceNormal);
+        }
+        float vertexNormalInfluence = 0.3f;
+        lightStrength = pixelLightValue * (1.f - vertexNormalInfluence) + (outVertexLightValue * vertexNormalInfluence);
+    }
+    outColor = vec4(lightStrength * albedo, 1.f);
 }
\ No newline at end of file
@@ -1,33 +1,41 @@
 #version 450
 
+// Must match maxLightCount in app-config.h
+#define MAX_LIGHTS 4
+
+// The number of lights the pipeline is specialized for, the loop over them is unrolled when it is compiled
+layout(constant_id = 0) const uint LIGHT_COUNT = 1u;
+
+// Must match VSUniformBuffer in app-config.h
 layout(binding = 0) uniform UniformBufferObject {
     mat4 world;
     mat4 view;
     mat4 proj;
+    vec4 lightDirections[MAX_LIGHTS];
 } ubo;
 
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec3 inTangent;
+layout(location = 2) in vec4 inTangent;
 layout(location = 3) in vec2 inTexCoord;
-layout(location = 0) out vec4 outLightDir;
 layout(location = 1) out vec2 outTexCoord;
 layout(location = 2) out mat4 outTNBMatrix;
 layout(location = 6) out float outVertexLightValue;
 
 
 void main() {
-    vec3 lightDir = {-2.f, -3.f, 1.f};
-    lightDir = normalize(lightDir);
-
-    float vertexLightValue = dot(-lightDir, inNormal);
+    float vertexLightValue = 0.f;
+    for (uint light = 0u ; light < LIGHT_COUNT ; light++) {
+        vertexLightValue += dot(-ubo.lightDirections[light].xyz, inNormal);
+    }
     outVertexLightValue = vertexLightValue;
 
-    vec3 bitangent = normalize(cross(inTangent, inNormal));
+    // The tangent's w component flips the bitangent for mirrored UVs
+    vec3 bitangent = normalize(cross(inTangent.xyz, inNormal)) * inTangent.w;
 
     mat4 tnbMatrix = {
-        vec4(inTangent, 0.f),
+        vec4(inTangent.xyz, 0.f),
         vec4(inNormal, 0.f),
         vec4(bitangent, 0.f),
         vec4(0.f, 0.f, 0.f, 0.f)
@@ -39,6 +47,5 @@ void main() {
     vec4 inPositionModified = vec4(inPosition, 1.0);
     inPositionModified = ubo.proj * ubo.view * inPositionModified;
     gl_Position = inPositionModified;
-    outLightDir = vec4(lightDir, 0.f);
     outTexCoord = inTexCoord;
 }
\ No newline at end of file
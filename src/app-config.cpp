@@ -1,5 +1,6 @@
 #include "vulkan-app.h"
 #include "file-utilities.h"
+#include "file-loader.h"
 #include "resource-utilities.h"
 #include "filesystem"
 #include <iostream>
@@ -10,9 +11,35 @@
 #include "material-blueprint.h"
 #include "image/image.h"
 #include "image/image-loader.h"
-
-AppImageBundle albedo;
-AppImageBundle normal;
+#include "image/texture-compressor.h"
+#include "image/ktx2-file.h"
+#include "texture-array-pool.h"
+#include "mipmap-generator.h"
+#include "texture-upload-converter.h"
+#include "texture-registry.h"
+#include "bindless-texture-table.h"
+#include "texture-streamer.h"
+#include "texture-residency-manager.h"
+#include "asset-loader.h"
+#include "pipeline-variant-cache.h"
+#include "layout-cache.h"
+#include "descriptor-allocator.h"
+#include "command-buffer-allocator.h"
+#include "shader-reflection.h"
+#include "embedded-shaders.h"
+#include <cstddef>
+
+// Albedo textures are BC7 and normal maps BC5 compressed, each format has its own growable texture array. Devices
+// that cannot sample BC formats upload both uncompressed into the albedo array, which is then bound for both
+TextureArrayPool albedoPool;
+TextureArrayPool normalPool;
+bool compressedTextures = true;
+
+// Fills the mip chains of uncompressed textures, with a compute fallback for formats that cannot be blitted
+MipmapGenerator mipmapGenerator;
+
+// Expands uncompressed JPEG uploads to RGBA on the device, from packed RGB or from the JPEG's YCbCr planes
+TextureUploadConverter textureUploadConverter;
 
 AppSwapchain swapchain;
 AppImageBundle depthStencilImage;
@@ -20,9 +47,23 @@ AppPipelineLayout pipelineLayout;
 AppRenderPass renderPass;
 AppShaderModule vertexShaderModule;
 AppShaderModule fragmentShaderModule;
-AppPipeline graphicsPipeline;
+
+// Compiles each permutation of the graphics pipeline once, materials with and without a normal map draw with their own
+PipelineVariantCache pipelineVariants;
+AppPipeline normalMappedPipeline;
+AppPipeline vertexLitPipeline;
+
+// The directional lights of the scene, the graphics pipeline is specialized for their count
+const std::vector<glm::vec3> lightDirections = {glm::vec3(-2.f, -3.f, 1.f)};
 AppCommandPool commandPool;
 VkCommandBuffer commandBuffer;
+VkCommandBuffer defragmentCommandBuffer;
+VkCommandBuffer streamingCommandBuffer;
+
+// The frame's command buffer comes from the pool of the frame slot being recorded, which is reset as a whole once the
+// slot's previous frame has completed
+CommandBufferAllocator frameCommandBuffers;
+uint32_t frameSlot = 0U;
 
 AppBufferBundle stagingVertexBuffer;
 AppBufferBundle deviceVertexBuffer;
@@ -32,11 +73,114 @@ VIBufferManager viBufferManager;
 
 std::vector<AppBufferBundle> uniformBuffersVS;
 AppDescriptorSetLayout descriptorSetLayout;
-AppDescriptorPool descriptorPool;
-std::vector<VkDescriptorSet> descriptorSetsPerFrame;
+
+// The descriptor sets, push constants and vertex inputs of the graphics shaders, which the layouts are derived from
+ShaderReflection graphicsReflection;
+LayoutCache layoutCache;
+
+// Allocates the sets that live as long as the application, the material sets
+DescriptorAllocator persistentDescriptors;
+
+// Allocates the sets written for a single frame, one allocator per frame slot. A slot's sets are returned at once
+// when its previous frame has completed
+std::vector<DescriptorAllocator> frameDescriptors;
+
+// The frame's set is written from a FrameDescriptors through the template with one call, the texture arrays are only
+// written when textures are not bindless
+struct FrameDescriptors {
+    VkDescriptorBufferInfo uniformBuffer;
+    VkDescriptorImageInfo albedo;
+    VkDescriptorImageInfo normal;
+};
+AppDescriptorUpdateTemplate frameDescriptorTemplate;
 
 AppSampler sampler;
 
+// Deduplicates texture loads, each distinct texture occupies a single layer of the albedo or normal array
+TextureRegistry textureRegistry;
+
+// Streams the finer mip levels of textures after their mip tail has been uploaded
+TextureStreamer textureStreamer;
+
+// Holds every texture array and material when textures are bindless
+BindlessTextureTable bindlessTextureTable;
+bool bindlessTextures = false;
+
+// Gives each bindless texture its own image, holding only the levels shader feedback asks for
+TextureResidencyManager textureResidency;
+bool textureResidencyEnabled = false;
+
+// Reads asset files for the asset loader, which loads meshes and textures without blocking the main thread
+AsyncFileReader assetFileReader;
+AssetLoader assetLoader;
+
+// Each mesh that has finished loading, the textures it samples, and the bindless material that references them
+struct MeshTextures {
+    Mesh* mesh;
+    TextureHandle albedo;
+    TextureHandle normal;
+    uint32_t materialIndex = 0U;
+
+    // Meshes without a normal map reference their albedo texture in its place, which is never sampled
+    bool normalMapping = true;
+};
+std::vector<MeshTextures> meshTextures = {};
+
+uint32_t albedoTextureSlot = 0U;
+uint32_t normalTextureSlot = 0U;
+
+/**
+ * Writes the bindless material of a mesh, including the levels of its textures that are resident so far
+ */
+void writeBindlessMaterial(MeshTextures &mesh, bool isNewMaterial) {
+    BindlessMaterial material {
+        albedoTextureSlot, mesh.albedo.layer.layer,
+        normalTextureSlot, mesh.normal.layer.layer,
+        static_cast<float>(textureStreamer.getResidentLevel(mesh.albedo.layer)),
+        static_cast<float>(textureStreamer.getResidentLevel(mesh.normal.layer)),
+        0.f, 0.f,
+        TextureResidencyManager::noFeedback, TextureResidencyManager::noFeedback
+    };
+
+    // Managed textures are layer 0 of their own image, which starts at their resident level, and need no lod clamp
+    if (textureResidencyEnabled) {
+        uint32_t albedoId = mesh.albedo.layer.layer;
+        uint32_t normalId = mesh.normal.layer.layer;
+        material = BindlessMaterial {
+            textureResidency.getTextureSlot(albedoId), 0U,
+            textureResidency.getTextureSlot(normalId), 0U,
+            0.f, 0.f,
+            static_cast<float>(textureResidency.getResidentLevel(albedoId)),
+            static_cast<float>(textureResidency.getResidentLevel(normalId)),
+            albedoId, normalId
+        };
+    }
+    if (isNewMaterial) mesh.materialIndex = bindlessTextureTable.createMaterial(material);
+    else bindlessTextureTable.updateMaterial(mesh.materialIndex, &material);
+}
+
+/**
+ * Loads a model's textures and meshes, each mesh is drawn from the first frame after its upload has completed. Models
+ * without a normal map, whose normalPath is empty, are drawn lit by their vertex normals
+ */
+Task<void> loadModel(std::string meshPath, std::string albedoPath, std::string normalPath, LoadPriority priority)
+{
+    bool normalMapping = !normalPath.empty();
+    TextureCompression albedoCompression = compressedTextures ? TextureCompression::BC7 : TextureCompression::NONE;
+    TextureCompression normalCompression = compressedTextures ? TextureCompression::BC5 : TextureCompression::NONE;
+    TextureHandle albedo = co_await assetLoader.loadTexture(albedoPath, albedoCompression, priority);
+    TextureHandle normal = albedo;
+    if (normalMapping) normal = co_await assetLoader.loadTexture(normalPath, normalCompression, priority);
+
+    // Each mesh is added as its upload completes, on the main thread between frames
+    co_await assetLoader.importMesh(meshPath, priority, CancellationToken(), [albedo, normal, normalMapping](Mesh* mesh) {
+        meshTextures.push_back(MeshTextures {mesh, albedo, normal, 0U, normalMapping});
+
+        // Bindless draws only push the index of their material, which references the textures' slots and layers
+        if (bindlessTextures) writeBindlessMaterial(meshTextures.back(), true);
+    });
+}
+
 // Signal when an image is available
 AppSemaphore imageAvailableSemaphore;
 
@@ -87,140 +231,290 @@ void destroySwapchainAndResources(VulkanApp* app) {
 }
 
 void VulkanApp::userInit() {
+    // Startup runs as a graph of tasks on the job system once userInit returns, each task starts as soon as the tasks
+    // it depends on have finished. Tasks that record or submit commands run on the main thread, which owns the queues
+    StartupGraph::TaskId deviceTask = internalStartupTasks.logicalDevice;
+
+    // Packed builds ship their assets in an archive, development builds load the loose files
+    StartupGraph::TaskId archiveTask = startupGraph.addTask("mount archive", []() {
+        if (std::filesystem::exists(assetArchivePath)) FileLoader::mountArchive(assetArchivePath, assetArchiveRoot);
+    });
+
     // Create the depth stencil image, view and memory
-    depthStencilImage = createImageAll(this, this->viewportSettings.width, this->viewportSettings.height, AppImageTemplate::DEPTH_STENCIL);
-
-    renderPass.init(this,
-        // Attachments
-        { 
-            AttachmentTemplate::SWAPCHAIN_COLOR_ATTACHMENT,
-            AttachmentTemplate::SWAPCHAIN_DEPTH_STENCIL_ATTACHMENT
-        },
-        // Subpasses
-        {
-            // subpass 1
-            AppSubpass {
-                {
-                    // Color and depth stencil attachments at the 0th and 1st index, respectively
-                    // This must match the framebuffer views
-                    AppSubpassAttachmentRef{0U, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
-                    AppSubpassAttachmentRef{1U, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL}
+    StartupGraph::TaskId depthTask = startupGraph.addTask("depth image", [this]() {
+        depthStencilImage = createImageAll(this, this->viewportSettings.width, this->viewportSettings.height, AppImageTemplate::DEPTH_STENCIL);
+    }, {deviceTask});
+
+    StartupGraph::TaskId renderPassTask = startupGraph.addTask("render pass", [this]() {
+        renderPass.init(this,
+            // Attachments
+            { 
+                AttachmentTemplate::SWAPCHAIN_COLOR_ATTACHMENT,
+                AttachmentTemplate::SWAPCHAIN_DEPTH_STENCIL_ATTACHMENT
+            },
+            // Subpasses
+            {
+                // subpass 1
+                AppSubpass {
+                    {
+                        // Color and depth stencil attachments at the 0th and 1st index, respectively
+                        // This must match the framebuffer views
+                        AppSubpassAttachmentRef{0U, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+                        AppSubpassAttachmentRef{1U, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL}
+                    }
                 }
+            },
+            {
+                // subpass dependency
+                {VK_SUBPASS_EXTERNAL, 0U, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0U, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 0U}
             }
-        },
-        {
-            // subpass dependency
-            {VK_SUBPASS_EXTERNAL, 0U, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0U, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 0U}
-        }
-    );
-
-    createSwapchainAndResources(this);
-
-
-    // Create a command pool for graphics family command buffers
-    commandPool.init(this, this->queueFamilyIndices.graphics);
-
-    // Allocate a command buffer from the command pool
-    commandBuffer = commandPool.allocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-
-    // Create the vertex and index staging buffers
-    stagingVertexBuffer = createBufferAll(this, AppBufferTemplate::VERTEX_BUFFER_STAGING, sizeof(Vertex) * 200);
-    deviceVertexBuffer = createBufferAll(this, AppBufferTemplate::VERTEX_BUFFER_DEVICE, sizeof(Vertex) * supportedVertexCount);
-    stagingIndexBuffer = createBufferAll(this, AppBufferTemplate::INDEX_BUFFER_STAGING, sizeof(uint32_t) * 200);
-    deviceIndexBuffer = createBufferAll(this, AppBufferTemplate::INDEX_BUFFER_DEVICE, sizeof(uint32_t) * supportedIndexCount);
+        );
+    }, {deviceTask});
+
+    StartupGraph::TaskId swapchainTask = startupGraph.addTask("swapchain", [this]() {
+        createSwapchainAndResources(this);
+    }, {deviceTask, internalStartupTasks.surface, depthTask, renderPassTask});
+
+    StartupGraph::TaskId commandBufferTask = startupGraph.addTask("command buffers", [this]() {
+        // Create a command pool for graphics family command buffers
+        commandPool.init(this, this->queueFamilyIndices.graphics);
+
+        // Allocate a command buffer from the command pool for uploads recorded outside of the frame
+        commandBuffer = commandPool.allocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+        frameCommandBuffers.init(this, this->queueFamilyIndices.graphics, maxFramesInFlight);
+
+        // Allocate a separate command buffer for geometry defragmentation, its copies run alongside the frame's command buffer
+        defragmentCommandBuffer = commandPool.allocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+        // Allocate a command buffer for the uploads of streamed texture levels
+        streamingCommandBuffer = commandPool.allocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    }, {deviceTask}, StartupThread::MAIN);
+
+    StartupGraph::TaskId geometryBufferTask = startupGraph.addTask("geometry buffers", [this]() {
+        // Create the vertex and index staging buffers
+        stagingVertexBuffer = createBufferAll(this, AppBufferTemplate::VERTEX_BUFFER_STAGING, sizeof(Vertex) * 200);
+        deviceVertexBuffer = createBufferAll(this, AppBufferTemplate::VERTEX_BUFFER_DEVICE, sizeof(Vertex) * supportedVertexCount);
+        stagingIndexBuffer = createBufferAll(this, AppBufferTemplate::INDEX_BUFFER_STAGING, sizeof(uint32_t) * 200);
+        deviceIndexBuffer = createBufferAll(this, AppBufferTemplate::INDEX_BUFFER_DEVICE, sizeof(uint32_t) * supportedIndexCount);
+
+        // Initialize the staging buffer managers, the device buffers are grown automatically when geometry no longer fits
+        viBufferManager.init(this, deviceVertexBuffer, deviceIndexBuffer, stagingVertexBuffer, stagingIndexBuffer);
+    }, {deviceTask});
+
+    // Only the fragment shader variant matching the descriptor layouts is used
+    auto getFragmentSpirv = []() {
+        if (!bindlessTextures) return std::span<const uint32_t>(fragSpirv);
+        return textureResidencyEnabled ? std::span<const uint32_t>(fragBindlessFeedbackSpirv) : std::span<const uint32_t>(fragBindlessSpirv);
+    };
 
-    // Initialize the staging buffer managers
-    viBufferManager.init(deviceVertexBuffer, deviceIndexBuffer, stagingVertexBuffer, stagingIndexBuffer);
+    StartupGraph::TaskId layoutTask = startupGraph.addTask("descriptor layouts", [this, getFragmentSpirv]() {
+        // Bindless textures live in their own descriptor set, so the per-frame sets only hold the uniform buffer
+        bindlessTextures = useBindlessTextures && logicalDevice.supportsDescriptorIndexing();
+        if (bindlessTextures) bindlessTextureTable.init(this, maxBindlessTextures, maxBindlessMaterials, sizeof(BindlessMaterial));
+
+        // Managed textures own their images, so the texture arrays are only created when residency is not managed. Their
+        // levels are loaded from compressed caches, so uncompressed textures are never managed
+        compressedTextures = logicalDevice.supportsTextureCompressionBC();
+        textureResidencyEnabled = bindlessTextures && compressedTextures && useTextureResidency && logicalDevice.supportsFragmentStores();
+
+        // The per-frame descriptor set layout is set 0 of the shaders, the bindless and residency sets are owned by
+        // their managers
+        graphicsReflection = ShaderReflection::reflect(std::span<const uint32_t>(vertSpirv));
+        graphicsReflection.merge(ShaderReflection::reflect(getFragmentSpirv()));
+        graphicsReflection.checkVertexAttributes(Vertex::getAttributeDescriptions());
+
+        layoutCache.init(this);
+        descriptorSetLayout = layoutCache.getDescriptorSetLayout(graphicsReflection.getDescriptorItems(0U));
+
+        sampler.init(this, AppSamplerTemplate::DEFAULT);
+    }, {deviceTask});
+
+    // The texture arrays transition their layers with the frame's command buffer, so they are created on the main thread
+    StartupGraph::TaskId textureStorageTask = startupGraph.addTask("texture storage", [this]() {
+        if (textureResidencyEnabled) {
+            TextureResidencyBudget residencyBudget {};
+            residencyBudget.maxResidentBytes = textureResidencyBudgetBytes;
+            residencyBudget.maxConcurrentLoads = streamingConcurrentLoads;
+            residencyBudget.evictionDelayFrames = textureEvictionDelayFrames;
+            textureResidency.init(this, &bindlessTextureTable, sampler, bindlessTextureTable.getTextureCapacity(), residencyBudget);
+        }
+        else if (compressedTextures) {
+            // Create the albedo and normal texture arrays, they grow as textures are added
+            albedoPool.init(this, AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE_BC7, textureSize, textureSize, initialTextureArrayLayers, commandBuffer);
+            normalPool.init(this, AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE_BC5, textureSize, textureSize, initialTextureArrayLayers, commandBuffer);
+        }
+        else {
+            // Uncompressed textures are uploaded at their full size and their mip chains generated on the device
+            albedoPool.init(this, AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE, textureSize, textureSize, initialTextureArrayLayers, commandBuffer);
+            mipmapGenerator.init(this, std::span<const uint32_t>(downsampleSpirv));
+            textureUploadConverter.init(this, std::span<const uint32_t>(expandRGBSpirv), std::span<const uint32_t>(convertYCbCrSpirv));
+        }
 
-    // Create a descriptor pool capable of storing the uniform buffer for each frame in flight, the albedo and the normal
-    descriptorPool.init(this, swapchain.getImageCount(), {
-        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, swapchain.getImageCount()},
-        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2}
-    });
-    
-    // Create the descriptor set layout
-    descriptorSetLayout.init(this, {
-        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT},
-        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT},
-        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT}
-    });
+        // Each texture array takes one slot of the bindless table, which the pool rewrites whenever the array grows
+        if (bindlessTextures && !textureResidencyEnabled) {
+            albedoTextureSlot = bindlessTextureTable.allocateTextureSlot();
+            albedoPool.bindDescriptor(bindlessTextureTable.getDescriptorSet(), BindlessTextureTable::textureBinding, sampler, albedoTextureSlot);
+            normalTextureSlot = albedoTextureSlot;
+            if (compressedTextures) {
+                normalTextureSlot = bindlessTextureTable.allocateTextureSlot();
+                normalPool.bindDescriptor(bindlessTextureTable.getDescriptorSet(), BindlessTextureTable::textureBinding, sampler, normalTextureSlot);
+            }
+        }
+    }, {layoutTask, commandBufferTask}, StartupThread::MAIN);
 
-    sampler.init(this, AppSamplerTemplate::DEFAULT);
+    startupGraph.addTask("frame descriptors", [this]() {
+        // Each frame allocates and writes set 0 of the shaders, so a frame slot's pool holds exactly one of them. The
+        // texture arrays are written into it as they are when the frame is recorded, however often they have grown
+        frameDescriptors.resize(maxFramesInFlight);
+        for (DescriptorAllocator &descriptorAllocator : frameDescriptors) descriptorAllocator.init(this, 1U, graphicsReflection.getPoolSizes(0U, 1U));
 
-    // Create an app image bundle for the albedo and normal textures
-    albedo = createImageAll(this, 2048U, 2048U, AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE, 2U);
-    normal = createImageAll(this, 2048U, 2048U, AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE, 2U);
+        //                                                          {binding, array element, count, type, offset, stride}
+        std::vector<VkDescriptorUpdateTemplateEntry> templateEntries = {
+            VkDescriptorUpdateTemplateEntry {0U, 0U, 1U, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, offsetof(FrameDescriptors, uniformBuffer), sizeof(VkDescriptorBufferInfo)}
+        };
+        if (!bindlessTextures) {
+            templateEntries.push_back(VkDescriptorUpdateTemplateEntry {1U, 0U, 1U, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, offsetof(FrameDescriptors, albedo), sizeof(VkDescriptorImageInfo)});
+            templateEntries.push_back(VkDescriptorUpdateTemplateEntry {2U, 0U, 1U, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, offsetof(FrameDescriptors, normal), sizeof(VkDescriptorImageInfo)});
+        }
+        frameDescriptorTemplate.init(this, descriptorSetLayout, templateEntries);
 
-    for (uint32_t frame = 0u; frame < swapchain.getImageCount() ; frame++) {
-        // Create a uniform buffer for all frames in flight
-        uniformBuffersVS.push_back(createBufferAll(this, AppBufferTemplate::UNIFORM_BUFFER, sizeof(VSUniformBuffer)));
+        // A material set holds the combined image sampler of its texture array, see MaterialBlueprint
+        persistentDescriptors.init(this, 1U, {{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1U}});
 
-        // Allocate the descriptor sets for each frame
-        descriptorSetsPerFrame.push_back(descriptorPool.allocateDescriptorSet(&descriptorSetLayout));
+        for (uint32_t frame = 0u; frame < swapchain.getImageCount() ; frame++) {
+            // Create a uniform buffer for all frames in flight
+            uniformBuffersVS.push_back(createBufferAll(this, AppBufferTemplate::UNIFORM_BUFFER, sizeof(VSUniformBuffer)));
 
-        // Update all descriptors associated with the descriptor set for this frame
-        updateDescriptor(uniformBuffersVS[frame].buffer, descriptorSetsPerFrame[frame], sizeof(VSUniformBuffer), 0U, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-        updateDescriptor(albedo.imageView, descriptorSetsPerFrame[frame], 1U, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sampler);
-        updateDescriptor(normal.imageView, descriptorSetsPerFrame[frame], 2U, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sampler);
+            // Uniform buffer memory is persistently mapped when allocated
+            mappedUBOs.push_back(uniformBuffersVS[frame].deviceMemory.getMappedData());
+        }
+    }, {swapchainTask, layoutTask, textureStorageTask});
+
+    // Shader modules and the pipeline are created while the textures and meshes are decoded. The SPIR-V is compiled
+    // into the binary by the build
+    StartupGraph::TaskId shaderTask = startupGraph.addTask("shader modules", [this, getFragmentSpirv]() {
+        // Create the shader modules that will be used
+        vertexShaderModule.init(this, std::span<const uint32_t>(vertSpirv), VK_SHADER_STAGE_VERTEX_BIT);
+        fragmentShaderModule.init(this, getFragmentSpirv(), VK_SHADER_STAGE_FRAGMENT_BIT);
+    }, {deviceTask, layoutTask});
+
+    startupGraph.addTask("pipeline", [this]() {
+        // Set 0 holds the per-frame descriptors, set 1 the bindless textures and materials and set 2 the residency feedback
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts = {descriptorSetLayout.get()};
+        if (bindlessTextures) descriptorSetLayouts.push_back(bindlessTextureTable.getDescriptorSetLayout().get());
+        if (textureResidencyEnabled) descriptorSetLayouts.push_back(textureResidency.getFeedbackDescriptorSetLayout().get());
+
+        // Create the pipeline layout with the push constant range of the shaders, then the pipeline
+        if (graphicsReflection.getSetCount() != descriptorSetLayouts.size()) throw std::runtime_error("The graphics shaders use descriptor sets that were not created");
+        std::vector<VkPushConstantRange> pushConstantRanges = graphicsReflection.getPushConstantRanges();
+        if (pushConstantRanges.empty() || pushConstantRanges[0].stageFlags != VK_SHADER_STAGE_FRAGMENT_BIT || pushConstantRanges[0].size != sizeof(FragmentPushConst)) {
+            throw std::runtime_error("The graphics shaders' push constants do not match FragmentPushConst");
+        }
+        pipelineLayout = layoutCache.getPipelineLayout(descriptorSetLayouts, pushConstantRanges);
 
-        // Map the memory for the Uniform Buffer Objects
-        mappedUBOs.push_back({});
-        vkMapMemory(logicalDevice.get(), uniformBuffersVS[frame].deviceMemory.get(), 0u, sizeof(VSUniformBuffer), 0, &(mappedUBOs[frame]));
-    }
+        // Only the permutations the materials draw with are compiled, through the cache saved by the previous run. The
+        // light count is fixed for the scene and managed textures need no lod clamp
+        if (lightDirections.size() > maxLightCount) throw std::runtime_error("The scene has more lights than the graphics pipeline supports");
+        for (uint32_t light = 0U ; light < lightDirections.size() ; light++) {
+            uniformBuffer.lightDirections[light] = glm::vec4(glm::normalize(lightDirections[light]), 0.f);
+        }
+        pipelineVariants.init(this, pipelineCachePath);
+        for (bool normalMapping : {true, false}) {
+            ShaderSpecialization specialization;
+            specialization.set(lightCountConstantId, static_cast<uint32_t>(lightDirections.size()));
+            specialization.set(normalMappingConstantId, normalMapping);
+            specialization.set(lodClampConstantId, !textureResidencyEnabled);
+
+            AppPipeline pipeline = pipelineVariants.getGraphicsPipeline({vertexShaderModule, fragmentShaderModule}, pipelineLayout, renderPass, specialization);
+            if (normalMapping) normalMappedPipeline = pipeline;
+            else vertexLitPipeline = pipeline;
+        }
 
-    std::vector<char> vertexShaderByteCode = readFile("../shaders/build/vert.spv");
-    std::vector<char> fragmentShaderByteCode = readFile("../shaders/build/frag.spv");
-
-    // Create the shader modules that will be used
-    vertexShaderModule.init(this, vertexShaderByteCode, VK_SHADER_STAGE_VERTEX_BIT);
-    fragmentShaderModule.init(this, fragmentShaderByteCode, VK_SHADER_STAGE_FRAGMENT_BIT);
-
-    // Create the pipeline layout and pipeline
-    pipelineLayout.init(this,
-        // Specify descriptor sets
-        {
-            descriptorSetLayout.get()
-        }, 
-        // Specify push constant ranges
-        {
-            {
-                VK_SHADER_STAGE_FRAGMENT_BIT, // Accessible shader stage
-                0U, // Offset
-                sizeof(FragmentPushConst) // Size
-            }
+        // A cache that cannot be saved only costs the next run its compile time
+        try {
+            pipelineVariants.save();
         }
-    );
-    graphicsPipeline.init(this, 
-        {vertexShaderModule, fragmentShaderModule},
-        pipelineLayout,
-        renderPass
-    );
+        catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }, {shaderTask, renderPassTask, layoutTask, textureStorageTask});
 
     // Create some sync primitives that we'll use during rendering
-    renderingFinishedSemaphore.init(this);
-    imageAvailableSemaphore.init(this);
-    inFlightFence.init(this, VK_FENCE_CREATE_SIGNALED_BIT);
-
-    
-
-    geometryManager.importOBJ("../mesh/cube.obj", commandBuffer);
-    geometryManager.importOBJ("../mesh/cube1.obj", commandBuffer);
-
-      // Load the brick wall texture into layer 0 of the albedo and normal, respectively
-    loadImage(this, "../images/alley-brick-wall_albedo.jpg", albedo.image, commandBuffer, 0U);
-    loadImage(this, "../images/alley-brick-wall_normal-dx.jpg", normal.image, commandBuffer, 0U);
-
-    loadImage(this, "../images/new-brick-wall-albedo.jpeg", albedo.image, commandBuffer, 1U);
-    loadImage(this, "../images/new-brick-wall-normal.jpeg", normal.image, commandBuffer, 1U);
-
-    viBufferManager.addGeometry(geometryManager.getMesh(0), commandBuffer);
-    viBufferManager.addGeometry(geometryManager.getMesh(1), commandBuffer);
+    startupGraph.addTask("sync primitives", [this]() {
+        renderingFinishedSemaphore.init(this);
+        imageAvailableSemaphore.init(this);
+        inFlightFence.init(this, VK_FENCE_CREATE_SIGNALED_BIT);
+    }, {deviceTask});
+
+    StartupGraph::TaskId registryTask = startupGraph.addTask("texture registry", [this]() {
+        // Albedo textures are compressed to BC7 and normal maps to BC5, each into its own managed image or a free layer of
+        // its texture array. Uncompressed textures are decoded into a layer of the albedo array and their mip chain generated
+        textureRegistry.init(
+            [this](const KTX2Texture &texture, const std::vector<char> &sourceFile, TextureCompression compression) {
+                if (textureResidencyEnabled) {
+                    AppImageTemplate imageTemplate = compression == TextureCompression::BC7 ? AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE_BC7 : AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE_BC5;
+                    return TextureLayer {nullptr, textureResidency.addTexture(texture, imageTemplate, commandBuffer)};
+                }
 
-    Image brickWallAlbedo = ImageLoader::loadJPEGFromFile("../images/alley-brick-wall_albedo.jpg", 0U);
-    Image brickWallNormal = ImageLoader::loadJPEGFromFile("../images/alley-brick-wall_normal.jpg", 0U);
+                TextureArrayPool &pool = compression == TextureCompression::BC5 ? normalPool : albedoPool;
+                uint32_t layer = pool.allocateLayer(commandBuffer);
+                try {
+                    if (compression == TextureCompression::NONE) loadJPEGImage(this, sourceFile, pool.getTextureArray().image, commandBuffer, layer, &mipmapGenerator, &textureUploadConverter);
+                    else loadKTX2Image(this, texture, pool.getTextureArray().image, commandBuffer, layer);
+                }
+                catch (...) {
+                    pool.freeLayer(layer);
+                    throw;
+                }
+                return TextureLayer {&pool, layer};
+            },
+            [](TextureLayer layer, TextureCompression) {
+                if (layer.pool == nullptr) {
+                    textureResidency.removeTexture(layer.layer);
+                    return;
+                }
+                textureStreamer.removeTexture(layer);
+                layer.pool->freeLayer(layer.layer);
+            }
+        );
+
+        // Only the mip tails are loaded before the first frame, the remaining levels are streamed in by userTick, all of
+        // them or only those the feedback asks for when residency is managed
+        textureStreamer.init(this, TextureStreamingBudget {streamingConcurrentLoads, streamingUploadBytesPerFrame});
+        textureRegistry.enableStreaming(
+            [](TextureLayer layer, uint32_t residentLevel, TextureRegistry::LevelLoadFunction loadLevels) {
+                if (layer.pool == nullptr) {
+                    textureResidency.setLoader(layer.layer, loadLevels);
+                    return;
+                }
+                textureStreamer.addTexture(layer, residentLevel, [loadLevels]() { return loadLevels(0U); });
+            },
+            streamingMipTailSize
+        );
+    }, {textureStorageTask});
+
+    // Meshes and textures are loaded in the background, every frame draws the meshes whose loads have completed. Files
+    // are read on the reader's threads, decoded on the job system's workers and uploaded from userTick. The loads are
+    // spawned as early as possible, so their reads and decodes overlap the rest of startup
+    startupGraph.addTask("asset loads", [this]() {
+        assetFileReader.init();
+        assetLoader.init(this, &assetFileReader, &JobSystem::shared(), &textureRegistry, &viBufferManager, AssetLoaderConfig {assetLoaderConcurrentLoads});
+
+        // The registry decodes and uploads each distinct texture only once, however many models share it
+        assetLoader.spawn(loadModel("../mesh/cube.obj", "../images/alley-brick-wall_albedo.jpg", "../images/alley-brick-wall_normal-dx.jpg", LoadPriority::NORMAL));
+        assetLoader.spawn(loadModel("../mesh/cube1.obj", "../images/new-brick-wall-albedo.jpeg", "../images/new-brick-wall-normal.jpeg", LoadPriority::NORMAL));
+    }, {archiveTask, registryTask, geometryBufferTask, commandBufferTask}, StartupThread::MAIN);
+
+    // The material only needs the dimensions of its textures, the texels live on the device
+    Image brickWallAlbedo;
+    brickWallAlbedo.setWidth(textureSize);
+    brickWallAlbedo.setHeight(textureSize);
+    Image brickWallNormal;
+    brickWallNormal.setWidth(textureSize);
+    brickWallNormal.setHeight(textureSize);
 
     MaterialBlueprint pbrMaterialBlueprint;
-    //pbrMaterialBlueprint.init(graphicsPipeline.get());
+    //pbrMaterialBlueprint.init(normalMappedPipeline.get(), &persistentDescriptors);
 
     struct PBRMaterialInput : public MaterialInput {
         MaterialInputImage albedo {"Albedo"};
@@ -237,44 +531,90 @@ void VulkanApp::userInit() {
 
     Material matBrickWall = pbrMaterialBlueprint.createMaterial(&brickWall);
 
-    geometryManager.getMesh(0)->setMaterial(&matBrickWall);
+}
 
+/**
+ * Allocates set 0 of the frame from the frame slot's allocator and writes the frame's uniform buffer and the texture
+ * arrays into it
+ */
+VkDescriptorSet writeFrameDescriptors(uint32_t frame) {
+    VkDescriptorSet frameDescriptorSet = frameDescriptors[frameSlot].allocate(descriptorSetLayout);
+
+    FrameDescriptors descriptors {};
+    descriptors.uniformBuffer = VkDescriptorBufferInfo {uniformBuffersVS[frame].buffer.get(), 0U, sizeof(VSUniformBuffer)};
+    if (!bindlessTextures) {
+        TextureArrayPool &normalMaps = compressedTextures ? normalPool : albedoPool;
+        descriptors.albedo = VkDescriptorImageInfo {sampler.get(), albedoPool.getTextureArray().imageView.get(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        descriptors.normal = VkDescriptorImageInfo {sampler.get(), normalMaps.getTextureArray().imageView.get(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    }
+    frameDescriptorTemplate.update(frameDescriptorSet, &descriptors);
+
+    return frameDescriptorSet;
 }
 
 /**
  * Writes the command buffer to be submitted, using a multithreaded approach
  */
-void writeCommandBuffer(uint32_t frame, AppBase* appBase) {
+void writeCommandBuffer(uint32_t frame, VkDescriptorSet frameDescriptorSet, VkCommandBuffer frameCommandBuffer, AppBase* appBase) {
     ViewportSettings viewportSettings = appBase->viewportSettings;
 
     VkCommandBufferBeginInfo beginInfo {};
     beginInfo.pNext = nullptr;
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.pInheritanceInfo = nullptr;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.get());
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout.get(), 0U, 1U, &descriptorSetsPerFrame[frame], 0U, nullptr);
+    vkBeginCommandBuffer(frameCommandBuffer, &beginInfo);
 
-    VkDeviceSize vertexBufferOffsets = 0U;
-    vkCmdBindVertexBuffers(commandBuffer, 0U, 1U, deviceVertexBuffer.buffer.getRef(), &vertexBufferOffsets);
-    vkCmdBindIndexBuffer(commandBuffer, deviceIndexBuffer.buffer.get(), 0U, VK_INDEX_TYPE_UINT32);
+    // Every permutation of the graphics pipeline shares its layout, so the descriptor sets stay bound across them
+    vkCmdBindDescriptorSets(frameCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout.get(), 0U, 1U, &frameDescriptorSet, 0U, nullptr);
 
-    appBeginRenderPass(&renderPass, &framebuffers[frame], commandBuffer);
+    // The bindless set is shared by every frame and every draw, it is bound once and never rebound
+    if (bindlessTextures) {
+        VkDescriptorSet bindlessSet = bindlessTextureTable.getDescriptorSet();
+        vkCmdBindDescriptorSets(frameCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout.get(), 1U, 1U, &bindlessSet, 0U, nullptr);
+    }
 
-    // Draw mesh 1
-    FragmentPushConst pushConst{0U};
-    vkCmdPushConstants(commandBuffer, pipelineLayout.get(), VK_SHADER_STAGE_FRAGMENT_BIT, 0U, sizeof(FragmentPushConst), &pushConst);
-    drawMesh(appBase->geometryManager.getMesh(0U), commandBuffer);
-    
-    // Draw mesh 2
-    pushConst.textureIndex = 1U;
-    vkCmdPushConstants(commandBuffer, pipelineLayout.get(), VK_SHADER_STAGE_FRAGMENT_BIT, 0U, sizeof(FragmentPushConst), &pushConst);
-    drawMesh(appBase->geometryManager.getMesh(1U), commandBuffer);
+    // Each frame in flight writes its own feedback buffer
+    if (textureResidencyEnabled) {
+        VkDescriptorSet feedbackSet = textureResidency.getFeedbackDescriptorSet();
+        vkCmdBindDescriptorSets(frameCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout.get(), 2U, 1U, &feedbackSet, 0U, nullptr);
+    }
+
+    VkDeviceSize vertexBufferOffsets = 0U;
+    // Bind the buffers owned by the manager, the initial device buffers are replaced if the arena grows
+    vkCmdBindVertexBuffers(frameCommandBuffer, 0U, 1U, viBufferManager.getVertexBuffer().buffer.getRef(), &vertexBufferOffsets);
+    vkCmdBindIndexBuffer(frameCommandBuffer, viBufferManager.getIndexBuffer().buffer.get(), 0U, VK_INDEX_TYPE_UINT32);
+
+    appBeginRenderPass(&renderPass, &framebuffers[frame], frameCommandBuffer);
+
+    // Draw each loaded mesh with the layers its textures were uploaded to, consecutive meshes drawn with the same
+    // permutation share its bind
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    for (uint32_t mesh = 0U ; mesh < meshTextures.size() ; mesh++) {
+        VkPipeline pipeline = meshTextures[mesh].normalMapping ? normalMappedPipeline.get() : vertexLitPipeline.get();
+        if (pipeline != boundPipeline) {
+            vkCmdBindPipeline(frameCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            boundPipeline = pipeline;
+        }
+
+        FragmentPushConst pushConst {
+            meshTextures[mesh].albedo.layer.layer,
+            meshTextures[mesh].normal.layer.layer,
+            meshTextures[mesh].materialIndex,
+            static_cast<float>(textureStreamer.getResidentLevel(meshTextures[mesh].albedo.layer)),
+            static_cast<float>(textureStreamer.getResidentLevel(meshTextures[mesh].normal.layer))
+        };
+        vkCmdPushConstants(frameCommandBuffer, pipelineLayout.get(), VK_SHADER_STAGE_FRAGMENT_BIT, 0U, sizeof(FragmentPushConst), &pushConst);
+        drawMesh(meshTextures[mesh].mesh, frameCommandBuffer);
+    }
     
-    vkCmdEndRenderPass(commandBuffer);
+    vkCmdEndRenderPass(frameCommandBuffer);
 
-    vkEndCommandBuffer(commandBuffer);
+    // The feedback is read on the host once the frame's fence is signalled
+    if (textureResidencyEnabled) textureResidency.writeFeedbackBarrier(frameCommandBuffer);
+
+    vkEndCommandBuffer(frameCommandBuffer);
 }
 
 
@@ -287,6 +627,32 @@ void VulkanApp::userTick(double deltaTime) {
     // Wait for the in-flight fence to become signalled (last submitted queue has completed)
     vkWaitForFences(logicalDevice.get(), 1U, inFlightFence.getRef(), true, UINT64_MAX);
 
+    // The previous frame of this slot has completed, so its command buffers can be recorded again and its descriptor
+    // sets allocated again
+    frameCommandBuffers.resetFrame(frameSlot);
+    frameDescriptors[frameSlot].reset();
+
+    // The previous frame has completed, release any geometry buffers it may have been using
+    viBufferManager.onFrameComplete();
+    albedoPool.onFrameComplete();
+    normalPool.onFrameComplete();
+    if (bindlessTextures) bindlessTextureTable.onFrameComplete();
+    if (textureResidencyEnabled) textureResidency.onFrameComplete();
+
+    // Resume the asset loads that are ready for the main thread, which upload their textures and add their meshes
+    assetLoader.update();
+
+    // Upload the next streamed texture levels, or load and evict levels according to the completed frame's feedback.
+    // The previous frame has completed so its materials can be rewritten
+    bool residencyChanged = textureStreamer.update(streamingCommandBuffer);
+    if (textureResidencyEnabled && textureResidency.update(streamingCommandBuffer)) residencyChanged = true;
+    if (residencyChanged && bindlessTextures) {
+        for (MeshTextures &mesh : meshTextures) writeBindlessMaterial(mesh, false);
+    }
+
+    // Compact the vertex and index arenas a little each frame
+    viBufferManager.defragment(defragmentCommandBuffer, defragmentByteBudgetPerFrame);
+
     vkAcquireNextImageKHR(logicalDevice.get(), swapchain.get(), UINT64_MAX, imageAvailableSemaphore.get(), VK_NULL_HANDLE, &freeFrameIndex);
 
     vkResetFences(logicalDevice.get(), 1U, inFlightFence.getRef());
@@ -296,9 +662,10 @@ void VulkanApp::userTick(double deltaTime) {
     uniformBuffer.viewMatrix = appCamera.getViewMatrix();
     memcpy(mappedUBOs[freeFrameIndex], &uniformBuffer, sizeof(VSUniformBuffer));
 
-    // Write the command buffer
-    vkResetCommandBuffer(commandBuffer, 0U);
-    writeCommandBuffer(freeFrameIndex, this);
+    // Write the frame's descriptors and command buffer
+    VkDescriptorSet frameDescriptorSet = writeFrameDescriptors(freeFrameIndex);
+    VkCommandBuffer frameCommandBuffer = frameCommandBuffers.acquire(frameSlot);
+    writeCommandBuffer(freeFrameIndex, frameDescriptorSet, frameCommandBuffer, this);
 
     // Indicates that the color attachment output stage must wait for the imageAvailableSemaphore
     VkPipelineStageFlags waitSemaphoreStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
@@ -307,7 +674,7 @@ void VulkanApp::userTick(double deltaTime) {
     submitInfo.pNext = nullptr;
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submitInfo.commandBufferCount = 1U;
-    submitInfo.pCommandBuffers = &commandBuffer;
+    submitInfo.pCommandBuffers = &frameCommandBuffer;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.waitSemaphoreCount = 1U;
     submitInfo.pSignalSemaphores = renderingFinishedSemaphore.getRef();
@@ -327,6 +694,8 @@ void VulkanApp::userTick(double deltaTime) {
     presentInfo.swapchainCount = 1U;
 
     THROW(vkQueuePresentKHR(queues.graphicsQueue, &presentInfo), "Failed to present");
+
+    frameSlot = (frameSlot + 1U) % maxFramesInFlight;
 }
 
 
@@ -5,14 +5,105 @@
 static uint32_t supportedVertexCount = 200U;
 static uint32_t supportedIndexCount = 200U;
 
+// The number of frames that may be recorded/submitted before the CPU waits on the GPU
+static uint32_t maxFramesInFlight = 1U;
+
+// The maximum number of bytes the geometry defragmenter may move per frame
+static uint32_t defragmentByteBudgetPerFrame = 256U * 1024U;
+
+// The width and height of albedo and normal textures, every texture of a texture array has the same size
+static uint32_t textureSize = 2048U;
+
+// The number of layers texture arrays are created with, they grow geometrically once full
+static uint32_t initialTextureArrayLayers = 2U;
+
+// Textures are first uploaded with only the levels no larger than this, the finer levels are streamed in afterwards
+static uint32_t streamingMipTailSize = 256U;
+
+// Limits the background loads and the per-frame uploads of streamed texture levels
+static uint32_t streamingConcurrentLoads = 2U;
+static uint32_t streamingUploadBytesPerFrame = 4U * 1024U * 1024U;
+
+// Whether textures are bound through a single bindless descriptor set, when the device supports descriptor indexing
+static bool useBindlessTextures = true;
+
+// The sizes of the bindless texture array and material buffer
+static uint32_t maxBindlessTextures = 1024U;
+static uint32_t maxBindlessMaterials = 256U;
+
+// Whether the levels of bindless textures are kept resident according to the levels shaders sample, rather than all
+// streamed in, when the device supports fragment shader stores
+static bool useTextureResidency = true;
+
+// The most memory resident texture levels may occupy, lowered to the device's reported budget under VK_EXT_memory_budget
+static uint64_t textureResidencyBudgetBytes = 256U * 1024U * 1024U;
+
+// The number of frames texture levels that are no longer sampled stay resident
+static uint32_t textureEvictionDelayFrames = 120U;
+
+// The number of asset loads that run at once, the rest wait for a slot in order of priority
+static uint32_t assetLoaderConcurrentLoads = 4U;
+
+// The asset archive mounted at startup, relative to SOURCE_ROOT. Files it holds are loaded from it rather than from
+// disk, files it does not hold (or every file, if it does not exist) are loaded from disk
+static const char* assetArchivePath = "../assets.pak";
+static const char* assetArchiveRoot = "..";
+
+// Where the driver's pipeline cache is saved between runs, relative to SOURCE_ROOT
+static const char* pipelineCachePath = "pipeline-cache.bin";
+
+// The most lights the graphics pipeline can be specialized for, must match MAX_LIGHTS in shader.vert and the
+// fragment shaders
+static const uint32_t maxLightCount = 4U;
+
+// The constant_id of each specialization constant of the graphics shaders
+static const uint32_t lightCountConstantId = 0U;
+static const uint32_t normalMappingConstantId = 1U;
+static const uint32_t lodClampConstantId = 2U;
+
 struct FragmentPushConst {
-    uint32_t textureIndex = 0u;
+    // The layers of the albedo and normal arrays sampled by the draw
+    uint32_t albedoIndex = 0u;
+    uint32_t normalIndex = 0u;
+
+    // The material sampled by the draw, used instead of the layers above when textures are bindless
+    uint32_t materialIndex = 0u;
+
+    // The finest albedo and normal levels that hold data while the textures are streamed in
+    float albedoMinLod = 0.f;
+    float normalMinLod = 0.f;
+};
+
+/**
+ * A material as stored in the bindless material buffer, textures are referenced by their slot in the bindless
+ * texture array and their layer within that texture array. Must match Material in shader-bindless.frag (std430).
+ */
+struct BindlessMaterial {
+    uint32_t albedoTexture;
+    uint32_t albedoLayer;
+    uint32_t normalTexture;
+    uint32_t normalLayer;
+
+    // The finest levels that hold data while the textures are streamed in
+    float albedoMinLod;
+    float normalMinLod;
+
+    // The texture levels held by level 0 of the textures' images, non-zero when an image only holds its resident levels
+    float albedoBaseLevel;
+    float normalBaseLevel;
+
+    // Where the shader writes the levels it samples the textures at, TextureResidencyManager::noFeedback for none
+    uint32_t albedoFeedbackId;
+    uint32_t normalFeedbackId;
 };
 
 struct VSUniformBuffer {
     glm::mat4 worldMatrix;
     glm::mat4 viewMatrix;
     glm::mat4 projMatrix;
+
+    // The normalized directions the lights shine in, only the first as many as the pipeline's light count are read
+    glm::vec4 lightDirections[maxLightCount];
 };
 
 struct Face {
@@ -27,7 +118,8 @@ struct Face {
 struct Vertex {
     glm::vec3 position;
     glm::vec3 normal;
-    glm::vec3 tangent;
+    // xyz holds the tangent, w holds the handedness of the UV mapping (-1 where the UVs are mirrored, +1 otherwise)
+    glm::vec4 tangent;
     glm::vec2 texCoord;
 
     static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
@@ -49,18 +141,18 @@ struct Vertex {
             },
             // Tangent
             {
-                2U, // Location, the shader input location (layout(location = 1) in vec3 normal)
+                2U, // Location, the shader input location (layout(location = 2) in vec4 tangent)
                 0U, // Binding, the binding number of the vertex buffer from which this data is coming,
-                VK_FORMAT_R32G32B32_SFLOAT, // Format, we use a Float3 for the normal,
-                24U // Offset, we use 12 bytes since position is made up of 3 x 4-byte values
+                VK_FORMAT_R32G32B32A32_SFLOAT, // Format, we use a Float4 for the tangent and its handedness,
+                24U // Offset, we use 24 bytes since position & normal take up 6 x 4-byte values
             },
 
             // Texcoord
             {
-                3U, // Location, the shader input location (layout(location = 2) in vec2 texCoord)
+                3U, // Location, the shader input location (layout(location = 3) in vec2 texCoord)
                 0U, // Binding, the binding number of the vertex buffer from which this data is coming,
                 VK_FORMAT_R32G32_SFLOAT, // Format, we use a Float2 for the texture coordinate,
-                36U // Offset, we use 24 bytes since position & normal take up 6 x 4-byte values
+                40U // Offset, we use 40 bytes since position, normal & tangent take up 10 x 4-byte values
             }
         };
     }
@@ -29,7 +29,9 @@ void VulkanApp::internalInit()
     viewportSettings.farPlane = 1000.0f;
 
     // Create the instance
-    instance.init(this, "Vulkan App", true);
+    internalStartupTasks.instance = startupGraph.addTask("instance", [this]() {
+        instance.init(this, "Vulkan App", true);
+    });
 
     // int argc = 0;
     // char** argv = nullptr;
@@ -46,21 +48,37 @@ void VulkanApp::internalInit()
     // QWidget* windowWrapper = QWidget::createWindowContainer(window);
     // VkSurfaceKHR qtSurface = QVulkanInstance::surfaceForWindow(window);
 
-    // Enumerate the physical device and queue families
-    enumeratePhysicalDevice();
-    enumerateQueueFamilies();
-
-    createWindow();
+    // GLFW windows must be created on the main thread
+    internalStartupTasks.window = startupGraph.addTask("window", [this]() {
+        createWindow();
+    }, {}, StartupThread::MAIN);
 
-    setupDebugMessenger();
-
-    logicalDevice.init(this, physicalDevice, {}, {"VK_KHR_swapchain"});
-    getQueues();
+    // Enumerate the physical device and queue families
+    internalStartupTasks.physicalDevice = startupGraph.addTask("physical device", [this]() {
+        enumeratePhysicalDevice();
+        enumerateQueueFamilies();
+    }, {internalStartupTasks.instance});
+
+    startupGraph.addTask("debug messenger", [this]() {
+        setupDebugMessenger();
+    }, {internalStartupTasks.instance});
+
+    internalStartupTasks.logicalDevice = startupGraph.addTask("logical device", [this]() {
+        logicalDevice.init(this, physicalDevice, {}, {"VK_KHR_swapchain"});
+        getQueues();
+    }, {internalStartupTasks.physicalDevice});
+
+    internalStartupTasks.surface = startupGraph.addTask("surface", [this]() {
+        surface.init(this, window);
+    }, {internalStartupTasks.instance, internalStartupTasks.window});
+}
 
-    surface.init(this, window);
+void VulkanApp::runStartup()
+{
+    startupGraph.run(JobSystem::shared());
+    startupGraph.printReport(std::cout);
 
     lastRenderTime = highResClock.now();
-
 }
 
 void VulkanApp::internalLoop()
@@ -433,6 +451,7 @@ int main() {
     VulkanApp app;
     app.internalInit();
     app.userInit();
+    app.runStartup();
     app.internalLoop();
     app.cleanup();
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "geometry-utilities.h"
 #include <chrono>
 #include "app-base.h"
+#include "startup-graph.h"
 
 
 class VulkanApp : public AppBase {
@@ -44,7 +45,20 @@ class VulkanApp : public AppBase {
     void processKeyActions();
 
 
+    /**
+     * internalInit and userInit declare the startup work as tasks of the startup graph, runStartup runs them
+     */
+    StartupGraph startupGraph;
+    struct InternalStartupTasks {
+        StartupGraph::TaskId instance;
+        StartupGraph::TaskId window;
+        StartupGraph::TaskId physicalDevice;
+        StartupGraph::TaskId logicalDevice;
+        StartupGraph::TaskId surface;
+    } internalStartupTasks;
+
     void internalInit();
+    void runStartup();
     void internalLoop();
     
     public:
@@ -0,0 +1,187 @@
+#include "asset-cooker.h"
+#include "asset-archive.h"
+#include "file-loader.h"
+#include "image-loader.h"
+#include "ktx2-file.h"
+#include "geometry-manager.h"
+#include "geometry-utilities.h"
+#include "mesh-cache.h"
+#include "job-system.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+static std::string toLower(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+/**
+ * @brief Continues an FNV-1a hash over the bytes of a value
+ */
+template <typename T>
+static uint64_t combineHash(uint64_t hash, T value)
+{
+    unsigned char bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+    for (unsigned char byte : bytes) {
+        hash ^= byte;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Lists the files under a directory with one of the extensions, as paths relative to the root, sorted
+ */
+static std::vector<std::string> findSources(const std::filesystem::path &root, const std::string &directory, const std::vector<std::string> &extensions)
+{
+    std::vector<std::string> sourceNames = {};
+    if (!std::filesystem::is_directory(root / directory)) return sourceNames;
+
+    for (const std::filesystem::directory_entry &entry : std::filesystem::recursive_directory_iterator(root / directory)) {
+        if (!entry.is_regular_file()) continue;
+        std::string extension = toLower(entry.path().extension().string());
+        if (std::find(extensions.begin(), extensions.end(), extension) == extensions.end()) continue;
+        sourceNames.push_back(entry.path().lexically_relative(root).generic_string());
+    }
+    std::sort(sourceNames.begin(), sourceNames.end());
+    return sourceNames;
+}
+
+void AssetCooker::init(AssetCookerConfig config)
+{
+    this->config = config;
+    this->config.rootDirectory = std::filesystem::absolute(config.rootDirectory).lexically_normal();
+}
+
+std::vector<CookJob> AssetCooker::findJobs()
+{
+    std::vector<CookJob> jobs = {};
+
+    for (const std::string &sourceName : findSources(config.rootDirectory, "mesh", {".obj"})) {
+        jobs.push_back(CookJob {CookJobType::MESH, sourceName, MeshCache::getCachePath(sourceName)});
+    }
+
+    // Normal maps are named as such, they keep only the two channels BC5 stores and the shader reconstructs z
+    for (const std::string &sourceName : findSources(config.rootDirectory, "images", {".jpg", ".jpeg"})) {
+        CookJob job {CookJobType::TEXTURE, sourceName, sourceName + ".ktx2"};
+        job.compression = toLower(std::filesystem::path(sourceName).filename().string()).find("normal") != std::string::npos ? TextureCompression::BC5 : TextureCompression::BC7;
+        jobs.push_back(job);
+    }
+
+    return jobs;
+}
+
+AssetCookerStats AssetCooker::cook()
+{
+    database.load(config.databasePath.string());
+
+    std::vector<CookJob> jobs = findJobs();
+    JobSystem::shared().parallelFor(0U, jobs.size(), [this, &jobs](uint32_t first, uint32_t last) {
+        for (uint32_t i = first ; i < last ; i++) runJob(jobs[i]);
+    }, 1U);
+
+    database.save(config.databasePath.string());
+    return stats;
+}
+
+uint64_t AssetCooker::hashInputs(const CookJob &job)
+{
+    std::filesystem::path sourcePath = config.rootDirectory / job.sourceName;
+    std::vector<char> sourceFile = FileLoader::loadFile(sourcePath.string());
+    if (sourceFile.empty() && !std::filesystem::is_regular_file(sourcePath)) throw std::runtime_error("Failed to read " + sourcePath.string());
+
+    uint64_t hash = combineHash(14695981039346656037ULL, version);
+    hash = combineHash(hash, static_cast<uint32_t>(job.type));
+    hash = combineHash(hash, AssetArchive::hashBytes(sourceFile.data(), sourceFile.size()));
+
+    switch (job.type) {
+        case CookJobType::MESH : {
+            // The material library is parsed along with the OBJ
+            hash = combineHash(hash, MeshCache::version);
+            std::string mtlPath = GeometryManager::findMaterialLibrary(sourcePath.string(), sourceFile);
+            std::vector<char> mtlFile = mtlPath.empty() ? std::vector<char>{} : FileLoader::loadFile(mtlPath);
+            hash = combineHash(hash, AssetArchive::hashBytes(mtlFile.data(), mtlFile.size()));
+            break;
+        }
+        case CookJobType::TEXTURE :
+            hash = combineHash(hash, TextureCompressor::getFormat(job.compression));
+            break;
+    }
+    return hash;
+}
+
+void AssetCooker::runJob(const CookJob &job)
+{
+    std::filesystem::path outputPath = config.rootDirectory / job.outputName;
+    auto start = std::chrono::steady_clock::now();
+
+    try {
+        uint64_t inputHash = hashInputs(job);
+        if (!config.force && std::filesystem::exists(outputPath) && database.isUpToDate(job.outputName, inputHash)) {
+            // The runtime only trusts caches written after their sources, an unchanged source may still have been touched
+            std::filesystem::path sourcePath = config.rootDirectory / job.sourceName;
+            if (std::filesystem::last_write_time(outputPath) < std::filesystem::last_write_time(sourcePath)) {
+                std::filesystem::last_write_time(outputPath, std::filesystem::file_time_type::clock::now());
+            }
+            database.record(job.outputName, inputHash);
+
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.upToDateAssets++;
+            return;
+        }
+
+        // Written beside the output and renamed over it, so a failed or interrupted cook never leaves a partial output
+        std::filesystem::path temporaryPath = outputPath.string() + ".tmp";
+        switch (job.type) {
+            case CookJobType::MESH : cookMesh(job, temporaryPath); break;
+            case CookJobType::TEXTURE : cookTexture(job, temporaryPath); break;
+        }
+        std::filesystem::rename(temporaryPath, outputPath);
+        database.record(job.outputName, inputHash);
+
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.cookedAssets++;
+        std::cout << "Cooked " << job.outputName << " (" << static_cast<uint32_t>(milliseconds) << " ms)" << std::endl;
+    }
+    catch (const std::exception &e) {
+        std::filesystem::remove(outputPath.string() + ".tmp");
+
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.failedAssets++;
+        std::cerr << "Failed to cook " << job.outputName << ": " << e.what() << std::endl;
+    }
+}
+
+void AssetCooker::cookMesh(const CookJob &job, const std::filesystem::path &outputPath)
+{
+    std::string sourcePath = (config.rootDirectory / job.sourceName).string();
+    std::vector<char> objFile = FileLoader::loadFile(sourcePath);
+    std::string mtlPath = GeometryManager::findMaterialLibrary(sourcePath, objFile);
+    std::vector<char> mtlFile = mtlPath.empty() ? std::vector<char>{} : FileLoader::loadFile(mtlPath);
+
+    std::vector<Mesh> meshes = GeometryManager::parseOBJ(sourcePath, objFile, mtlFile);
+    if (meshes.empty()) throw std::runtime_error("Failed to parse " + sourcePath);
+
+    std::vector<CookedMesh> cookedMeshes = {};
+    for (Mesh &mesh : meshes) {
+        auto [vertices, indices] = mesh.getVertexAndIndexData();
+        optimizeVertexCache(indices, vertices.size());
+        optimizeVertexFetch(vertices, indices);
+        cookedMeshes.push_back(CookedMesh {mesh.getShapeName(), std::move(vertices), std::move(indices)});
+    }
+    MeshCache::writeToFile(outputPath.string(), cookedMeshes);
+}
+
+void AssetCooker::cookTexture(const CookJob &job, const std::filesystem::path &outputPath)
+{
+    Image image = ImageLoader::loadJPEGFromFile((config.rootDirectory / job.sourceName).string(), 0U);
+    KTX2Texture texture = TextureCompressor::compressWithMipChain(image, job.compression);
+    KTX2File::writeToFile(outputPath.string(), texture);
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "cook-database.h"
+#include "texture-compressor.h"
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <mutex>
+
+enum class CookJobType {
+    // An OBJ, cooked to a MeshCache next to it
+    MESH,
+    // A JPEG, cooked to a block-compressed KTX2 file with a full mip chain next to it, where the texture registry looks
+    TEXTURE
+};
+
+struct CookJob {
+    CookJobType type;
+
+    // Paths relative to the asset root
+    std::string sourceName;
+    std::string outputName;
+
+    TextureCompression compression = TextureCompression::BC7;
+};
+
+struct AssetCookerConfig {
+    // Holds the mesh and images directories
+    std::filesystem::path rootDirectory;
+    std::filesystem::path databasePath;
+
+    // Cooks every asset whether or not it is up to date
+    bool force = false;
+};
+
+struct AssetCookerStats {
+    uint32_t cookedAssets = 0U;
+    uint32_t upToDateAssets = 0U;
+    uint32_t failedAssets = 0U;
+};
+
+/**
+ * @class AssetCooker
+ *
+ * @brief Converts the source assets into the forms the runtime loads without further processing
+ *
+ * Meshes are parsed, given tangents, reordered for the vertex cache and quantized. Textures are given full mip chains
+ * and compressed to BC7, or to BC5 when their name marks them as a normal map. Each asset is only cooked when its
+ * inputs or the way it is cooked changed since the last cook (see CookDatabase). Shaders are not cooked, the build
+ * compiles them and embeds their SPIR-V in the app (see shaders/CMakeLists.txt).
+ *
+ * Every asset is cooked as a job on the job system, which the texture compressor and tangent generation split further
+ * across every core.
+ */
+class AssetCooker {
+    AssetCookerConfig config;
+    CookDatabase database;
+
+    std::mutex statsMutex;
+    AssetCookerStats stats {};
+
+    std::vector<CookJob> findJobs();
+    void runJob(const CookJob &job);
+    uint64_t hashInputs(const CookJob &job);
+    void cookMesh(const CookJob &job, const std::filesystem::path &outputPath);
+    void cookTexture(const CookJob &job, const std::filesystem::path &outputPath);
+
+    public:
+    // Part of every input hash, bump it whenever a change to the cooker changes what it writes
+    static const uint32_t version = 1U;
+
+    void init(AssetCookerConfig config);
+
+    /**
+     * @brief Cooks every asset that is not up to date and saves the database
+     */
+    AssetCookerStats cook();
+
+};
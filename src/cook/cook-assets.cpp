@@ -0,0 +1,49 @@
+#include "asset-cooker.h"
+#include <iostream>
+#include <stdexcept>
+
+/**
+ * Cooks the meshes and textures under an asset root into their runtime forms, skipping those that are up to date
+ *
+ * Usage: cook-assets <root directory> [--database <path>] [--force]
+ */
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <root directory> [--database <path>] [--force]" << std::endl;
+        return 1;
+    }
+
+    AssetCookerConfig config {};
+    config.rootDirectory = argv[1];
+    config.databasePath = config.rootDirectory / "cook.db";
+    for (int i = 2 ; i < argc ; i++) {
+        std::string argument = argv[i];
+        if (argument == "--force") {
+            config.force = true;
+            continue;
+        }
+        if (i + 1 == argc) {
+            std::cerr << "Missing value for " << argument << std::endl;
+            return 1;
+        }
+
+        if (argument == "--database") config.databasePath = argv[++i];
+        else {
+            std::cerr << "Unknown option " << argument << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        AssetCooker cooker;
+        cooker.init(config);
+        AssetCookerStats stats = cooker.cook();
+        std::cout << "Cooked " << stats.cookedAssets << " assets, " << stats.upToDateAssets << " up to date, " << stats.failedAssets << " failed" << std::endl;
+        return stats.failedAssets == 0U ? 0 : 1;
+    }
+    catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
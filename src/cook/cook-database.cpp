@@ -0,0 +1,54 @@
+#include "cook-database.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+
+void CookDatabase::load(const std::string &databasePath)
+{
+    std::lock_guard<std::mutex> lock(entryMutex);
+    previousEntries.clear();
+
+    std::ifstream input(databasePath);
+    for (std::string line ; std::getline(input, line) ; ) {
+        size_t separator = line.find(' ');
+        if (separator == std::string::npos) continue;
+
+        // A malformed line only costs a recook of its output
+        try {
+            previousEntries[line.substr(separator + 1U)] = std::stoull(line.substr(0U, separator), nullptr, 16);
+        }
+        catch (const std::exception&) {}
+    }
+}
+
+void CookDatabase::save(const std::string &databasePath)
+{
+    std::lock_guard<std::mutex> lock(entryMutex);
+
+    // Written beside the database and renamed over it, so an interrupted cook never leaves a truncated database
+    std::string temporaryPath = databasePath + ".tmp";
+    {
+        std::ofstream output(temporaryPath, std::ios::trunc);
+        if (!output.is_open()) throw std::runtime_error("Failed to open cook database for writing: " + temporaryPath);
+        for (const auto &[outputName, inputHash] : entries) {
+            output << std::hex << std::setw(16) << std::setfill('0') << inputHash << ' ' << outputName << '\n';
+        }
+        if (!output) throw std::runtime_error("Failed to write cook database: " + temporaryPath);
+    }
+    std::filesystem::rename(temporaryPath, databasePath);
+}
+
+bool CookDatabase::isUpToDate(const std::string &outputName, uint64_t inputHash)
+{
+    std::lock_guard<std::mutex> lock(entryMutex);
+    auto entry = previousEntries.find(outputName);
+    return entry != previousEntries.end() && entry->second == inputHash;
+}
+
+void CookDatabase::record(const std::string &outputName, uint64_t inputHash)
+{
+    std::lock_guard<std::mutex> lock(entryMutex);
+    entries[outputName] = inputHash;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <map>
+#include <mutex>
+#include <cstdint>
+
+/**
+ * @class CookDatabase
+ *
+ * @brief Remembers the hash of the inputs each cooked output was last built from
+ *
+ * An output is up to date when it exists and the hash of its inputs, its settings and the cooker version matches the
+ * one recorded by the previous cook, so editing an input, changing how it is cooked or updating the cooker recooks it,
+ * while touching a file without changing it does not. The database is a text file of one "<hash> <output name>" line
+ * per output, and only the outputs recorded during this cook are saved, so those of deleted sources are forgotten.
+ */
+class CookDatabase {
+    std::mutex entryMutex;
+    std::map<std::string, uint64_t> previousEntries = {};
+    std::map<std::string, uint64_t> entries = {};
+
+    public:
+    /**
+     * @brief Loads the database written by a previous cook, a missing database is treated as empty
+     */
+    void load(const std::string &databasePath);
+
+    void save(const std::string &databasePath);
+
+    /**
+     * @brief Whether the previous cook recorded the output as cooked from inputs with the given hash
+     *
+     * @param outputName The output's path relative to the asset root, so the database does not depend on where the
+     * root is checked out
+     */
+    bool isUpToDate(const std::string &outputName, uint64_t inputHash);
+
+    /**
+     * @brief Records that the output is cooked from inputs with the given hash
+     */
+    void record(const std::string &outputName, uint64_t inputHash);
+};
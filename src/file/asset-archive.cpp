@@ -0,0 +1,168 @@
+#include "asset-archive.h"
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+static const char archiveIdentifier[8] = {'V', 'K', 'A', 'S', 'S', 'E', 'T', '\0'};
+
+// The table of contents is aligned to the size of a cache line
+static const uint64_t tocAlignment = 64U;
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return ((value + alignment - 1U) / alignment) * alignment;
+}
+
+uint64_t AssetArchive::hashBytes(const char* data, size_t size)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0U ; i < size ; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void AssetArchive::open(const std::string &archivePath)
+{
+    close();
+    file.open(archivePath, FileAccessPattern::RANDOM);
+
+    if (file.size() < sizeof(ArchiveHeader) || memcmp(file.data(), archiveIdentifier, sizeof(archiveIdentifier)) != 0) {
+        close();
+        throw std::runtime_error("Failed to open asset archive, invalid identifier: " + archivePath);
+    }
+    header = reinterpret_cast<const ArchiveHeader*>(file.data());
+
+    uint64_t tocEnd = header->tocOffset + static_cast<uint64_t>(header->entryCount) * sizeof(ArchiveEntry);
+    bool isValid = header->version == version && header->tocOffset % tocAlignment == 0U && tocEnd <= file.size()
+        && header->pathsOffset + header->pathsSize <= file.size();
+    if (!isValid) {
+        close();
+        throw std::runtime_error("Failed to open asset archive, invalid header: " + archivePath);
+    }
+    entries = reinterpret_cast<const ArchiveEntry*>(file.data() + header->tocOffset);
+    paths = file.data() + header->pathsOffset;
+
+    for (uint32_t i = 0U ; i < header->entryCount ; i++) {
+        const ArchiveEntry &entry = entries[i];
+        bool isEntryValid = entry.offset + entry.size <= file.size() && static_cast<uint64_t>(entry.pathOffset) + entry.pathLength <= header->pathsSize
+            && (i == 0U || entries[i - 1U].pathHash <= entry.pathHash);
+        if (!isEntryValid) {
+            close();
+            throw std::runtime_error("Failed to open asset archive, invalid table of contents: " + archivePath);
+        }
+    }
+
+    // Lookups touch the table of contents and paths on every load, so read them in now
+    file.advise(FileAccessPattern::WILL_NEED, 0U, header->pathsOffset + header->pathsSize);
+}
+
+const ArchiveEntry* AssetArchive::findEntry(const std::string &path) const
+{
+    if (header == nullptr) return nullptr;
+
+    uint64_t pathHash = hashBytes(path.data(), path.size());
+    const ArchiveEntry* end = entries + header->entryCount;
+    const ArchiveEntry* entry = std::lower_bound(entries, end, pathHash, [](const ArchiveEntry &entry, uint64_t hash) {
+        return entry.pathHash < hash;
+    });
+
+    // Entries whose paths share a hash are adjacent
+    for ( ; entry != end && entry->pathHash == pathHash ; entry++) {
+        if (entry->pathLength == path.size() && memcmp(paths + entry->pathOffset, path.data(), path.size()) == 0) return entry;
+    }
+    return nullptr;
+}
+
+MappedFile AssetArchive::find(const std::string &path) const
+{
+    const ArchiveEntry* entry = findEntry(path);
+    if (entry == nullptr) return MappedFile();
+    if (entry->compression != ARCHIVE_COMPRESSION_NONE) throw std::runtime_error("Failed to read " + path + " from asset archive, unsupported compression");
+
+    return MappedFile::view(file.data() + entry->offset, entry->size);
+}
+
+std::vector<std::string> AssetArchive::verify() const
+{
+    std::vector<std::string> corruptPaths = {};
+    for (uint32_t i = 0U ; i < getEntryCount() ; i++) {
+        const ArchiveEntry &entry = entries[i];
+        if (hashBytes(file.data() + entry.offset, entry.size) != entry.contentHash) {
+            corruptPaths.emplace_back(paths + entry.pathOffset, entry.pathLength);
+        }
+    }
+    return corruptPaths;
+}
+
+void AssetArchive::close()
+{
+    file.close();
+    header = nullptr;
+    entries = nullptr;
+    paths = nullptr;
+}
+
+void AssetArchiveWriter::addFile(const std::string &path, std::vector<char> data)
+{
+    for (const PendingFile &file : files) {
+        if (file.path == path) throw std::runtime_error("Failed to add " + path + " to asset archive, the path has already been added");
+    }
+    files.push_back({path, std::move(data)});
+}
+
+uint64_t AssetArchiveWriter::write(const std::string &archivePath)
+{
+    std::vector<ArchiveEntry> entries(files.size());
+    std::string paths;
+    for (uint32_t i = 0U ; i < files.size() ; i++) {
+        entries[i] = {};
+        entries[i].pathHash = AssetArchive::hashBytes(files[i].path.data(), files[i].path.size());
+        entries[i].size = files[i].data.size();
+        entries[i].contentHash = AssetArchive::hashBytes(files[i].data.data(), files[i].data.size());
+        entries[i].compression = ARCHIVE_COMPRESSION_NONE;
+        entries[i].pathOffset = paths.size();
+        entries[i].pathLength = files[i].path.size();
+        paths += files[i].path;
+    }
+
+    // Payloads are written in the order the files were added, so files that are loaded together stay together
+    uint64_t tocOffset = alignUp(sizeof(ArchiveHeader), tocAlignment);
+    uint64_t pathsOffset = tocOffset + entries.size() * sizeof(ArchiveEntry);
+    uint64_t payloadOffset = alignUp(pathsOffset + paths.size(), AssetArchive::payloadAlignment);
+    for (ArchiveEntry &entry : entries) {
+        entry.offset = payloadOffset;
+        payloadOffset = alignUp(payloadOffset + entry.size, AssetArchive::payloadAlignment);
+    }
+    uint64_t archiveSize = entries.empty() ? pathsOffset + paths.size() : entries.back().offset + entries.back().size;
+
+    std::vector<char> archive(archiveSize, 0);
+    for (uint32_t i = 0U ; i < files.size() ; i++) {
+        memcpy(archive.data() + entries[i].offset, files[i].data.data(), files[i].data.size());
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const ArchiveEntry &a, const ArchiveEntry &b) { return a.pathHash < b.pathHash; });
+
+    ArchiveHeader header {};
+    memcpy(header.identifier, archiveIdentifier, sizeof(archiveIdentifier));
+    header.version = AssetArchive::version;
+    header.entryCount = entries.size();
+    header.tocOffset = tocOffset;
+    header.pathsOffset = pathsOffset;
+    header.pathsSize = paths.size();
+    header.payloadAlignment = AssetArchive::payloadAlignment;
+
+    memcpy(archive.data(), &header, sizeof(ArchiveHeader));
+    memcpy(archive.data() + tocOffset, entries.data(), entries.size() * sizeof(ArchiveEntry));
+    memcpy(archive.data() + pathsOffset, paths.data(), paths.size());
+
+    std::ofstream output(archivePath, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) throw std::runtime_error("Failed to open asset archive for writing: " + archivePath);
+    output.write(archive.data(), archive.size());
+    if (!output) throw std::runtime_error("Failed to write asset archive: " + archivePath);
+
+    return archive.size();
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "mapped-file.h"
+#include <vector>
+#include <string>
+
+/**
+ * How an archived file's payload is stored
+ */
+enum ArchiveCompression : uint32_t {
+    ARCHIVE_COMPRESSION_NONE = 0U
+};
+
+/**
+ * The fixed size header at the start of an archive
+ *
+ * An archive is laid out as the header, the table of contents (one ArchiveEntry per file, sorted by path hash), the
+ * paths the entries refer to, then the payloads. The table of contents is aligned so that it can be used in place
+ * from a mapping, and every payload starts on a payloadAlignment boundary so that it can be handed out as a mapped
+ * view without copying. All values are little endian.
+ */
+struct ArchiveHeader {
+    char identifier[8];
+    uint32_t version;
+    uint32_t entryCount;
+    uint64_t tocOffset;
+    uint64_t pathsOffset;
+    uint64_t pathsSize;
+    uint32_t payloadAlignment;
+    uint32_t reserved;
+};
+
+struct ArchiveEntry {
+    // Hash of the path relative to the archive root, with forward slashes
+    uint64_t pathHash;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t contentHash;
+    uint32_t compression;
+    // The path, as an offset into the paths block, so that entries whose path hashes collide can be told apart
+    uint32_t pathOffset;
+    uint32_t pathLength;
+    uint32_t reserved;
+};
+
+/**
+ * @class AssetArchive
+ *
+ * @brief Maps an archive of packed files and finds the files in it by path
+ *
+ * Looking a file up is a binary search of the mapped table of contents, and its contents are a view of the mapping,
+ * so an archive costs a single open however many files it holds.
+ */
+class AssetArchive {
+    MappedFile file;
+    const ArchiveHeader* header = nullptr;
+    const ArchiveEntry* entries = nullptr;
+    const char* paths = nullptr;
+
+    const ArchiveEntry* findEntry(const std::string &path) const;
+
+    public:
+    static const uint32_t version = 1U;
+    static const uint32_t payloadAlignment = 4096U;
+
+    /**
+     * @brief Maps an archive and validates its header and table of contents, throwing if it is not a valid archive
+     */
+    void open(const std::string &archivePath);
+
+    /**
+     * @brief Finds a file by its path relative to the archive root
+     *
+     * @return A view of the file's payload, which is valid until the archive is closed, or a view that is not open if
+     * the archive does not hold the file
+     */
+    MappedFile find(const std::string &path) const;
+
+    bool contains(const std::string &path) const { return findEntry(path) != nullptr; }
+
+    /**
+     * @brief Checks every payload against its content hash, which reads the whole archive
+     *
+     * @return The paths of the files whose payloads do not match
+     */
+    std::vector<std::string> verify() const;
+
+    uint32_t getEntryCount() const { return header == nullptr ? 0U : header->entryCount; }
+
+    void close();
+
+    static uint64_t hashBytes(const char* data, size_t size);
+};
+
+/**
+ * @class AssetArchiveWriter
+ *
+ * @brief Packs files into an archive that AssetArchive reads
+ */
+class AssetArchiveWriter {
+    struct PendingFile {
+        std::string path;
+        std::vector<char> data;
+    };
+    std::vector<PendingFile> files = {};
+
+    public:
+    /**
+     * @brief Adds a file to the archive, throwing if a file with the same path has already been added
+     *
+     * @param path The path the file is found by, relative to the archive root
+     */
+    void addFile(const std::string &path, std::vector<char> data);
+
+    /**
+     * @brief Writes every added file to an archive
+     *
+     * @return The size of the archive in bytes
+     */
+    uint64_t write(const std::string &archivePath);
+};
@@ -0,0 +1,161 @@
+#include "async-file-reader.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+void AsyncFileReader::init(AsyncFileReaderConfig config)
+{
+    this->config = config;
+    if (this->config.threadCount == 0U) this->config.threadCount = std::max(1U, JobSystem::shared().getThreadCount());
+    this->config.maxQueuedReads = std::max(this->config.maxQueuedReads, 1U);
+    initialized = true;
+}
+
+void AsyncFileReader::readerLoop()
+{
+    while (true) {
+        ReadRequest request;
+        {
+            std::lock_guard<std::mutex> lock(requestMutex);
+            if (requests.empty()) {
+                activeReaders--;
+                return;
+            }
+
+            request = std::move(requests.front());
+            requests.pop();
+        }
+
+        try {
+            request();
+        }
+        catch (...) {
+            // A callback threw, another reader takes over the queue before the exception is handed to readerJobs
+            JobSystem::shared().run([this]() { readerLoop(); }, &readerJobs);
+            throw;
+        }
+    }
+}
+
+void AsyncFileReader::queueRequest(ReadRequest request)
+{
+    if (!initialized) throw std::runtime_error("Failed to queue file read, file reader not initialized");
+
+    uint32_t queuedReads;
+    uint32_t ranReads = 0U;
+    bool startReader = false;
+    while (true) {
+        ReadRequest oldest;
+        {
+            std::lock_guard<std::mutex> lock(requestMutex);
+            if (requests.size() < config.maxQueuedReads) {
+                requests.push(std::move(request));
+                queuedReads = requests.size();
+                if (activeReaders < config.threadCount) {
+                    activeReaders++;
+                    startReader = true;
+                }
+                break;
+            }
+
+            oldest = std::move(requests.front());
+            requests.pop();
+        }
+
+        // Waiting for a reader to take a read could tie up a worker that a reader needs, so the caller reads instead
+        oldest();
+        ranReads++;
+    }
+    if (startReader) JobSystem::shared().run([this]() { readerLoop(); }, &readerJobs);
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats.maxQueuedReads = std::max(stats.maxQueuedReads, queuedReads);
+    stats.callerReads += ranReads;
+}
+
+std::vector<char> AsyncFileReader::readRange(const std::string &filePath, uint64_t offset, uint64_t size)
+{
+    MappedFile file = FileLoader::mapFile(filePath, FileAccessPattern::SEQUENTIAL);
+    if (offset > file.size()) throw std::runtime_error("Failed to read file, the offset is past the end of the file: " + filePath);
+    size = std::min<uint64_t>(size, file.size() - offset);
+
+    std::vector<char> data(size);
+    uint64_t windowSize = config.readAheadBytes == 0U ? size : config.readAheadBytes;
+    if (config.readAheadBytes > 0U) file.advise(FileAccessPattern::WILL_NEED, offset, windowSize);
+
+    for (uint64_t copied = 0U ; copied < size ; copied += windowSize) {
+        // Start reading the next window before copying this one, which faults in whatever has not arrived yet
+        if (config.readAheadBytes > 0U && copied + windowSize < size) {
+            file.advise(FileAccessPattern::WILL_NEED, offset + copied + windowSize, windowSize);
+        }
+        memcpy(data.data() + copied, file.data() + offset + copied, std::min(windowSize, size - copied));
+    }
+    return data;
+}
+
+std::future<std::vector<char>> AsyncFileReader::read(const std::string &filePath, uint64_t offset, uint64_t size)
+{
+    // std::function must be copyable, so the promise is shared with the callback rather than moved into it
+    std::shared_ptr<std::promise<std::vector<char>>> result = std::make_shared<std::promise<std::vector<char>>>();
+    std::future<std::vector<char>> future = result->get_future();
+
+    read(filePath, [result](std::vector<char> data, std::exception_ptr error) {
+        if (error) result->set_exception(error);
+        else result->set_value(std::move(data));
+    }, offset, size);
+    return future;
+}
+
+void AsyncFileReader::read(const std::string &filePath, ReadCallback onComplete, uint64_t offset, uint64_t size)
+{
+    queueRequest([this, filePath, onComplete, offset, size]() {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<char> data;
+        try {
+            data = readRange(filePath, offset, size);
+        }
+        catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(statsMutex);
+                stats.failedReads++;
+            }
+            onComplete({}, std::current_exception());
+            return;
+        }
+
+        uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.reads.files++;
+            stats.reads.bytes += data.size();
+            stats.reads.nanoseconds += nanoseconds;
+        }
+        onComplete(std::move(data), nullptr);
+    });
+}
+
+std::vector<std::vector<char>> AsyncFileReader::readAll(const std::vector<std::string> &filePaths)
+{
+    std::vector<std::future<std::vector<char>>> futures = {};
+    for (const std::string &filePath : filePaths) futures.push_back(read(filePath));
+
+    std::vector<std::vector<char>> files = {};
+    for (std::future<std::vector<char>> &future : futures) files.push_back(future.get());
+    return files;
+}
+
+AsyncFileReaderStats AsyncFileReader::getStats()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return stats;
+}
+
+void AsyncFileReader::destroy()
+{
+    if (!initialized) return;
+    initialized = false;
+
+    // Readers only return once the queue is empty, so every future handed out has been satisfied
+    JobSystem::shared().wait(readerJobs);
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "file-loader.h"
+#include "job-system.h"
+#include <future>
+#include <mutex>
+#include <queue>
+#include <functional>
+
+struct AsyncFileReaderConfig {
+    // The number of files read at once, each read takes a job system worker, 0 uses one per worker
+    uint32_t threadCount = 2U;
+
+    // The number of reads that may wait for a reader, callers queueing more read the oldest queued file themselves
+    uint32_t maxQueuedReads = 64U;
+
+    // How far ahead of the bytes being copied the kernel is asked to read, 0 leaves read-ahead to the kernel
+    uint64_t readAheadBytes = 4U * 1024U * 1024U;
+};
+
+struct AsyncFileReaderStats {
+    // Totals of the completed reads, nanoseconds is the time the readers spent reading
+    FileIOStats reads {};
+    uint32_t failedReads = 0U;
+
+    // The deepest the queue has been, and the number of reads run by callers that found the queue full
+    uint32_t maxQueuedReads = 0U;
+    uint32_t callerReads = 0U;
+};
+
+/**
+ * @class AsyncFileReader
+ *
+ * @brief Reads files into memory as jobs on the shared job system
+ *
+ * Each read maps its file and copies it out a window at a time, asking the kernel to read the window after the one
+ * being copied so that the disk stays busy while the reader copies. At most threadCount reader jobs run at once, each
+ * working through the queue until it is empty, so reads never hold more workers than that. The queue is bounded, a
+ * producer that finds it full reads the oldest queued file itself rather than waiting, which keeps it from queueing
+ * work far ahead of the readers without blocking a worker when the producer is itself a job.
+ */
+class AsyncFileReader {
+    // A queued read, which calls its read callback when run
+    using ReadRequest = std::function<void()>;
+
+    AsyncFileReaderConfig config;
+    bool initialized = false;
+    std::queue<ReadRequest> requests = {};
+    std::mutex requestMutex;
+
+    // The reader jobs working through the queue, activeReaders is guarded by requestMutex
+    uint32_t activeReaders = 0U;
+    JobCounter readerJobs;
+
+    std::mutex statsMutex;
+    AsyncFileReaderStats stats {};
+
+    void readerLoop();
+    void queueRequest(ReadRequest request);
+    std::vector<char> readRange(const std::string &filePath, uint64_t offset, uint64_t size);
+
+    public:
+    // Reads from the offset to the end of the file
+    static const uint64_t wholeFile = UINT64_MAX;
+
+    // Receives the bytes read, or the exception thrown while reading, on the reader's worker
+    using ReadCallback = std::function<void(std::vector<char> data, std::exception_ptr error)>;
+
+    /**
+     * @brief Configures the reader, the reads run on JobSystem::shared
+     */
+    void init(AsyncFileReaderConfig config = AsyncFileReaderConfig{});
+
+    /**
+     * @brief Queues a file, or a range of it, to be read by a reader job
+     *
+     * @note Reads the oldest queued file on the calling thread while the queue holds maxQueuedReads reads
+     *
+     * @return A future that holds the bytes read, or the exception thrown while reading
+     */
+    std::future<std::vector<char>> read(const std::string &filePath, uint64_t offset = 0U, uint64_t size = wholeFile);
+
+    /**
+     * @brief Queues a file, or a range of it, to be read by a reader job, calling onComplete once it has been read
+     *
+     * onComplete runs on the reader's worker, so it should hand any lengthy work off rather than hold up later reads. An
+     * exception thrown by onComplete is rethrown by destroy.
+     *
+     * @note Reads the oldest queued file on the calling thread while the queue holds maxQueuedReads reads
+     */
+    void read(const std::string &filePath, ReadCallback onComplete, uint64_t offset = 0U, uint64_t size = wholeFile);
+
+    /**
+     * @brief Reads a batch of files in parallel, blocking until all of them are read
+     *
+     * @return The files' contents, in the same order as the file paths
+     */
+    std::vector<std::vector<char>> readAll(const std::vector<std::string> &filePaths);
+
+    AsyncFileReaderStats getStats();
+
+    uint32_t getThreadCount() { return config.threadCount; }
+
+    /**
+     * @brief Finishes any queued reads, waiting on the reader jobs
+     *
+     * @note Rethrows the first exception thrown by a read callback
+     */
+    void destroy();
+
+    ~AsyncFileReader()
+    {
+        // Nothing is left to report a callback's exception to
+        try { destroy(); } catch (...) {}
+    }
+};
@@ -1,16 +1,182 @@
 #include "file-loader.h"
+#include "asset-archive.h"
 #include <fstream>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <filesystem>
+#include <cstring>
+
+static std::mutex statsMutex;
+static FileIOStats readStats {};
+static FileIOStats mapStats {};
+static FileIOStats archiveStats {};
+
+struct MountedArchive {
+    std::unique_ptr<AssetArchive> archive;
+    std::filesystem::path mountDirectory;
+    std::filesystem::file_time_type lastWriteTime;
+};
+static std::mutex archiveMutex;
+static std::vector<MountedArchive> mountedArchives = {};
+
+static void recordFile(FileIOStats &stats, bool opened, uint64_t bytes, std::chrono::steady_clock::time_point start)
+{
+    uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    if (!opened) {
+        stats.failedOpens++;
+        return;
+    }
+    stats.files++;
+    stats.bytes += bytes;
+    stats.nanoseconds += nanoseconds;
+}
+
+/**
+ * Finds a file in the mounted archives, returning a view that is not open if none of them hold it
+ *
+ * @param lastWriteTime Set to the last write time of the archive holding the file, if any, may be nullptr
+ */
+static MappedFile findInArchives(const std::string &filename, std::filesystem::file_time_type* lastWriteTime = nullptr)
+{
+    std::lock_guard<std::mutex> lock(archiveMutex);
+    if (mountedArchives.empty()) return MappedFile();
+
+    // Archives are keyed by paths relative to their root, so "../images/a.jpg" and "images/a.jpg" find the same file
+    std::filesystem::path absolutePath = std::filesystem::absolute(filename).lexically_normal();
+    for (const MountedArchive &mounted : mountedArchives) {
+        std::filesystem::path relativePath = absolutePath.lexically_relative(mounted.mountDirectory);
+        if (relativePath.empty() || *relativePath.begin() == "..") continue;
+
+        MappedFile file = mounted.archive->find(relativePath.generic_string());
+        if (file.isOpen()) {
+            if (lastWriteTime != nullptr) *lastWriteTime = mounted.lastWriteTime;
+            return file;
+        }
+    }
+    return MappedFile();
+}
 
 std::vector<char> FileLoader::loadFile(const std::string filename)
 {
+    auto start = std::chrono::steady_clock::now();
+
+    MappedFile archived = findInArchives(filename);
+    if (archived.isOpen()) {
+        std::vector<char> fileData(archived.data(), archived.data() + archived.size());
+        recordFile(archiveStats, true, fileData.size(), start);
+        return fileData;
+    }
+
     std::vector<char> fileData;
     std::ifstream file(filename, std::ios::binary | std::ios::ate);
-    bool open = file.is_open();
-    if (open) {
-        size_t fileSize = (size_t)file.tellg();
-        fileData.resize(fileSize);
-        file.seekg(0);
-        file.read(fileData.data(), fileSize);
+    if (!file.is_open()) {
+        recordFile(readStats, false, 0U, start);
         return fileData;
     }
-}
\ No newline at end of file
+
+    size_t fileSize = (size_t)file.tellg();
+    fileData.resize(fileSize);
+    file.seekg(0);
+    file.read(fileData.data(), fileSize);
+    if (!file) {
+        // A short read is reported the same way as a failed open, rather than handing back a truncated file
+        recordFile(readStats, false, 0U, start);
+        return std::vector<char>();
+    }
+
+    recordFile(readStats, true, fileSize, start);
+    return fileData;
+}
+
+MappedFile FileLoader::mapFile(const std::string &filename, FileAccessPattern accessPattern)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    MappedFile archived = findInArchives(filename);
+    if (archived.isOpen()) {
+        archived.advise(accessPattern);
+        recordFile(archiveStats, true, archived.size(), start);
+        return archived;
+    }
+
+    MappedFile file;
+    try {
+        file.open(filename, accessPattern);
+    }
+    catch (...) {
+        recordFile(mapStats, false, 0U, start);
+        throw;
+    }
+
+    recordFile(mapStats, true, file.size(), start);
+    return file;
+}
+
+bool FileLoader::exists(const std::string &filename)
+{
+    return isArchived(filename) || std::filesystem::exists(filename);
+}
+
+bool FileLoader::isArchived(const std::string &filename)
+{
+    return findInArchives(filename).isOpen();
+}
+
+std::optional<std::filesystem::file_time_type> FileLoader::getLastWriteTime(const std::string &filename)
+{
+    std::filesystem::file_time_type lastWriteTime;
+    if (findInArchives(filename, &lastWriteTime).isOpen()) return lastWriteTime;
+
+    std::error_code error;
+    lastWriteTime = std::filesystem::last_write_time(filename, error);
+    if (error) return std::nullopt;
+    return lastWriteTime;
+}
+
+bool FileLoader::isCurrent(const std::string &derivedPath, const std::string &sourcePath)
+{
+    std::optional<std::filesystem::file_time_type> derivedTime = getLastWriteTime(derivedPath);
+    if (!derivedTime) return false;
+
+    std::optional<std::filesystem::file_time_type> sourceTime = getLastWriteTime(sourcePath);
+    return !sourceTime || *derivedTime >= *sourceTime;
+}
+
+FileIOStats FileLoader::getReadStats()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return readStats;
+}
+
+FileIOStats FileLoader::getMapStats()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return mapStats;
+}
+
+FileIOStats FileLoader::getArchiveStats()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return archiveStats;
+}
+
+void FileLoader::mountArchive(const std::string &archivePath, const std::string &mountDirectory)
+{
+    std::unique_ptr<AssetArchive> archive = std::make_unique<AssetArchive>();
+    archive->open(archivePath);
+
+    // Archives hold no time per file, every file in one is as new as the archive
+    std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(archivePath);
+
+    std::lock_guard<std::mutex> lock(archiveMutex);
+    mountedArchives.push_back({std::move(archive), std::filesystem::absolute(mountDirectory).lexically_normal(), lastWriteTime});
+}
+
+void FileLoader::unmountArchives()
+{
+    std::lock_guard<std::mutex> lock(archiveMutex);
+    mountedArchives.clear();
+}
@@ -1,8 +1,93 @@
 #pragma once
+#include "mapped-file.h"
 #include <vector>
 #include <string>
+#include <optional>
+#include <filesystem>
 
+struct FileIOStats {
+    uint32_t files = 0U;
+    uint64_t bytes = 0U;
+    // Time spent opening and reading, or opening and mapping, the files
+    uint64_t nanoseconds = 0U;
+    uint32_t failedOpens = 0U;
+
+    double getMegabytesPerSecond() const { return nanoseconds == 0U ? 0.0 : (bytes / (1024.0 * 1024.0)) / (nanoseconds * 1e-9); }
+};
+
+/**
+ * @class FileLoader
+ *
+ * @brief Loads files from disk, or from the asset archives that have been mounted
+ *
+ * Files inside a mounted archive's directory are looked up in the archive first and fall back to disk, so callers
+ * load by the same relative paths whether or not the assets have been packed.
+ */
 class FileLoader {
     public:
+    /**
+     * @brief Reads a whole file into memory
+     *
+     * @return The file's contents, or an empty vector if the file could not be opened or read
+     */
     static std::vector<char> loadFile(const std::string filename);
-};
\ No newline at end of file
+
+    /**
+     * @brief Maps a whole file read-only, for consumers that parse it in place rather than keeping a copy
+     *
+     * @note Throws if the file cannot be opened or mapped
+     */
+    static MappedFile mapFile(const std::string &filename, FileAccessPattern accessPattern = FileAccessPattern::NORMAL);
+
+    /**
+     * @brief Whether a file can be loaded, from a mounted archive or from disk
+     */
+    static bool exists(const std::string &filename);
+
+    /**
+     * @brief Whether a file is served from a mounted archive, where nothing can be written beside it
+     */
+    static bool isArchived(const std::string &filename);
+
+    /**
+     * @brief Gets when a file was last written, a file served from an archive was last written when the archive was
+     *
+     * @return The time, or nothing if the file can neither be found in a mounted archive nor on disk
+     */
+    static std::optional<std::filesystem::file_time_type> getLastWriteTime(const std::string &filename);
+
+    /**
+     * @brief Whether a file derived from a source, such as a cache, exists and was written after the source
+     *
+     * A source that cannot be found, such as one only shipped in its derived form, never outdates the derived file.
+     */
+    static bool isCurrent(const std::string &derivedPath, const std::string &sourcePath);
+
+    /**
+     * @brief Serves the files an archive holds from it, archives mounted first are searched first
+     *
+     * @param mountDirectory The directory the archive's paths are relative to
+     *
+     * @note Views returned by mapFile for archived files are only valid until the archive is unmounted
+     */
+    static void mountArchive(const std::string &archivePath, const std::string &mountDirectory);
+
+    static void unmountArchives();
+
+    /**
+     * @brief Gets the totals of every loadFile call, across all threads
+     */
+    static FileIOStats getReadStats();
+
+    /**
+     * @brief Gets the totals of every mapFile call, across all threads
+     *
+     * @note Mapping reads nothing up front, the bytes are those mapped rather than those the consumers touched
+     */
+    static FileIOStats getMapStats();
+
+    /**
+     * @brief Gets the totals of the loadFile and mapFile calls that were served from a mounted archive
+     */
+    static FileIOStats getArchiveStats();
+};
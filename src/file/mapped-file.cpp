@@ -0,0 +1,172 @@
+#include "mapped-file.h"
+#include <stdexcept>
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this == &other) return *this;
+    close();
+
+    mappedData = std::exchange(other.mappedData, nullptr);
+    fileSize = std::exchange(other.fileSize, 0U);
+    opened = std::exchange(other.opened, false);
+    ownsMapping = std::exchange(other.ownsMapping, true);
+    #ifdef _WIN32
+    fileHandle = std::exchange(other.fileHandle, nullptr);
+    mappingHandle = std::exchange(other.mappingHandle, nullptr);
+    #endif
+    return *this;
+}
+
+MappedFile MappedFile::view(const char* data, size_t size)
+{
+    MappedFile file;
+    file.mappedData = data;
+    file.fileSize = size;
+    file.opened = true;
+    file.ownsMapping = false;
+    return file;
+}
+
+#ifdef _WIN32
+
+void MappedFile::open(const std::string &filePath, FileAccessPattern accessPattern)
+{
+    close();
+
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (accessPattern == FileAccessPattern::SEQUENTIAL) flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    else if (accessPattern == FileAccessPattern::RANDOM) flags |= FILE_FLAG_RANDOM_ACCESS;
+
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Failed to open file: " + filePath);
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw std::runtime_error("Failed to get the size of file: " + filePath);
+    }
+    fileHandle = file;
+    fileSize = static_cast<size_t>(size.QuadPart);
+    opened = true;
+    if (fileSize == 0U) return;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0U, 0U, nullptr);
+    if (mapping == nullptr) {
+        close();
+        throw std::runtime_error("Failed to map file: " + filePath);
+    }
+    mappingHandle = mapping;
+
+    mappedData = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0U, 0U, 0U));
+    if (mappedData == nullptr) {
+        close();
+        throw std::runtime_error("Failed to map file: " + filePath);
+    }
+
+    if (accessPattern == FileAccessPattern::WILL_NEED) advise(accessPattern);
+}
+
+void MappedFile::advise(FileAccessPattern accessPattern, size_t offset, size_t size)
+{
+    if (mappedData == nullptr || offset >= fileSize || accessPattern != FileAccessPattern::WILL_NEED) return;
+
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<char*>(mappedData) + offset;
+    range.NumberOfBytes = std::min(size, fileSize - offset);
+    PrefetchVirtualMemory(GetCurrentProcess(), 1U, &range, 0U);
+}
+
+void MappedFile::close()
+{
+    if (mappedData != nullptr && ownsMapping) UnmapViewOfFile(mappedData);
+    if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+    if (fileHandle != nullptr) CloseHandle(fileHandle);
+    mappedData = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+    fileSize = 0U;
+    opened = false;
+    ownsMapping = true;
+}
+
+#else
+
+static int getAdvice(FileAccessPattern accessPattern)
+{
+    switch (accessPattern) {
+        case FileAccessPattern::SEQUENTIAL: return MADV_SEQUENTIAL;
+        case FileAccessPattern::RANDOM: return MADV_RANDOM;
+        case FileAccessPattern::WILL_NEED: return MADV_WILLNEED;
+        default: return MADV_NORMAL;
+    }
+}
+
+void MappedFile::open(const std::string &filePath, FileAccessPattern accessPattern)
+{
+    close();
+
+    int file = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) throw std::runtime_error("Failed to open file: " + filePath);
+
+    struct stat fileStatus;
+    if (fstat(file, &fileStatus) != 0) {
+        ::close(file);
+        throw std::runtime_error("Failed to get the size of file: " + filePath);
+    }
+    fileSize = static_cast<size_t>(fileStatus.st_size);
+
+    // The mapping keeps its own reference to the file, so the descriptor is not needed past this point
+    if (fileSize > 0U) {
+        void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(file);
+            fileSize = 0U;
+            throw std::runtime_error("Failed to map file: " + filePath);
+        }
+        mappedData = static_cast<const char*>(mapping);
+    }
+    ::close(file);
+    opened = true;
+
+    advise(accessPattern);
+}
+
+void MappedFile::advise(FileAccessPattern accessPattern, size_t offset, size_t size)
+{
+    if (mappedData == nullptr || offset >= fileSize) return;
+
+    // madvise takes page aligned addresses, views need not start on a page boundary so the address itself is aligned
+    uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start = reinterpret_cast<uintptr_t>(mappedData) + offset;
+    uintptr_t alignedStart = start - start % pageSize;
+    size_t alignedSize = std::min(size, fileSize - offset) + (start - alignedStart);
+    madvise(reinterpret_cast<void*>(alignedStart), alignedSize, getAdvice(accessPattern));
+}
+
+void MappedFile::close()
+{
+    if (mappedData != nullptr && ownsMapping) munmap(const_cast<char*>(mappedData), fileSize);
+    mappedData = nullptr;
+    fileSize = 0U;
+    opened = false;
+    ownsMapping = true;
+}
+
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * How a mapped range is expected to be read, passed on to the kernel as a madvise hint
+ */
+enum class FileAccessPattern {
+    NORMAL,
+    // Read front to back once, the kernel reads ahead aggressively and drops pages behind the reader
+    SEQUENTIAL,
+    // Read in small scattered pieces, the kernel does not read ahead
+    RANDOM,
+    // Read soon, the kernel starts reading the range in the background
+    WILL_NEED
+};
+
+/**
+ * @class MappedFile
+ *
+ * @brief A read-only memory mapping of a whole file
+ *
+ * Pages are read from disk the first time they are touched, so consumers that only look at part of a file (such as
+ * the mip tail of a KTX2 file) never read the rest, and nothing is copied into an intermediate buffer. The mapping is
+ * released when the MappedFile is destroyed or moved from, any pointer into it must not outlive it.
+ *
+ * @note On Windows the hints other than WILL_NEED have no effect
+ */
+class MappedFile {
+    const char* mappedData = nullptr;
+    size_t fileSize = 0U;
+    // Empty files cannot be mapped, so they are open without a mapping
+    bool opened = false;
+    // Views of memory mapped elsewhere, such as a file in a mounted archive, do not unmap it
+    bool ownsMapping = true;
+    #ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+    #endif
+
+    public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile& operator=(MappedFile &&other) noexcept;
+    ~MappedFile() { close(); }
+
+    /**
+     * @brief Maps a file, throwing if it cannot be opened or mapped
+     *
+     * @param accessPattern The hint given for the whole file, see advise
+     */
+    void open(const std::string &filePath, FileAccessPattern accessPattern = FileAccessPattern::NORMAL);
+
+    /**
+     * @brief Wraps memory that is already mapped, which must outlive the returned view
+     */
+    static MappedFile view(const char* data, size_t size);
+
+    /**
+     * @brief Hints how a range of the file will be read, ranges are widened to whole pages
+     */
+    void advise(FileAccessPattern accessPattern, size_t offset = 0U, size_t size = SIZE_MAX);
+
+    void close();
+
+    bool isOpen() const { return opened; }
+
+    const char* data() const { return mappedData; }
+    size_t size() const { return fileSize; }
+};
@@ -0,0 +1,56 @@
+#include "asset-archive.h"
+#include "file-loader.h"
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * Packs files, and every file under directories, into an asset archive
+ *
+ * Usage: pack-assets <output archive> <root directory> <path relative to the root>...
+ */
+int main(int argc, char** argv)
+{
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <output archive> <root directory> <path relative to the root>..." << std::endl;
+        return 1;
+    }
+    std::filesystem::path root = argv[2];
+
+    try {
+        std::vector<std::filesystem::path> filePaths = {};
+        for (int i = 3 ; i < argc ; i++) {
+            std::filesystem::path path = root / argv[i];
+            if (std::filesystem::is_directory(path)) {
+                for (const std::filesystem::directory_entry &entry : std::filesystem::recursive_directory_iterator(path)) {
+                    if (entry.is_regular_file()) filePaths.push_back(entry.path());
+                }
+            } else {
+                filePaths.push_back(path);
+            }
+        }
+
+        // Sorted so that packing the same files always writes the same archive
+        std::sort(filePaths.begin(), filePaths.end());
+
+        AssetArchiveWriter writer;
+        for (const std::filesystem::path &filePath : filePaths) {
+            std::vector<char> data = FileLoader::loadFile(filePath.string());
+            if (data.empty() && !std::filesystem::is_regular_file(filePath)) throw std::runtime_error("Failed to read " + filePath.string());
+            writer.addFile(filePath.lexically_relative(root).generic_string(), std::move(data));
+        }
+        uint64_t archiveSize = writer.write(argv[1]);
+
+        AssetArchive archive;
+        archive.open(argv[1]);
+        if (!archive.verify().empty()) throw std::runtime_error("Failed to verify the written archive");
+
+        std::cout << "Packed " << filePaths.size() << " files into " << argv[1] << " (" << archiveSize << " bytes)" << std::endl;
+    }
+    catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,8 +1,17 @@
 #include "file-utilities.h"
 #include <fstream>
-#include "turbojpeg.h"
+#include <stdexcept>
 
 std::vector<char> readFile(const std::string filename)
 {
-    
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) throw std::runtime_error("Failed to open file: " + filename);
+
+    size_t fileSize = (size_t)file.tellg();
+    std::vector<char> fileData(fileSize);
+    file.seekg(0);
+    file.read(fileData.data(), fileSize);
+    if (!file) throw std::runtime_error("Failed to read file: " + filename);
+
+    return fileData;
 }
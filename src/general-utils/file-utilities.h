@@ -3,6 +3,11 @@
 #include <string>
 #include <inttypes.h>
 
+/**
+ * @brief Reads a whole file into memory, such as shader byte code the application cannot run without
+ * 
+ * @note Throws if the file cannot be opened or read
+ */
 std::vector<char> readFile(const std::string filename);
 
 /**
@@ -0,0 +1,52 @@
+#pragma once
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLOAT4_SSE2
+#include <emmintrin.h>
+#endif
+
+/**
+ * Four floats processed in lock-step. Maps onto an SSE register when available, otherwise onto a plain array
+ * that the compiler is free to vectorize, so kernels are written once against this type.
+ */
+struct Float4 {
+#ifdef FLOAT4_SSE2
+    __m128 v;
+
+    static Float4 load(const float* p) { return {_mm_loadu_ps(p)}; }
+    static Float4 splat(float f) { return {_mm_set1_ps(f)}; }
+    void store(float* p) const { _mm_storeu_ps(p, v); }
+
+    friend Float4 operator+(Float4 a, Float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+    friend Float4 operator-(Float4 a, Float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+    friend Float4 operator*(Float4 a, Float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+    friend Float4 operator/(Float4 a, Float4 b) { return {_mm_div_ps(a.v, b.v)}; }
+    friend Float4 sqrt(Float4 a) { return {_mm_sqrt_ps(a.v)}; }
+    friend Float4 max(Float4 a, Float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+
+    // Returns 1 for positive lanes, -1 for negative lanes and 0 for zero lanes
+    friend Float4 sign(Float4 a) {
+        __m128 zero = _mm_setzero_ps();
+        __m128 one = _mm_set1_ps(1.f);
+        return {_mm_sub_ps(_mm_and_ps(_mm_cmpgt_ps(a.v, zero), one), _mm_and_ps(_mm_cmplt_ps(a.v, zero), one))};
+    }
+#else
+    float v[4];
+
+    static Float4 load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+    static Float4 splat(float f) { return {{f, f, f, f}}; }
+    void store(float* p) const { for (int i = 0 ; i < 4 ; i++) p[i] = v[i]; }
+
+    template <typename Op>
+    static Float4 apply(Float4 a, Float4 b, Op op) { Float4 r; for (int i = 0 ; i < 4 ; i++) r.v[i] = op(a.v[i], b.v[i]); return r; }
+
+    friend Float4 operator+(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x + y; }); }
+    friend Float4 operator-(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x - y; }); }
+    friend Float4 operator*(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x * y; }); }
+    friend Float4 operator/(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x / y; }); }
+    friend Float4 sqrt(Float4 a) { return apply(a, a, [](float x, float) { return std::sqrt(x); }); }
+    friend Float4 max(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x > y ? x : y; }); }
+    friend Float4 sign(Float4 a) { return apply(a, a, [](float x, float) { return x > 0.f ? 1.f : (x < 0.f ? -1.f : 0.f); }); }
+#endif
+};
@@ -0,0 +1,75 @@
+#include "job-system.h"
+#include <iostream>
+#include <chrono>
+#include <atomic>
+
+/**
+ * Measures the scheduling overhead of the job system, every job does no work so the time per job is all overhead
+ *
+ * Usage: job-system-benchmark [job count] [thread count]
+ */
+static double nanosecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t jobCount = argc > 1 ? std::stoul(argv[1]) : 1000000U;
+    JobSystemConfig config;
+    config.threadCount = argc > 2 ? std::stoul(argv[2]) : 0U;
+
+    JobSystem jobSystem;
+    jobSystem.init(config);
+    std::cout << jobSystem.getThreadCount() << " workers, " << jobCount << " jobs" << std::endl;
+
+    std::atomic<uint32_t> executed {0U};
+
+    // Independent jobs submitted from outside the pool, through the shared queue
+    auto start = std::chrono::steady_clock::now();
+    JobCounter counter;
+    for (uint32_t i = 0U ; i < jobCount ; i++) jobSystem.run([&executed]() { executed.fetch_add(1U, std::memory_order_relaxed); }, &counter);
+    jobSystem.wait(counter);
+    std::cout << "run from main thread:     " << nanosecondsSince(start) / jobCount << " ns/job" << std::endl;
+
+    // Jobs submitted by a job, which go to a worker's own deque and are stolen from there
+    start = std::chrono::steady_clock::now();
+    JobCounter spawnCounter;
+    jobSystem.run([&]() {
+        for (uint32_t i = 0U ; i < jobCount ; i++) jobSystem.run([&executed]() { executed.fetch_add(1U, std::memory_order_relaxed); }, &spawnCounter);
+    }, &spawnCounter);
+    jobSystem.wait(spawnCounter);
+    std::cout << "run from worker:          " << nanosecondsSince(start) / jobCount << " ns/job" << std::endl;
+
+    // Every element as its own subrange, then the adaptive grain
+    start = std::chrono::steady_clock::now();
+    jobSystem.parallelFor(0U, jobCount, [&executed](uint32_t first, uint32_t last) { executed.fetch_add(last - first, std::memory_order_relaxed); }, 1U);
+    std::cout << "parallelFor, grain 1:     " << nanosecondsSince(start) / jobCount << " ns/element" << std::endl;
+
+    uint64_t submittedBefore = jobSystem.getStats().submittedJobs;
+    start = std::chrono::steady_clock::now();
+    jobSystem.parallelFor(0U, jobCount, [&executed](uint32_t first, uint32_t last) { executed.fetch_add(last - first, std::memory_order_relaxed); });
+    std::cout << "parallelFor, adaptive:    " << nanosecondsSince(start) / jobCount << " ns/element, "
+        << jobSystem.getStats().submittedJobs - submittedBefore << " jobs" << std::endl;
+
+    // A chain of dependent jobs, each only runnable once the previous one has finished
+    uint32_t chainLength = std::min(jobCount, 100000U);
+    start = std::chrono::steady_clock::now();
+    std::vector<JobCounter> chain(chainLength);
+    jobSystem.run([&executed]() { executed.fetch_add(1U, std::memory_order_relaxed); }, &chain[0]);
+    for (uint32_t i = 1U ; i < chainLength ; i++) {
+        jobSystem.runAfter(chain[i - 1U], [&executed]() { executed.fetch_add(1U, std::memory_order_relaxed); }, &chain[i]);
+    }
+    jobSystem.wait(chain.back());
+    std::cout << "dependency chain:         " << nanosecondsSince(start) / chainLength << " ns/job" << std::endl;
+
+    JobSystemStats stats = jobSystem.getStats();
+    std::cout << stats.executedJobs << " jobs executed, " << stats.stolenJobs << " stolen, " << stats.deferredJobs << " deferred" << std::endl;
+
+    uint64_t expected = 4ULL * jobCount + chainLength;
+    if (executed.load() != expected) {
+        std::cerr << "Expected " << expected << " executions, counted " << executed.load() << std::endl;
+        return 1;
+    }
+    return 0;
+}
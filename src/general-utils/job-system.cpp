@@ -0,0 +1,293 @@
+#include "job-system.h"
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#endif
+
+struct Job {
+    JobSystem::JobFunction function;
+    JobCounter* counter;
+};
+
+// The number of times an idle worker looks for a job before it sleeps
+static const uint32_t idleSpinCount = 64U;
+
+// The job system the current thread is a worker of, if any, and its index within that system
+static thread_local JobSystem* currentSystem = nullptr;
+static thread_local uint32_t currentWorker = 0U;
+
+// Picks the first victim of a steal, xorshift is plenty to spread thieves across the deques
+static uint32_t nextRandom()
+{
+    static thread_local uint32_t state = std::hash<std::thread::id>()(std::this_thread::get_id()) | 1U;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+void JobSystem::init(JobSystemConfig config)
+{
+    this->config = config;
+    uint32_t hardwareThreads = std::max(1U, std::thread::hardware_concurrency());
+    uint32_t threadCount = config.threadCount == 0U ? std::max(1U, hardwareThreads - 1U) : config.threadCount;
+
+    stopping = false;
+    for (uint32_t i = 0U ; i < threadCount ; i++) {
+        deques.push_back(std::make_unique<WorkStealingDeque<Job*>>(config.dequeCapacity));
+    }
+    for (uint32_t i = 0U ; i < threadCount ; i++) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+        if (config.pinThreads) pinThread(workers.back(), i);
+    }
+}
+
+void JobSystem::pinThread(std::thread &thread, uint32_t workerIndex)
+{
+    // Worker i takes hardware thread i + 1, leaving the first to the main thread
+    uint32_t hardwareThread = (workerIndex + 1U) % std::max(1U, std::thread::hardware_concurrency());
+#ifdef _WIN32
+    SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << (hardwareThread % (sizeof(DWORD_PTR) * 8U)));
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(hardwareThread, &cpuSet);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet);
+#endif
+}
+
+void JobSystem::workerLoop(uint32_t workerIndex)
+{
+    currentSystem = this;
+    currentWorker = workerIndex;
+
+    uint32_t idleSpins = 0U;
+    while (true) {
+        Job* job = findJob();
+        if (job != nullptr) {
+            execute(job);
+            idleSpins = 0U;
+            continue;
+        }
+
+        // Only exit once every queued job has been taken, so every counter handed out eventually reaches zero
+        if (stopping.load(std::memory_order_acquire)) {
+            if (pendingJobs.load(std::memory_order_acquire) <= 0) return;
+            continue;
+        }
+
+        if (++idleSpins < idleSpinCount) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepingWorkers++;
+        jobAvailable.wait(lock, [this]() { return stopping.load() || pendingJobs.load() > 0; });
+        sleepingWorkers--;
+        idleSpins = 0U;
+    }
+}
+
+void JobSystem::schedule(Job* job)
+{
+    if (currentSystem == this) {
+        deques[currentWorker]->push(job);
+    } else {
+        std::lock_guard<std::mutex> lock(injectedMutex);
+        injectedJobs.push_back(job);
+    }
+
+    // Counted before checking for sleepers, a worker about to sleep either sees the job or is woken
+    pendingJobs.fetch_add(1);
+    if (sleepingWorkers.load() > 0U) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        jobAvailable.notify_one();
+    }
+}
+
+Job* JobSystem::findJob()
+{
+    Job* job = nullptr;
+    bool isWorker = currentSystem == this;
+    if (isWorker && deques[currentWorker]->pop(job)) {
+        pendingJobs.fetch_sub(1);
+        return job;
+    }
+    if (pendingJobs.load(std::memory_order_relaxed) <= 0) return nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(injectedMutex);
+        if (!injectedJobs.empty()) {
+            job = injectedJobs.front();
+            injectedJobs.pop_front();
+            pendingJobs.fetch_sub(1);
+            return job;
+        }
+    }
+
+    uint32_t dequeCount = deques.size();
+    uint32_t firstVictim = nextRandom() % dequeCount;
+    for (uint32_t i = 0U ; i < dequeCount ; i++) {
+        uint32_t victim = (firstVictim + i) % dequeCount;
+        if (isWorker && victim == currentWorker) continue;
+        if (deques[victim]->steal(job)) {
+            pendingJobs.fetch_sub(1);
+            stolenJobs.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::execute(Job* job)
+{
+    // A job that throws still finishes, so its counter reaches zero and the waiter sees the exception
+    try {
+        job->function();
+    }
+    catch (...) {
+        fail(job->counter, std::current_exception());
+    }
+    if (job->counter != nullptr) finish(*job->counter);
+    delete job;
+    executedJobs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void JobSystem::finish(JobCounter &counter)
+{
+    // The count only reaches zero under the lock, so a waiter that takes the lock after seeing zero knows this thread
+    // is done with the counter and may destroy it
+    std::vector<Job*> readyJobs = {};
+    {
+        std::lock_guard<std::mutex> lock(counter.waitingMutex);
+        if (counter.count.fetch_sub(1U, std::memory_order_acq_rel) == 1U) readyJobs.swap(counter.waitingJobs);
+    }
+    for (Job* job : readyJobs) schedule(job);
+}
+
+void JobSystem::fail(JobCounter* counter, std::exception_ptr exception)
+{
+    failedJobs.fetch_add(1, std::memory_order_relaxed);
+    if (counter == nullptr) return;
+
+    std::lock_guard<std::mutex> lock(counter->waitingMutex);
+    if (!counter->exception) counter->exception = exception;
+}
+
+void JobSystem::run(JobFunction function, JobCounter* counter)
+{
+    if (workers.empty()) throw std::runtime_error("Failed to run job, job system not initialized");
+
+    if (counter != nullptr) counter->count.fetch_add(1U, std::memory_order_relaxed);
+    submittedJobs.fetch_add(1, std::memory_order_relaxed);
+    schedule(new Job{std::move(function), counter});
+}
+
+void JobSystem::runAfter(JobCounter &dependency, JobFunction function, JobCounter* counter)
+{
+    if (workers.empty()) throw std::runtime_error("Failed to run job, job system not initialized");
+
+    if (counter != nullptr) counter->count.fetch_add(1U, std::memory_order_relaxed);
+    submittedJobs.fetch_add(1, std::memory_order_relaxed);
+    Job* job = new Job{std::move(function), counter};
+    {
+        std::lock_guard<std::mutex> lock(dependency.waitingMutex);
+        if (!dependency.isDone()) {
+            dependency.waitingJobs.push_back(job);
+            deferredJobs.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    schedule(job);
+}
+
+void JobSystem::processRange(uint32_t first, uint32_t last, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)> &function, JobCounter &counter)
+{
+    while (first < last) {
+        if (last - first > grainSize && pendingJobs.load(std::memory_order_relaxed) < static_cast<int64_t>(workers.size())) {
+            uint32_t middle = first + (last - first) / 2U;
+            run([this, middle, last, grainSize, &function, &counter]() { processRange(middle, last, grainSize, function, counter); }, &counter);
+            last = middle;
+            continue;
+        }
+
+        uint32_t grainLast = std::min(last, first + grainSize);
+        function(first, grainLast);
+        first = grainLast;
+    }
+}
+
+void JobSystem::parallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t first, uint32_t last)> &function, uint32_t grainSize)
+{
+    if (begin >= end) return;
+
+    // Splitting adapts to idle workers, so the default grain only needs to be small enough to balance the tail
+    if (grainSize == 0U) grainSize = std::max(1U, (end - begin) / ((getThreadCount() + 1U) * 32U));
+
+    // The jobs split off reference the counter and function, so they must finish before an exception leaves this frame
+    JobCounter counter;
+    try {
+        processRange(begin, end, grainSize, function, counter);
+    }
+    catch (...) {
+        fail(&counter, std::current_exception());
+    }
+    wait(counter);
+}
+
+void JobSystem::wait(JobCounter &counter)
+{
+    while (!counter.isDone()) {
+        Job* job = findJob();
+        if (job != nullptr) execute(job);
+        else std::this_thread::yield();
+    }
+
+    // Wait for the thread that finished the last job to release the counter
+    std::exception_ptr exception = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(counter.waitingMutex);
+        std::swap(exception, counter.exception);
+    }
+    if (exception) std::rethrow_exception(exception);
+}
+
+JobSystemStats JobSystem::getStats()
+{
+    JobSystemStats stats;
+    stats.submittedJobs = submittedJobs.load(std::memory_order_relaxed);
+    stats.executedJobs = executedJobs.load(std::memory_order_relaxed);
+    stats.stolenJobs = stolenJobs.load(std::memory_order_relaxed);
+    stats.deferredJobs = deferredJobs.load(std::memory_order_relaxed);
+    stats.failedJobs = failedJobs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void JobSystem::destroy()
+{
+    if (workers.empty()) return;
+
+    stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        jobAvailable.notify_all();
+    }
+
+    for (std::thread &worker : workers) worker.join();
+    workers.clear();
+    deques.clear();
+}
+
+JobSystem& JobSystem::shared()
+{
+    static JobSystem jobSystem;
+    static std::once_flag started;
+    std::call_once(started, []() { jobSystem.init(); });
+    return jobSystem;
+}
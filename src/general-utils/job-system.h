@@ -0,0 +1,200 @@
+#pragma once
+#include "work-stealing-deque.h"
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+// A job and the counter it decrements once finished, defined in job-system.cpp
+struct Job;
+
+/**
+ * @class JobCounter
+ *
+ * @brief Counts the unfinished jobs that were run with it, jobs can be held back until a counter reaches zero
+ *
+ * The first exception thrown by a job run with the counter is kept and rethrown by JobSystem::wait.
+ *
+ * @note A counter must outlive the jobs run with it and the jobs waiting on it
+ */
+class JobCounter {
+    friend class JobSystem;
+
+    std::atomic<uint32_t> count {0U};
+
+    // Jobs run after this counter, scheduled once it reaches zero
+    std::mutex waitingMutex;
+    std::vector<Job*> waitingJobs = {};
+
+    // The first exception thrown by one of the jobs, guarded by waitingMutex
+    std::exception_ptr exception = nullptr;
+
+    public:
+    bool isDone() const { return count.load(std::memory_order_acquire) == 0U; }
+};
+
+struct JobSystemConfig {
+    // The number of worker threads, 0 uses one per hardware thread other than the main thread's
+    uint32_t threadCount = 0U;
+
+    // Whether each worker is pinned to its own hardware thread, which keeps its caches warm at the cost of being
+    // unable to move away from a busy core
+    bool pinThreads = false;
+
+    // The initial capacity of each worker's deque, they grow when full
+    uint32_t dequeCapacity = 1024U;
+};
+
+struct JobSystemStats {
+    uint64_t submittedJobs = 0U;
+    uint64_t executedJobs = 0U;
+    // Jobs taken from another worker's deque
+    uint64_t stolenJobs = 0U;
+    // Jobs that were held back until the counter they were run after reached zero
+    uint64_t deferredJobs = 0U;
+    // Jobs that threw, including those run without a counter whose exception was dropped
+    uint64_t failedJobs = 0U;
+};
+
+/**
+ * @class JobSystem
+ *
+ * @brief Runs jobs on a pool of worker threads that steal work from each other
+ *
+ * Each worker owns a Chase-Lev deque that the jobs it runs push to and pop from, newest first, so nested work stays on
+ * the thread whose caches hold its data. Idle workers steal the oldest job of a random other worker, which tends to be
+ * the largest remaining piece of work. Jobs submitted from threads outside the pool go to a shared queue.
+ *
+ * Waiting on a counter runs other jobs until it reaches zero rather than blocking, so jobs may wait on the jobs they
+ * run without tying up a worker. A job that blocks on anything else (such as a file read or a future) holds its
+ * worker until it returns, so blocking work should be limited to fewer jobs at a time than there are workers.
+ *
+ * An exception thrown by a job is caught on the worker and rethrown by wait on the job's counter, the exception of a
+ * job run without a counter is only counted in failedJobs.
+ */
+class JobSystem {
+    public:
+    using JobFunction = std::function<void()>;
+
+    private:
+    JobSystemConfig config;
+    std::vector<std::thread> workers = {};
+    std::vector<std::unique_ptr<WorkStealingDeque<Job*>>> deques = {};
+
+    // Jobs submitted from threads outside the pool
+    std::mutex injectedMutex;
+    std::deque<Job*> injectedJobs = {};
+
+    // Idle workers sleep until a job is submitted, pendingJobs counts the jobs that are queued and not yet taken
+    std::atomic<int64_t> pendingJobs {0};
+    std::atomic<uint32_t> sleepingWorkers {0U};
+    std::mutex sleepMutex;
+    std::condition_variable jobAvailable;
+    std::atomic<bool> stopping {false};
+
+    std::atomic<uint64_t> submittedJobs {0U};
+    std::atomic<uint64_t> executedJobs {0U};
+    std::atomic<uint64_t> stolenJobs {0U};
+    std::atomic<uint64_t> deferredJobs {0U};
+    std::atomic<uint64_t> failedJobs {0U};
+
+    void workerLoop(uint32_t workerIndex);
+    void schedule(Job* job);
+    Job* findJob();
+    void execute(Job* job);
+    void finish(JobCounter &counter);
+    void fail(JobCounter* counter, std::exception_ptr exception);
+    void pinThread(std::thread &thread, uint32_t workerIndex);
+    void processRange(uint32_t first, uint32_t last, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)> &function, JobCounter &counter);
+
+    public:
+    /**
+     * @brief Starts the worker threads
+     */
+    void init(JobSystemConfig config = JobSystemConfig{});
+
+    /**
+     * @brief Runs a job on the pool
+     *
+     * @param counter Incremented now and decremented once the job has finished, may be nullptr
+     */
+    void run(JobFunction function, JobCounter* counter = nullptr);
+
+    /**
+     * @brief Runs a job on the pool once every job run with the dependency has finished
+     */
+    void runAfter(JobCounter &dependency, JobFunction function, JobCounter* counter = nullptr);
+
+    /**
+     * @brief Runs a job on the pool that produces a value
+     *
+     * @return A future that holds the job's result, or the exception it threw
+     */
+    template <typename Function>
+    std::future<std::invoke_result_t<Function>> runAsync(Function function, JobCounter* counter = nullptr)
+    {
+        // std::function must be copyable, so the promise is shared with the job rather than moved into it
+        using Result = std::invoke_result_t<Function>;
+        std::shared_ptr<std::promise<Result>> result = std::make_shared<std::promise<Result>>();
+        std::future<Result> future = result->get_future();
+
+        run([function = std::move(function), result]() mutable {
+            try {
+                if constexpr (std::is_void_v<Result>) {
+                    function();
+                    result->set_value();
+                } else {
+                    result->set_value(function());
+                }
+            }
+            catch (...) {
+                result->set_exception(std::current_exception());
+            }
+        }, counter);
+        return future;
+    }
+
+    /**
+     * @brief Calls function over subranges of [begin, end) in parallel, returning once every subrange is done
+     *
+     * The calling thread works through the range a grain at a time. Whenever fewer jobs are queued than there are
+     * workers it first splits off the second half of what remains as a job, and whoever runs that job does the same,
+     * so the range is only divided as finely as there are idle workers to take it.
+     *
+     * @param grainSize The largest subrange function is called with, 0 chooses one from the range and thread count
+     *
+     * @note Rethrows the first exception thrown by function, once every subrange that was started has returned
+     */
+    void parallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t first, uint32_t last)> &function, uint32_t grainSize = 0U);
+
+    /**
+     * @brief Runs jobs until every job run with the counter has finished
+     *
+     * @note Rethrows the first exception thrown by one of the jobs, the counter may be reused afterwards
+     */
+    void wait(JobCounter &counter);
+
+    /**
+     * @brief Gets the number of worker threads, the threads that wait also run jobs
+     */
+    uint32_t getThreadCount() { return workers.size(); }
+
+    JobSystemStats getStats();
+
+    /**
+     * @brief Finishes every queued job and joins the worker threads
+     */
+    void destroy();
+
+    ~JobSystem() { destroy(); }
+
+    /**
+     * @brief Gets the process-wide job system, started with the default configuration on first use
+     */
+    static JobSystem& shared();
+};
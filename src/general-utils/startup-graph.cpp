@@ -0,0 +1,167 @@
+#include "startup-graph.h"
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+
+static double millisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+StartupGraph::TaskId StartupGraph::addTask(const std::string &name, TaskFunction function, std::vector<TaskId> dependencies, StartupThread thread)
+{
+    TaskId id = tasks.size();
+    for (TaskId dependency : dependencies) {
+        if (dependency >= id) throw std::runtime_error("Failed to add startup task " + name + ", it depends on a task that has not been added");
+    }
+
+    tasks.push_back(std::make_unique<Task>());
+    Task &task = *tasks.back();
+    task.name = name;
+    task.function = function;
+    task.thread = thread;
+    task.dependencies = dependencies;
+    task.timing.name = name;
+    for (TaskId dependency : dependencies) tasks[dependency]->dependents.push_back(id);
+    return id;
+}
+
+void StartupGraph::run(JobSystem &jobSystem)
+{
+    this->jobSystem = &jobSystem;
+    finishedTasks = 0U;
+    mainThreadTasks.clear();
+    firstError = nullptr;
+    for (std::unique_ptr<Task> &task : tasks) {
+        task->remainingDependencies.store(task->dependencies.size());
+        task->failed = false;
+        task->timing = StartupTaskTiming {task->name};
+    }
+
+    startTime = std::chrono::steady_clock::now();
+    for (TaskId id = 0U ; id < tasks.size() ; id++) {
+        if (tasks[id]->dependencies.empty()) dispatch(id);
+    }
+
+    while (true) {
+        TaskId id;
+        {
+            std::unique_lock<std::mutex> lock(mainThreadMutex);
+            mainThreadWake.wait(lock, [this]() { return !mainThreadTasks.empty() || finishedTasks == tasks.size(); });
+            if (mainThreadTasks.empty()) break;
+
+            id = mainThreadTasks.back();
+            mainThreadTasks.pop_back();
+        }
+        execute(id);
+    }
+    totalMilliseconds = millisecondsBetween(startTime, std::chrono::steady_clock::now());
+
+    // Mark the critical path, the longest chain of durations. Dependencies always precede their dependents, so one
+    // pass in the order the tasks were added sees every dependency's path before its dependents'
+    std::vector<double> pathMilliseconds(tasks.size(), 0.0);
+    std::vector<TaskId> criticalDependency(tasks.size(), UINT32_MAX);
+    TaskId pathEnd = UINT32_MAX;
+    for (TaskId id = 0U ; id < tasks.size() ; id++) {
+        for (TaskId dependency : tasks[id]->dependencies) {
+            if (criticalDependency[id] == UINT32_MAX || pathMilliseconds[dependency] > pathMilliseconds[criticalDependency[id]]) criticalDependency[id] = dependency;
+        }
+        double dependencyMilliseconds = criticalDependency[id] == UINT32_MAX ? 0.0 : pathMilliseconds[criticalDependency[id]];
+        pathMilliseconds[id] = dependencyMilliseconds + tasks[id]->timing.durationMilliseconds;
+        if (pathEnd == UINT32_MAX || pathMilliseconds[id] > pathMilliseconds[pathEnd]) pathEnd = id;
+    }
+    for (TaskId id = pathEnd ; id != UINT32_MAX ; id = criticalDependency[id]) tasks[id]->timing.onCriticalPath = true;
+
+    if (firstError) std::rethrow_exception(firstError);
+}
+
+void StartupGraph::dispatch(TaskId id)
+{
+    if (tasks[id]->thread == StartupThread::ANY) {
+        jobSystem->run([this, id]() { execute(id); });
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        mainThreadTasks.push_back(id);
+    }
+    mainThreadWake.notify_one();
+}
+
+void StartupGraph::execute(TaskId id)
+{
+    Task &task = *tasks[id];
+
+    // A task whose dependency failed is skipped, and passes the failure on to its own dependents
+    bool skipped = false;
+    for (TaskId dependency : task.dependencies) skipped = skipped || tasks[dependency]->failed;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!skipped) {
+        try {
+            task.function();
+        }
+        catch (...) {
+            task.failed = true;
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!firstError) firstError = std::current_exception();
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    task.failed = task.failed || skipped;
+    task.timing.skipped = skipped;
+    task.timing.ranOnMainThread = task.thread == StartupThread::MAIN;
+    task.timing.startMilliseconds = millisecondsBetween(startTime, start);
+    task.timing.durationMilliseconds = millisecondsBetween(start, end);
+
+    // The last dependency to finish schedules the dependent, the atomic orders this task's writes before its reads
+    for (TaskId dependent : task.dependents) {
+        if (tasks[dependent]->remainingDependencies.fetch_sub(1U, std::memory_order_acq_rel) == 1U) dispatch(dependent);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        finishedTasks++;
+    }
+    mainThreadWake.notify_one();
+}
+
+std::vector<StartupTaskTiming> StartupGraph::getTimings()
+{
+    std::vector<StartupTaskTiming> timings = {};
+    for (std::unique_ptr<Task> &task : tasks) timings.push_back(task->timing);
+    return timings;
+}
+
+double StartupGraph::getCriticalPathMilliseconds()
+{
+    double milliseconds = 0.0;
+    for (std::unique_ptr<Task> &task : tasks) {
+        if (task->timing.onCriticalPath) milliseconds += task->timing.durationMilliseconds;
+    }
+    return milliseconds;
+}
+
+void StartupGraph::printReport(std::ostream &output)
+{
+    std::vector<StartupTaskTiming> timings = getTimings();
+    std::stable_sort(timings.begin(), timings.end(), [](const StartupTaskTiming &a, const StartupTaskTiming &b) {
+        return a.startMilliseconds < b.startMilliseconds;
+    });
+
+    size_t nameWidth = 4U;
+    for (const StartupTaskTiming &timing : timings) nameWidth = std::max(nameWidth, timing.name.size());
+
+    std::ios::fmtflags flags = output.flags();
+    output << std::fixed << std::setprecision(2);
+    output << "Startup took " << totalMilliseconds << " ms, critical path (*) " << getCriticalPathMilliseconds() << " ms" << std::endl;
+    output << "  " << std::left << std::setw(nameWidth) << "task" << std::right << std::setw(12) << "start ms" << std::setw(12) << "took ms" << "  thread" << std::endl;
+    for (const StartupTaskTiming &timing : timings) {
+        output << (timing.onCriticalPath ? "* " : "  ") << std::left << std::setw(nameWidth) << timing.name << std::right
+            << std::setw(12) << timing.startMilliseconds << std::setw(12) << timing.durationMilliseconds
+            << (timing.ranOnMainThread ? "  main" : "  worker") << (timing.skipped ? " (skipped)" : "") << std::endl;
+    }
+    output.flags(flags);
+}
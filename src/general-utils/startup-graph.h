@@ -0,0 +1,106 @@
+#pragma once
+#include "job-system.h"
+#include <string>
+#include <vector>
+#include <ostream>
+#include <chrono>
+#include <exception>
+
+/**
+ * Where a startup task may run
+ */
+enum class StartupThread {
+    // Any worker of the job system
+    ANY,
+    // The thread that runs the graph, for work tied to it such as window creation or queue submission
+    MAIN
+};
+
+struct StartupTaskTiming {
+    std::string name;
+    // Relative to the start of the graph
+    double startMilliseconds = 0.0;
+    double durationMilliseconds = 0.0;
+    bool ranOnMainThread = false;
+    // Whether the task was skipped because a task it depends on failed
+    bool skipped = false;
+    bool onCriticalPath = false;
+};
+
+/**
+ * @class StartupGraph
+ *
+ * @brief Runs startup tasks on the job system as soon as the tasks they depend on have finished
+ *
+ * Tasks are added with the tasks they depend on, which must have been added before them, so the graph can never
+ * hold a cycle. Run records when each task started and how long it took. The critical path is the chain of dependent
+ * tasks with the greatest total duration, the time startup would take with unlimited threads, so shortening any task
+ * off it does not shorten startup.
+ */
+class StartupGraph {
+    public:
+    using TaskId = uint32_t;
+    using TaskFunction = std::function<void()>;
+
+    private:
+    struct Task {
+        std::string name;
+        TaskFunction function;
+        StartupThread thread;
+        std::vector<TaskId> dependencies;
+        std::vector<TaskId> dependents = {};
+        std::atomic<uint32_t> remainingDependencies {0U};
+        bool failed = false;
+        StartupTaskTiming timing {};
+    };
+    std::vector<std::unique_ptr<Task>> tasks = {};
+
+    JobSystem* jobSystem = nullptr;
+    std::chrono::steady_clock::time_point startTime;
+    double totalMilliseconds = 0.0;
+
+    // Tasks ready to run on the main thread, and the count of finished tasks the main thread waits on
+    std::mutex mainThreadMutex;
+    std::condition_variable mainThreadWake;
+    std::vector<TaskId> mainThreadTasks = {};
+    uint32_t finishedTasks = 0U;
+
+    std::mutex errorMutex;
+    std::exception_ptr firstError = nullptr;
+
+    void dispatch(TaskId id);
+    void execute(TaskId id);
+
+    public:
+    /**
+     * @brief Adds a task, throwing if a dependency has not been added yet
+     *
+     * @return The task's id, to be depended on by later tasks
+     */
+    TaskId addTask(const std::string &name, TaskFunction function, std::vector<TaskId> dependencies = {}, StartupThread thread = StartupThread::ANY);
+
+    /**
+     * @brief Runs every task, returning once all of them have finished
+     *
+     * The calling thread runs the tasks that must run on the main thread and otherwise waits. If a task throws, the
+     * tasks that depend on it are skipped, the others still run, and the first exception is rethrown at the end.
+     */
+    void run(JobSystem &jobSystem);
+
+    /**
+     * @brief Gets the timings of the last run, in the order the tasks were added
+     */
+    std::vector<StartupTaskTiming> getTimings();
+
+    /**
+     * @brief Gets the total duration of the critical path of the last run
+     */
+    double getCriticalPathMilliseconds();
+
+    double getTotalMilliseconds() { return totalMilliseconds; }
+
+    /**
+     * @brief Writes a table of the last run's tasks, in the order they started, marking those on the critical path
+     */
+    void printReport(std::ostream &output);
+};
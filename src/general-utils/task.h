@@ -0,0 +1,150 @@
+#pragma once
+#include "job-system.h"
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+template <typename T>
+class Task;
+
+/**
+ * The part of a task's promise that does not depend on its result type
+ */
+class TaskPromiseBase {
+    template <typename T>
+    friend class Task;
+
+    // Resumed once the task finishes, the coroutine that awaited it
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr exception = nullptr;
+
+    // Transfers straight to the continuation, so chains of awaited tasks do not grow the stack
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept { return handle.promise().continuation; }
+
+        void await_resume() noexcept {}
+    };
+
+    public:
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase {
+    template <typename U>
+    friend class Task;
+
+    std::optional<T> value = std::nullopt;
+
+    public:
+    Task<T> get_return_object();
+    void return_value(T result) { value.emplace(std::move(result)); }
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+    public:
+    Task<void> get_return_object();
+    void return_void() {}
+};
+
+/**
+ * @class Task
+ *
+ * @brief A coroutine that produces a T, started when it is first awaited
+ *
+ * Awaiting a task runs it on the awaiting thread until it first suspends, and the awaiting coroutine is resumed on
+ * whichever thread the task finishes on. Exceptions thrown by the task are rethrown where it is awaited. A task owns
+ * its coroutine frame and destroys it when the task is destroyed, so it must not be destroyed while suspended.
+ */
+template <typename T>
+class Task {
+    public:
+    using promise_type = TaskPromise<T>;
+
+    private:
+    std::coroutine_handle<promise_type> handle = nullptr;
+
+    public:
+    Task() = default;
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    Task(Task &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task& operator=(Task &&other) noexcept
+    {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { if (handle) handle.destroy(); }
+
+    bool await_ready() const noexcept { return !handle || handle.done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+
+    T await_resume()
+    {
+        if (handle.promise().exception) std::rethrow_exception(handle.promise().exception);
+        if constexpr (!std::is_void_v<T>) return std::move(*handle.promise().value);
+    }
+};
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object()
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+/**
+ * @class DetachedTask
+ *
+ * @brief A coroutine that starts immediately and destroys itself once finished, nothing can await it
+ *
+ * @note Exceptions must be caught within the coroutine, one that escapes terminates the program
+ */
+class DetachedTask {
+    public:
+    struct promise_type {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+/**
+ * @brief Suspends the awaiting coroutine and resumes it as a job on the job system
+ */
+inline auto resumeOn(JobSystem &jobSystem)
+{
+    struct JobSystemAwaiter {
+        JobSystem &jobSystem;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { jobSystem.run([handle]() { handle.resume(); }); }
+        void await_resume() const noexcept {}
+    };
+    return JobSystemAwaiter {jobSystem};
+}
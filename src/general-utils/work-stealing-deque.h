@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @class WorkStealingDeque
+ *
+ * @brief A Chase-Lev deque, the owning thread pushes and pops at the bottom while any thread steals from the top
+ *
+ * Follows "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê et al., 2013). The ring buffer doubles
+ * when full. Buffers that have been grown out of are kept until the deque is destroyed, since a thief may still be
+ * reading from one.
+ *
+ * @note push and pop must only be called by the owning thread, T must be trivially copyable
+ */
+template <typename T>
+class WorkStealingDeque {
+    struct RingBuffer {
+        int64_t capacity;
+        std::unique_ptr<std::atomic<T>[]> items;
+
+        explicit RingBuffer(int64_t capacity) : capacity(capacity), items(new std::atomic<T>[capacity]) {}
+
+        T get(int64_t index) { return items[index & (capacity - 1)].load(std::memory_order_relaxed); }
+        void put(int64_t index, T item) { items[index & (capacity - 1)].store(item, std::memory_order_relaxed); }
+    };
+
+    alignas(64) std::atomic<int64_t> top {0};
+    alignas(64) std::atomic<int64_t> bottom {0};
+    std::atomic<RingBuffer*> buffer {nullptr};
+    std::vector<std::unique_ptr<RingBuffer>> buffers = {};
+
+    RingBuffer* grow(RingBuffer* current, int64_t bottomIndex, int64_t topIndex)
+    {
+        buffers.push_back(std::make_unique<RingBuffer>(current->capacity * 2));
+        RingBuffer* grown = buffers.back().get();
+        for (int64_t i = topIndex ; i < bottomIndex ; i++) grown->put(i, current->get(i));
+        buffer.store(grown, std::memory_order_release);
+        return grown;
+    }
+
+    public:
+    /**
+     * @param capacity The initial capacity, rounded up to a power of two
+     */
+    explicit WorkStealingDeque(uint32_t capacity = 1024U)
+    {
+        int64_t roundedCapacity = 1;
+        while (roundedCapacity < capacity) roundedCapacity *= 2;
+        buffers.push_back(std::make_unique<RingBuffer>(roundedCapacity));
+        buffer.store(buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    void push(T item)
+    {
+        int64_t bottomIndex = bottom.load(std::memory_order_relaxed);
+        int64_t topIndex = top.load(std::memory_order_acquire);
+        RingBuffer* current = buffer.load(std::memory_order_relaxed);
+        if (bottomIndex - topIndex > current->capacity - 1) current = grow(current, bottomIndex, topIndex);
+
+        current->put(bottomIndex, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(bottomIndex + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Takes the most recently pushed item
+     *
+     * @return False if the deque was empty, or a thief took the last item first
+     */
+    bool pop(T &item)
+    {
+        int64_t bottomIndex = bottom.load(std::memory_order_relaxed) - 1;
+        RingBuffer* current = buffer.load(std::memory_order_relaxed);
+        bottom.store(bottomIndex, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t topIndex = top.load(std::memory_order_relaxed);
+
+        if (topIndex > bottomIndex) {
+            bottom.store(bottomIndex + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = current->get(bottomIndex);
+        if (topIndex == bottomIndex) {
+            // The last item, race any thieves for it
+            bool won = top.compare_exchange_strong(topIndex, topIndex + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(bottomIndex + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Takes the least recently pushed item, from any thread
+     *
+     * @return False if the deque was empty, or another thread took the item first
+     */
+    bool steal(T &item)
+    {
+        int64_t topIndex = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottomIndex = bottom.load(std::memory_order_acquire);
+        if (topIndex >= bottomIndex) return false;
+
+        RingBuffer* current = buffer.load(std::memory_order_acquire);
+        item = current->get(topIndex);
+        return top.compare_exchange_strong(topIndex, topIndex + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Gets an estimate of the number of items, which may be stale by the time it is read
+     */
+    int64_t size()
+    {
+        return std::max<int64_t>(bottom.load(std::memory_order_relaxed) - top.load(std::memory_order_relaxed), 0);
+    }
+};
@@ -41,37 +41,31 @@ std::pair<std::vector<Vertex>, std::vector<uint32_t>> GeometryBase::getVertexAnd
             Vertex vertex = {
                 position,
                 normal,
-                glm::vec3(0.f), // Will be computed later
+                glm::vec4(0.f), // Will be computed later
                 texCoord
             };
             vertexData.push_back(vertex);
             *insertionIndex = vertexData.size() - 1;
         }
         indexData.push_back(*insertionIndex);
-
-        // Compute the tangent vector for the past 3 vertices
-        if ((i + 1) % 3 == 0) {
-            // Get the indices of the last 3 vertices (index minus 2, index minus 1, index minus 0)
-            uint32_t im2 = indexData[i - 2];
-            uint32_t im1 = indexData[i - 1];
-            uint32_t im0 = indexData[i];
-
-            // Compute the tangent and bitangent vectors
-            std::pair<glm::vec3, glm::vec3> tangentBitangent = computeTangentBitangent(
-                vertexData[im2].position, vertexData[im2].texCoord,
-                vertexData[im1].position, vertexData[im1].texCoord,
-                vertexData[im0].position, vertexData[im0].texCoord
-            );
-
-            // Set the tangent vectors for the last 3 vertices
-            vertexData[im2].tangent = tangentBitangent.first;
-            vertexData[im1].tangent = tangentBitangent.first;
-            vertexData[im0].tangent = tangentBitangent.first;
-        }
     }
+
+    // Tangents are accumulated over every triangle sharing a vertex, so they can only be computed once all triangles are known
+    generateTangents(vertexData, indexData);
+
     return std::pair<std::vector<Vertex>, std::vector<uint32_t>>(vertexData, indexData);
 }
 
+std::list<MemoryBlockNode>::iterator GeometryBase::getVertexBufferBlock()
+{
+    return vertexBufferBlock;
+}
+
+std::list<MemoryBlockNode>::iterator GeometryBase::getIndexBufferBlock()
+{
+    return indexBufferBlock;
+}
+
 void GeometryBase::setVertexBufferBlock(std::list<MemoryBlockNode>::iterator vertexBufferBlock)
 {
     this->vertexBufferBlock = vertexBufferBlock;
@@ -87,6 +81,11 @@ void GeometryBase::setShapeName(std::string name)
     this->shapeName = name;   
 }
 
+std::string GeometryBase::getShapeName()
+{
+    return shapeName;
+}
+
 void GeometryBase::addVertexIndex(uint32_t positionIndex, uint32_t texCoordIndex, uint32_t normalIndex)
 {
     vertexIndices.push_back({positionIndex, texCoordIndex, normalIndex});
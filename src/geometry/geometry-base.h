@@ -29,10 +29,13 @@ class GeometryBase {
     uint32_t getVertexOffset();
     uint32_t getIndexOffset();
     std::pair<std::vector<Vertex>, std::vector<uint32_t>> getVertexAndIndexData();
+    std::list<MemoryBlockNode>::iterator getVertexBufferBlock();
+    std::list<MemoryBlockNode>::iterator getIndexBufferBlock();
     void setVertexBufferBlock(std::list<MemoryBlockNode>::iterator vertexBufferBlock);
     void setIndexBufferBlock(std::list<MemoryBlockNode>::iterator indexBufferBlock);
 
     void setShapeName(std::string name);
+    std::string getShapeName();
     void addVertexIndex(uint32_t positionIndex, uint32_t texCoordIndex, uint32_t normalIndex);
     void addPosition(glm::vec3 position);
     std::vector<glm::vec3> getPositions();
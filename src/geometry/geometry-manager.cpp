@@ -8,6 +8,8 @@
 #include "tiny_obj_loader.h"
 #include <set>
 #include "resource-structs.h"
+#include "file-loader.h"
+#include <filesystem>
 
 
 // void GeometryManager::setVertexBuffers(AppBufferBundle stagingVertexBuffer, AppBufferBundle deviceVertexBuffer)
@@ -125,7 +127,7 @@ void assembleVerticesAndIndices(std::vector<glm::vec3> &positionData, std::vecto
                 vertices.push_back({
                     positionData[face.posIndices[j]],
                     normalData[face.normalIndices[j]],
-                    glm::vec3{0.0f, 0.0f, 0.0f},
+                    glm::vec4{0.0f, 0.0f, 0.0f, 0.0f},
                     texCoordData[face.texCoordIndices[j]]
                 });
                 // Insert the index into the index list
@@ -139,23 +141,56 @@ void assembleVerticesAndIndices(std::vector<glm::vec3> &positionData, std::vecto
     }
 }
 
+Mesh* GeometryManager::addMesh(Mesh mesh)
+{
+    meshes.push_back(std::move(mesh));
+    return &meshes.back();
+}
+
+std::string GeometryManager::findMaterialLibrary(const std::string &path, const std::vector<char> &objFile)
+{
+    std::string objText(objFile.begin(), objFile.end());
+    std::istringstream objLines(objText);
+    for (std::string line ; std::getline(objLines, line) ; ) {
+        if (line.rfind("mtllib ", 0U) != 0U) continue;
+        std::string mtlName = line.substr(7U);
+        mtlName.erase(mtlName.find_last_not_of(" \r") + 1U);
+        return (std::filesystem::path(path).parent_path() / mtlName).string();
+    }
+    return "";
+}
+
 int GeometryManager::importOBJ(const char *path, VkCommandBuffer commandBuffer)
+{
+    // Load through FileLoader so that packed OBJs are read from the asset archive, along with the .mtl they reference
+    std::vector<char> objFile = FileLoader::loadFile(path);
+    std::string mtlPath = findMaterialLibrary(path, objFile);
+    std::vector<char> mtlFile = mtlPath.empty() ? std::vector<char>{} : FileLoader::loadFile(mtlPath);
+
+    std::vector<Mesh> parsedMeshes = parseOBJ(path, objFile, mtlFile);
+    for (Mesh &mesh : parsedMeshes) addMesh(std::move(mesh));
+    return parsedMeshes.size();
+}
+
+std::vector<Mesh> GeometryManager::parseOBJ(const std::string &path, const std::vector<char> &objFile, const std::vector<char> &mtlFile)
 {
     tinyobj::ObjReaderConfig readerConfig;
-    readerConfig.mtl_search_path = "./"; // Path to the .mtl file
     readerConfig.triangulate = true; // Triangulate the faces
 
     // Instantiate the reader
     tinyobj::ObjReader reader;
 
-    // Attempt to parse the file from the path
-    if (!reader.ParseFromFile(path, readerConfig)) {
+    // Attempt to parse the file's contents
+    std::string objText(objFile.begin(), objFile.end());
+    std::string mtlText(mtlFile.begin(), mtlFile.end());
+    if (objFile.empty() || !reader.ParseFromString(objText, mtlText, readerConfig)) {
+        if (objFile.empty()) std::cerr << "Failed to open OBJ file: " << path << std::endl;
 
         // Display any errors that occurred during the parsing process
         if (!reader.Error().empty()) {
             std::cerr << "TinyObjReader: " << reader.Error();
         }
-        return 0;
+        return {};
     }
 
     // Get the parsed attributes
@@ -167,11 +202,11 @@ int GeometryManager::importOBJ(const char *path, VkCommandBuffer commandBuffer)
     uint32_t shapeIndexOffset = 0U;
 
     // Iterate through the shapes that we've parsed
+    std::vector<Mesh> parsedMeshes(shapes.size());
     for (uint32_t s = 0U ; s < shapes.size() ; s++) {
 
-        // Create a new mesh for this shape
-        meshes.push_back({});
-        Mesh* mesh = &meshes[meshes.size() - 1];
+        // Fill the mesh for this shape
+        Mesh* mesh = &parsedMeshes[s];
 
         // Store the indices of vertices, normals, texCoords that we must copy to the mesh
         // The key is the vertex index, the value is the local index in the mesh
@@ -233,5 +268,5 @@ int GeometryManager::importOBJ(const char *path, VkCommandBuffer commandBuffer)
             mesh->addVertexIndex(localIndices.positionIndex, localIndices.texCoordIndex, localIndices.normalIndex);
         }
     }
-    return shapes.size();
+    return parsedMeshes;
 }
@@ -1,6 +1,8 @@
 #pragma once
 #include <map>
 #include <vector>
+#include <deque>
+#include <string>
 #include <stdint.h>
 #include "vulkan/vulkan.hpp"
 #include "mesh.h"
@@ -19,7 +21,8 @@ class GeometryManager {
     private:
     class VulkanApp* app;
 
-    std::vector<Mesh> meshes;
+    // A deque, so the meshes already added keep their addresses while loads add more
+    std::deque<Mesh> meshes;
 
     bool buffersInitialized = false;
 
@@ -33,6 +36,33 @@ class GeometryManager {
         return &meshes[index];
     }
 
+    uint32_t getMeshCount() {
+        return meshes.size();
+    }
+
+    /**
+     * @brief Takes ownership of a mesh
+     *
+     * @return The mesh's address, which stays valid for the lifetime of the manager
+     */
+    Mesh* addMesh(Mesh mesh);
+
     int importOBJ(const char* path, VkCommandBuffer commandBuffer);
 
+    /**
+     * @brief Finds the material library an OBJ file references
+     *
+     * @return The library's path, relative to the same directory as the OBJ, or an empty string if it has none
+     */
+    static std::string findMaterialLibrary(const std::string &path, const std::vector<char> &objFile);
+
+    /**
+     * @brief Parses the contents of an OBJ file into one mesh per shape, without touching the manager
+     *
+     * @param mtlFile The contents of the material library, which may be empty
+     *
+     * @return The meshes, or no meshes if the file could not be parsed
+     */
+    static std::vector<Mesh> parseOBJ(const std::string &path, const std::vector<char> &objFile, const std::vector<char> &mtlFile);
+
 };
\ No newline at end of file
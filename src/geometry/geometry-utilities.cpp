@@ -1,4 +1,8 @@
 #include "geometry-utilities.h"
+#include "job-system.h"
+#include <algorithm>
+#include <cmath>
+#include "float4.h"
 
 
 std::pair<glm::vec3, glm::vec3> computeTangentBitangent(glm::vec3 p1, glm::vec2 p1UV, glm::vec3 p2, glm::vec2 p2UV, glm::vec3 p3, glm::vec2 p3UV)
@@ -38,4 +42,326 @@ std::pair<glm::vec3, glm::vec3> computeTangentBitangent(glm::vec3 p1, glm::vec2
     bitangent = glm::normalize(bitangent);
 
     return std::pair<glm::vec3, glm::vec3> {tangent, bitangent};
-}
\ No newline at end of file
+}
+
+struct Float4x3 {
+    Float4 x, y, z;
+
+    friend Float4x3 operator+(Float4x3 a, Float4x3 b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+    friend Float4x3 operator-(Float4x3 a, Float4x3 b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+    friend Float4x3 operator*(Float4x3 a, Float4 s) { return {a.x * s, a.y * s, a.z * s}; }
+    friend Float4 dot(Float4x3 a, Float4x3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    friend Float4x3 cross(Float4x3 a, Float4x3 b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+};
+
+// The number of triangles processed together by the SIMD kernel
+static const uint32_t triangleBatchSize = 4U;
+
+// Meshes with fewer triangles than this per thread are not worth splitting across threads
+static const uint32_t minTrianglesPerThread = 8192U;
+
+/**
+ * A batch of triangles in structure-of-arrays form, one lane per triangle
+ */
+struct TriangleBatch {
+    float e1[3][triangleBatchSize];
+    float e2[3][triangleBatchSize];
+    float duv1[2][triangleBatchSize];
+    float duv2[2][triangleBatchSize];
+};
+
+struct TriangleBatchResult {
+    // Unit tangent and bitangent directions, scaled by the triangle's area
+    float tangent[3][triangleBatchSize];
+    float bitangent[3][triangleBatchSize];
+
+    // The cosine of the interior angle at each corner
+    float cornerCos[3][triangleBatchSize];
+};
+
+static void computeTriangleBatch(const TriangleBatch &batch, TriangleBatchResult &result)
+{
+    Float4x3 e1 = {Float4::load(batch.e1[0]), Float4::load(batch.e1[1]), Float4::load(batch.e1[2])};
+    Float4x3 e2 = {Float4::load(batch.e2[0]), Float4::load(batch.e2[1]), Float4::load(batch.e2[2])};
+    Float4 du1 = Float4::load(batch.duv1[0]), dv1 = Float4::load(batch.duv1[1]);
+    Float4 du2 = Float4::load(batch.duv2[0]), dv2 = Float4::load(batch.duv2[1]);
+
+    const Float4 epsilon = Float4::splat(1e-20f);
+    const Float4 half = Float4::splat(0.5f);
+
+    /**
+     * Same derivation as computeTangentBitangent, but only the direction of the UV-space inverse is needed since the
+     * result is renormalized, so the determinant contributes its sign only. This also keeps degenerate UVs (zero
+     * determinant) from producing infinities, they contribute a zero vector instead.
+     */
+    Float4 determinantSign = sign(du1 * dv2 - du2 * dv1);
+    Float4x3 tangent = (e1 * dv2 - e2 * dv1) * determinantSign;
+    Float4x3 bitangent = (e2 * du1 - e1 * du2) * determinantSign;
+
+    // Half the length of the edge cross product is the triangle's area
+    Float4 area = sqrt(dot(cross(e1, e2), cross(e1, e2))) * half;
+
+    tangent = tangent * (area / max(sqrt(dot(tangent, tangent)), epsilon));
+    bitangent = bitangent * (area / max(sqrt(dot(bitangent, bitangent)), epsilon));
+
+    // Corner angles, p0 sits between e1 and e2, p1 between -e1 and (e2 - e1), p2 between -e2 and (e1 - e2)
+    Float4x3 e3 = e2 - e1;
+    Float4 len1 = max(sqrt(dot(e1, e1)), epsilon);
+    Float4 len2 = max(sqrt(dot(e2, e2)), epsilon);
+    Float4 len3 = max(sqrt(dot(e3, e3)), epsilon);
+    Float4 cos0 = dot(e1, e2) / (len1 * len2);
+    Float4 cos1 = (Float4::splat(0.f) - dot(e1, e3)) / (len1 * len3);
+    Float4 cos2 = dot(e2, e3) / (len2 * len3);
+
+    tangent.x.store(result.tangent[0]); tangent.y.store(result.tangent[1]); tangent.z.store(result.tangent[2]);
+    bitangent.x.store(result.bitangent[0]); bitangent.y.store(result.bitangent[1]); bitangent.z.store(result.bitangent[2]);
+    cos0.store(result.cornerCos[0]); cos1.store(result.cornerCos[1]); cos2.store(result.cornerCos[2]);
+}
+
+/**
+ * @brief Accumulates the weighted tangents and bitangents of triangles [firstTriangle, lastTriangle) into per-vertex sums
+ */
+static void accumulateTangents(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, uint32_t firstTriangle, uint32_t lastTriangle,
+    std::vector<glm::vec3> &tangentSums, std::vector<glm::vec3> &bitangentSums)
+{
+    TriangleBatch batch {};
+    TriangleBatchResult result {};
+
+    for (uint32_t batchStart = firstTriangle ; batchStart < lastTriangle ; batchStart += triangleBatchSize) {
+        uint32_t laneCount = std::min(triangleBatchSize, lastTriangle - batchStart);
+
+        // Gather the batch into structure-of-arrays form, unused lanes are zeroed and produce zero contributions
+        for (uint32_t lane = 0U ; lane < triangleBatchSize ; lane++) {
+            glm::vec3 e1(0.f), e2(0.f);
+            glm::vec2 duv1(0.f), duv2(0.f);
+            if (lane < laneCount) {
+                const Vertex &v0 = vertices[indices[(batchStart + lane) * 3U + 0U]];
+                const Vertex &v1 = vertices[indices[(batchStart + lane) * 3U + 1U]];
+                const Vertex &v2 = vertices[indices[(batchStart + lane) * 3U + 2U]];
+                e1 = v1.position - v0.position;
+                e2 = v2.position - v0.position;
+                duv1 = v1.texCoord - v0.texCoord;
+                duv2 = v2.texCoord - v0.texCoord;
+            }
+            for (uint32_t c = 0U ; c < 3U ; c++) {
+                batch.e1[c][lane] = e1[c];
+                batch.e2[c][lane] = e2[c];
+            }
+            batch.duv1[0][lane] = duv1.x; batch.duv1[1][lane] = duv1.y;
+            batch.duv2[0][lane] = duv2.x; batch.duv2[1][lane] = duv2.y;
+        }
+
+        computeTriangleBatch(batch, result);
+
+        // Scatter the results to the triangle's vertices, weighting by the angle at each corner
+        for (uint32_t lane = 0U ; lane < laneCount ; lane++) {
+            glm::vec3 tangent = {result.tangent[0][lane], result.tangent[1][lane], result.tangent[2][lane]};
+            glm::vec3 bitangent = {result.bitangent[0][lane], result.bitangent[1][lane], result.bitangent[2][lane]};
+            for (uint32_t corner = 0U ; corner < 3U ; corner++) {
+                float angle = std::acos(std::clamp(result.cornerCos[corner][lane], -1.f, 1.f));
+                uint32_t vertexIndex = indices[(batchStart + lane) * 3U + corner];
+                tangentSums[vertexIndex] += tangent * angle;
+                bitangentSums[vertexIndex] += bitangent * angle;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Orthogonalizes the summed tangents of vertices [firstVertex, lastVertex) against their normals and stores the handedness
+ */
+static void finalizeTangents(std::vector<Vertex> &vertices, const std::vector<glm::vec3> &tangentSums, const std::vector<glm::vec3> &bitangentSums, uint32_t firstVertex, uint32_t lastVertex)
+{
+    for (uint32_t i = firstVertex ; i < lastVertex ; i++) {
+        glm::vec3 normal = vertices[i].normal;
+
+        // Gram-Schmidt, remove the component of the tangent along the normal
+        glm::vec3 tangent = tangentSums[i] - normal * glm::dot(normal, tangentSums[i]);
+
+        // Vertices without usable UVs get an arbitrary tangent perpendicular to the normal
+        if (glm::dot(tangent, tangent) < 1e-12f) {
+            glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3(1.f, 0.f, 0.f) : glm::vec3(0.f, 1.f, 0.f);
+            tangent = glm::cross(normal, axis);
+        }
+        tangent = glm::normalize(tangent);
+
+        // The UV mapping is mirrored if the accumulated bitangent opposes cross(normal, tangent)
+        float handedness = glm::dot(glm::cross(normal, tangent), bitangentSums[i]) < 0.f ? -1.f : 1.f;
+
+        vertices[i].tangent = glm::vec4(tangent, handedness);
+    }
+}
+
+void generateTangents(std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices)
+{
+    uint32_t vertexCount = vertices.size();
+    uint32_t triangleCount = indices.size() / 3U;
+
+    // One slice of triangles per thread that can run jobs, the workers and this thread
+    JobSystem &jobSystem = JobSystem::shared();
+    uint32_t sliceCount = std::max(1U, std::min(jobSystem.getThreadCount() + 1U, triangleCount / minTrianglesPerThread));
+
+    // Each slice accumulates into its own sums, so shared vertices never need to be synchronized
+    std::vector<std::vector<glm::vec3>> tangentSums(sliceCount, std::vector<glm::vec3>(vertexCount, glm::vec3(0.f)));
+    std::vector<std::vector<glm::vec3>> bitangentSums(sliceCount, std::vector<glm::vec3>(vertexCount, glm::vec3(0.f)));
+
+    if (sliceCount == 1U) {
+        accumulateTangents(vertices, indices, 0U, triangleCount, tangentSums[0], bitangentSums[0]);
+        finalizeTangents(vertices, tangentSums[0], bitangentSums[0], 0U, vertexCount);
+        return;
+    }
+
+    // Split the triangles into one contiguous, batch-aligned range per slice
+    uint32_t trianglesPerSlice = ((triangleCount / sliceCount) + triangleBatchSize - 1U) / triangleBatchSize * triangleBatchSize;
+    jobSystem.parallelFor(0U, sliceCount, [&](uint32_t firstSlice, uint32_t lastSlice) {
+        for (uint32_t t = firstSlice ; t < lastSlice ; t++) {
+            uint32_t first = std::min(triangleCount, t * trianglesPerSlice);
+            uint32_t last = t == sliceCount - 1U ? triangleCount : std::min(triangleCount, first + trianglesPerSlice);
+            accumulateTangents(vertices, indices, first, last, tangentSums[t], bitangentSums[t]);
+        }
+    }, 1U);
+
+    // Reduce the per-slice sums and finalize, split by vertex range so every vertex is owned by exactly one job
+    jobSystem.parallelFor(0U, vertexCount, [&](uint32_t first, uint32_t last) {
+        for (uint32_t i = first ; i < last ; i++) {
+            for (uint32_t other = 1U ; other < sliceCount ; other++) {
+                tangentSums[0][i] += tangentSums[other][i];
+                bitangentSums[0][i] += bitangentSums[other][i];
+            }
+        }
+        finalizeTangents(vertices, tangentSums[0], bitangentSums[0], first, last);
+    });
+}
+
+// The simulated LRU cache, the scores of Forsyth's paper are tuned for 32 entries
+static const uint32_t vertexCacheSize = 32U;
+
+/**
+ * @brief Scores a vertex by its position in the simulated cache and the number of its triangles not yet emitted
+ */
+static float scoreVertex(int32_t cachePosition, uint32_t remainingTriangles)
+{
+    // A vertex whose triangles have all been emitted can never be used again
+    if (remainingTriangles == 0U) return -1.f;
+
+    float score = 0.f;
+    if (cachePosition >= 0) {
+        // The three vertices of the last triangle score equally, whichever order they were pushed in
+        if (cachePosition < 3) score = 0.75f;
+        else score = std::pow(1.f - (cachePosition - 3) / float(vertexCacheSize - 3U), 1.5f);
+    }
+
+    // Vertices with few triangles left are prioritized, so that they leave the cache for good sooner
+    return score + 2.f * std::pow(float(remainingTriangles), -0.5f);
+}
+
+void optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount)
+{
+    uint32_t triangleCount = indices.size() / 3U;
+    if (triangleCount == 0U) return;
+
+    // The triangles of every vertex, as offsets into one shared array
+    std::vector<uint32_t> triangleOffsets(vertexCount + 1U, 0U);
+    for (uint32_t index : indices) triangleOffsets[index + 1U]++;
+    for (uint32_t i = 0U ; i < vertexCount ; i++) triangleOffsets[i + 1U] += triangleOffsets[i];
+    std::vector<uint32_t> vertexTriangles(indices.size());
+    std::vector<uint32_t> remainingTriangles(vertexCount, 0U);
+    for (uint32_t t = 0U ; t < triangleCount ; t++) {
+        for (uint32_t corner = 0U ; corner < 3U ; corner++) {
+            uint32_t vertex = indices[t * 3U + corner];
+            vertexTriangles[triangleOffsets[vertex] + remainingTriangles[vertex]++] = t;
+        }
+    }
+
+    std::vector<float> vertexScores(vertexCount);
+    for (uint32_t i = 0U ; i < vertexCount ; i++) vertexScores[i] = scoreVertex(-1, remainingTriangles[i]);
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (uint32_t t = 0U ; t < triangleCount ; t++) {
+        triangleScores[t] = vertexScores[indices[t * 3U]] + vertexScores[indices[t * 3U + 1U]] + vertexScores[indices[t * 3U + 2U]];
+    }
+
+    // The cache holds up to three more entries than its size while a triangle is being pushed
+    std::vector<uint32_t> cache = {};
+    cache.reserve(vertexCacheSize + 3U);
+
+    std::vector<uint32_t> optimizedIndices = {};
+    optimizedIndices.reserve(indices.size());
+    uint32_t scanStart = 0U;
+    while (true) {
+        // The next triangle is the best of those touching the cache, or the best remaining triangle when the cache has
+        // none left, such as at the start of a new disconnected piece of the mesh
+        int64_t bestTriangle = -1;
+        float bestScore = -1.f;
+        for (uint32_t vertex : cache) {
+            for (uint32_t i = triangleOffsets[vertex] ; i < triangleOffsets[vertex + 1U] ; i++) {
+                uint32_t t = vertexTriangles[i];
+                if (!emitted[t] && triangleScores[t] > bestScore) {
+                    bestTriangle = t;
+                    bestScore = triangleScores[t];
+                }
+            }
+        }
+        if (bestTriangle == -1) {
+            while (scanStart < triangleCount && emitted[scanStart]) scanStart++;
+            if (scanStart == triangleCount) break;
+            for (uint32_t t = scanStart ; t < triangleCount ; t++) {
+                if (!emitted[t] && triangleScores[t] > bestScore) {
+                    bestTriangle = t;
+                    bestScore = triangleScores[t];
+                }
+            }
+        }
+
+        emitted[bestTriangle] = true;
+        for (uint32_t corner = 0U ; corner < 3U ; corner++) {
+            uint32_t vertex = indices[bestTriangle * 3U + corner];
+            optimizedIndices.push_back(vertex);
+            remainingTriangles[vertex]--;
+
+            // Move the vertex to the front of the cache
+            auto position = std::find(cache.begin(), cache.end(), vertex);
+            if (position != cache.end()) cache.erase(position);
+            cache.insert(cache.begin(), vertex);
+        }
+
+        // Vertices pushed out of the cache lose their cache score
+        while (cache.size() > vertexCacheSize) {
+            vertexScores[cache.back()] = scoreVertex(-1, remainingTriangles[cache.back()]);
+            for (uint32_t i = triangleOffsets[cache.back()] ; i < triangleOffsets[cache.back() + 1U] ; i++) {
+                uint32_t t = vertexTriangles[i];
+                if (!emitted[t]) triangleScores[t] = vertexScores[indices[t * 3U]] + vertexScores[indices[t * 3U + 1U]] + vertexScores[indices[t * 3U + 2U]];
+            }
+            cache.pop_back();
+        }
+
+        // Rescore the vertices that remain cached, then the triangles that use them
+        for (uint32_t i = 0U ; i < cache.size() ; i++) vertexScores[cache[i]] = scoreVertex(i, remainingTriangles[cache[i]]);
+        for (uint32_t vertex : cache) {
+            for (uint32_t i = triangleOffsets[vertex] ; i < triangleOffsets[vertex + 1U] ; i++) {
+                uint32_t t = vertexTriangles[i];
+                if (!emitted[t]) triangleScores[t] = vertexScores[indices[t * 3U]] + vertexScores[indices[t * 3U + 1U]] + vertexScores[indices[t * 3U + 2U]];
+            }
+        }
+    }
+
+    indices = std::move(optimizedIndices);
+}
+
+void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices)
+{
+    std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+    std::vector<Vertex> orderedVertices = {};
+    orderedVertices.reserve(vertices.size());
+
+    for (uint32_t &index : indices) {
+        if (remap[index] == UINT32_MAX) {
+            remap[index] = orderedVertices.size();
+            orderedVertices.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices = std::move(orderedVertices);
+}
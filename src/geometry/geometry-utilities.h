@@ -1,9 +1,43 @@
 #pragma once
 #include <vector>
 #include "glm/glm.hpp"
+#include "app-config.h"
 
 
 //void importMesh();
 
 std::pair<glm::vec3, glm::vec3> computeTangentBitangent(glm::vec3 p1, glm::vec2 p1UV, glm::vec3 p2, glm::vec2 p2UV, glm::vec3 p3, glm::vec2 p3UV);
 
+/**
+ * @brief Generates a per-vertex tangent frame for an indexed triangle list
+ * 
+ * @note Each triangle's tangent and bitangent are accumulated into its three vertices, weighted by the triangle's area
+ * and the angle at each corner, so shared vertices blend all adjacent triangles. The accumulated tangent is then
+ * Gram-Schmidt orthogonalized against the vertex normal, and the handedness of the UV mapping is stored in tangent.w.
+ * 
+ * Triangles are processed in SIMD batches, and large meshes are split across threads.
+ * 
+ * @param vertices The vertices to write tangents to, positions, normals and texture coordinates must already be set
+ * @param indices The triangle list indices, 3 per triangle
+ */
+void generateTangents(std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices);
+
+
+/**
+ * @brief Reorders the triangles of an indexed triangle list so that consecutive triangles reuse the vertices still
+ * in the GPU's post-transform cache
+ * 
+ * @note Uses Forsyth's linear-speed vertex cache optimization: each vertex is scored by its position in a simulated
+ * LRU cache and by how many of its triangles have not been emitted yet, and the highest scoring triangle among
+ * those touching the cache is emitted next. The result does not depend on the exact size of the hardware cache.
+ * 
+ * @param indices The triangle list indices, 3 per triangle, reordered in place
+ * @param vertexCount The number of vertices the indices refer to
+ */
+void optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount);
+
+/**
+ * @brief Renumbers the vertices in the order the indices first reference them, so that vertex fetches walk through
+ * the vertex buffer in order. Vertices no index references are removed.
+ */
+void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices);
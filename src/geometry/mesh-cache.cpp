@@ -0,0 +1,211 @@
+#include "mesh-cache.h"
+#include "file-loader.h"
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+static const uint32_t meshCacheMagic = 0x4853454DU; // "MESH"
+
+struct MeshCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t meshCount;
+};
+
+struct MeshCacheMeshHeader {
+    uint32_t nameLength;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    // 2 or 4
+    uint32_t indexSize;
+    float positionMin[3];
+    // The size of one step of a quantized position along each axis
+    float positionScale[3];
+};
+
+struct QuantizedVertex {
+    uint16_t position[3];
+    // Bit 0 is set where the tangent handedness is -1
+    uint16_t flags;
+    int16_t normal[2];
+    int16_t tangent[2];
+    float texCoord[2];
+};
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return ((value + alignment - 1U) / alignment) * alignment;
+}
+
+template <typename T>
+static void appendValue(std::vector<char> &data, const T &value)
+{
+    size_t offset = data.size();
+    data.resize(offset + sizeof(T));
+    memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+static T readValue(const std::vector<char> &data, size_t offset)
+{
+    if (offset + sizeof(T) > data.size()) throw std::runtime_error("Failed to parse mesh cache, unexpected end of file");
+    T value;
+    memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+static int16_t quantizeSnorm(float value)
+{
+    return static_cast<int16_t>(std::round(std::clamp(value, -1.f, 1.f) * 32767.f));
+}
+
+/**
+ * @brief Projects a unit vector onto the octahedron and unfolds it into the square [-1, 1]^2
+ */
+static void encodeOctahedral(glm::vec3 direction, int16_t encoded[2])
+{
+    direction /= std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    glm::vec2 square = {direction.x, direction.y};
+    if (direction.z < 0.f) {
+        square = {
+            (1.f - std::abs(direction.y)) * (direction.x >= 0.f ? 1.f : -1.f),
+            (1.f - std::abs(direction.x)) * (direction.y >= 0.f ? 1.f : -1.f)
+        };
+    }
+    encoded[0] = quantizeSnorm(square.x);
+    encoded[1] = quantizeSnorm(square.y);
+}
+
+static glm::vec3 decodeOctahedral(const int16_t encoded[2])
+{
+    glm::vec2 square = {std::max(encoded[0] / 32767.f, -1.f), std::max(encoded[1] / 32767.f, -1.f)};
+    glm::vec3 direction = {square.x, square.y, 1.f - std::abs(square.x) - std::abs(square.y)};
+    if (direction.z < 0.f) {
+        float x = direction.x;
+        direction.x = (1.f - std::abs(direction.y)) * (x >= 0.f ? 1.f : -1.f);
+        direction.y = (1.f - std::abs(x)) * (direction.y >= 0.f ? 1.f : -1.f);
+    }
+    return glm::normalize(direction);
+}
+
+bool MeshCache::isCurrent(const std::string &objPath)
+{
+    return FileLoader::isCurrent(getCachePath(objPath), objPath);
+}
+
+void MeshCache::writeToFile(const std::string &filePath, const std::vector<CookedMesh> &meshes)
+{
+    std::vector<char> file = {};
+    appendValue(file, MeshCacheHeader {meshCacheMagic, version, static_cast<uint32_t>(meshes.size())});
+
+    for (const CookedMesh &mesh : meshes) {
+        MeshCacheMeshHeader header {};
+        header.nameLength = mesh.name.size();
+        header.vertexCount = mesh.vertices.size();
+        header.indexCount = mesh.indices.size();
+        header.indexSize = mesh.vertices.size() <= UINT16_MAX + 1U ? 2U : 4U;
+
+        glm::vec3 positionMin = glm::vec3(0.f);
+        glm::vec3 positionMax = glm::vec3(0.f);
+        if (!mesh.vertices.empty()) positionMin = positionMax = mesh.vertices[0].position;
+        for (const Vertex &vertex : mesh.vertices) {
+            positionMin = glm::min(positionMin, vertex.position);
+            positionMax = glm::max(positionMax, vertex.position);
+        }
+        glm::vec3 positionScale = (positionMax - positionMin) / 65535.f;
+        for (uint32_t axis = 0U ; axis < 3U ; axis++) {
+            header.positionMin[axis] = positionMin[axis];
+            header.positionScale[axis] = positionScale[axis];
+        }
+        appendValue(file, header);
+
+        file.insert(file.end(), mesh.name.begin(), mesh.name.end());
+        file.resize(alignUp(file.size(), 4U), 0);
+
+        for (const Vertex &vertex : mesh.vertices) {
+            QuantizedVertex quantized {};
+            for (uint32_t axis = 0U ; axis < 3U ; axis++) {
+                float steps = positionScale[axis] > 0.f ? (vertex.position[axis] - positionMin[axis]) / positionScale[axis] : 0.f;
+                quantized.position[axis] = static_cast<uint16_t>(std::clamp(std::round(steps), 0.f, 65535.f));
+            }
+            quantized.flags = vertex.tangent.w < 0.f ? 1U : 0U;
+            encodeOctahedral(vertex.normal, quantized.normal);
+            encodeOctahedral(glm::vec3(vertex.tangent), quantized.tangent);
+            quantized.texCoord[0] = vertex.texCoord.x;
+            quantized.texCoord[1] = vertex.texCoord.y;
+            appendValue(file, quantized);
+        }
+
+        for (uint32_t index : mesh.indices) {
+            if (header.indexSize == 2U) appendValue(file, static_cast<uint16_t>(index));
+            else appendValue(file, index);
+        }
+        file.resize(alignUp(file.size(), 4U), 0);
+    }
+
+    std::ofstream output(filePath, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) throw std::runtime_error("Failed to open mesh cache for writing: " + filePath);
+    output.write(file.data(), file.size());
+    if (!output) throw std::runtime_error("Failed to write mesh cache: " + filePath);
+}
+
+std::vector<CookedMesh> MeshCache::loadFromFile(const std::string &filePath)
+{
+    std::vector<char> cacheFile = FileLoader::loadFile(filePath);
+    if (cacheFile.empty()) throw std::runtime_error("Failed to open mesh cache: " + filePath);
+    return parse(cacheFile);
+}
+
+std::vector<CookedMesh> MeshCache::parse(const std::vector<char> &cacheFile)
+{
+    MeshCacheHeader header = readValue<MeshCacheHeader>(cacheFile, 0U);
+    if (header.magic != meshCacheMagic) throw std::runtime_error("Failed to parse mesh cache, not a mesh cache");
+    if (header.version != version) throw std::runtime_error("Failed to parse mesh cache, it was cooked for version " + std::to_string(header.version));
+
+    if (header.meshCount > cacheFile.size() / sizeof(MeshCacheMeshHeader)) throw std::runtime_error("Failed to parse mesh cache, unexpected end of file");
+
+    size_t offset = sizeof(MeshCacheHeader);
+    std::vector<CookedMesh> meshes(header.meshCount);
+    for (CookedMesh &mesh : meshes) {
+        MeshCacheMeshHeader meshHeader = readValue<MeshCacheMeshHeader>(cacheFile, offset);
+        offset += sizeof(MeshCacheMeshHeader);
+        if (meshHeader.indexSize != 2U && meshHeader.indexSize != 4U) throw std::runtime_error("Failed to parse mesh cache, invalid index size");
+
+        uint64_t meshSize = alignUp(meshHeader.nameLength, 4U) + uint64_t(meshHeader.vertexCount) * sizeof(QuantizedVertex) + uint64_t(meshHeader.indexCount) * meshHeader.indexSize;
+        if (offset + meshSize > cacheFile.size()) throw std::runtime_error("Failed to parse mesh cache, unexpected end of file");
+
+        mesh.name.assign(cacheFile.data() + offset, meshHeader.nameLength);
+        offset += alignUp(meshHeader.nameLength, 4U);
+
+        glm::vec3 positionMin = {meshHeader.positionMin[0], meshHeader.positionMin[1], meshHeader.positionMin[2]};
+        glm::vec3 positionScale = {meshHeader.positionScale[0], meshHeader.positionScale[1], meshHeader.positionScale[2]};
+        mesh.vertices.resize(meshHeader.vertexCount);
+        for (Vertex &vertex : mesh.vertices) {
+            QuantizedVertex quantized;
+            memcpy(&quantized, cacheFile.data() + offset, sizeof(QuantizedVertex));
+            offset += sizeof(QuantizedVertex);
+
+            vertex.position = positionMin + positionScale * glm::vec3(quantized.position[0], quantized.position[1], quantized.position[2]);
+            vertex.normal = decodeOctahedral(quantized.normal);
+            vertex.tangent = glm::vec4(decodeOctahedral(quantized.tangent), (quantized.flags & 1U) ? -1.f : 1.f);
+            vertex.texCoord = {quantized.texCoord[0], quantized.texCoord[1]};
+        }
+
+        mesh.indices.resize(meshHeader.indexCount);
+        for (uint32_t &index : mesh.indices) {
+            if (meshHeader.indexSize == 2U) {
+                uint16_t shortIndex;
+                memcpy(&shortIndex, cacheFile.data() + offset, sizeof(uint16_t));
+                index = shortIndex;
+            } else {
+                memcpy(&index, cacheFile.data() + offset, sizeof(uint32_t));
+            }
+            offset += meshHeader.indexSize;
+            if (index >= meshHeader.vertexCount) throw std::runtime_error("Failed to parse mesh cache, index out of range");
+        }
+        offset = alignUp(offset, 4U);
+    }
+    return meshes;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "app-config.h"
+
+/**
+ * A mesh as the runtime uploads it, its vertices already carry their tangents
+ */
+struct CookedMesh {
+    std::string name;
+    std::vector<Vertex> vertices = {};
+    std::vector<uint32_t> indices = {};
+};
+
+/**
+ * @class MeshCache
+ *
+ * @brief Reads and writes the cooked form of an OBJ file, written by the asset cooker next to the OBJ
+ *
+ * Vertices are quantized to 24 bytes: positions to 16 bits per axis within the mesh's bounds, normals and tangents
+ * to 16 bit octahedral pairs, with the tangent handedness in a flag. Indices are stored as 16 bits when the mesh has
+ * few enough vertices. Loading only expands the vertices back to the runtime layout, every other step of importing
+ * (parsing, deduplicating vertices, generating tangents, reordering for the vertex cache) happened when cooking.
+ */
+class MeshCache {
+public:
+    static const uint32_t version = 1U;
+
+    /**
+     * @brief Gets the path of the cache written for an OBJ file
+     */
+    static std::string getCachePath(const std::string &objPath) { return objPath + ".mesh"; }
+
+    /**
+     * @brief Whether the cache of an OBJ file exists, in a mounted archive or on disk, and was written after the OBJ, an
+     * OBJ that cannot be found (such as one only shipped in its cooked form) never outdates its cache
+     */
+    static bool isCurrent(const std::string &objPath);
+
+    static void writeToFile(const std::string &filePath, const std::vector<CookedMesh> &meshes);
+
+    static std::vector<CookedMesh> loadFromFile(const std::string &filePath);
+
+    /**
+     * @brief Parses a cache that is already in memory, throwing if it is not a valid cache of this version
+     */
+    static std::vector<CookedMesh> parse(const std::vector<char> &cacheFile);
+};
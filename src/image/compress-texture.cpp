@@ -0,0 +1,37 @@
+#include "image-loader.h"
+#include "texture-compressor.h"
+#include "ktx2-file.h"
+#include <iostream>
+#include <stdexcept>
+
+/**
+ * Compresses a JPEG into a KTX2 file with a full mip chain
+ * 
+ * Usage: compress-texture <input.jpg> <output.ktx2> <bc7|bc5>
+ */
+int main(int argc, char** argv)
+{
+    if (argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " <input.jpg> <output.ktx2> <bc7|bc5>" << std::endl;
+        return 1;
+    }
+
+    std::string format = argv[3];
+    if (format != "bc7" && format != "bc5") {
+        std::cerr << "Unknown format " << format << ", expected bc7 (albedo) or bc5 (normal maps)" << std::endl;
+        return 1;
+    }
+    TextureCompression compression = format == "bc7" ? TextureCompression::BC7 : TextureCompression::BC5;
+
+    try {
+        Image image = ImageLoader::loadJPEGFromFile(argv[1], 0U);
+        KTX2Texture texture = TextureCompressor::compressWithMipChain(image, compression);
+        KTX2File::writeToFile(argv[2], texture);
+        std::cout << "Wrote " << texture.levels.size() << " levels of " << texture.width << "x" << texture.height << " " << format << " to " << argv[2] << std::endl;
+    }
+    catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
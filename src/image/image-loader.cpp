@@ -4,47 +4,160 @@
 #include <stdexcept>
 #include "inttypes.h"
 
-Image ImageLoader::loadJPEGFromFile(const std::string &filePath, uint32_t alignment)
+/**
+ * Owns a turbojpeg decompressor for the lifetime of a thread. turbojpeg handles are not thread safe, but creating one
+ * per decode is wasteful, so each thread that decodes lazily creates its own and reuses it for every later decode.
+ */
+class ThreadDecompressor {
+    tjhandle handle = nullptr;
+    public:
+    tjhandle get() {
+        if (handle == nullptr) {
+            handle = tj3Init(TJINIT_DECOMPRESS);
+            if (handle == nullptr) throw std::runtime_error("Failed to create a turbojpeg decompressor");
+        }
+        return handle;
+    }
+    ~ThreadDecompressor() {
+        if (handle != nullptr) tj3Destroy(handle);
+    }
+};
+
+static thread_local ThreadDecompressor threadDecompressor;
+
+static const int decodePixelFormat = TJPF_RGBA;
+
+static const unsigned char* getJPEGData(const std::vector<char> &jpegFile)
 {
+    return static_cast<const unsigned char*>(static_cast<const void*>(jpegFile.data()));
+}
+
+Image ImageLoader::loadJPEGHeader(const std::vector<char> &jpegFile)
+{
+    tjhandle turboJpegHandle = threadDecompressor.get();
+
+    // Retrieve image parameters
+    if (tj3DecompressHeader(turboJpegHandle, getJPEGData(jpegFile), jpegFile.size()) != 0) throw std::runtime_error(std::string("Failed to read jpeg header: ") + tj3GetErrorStr(turboJpegHandle));
+
     Image image;
-    image.setRowByteAlignment(alignment);
+    image.setWidth(tj3Get(turboJpegHandle, TJPARAM_JPEGWIDTH));
+    image.setHeight(tj3Get(turboJpegHandle, TJPARAM_JPEGHEIGHT));
+    image.setBytesPerPixel(tjPixelSize[decodePixelFormat]);
+    return image;
+}
+
+/**
+ * Reads the header of a JPEG on this thread's decompressor, which must be done before decompressing, and resets any
+ * scaling left on the shared decompressor by a scaled decode
+ */
+static tjhandle prepareUnscaledDecode(const std::vector<char> &jpegFile)
+{
+    tjhandle turboJpegHandle = threadDecompressor.get();
+    if (tj3DecompressHeader(turboJpegHandle, getJPEGData(jpegFile), jpegFile.size()) != 0) throw std::runtime_error(std::string("Failed to read jpeg header: ") + tj3GetErrorStr(turboJpegHandle));
+    if (tj3SetScalingFactor(turboJpegHandle, TJUNSCALED) != 0) throw std::runtime_error(std::string("Failed to reset jpeg scaling: ") + tj3GetErrorStr(turboJpegHandle));
+    return turboJpegHandle;
+}
+
+void ImageLoader::decodeJPEGInto(const std::vector<char> &jpegFile, void* destination, uint32_t rowPitch)
+{
+    tjhandle turboJpegHandle = prepareUnscaledDecode(jpegFile);
+
+    if (tj3Decompress8(turboJpegHandle, getJPEGData(jpegFile), jpegFile.size(), static_cast<unsigned char*>(destination), rowPitch, decodePixelFormat) != 0) {
+        throw std::runtime_error(std::string("Failed to decompress jpeg image: ") + tj3GetErrorStr(turboJpegHandle));
+    }
+}
+
+void ImageLoader::decodeJPEGRGBInto(const std::vector<char> &jpegFile, void* destination)
+{
+    tjhandle turboJpegHandle = prepareUnscaledDecode(jpegFile);
 
-    tjhandle turboJpegHandle = tj3Init(TJINIT_DECOMPRESS);
-    
+    // A pitch of 0 packs the rows tightly
+    if (tj3Decompress8(turboJpegHandle, getJPEGData(jpegFile), jpegFile.size(), static_cast<unsigned char*>(destination), 0, TJPF_RGB) != 0) {
+        throw std::runtime_error(std::string("Failed to decompress jpeg image: ") + tj3GetErrorStr(turboJpegHandle));
+    }
+}
+
+JPEGPlaneLayout ImageLoader::getJPEGPlaneLayout(const std::vector<char> &jpegFile)
+{
+    tjhandle turboJpegHandle = threadDecompressor.get();
+    if (tj3DecompressHeader(turboJpegHandle, getJPEGData(jpegFile), jpegFile.size()) != 0) throw std::runtime_error(std::string("Failed to read jpeg header: ") + tj3GetErrorStr(turboJpegHandle));
+
+    JPEGPlaneLayout layout;
+    layout.width = tj3Get(turboJpegHandle, TJPARAM_JPEGWIDTH);
+    layout.height = tj3Get(turboJpegHandle, TJPARAM_JPEGHEIGHT);
+
+    int subsampling = tj3Get(turboJpegHandle, TJPARAM_SUBSAMP);
+    int colorspace = tj3Get(turboJpegHandle, TJPARAM_COLORSPACE);
+    if (subsampling < 0 || subsampling >= TJ_NUMSAMP || (colorspace != TJCS_YCbCr && colorspace != TJCS_GRAY)) return layout;
+
+    layout.planeCount = subsampling == TJSAMP_GRAY ? 1U : 3U;
+    layout.chromaScaleX = tjMCUWidth[subsampling] / 8;
+    layout.chromaScaleY = tjMCUHeight[subsampling] / 8;
+    for (uint32_t plane = 0U ; plane < layout.planeCount ; plane++) {
+        layout.planeWidths[plane] = tj3YUVPlaneWidth(plane, layout.width, subsampling);
+        layout.planeHeights[plane] = tj3YUVPlaneHeight(plane, layout.height, subsampling);
+
+        // Planes are decoded with rows aligned to a single byte, so each plane directly follows the previous one
+        layout.planeOffsets[plane] = layout.byteSize;
+        layout.byteSize += layout.planeWidths[plane] * layout.planeHeights[plane];
+    }
+    return layout;
+}
+
+void ImageLoader::decodeJPEGPlanesInto(const std::vector<char> &jpegFile, void* destination)
+{
+    tjhandle turboJpegHandle = prepareUnscaledDecode(jpegFile);
+
+    if (tj3DecompressToYUV8(turboJpegHandle, getJPEGData(jpegFile), jpegFile.size(), static_cast<unsigned char*>(destination), 1) != 0) {
+        throw std::runtime_error(std::string("Failed to decompress jpeg planes: ") + tj3GetErrorStr(turboJpegHandle));
+    }
+}
+
+Image ImageLoader::loadJPEGFromFile(const std::string &filePath, uint32_t alignment)
+{
     std::vector<char> jpegFile = FileLoader::loadFile(filePath);
     if (jpegFile.size() == 0) throw std::runtime_error("Failed to open jpeg image");
-    const unsigned char* jpegData = static_cast<const unsigned char*>(static_cast<void*>(jpegFile.data()));
-    
-    int pixelFormat = TJPF_RGBA;
 
-    // Retrieve image parameters
-    tj3DecompressHeader(turboJpegHandle, jpegData, jpegFile.size());
+    return loadJPEGFromMemory(jpegFile, alignment);
+}
 
-    // Returns the image height and width in pixels, respectively
-    int imageHeight = tj3Get(turboJpegHandle, TJPARAM_JPEGHEIGHT);
-    int imageWidth = tj3Get(turboJpegHandle, TJPARAM_JPEGWIDTH);
+Image ImageLoader::loadJPEGFromMemory(const std::vector<char> &jpegFile, uint32_t alignment)
+{
+    Image image = loadJPEGHeader(jpegFile);
+    image.setRowByteAlignment(alignment);
 
-    image.setWidth(imageWidth);
-    image.setHeight(imageHeight);
+    // Decode straight into a buffer of the final, padded size
+    std::vector<char> outputImageData(image.getPitch() * image.getHeight());
+    decodeJPEGInto(jpegFile, outputImageData.data(), image.getPitch());
 
-    // Returns the number of bits used per sample
-    int precision = tj3Get(turboJpegHandle, TJPARAM_PRECISION);
+    image.setData(std::move(outputImageData));
 
-    int samplesPerPixel = tjPixelSize[pixelFormat];
+    return image;
+}
 
-    // Determine the number of padded pixels needed per row to satisfy memory alignment requirements
-    int paddingPixelsPerRow = alignment == 0 ? 0 : (imageWidth % alignment);
+Image ImageLoader::loadJPEGScaledFromMemory(const std::vector<char> &jpegFile, uint32_t scaleDenominator)
+{
+    if (scaleDenominator != 1U && scaleDenominator != 2U && scaleDenominator != 4U && scaleDenominator != 8U) {
+        throw std::runtime_error("Failed to decode jpeg image, the scale must be 1/1, 1/2, 1/4 or 1/8");
+    }
 
-    // Determine the number of samples per row, aka pitch
-    int pitch = (imageWidth + paddingPixelsPerRow) * samplesPerPixel;
+    tjhandle turboJpegHandle = threadDecompressor.get();
+    if (tj3DecompressHeader(turboJpegHandle, getJPEGData(jpegFile), jpegFile.size()) != 0) throw std::runtime_error(std::string("Failed to read jpeg header: ") + tj3GetErrorStr(turboJpegHandle));
 
-    // Create a vector big enough for the image
-    int outputBufferSize = imageHeight * pitch;
-    std::vector<char> outputImageData(outputBufferSize);
+    tjscalingfactor scalingFactor {1, static_cast<int>(scaleDenominator)};
+    if (tj3SetScalingFactor(turboJpegHandle, scalingFactor) != 0) throw std::runtime_error(std::string("Failed to set jpeg scaling: ") + tj3GetErrorStr(turboJpegHandle));
 
-    tj3Decompress8(turboJpegHandle, jpegData, jpegFile.size(), static_cast<unsigned char*>(static_cast<void*>(outputImageData.data())), pitch, pixelFormat);
+    Image image;
+    image.setWidth(TJSCALED(tj3Get(turboJpegHandle, TJPARAM_JPEGWIDTH), scalingFactor));
+    image.setHeight(TJSCALED(tj3Get(turboJpegHandle, TJPARAM_JPEGHEIGHT), scalingFactor));
+    image.setBytesPerPixel(tjPixelSize[decodePixelFormat]);
+    image.setRowByteAlignment(0U);
 
-    image.setData(outputImageData);
+    std::vector<char> outputImageData(image.getPitch() * image.getHeight());
+    if (tj3Decompress8(turboJpegHandle, getJPEGData(jpegFile), jpegFile.size(), reinterpret_cast<unsigned char*>(outputImageData.data()), image.getPitch(), decodePixelFormat) != 0) {
+        throw std::runtime_error(std::string("Failed to decompress jpeg image: ") + tj3GetErrorStr(turboJpegHandle));
+    }
 
+    image.setData(std::move(outputImageData));
     return image;
-}
\ No newline at end of file
+}
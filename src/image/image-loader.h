@@ -1,7 +1,82 @@
 #pragma once
 #include "image.h"
 
+/**
+ * The layout of a JPEG decoded to its YCbCr planes: the Y plane followed by the Cb and Cr planes, each with rows of
+ * its plane width in bytes. Chroma planes are smaller than the Y plane when the JPEG subsamples chroma.
+ */
+struct JPEGPlaneLayout {
+    uint32_t width = 0U;
+    uint32_t height = 0U;
+
+    // 3, or 1 for grayscale JPEGs, which only have a Y plane. 0 if the JPEG cannot be decoded to YCbCr planes
+    uint32_t planeCount = 0U;
+
+    uint32_t planeWidths[3] = {0U, 0U, 0U};
+    uint32_t planeHeights[3] = {0U, 0U, 0U};
+    uint32_t planeOffsets[3] = {0U, 0U, 0U};
+
+    // The number of Y texels covered by a chroma texel horizontally and vertically, 2 and 2 for 4:2:0
+    uint32_t chromaScaleX = 1U;
+    uint32_t chromaScaleY = 1U;
+
+    uint32_t byteSize = 0U;
+};
+
 class ImageLoader {
 public:
     static Image loadJPEGFromFile(const std::string& filePath, uint32_t alignment);
+
+    /**
+     * @brief Decodes a JPEG that has already been read into memory
+     */
+    static Image loadJPEGFromMemory(const std::vector<char> &jpegFile, uint32_t alignment);
+
+    /**
+     * @brief Decodes a JPEG at a reduced size, which is much cheaper than a full decode since the IDCT is scaled too
+     * 
+     * @param scaleDenominator The image is decoded at 1/scaleDenominator of its size, 1, 2, 4 or 8
+     * 
+     * @return The tightly packed RGBA image, each dimension rounded up after scaling
+     */
+    static Image loadJPEGScaledFromMemory(const std::vector<char> &jpegFile, uint32_t scaleDenominator);
+
+    /**
+     * @brief Reads the dimensions of an encoded JPEG without decoding it
+     * 
+     * @return An image with its width, height and bytes per pixel set, but no pixel data
+     */
+    static Image loadJPEGHeader(const std::vector<char> &jpegFile);
+
+    /**
+     * @brief Decodes a JPEG as RGBA directly into caller-owned memory, such as a mapped staging image
+     * 
+     * @param jpegFile The encoded JPEG file
+     * @param destination The memory to decode into, at least rowPitch * height bytes
+     * @param rowPitch The number of bytes between the start of consecutive rows in the destination
+     */
+    static void decodeJPEGInto(const std::vector<char> &jpegFile, void* destination, uint32_t rowPitch);
+
+    /**
+     * @brief Decodes a JPEG as tightly packed RGB, three bytes per pixel, directly into caller-owned memory
+     * 
+     * @param destination The memory to decode into, at least width * height * 3 bytes
+     */
+    static void decodeJPEGRGBInto(const std::vector<char> &jpegFile, void* destination);
+
+    /**
+     * @brief Gets the layout a JPEG's YCbCr planes are decoded with, without decoding it
+     * 
+     * @return The layout, with a plane count of 0 for JPEGs that are not YCbCr or grayscale (such as CMYK) or whose
+     * chroma subsampling turbojpeg cannot decode to planes
+     */
+    static JPEGPlaneLayout getJPEGPlaneLayout(const std::vector<char> &jpegFile);
+
+    /**
+     * @brief Decodes a JPEG to its YCbCr planes directly into caller-owned memory, skipping colour conversion and
+     * chroma upsampling entirely
+     * 
+     * @param destination The memory to decode into, at least getJPEGPlaneLayout(jpegFile).byteSize bytes
+     */
+    static void decodeJPEGPlanesInto(const std::vector<char> &jpegFile, void* destination);
 };
\ No newline at end of file
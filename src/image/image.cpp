@@ -1,26 +1,22 @@
 #include "image.h"
+#include <cstring>
 
 void Image::setRowByteAlignment(uint32_t rowByteAlignment)
 {
-    uint32_t oldByteAlignment = this->rowByteAlignment;
+    uint32_t oldPitch = getPitch();
+    this->rowByteAlignment = rowByteAlignment;
+    uint32_t newPitch = getPitch();
 
-    // Return immediately if the alignment has not changed
-    if (rowByteAlignment == oldByteAlignment) return; 
+    // Nothing to repack if the pitch has not changed or there is no data yet
+    if (newPitch == oldPitch || imageData.empty()) return;
 
-    // Calculate the old number of bytes used for padding
-    uint32_t oldPaddingBytes = oldByteAlignment == 0U ? 0U : (width * bytesPerPixel) % oldByteAlignment;
-
-    // Calculate the new number of bytes used for padding
-    uint32_t newPaddingBytes = rowByteAlignment == 0U ? 0U : (width * bytesPerPixel) % rowByteAlignment;
-
-    uint32_t newPaddingPixels = newPaddingBytes / bytesPerPixel;
-
-    uint32_t newRowPitch = (width) * bytesPerPixel;
-
-    std::vector<char> newImageData(newRowPitch * height);
+    std::vector<char> newImageData(newPitch * height);
 
+    // Copy each row's pixels to its new offset, the padding at the end of each row is left zeroed
+    uint32_t rowBytes = width * bytesPerPixel;
     for (uint32_t row = 0U ; row < height ; row++) {
-        uint32_t rowPitch = width * bytesPerPixel;
-        uint32_t rowByteOffset = row * rowPitch;
+        memcpy(newImageData.data() + row * newPitch, imageData.data() + row * oldPitch, rowBytes);
     }
+
+    imageData = std::move(newImageData);
 }
\ No newline at end of file
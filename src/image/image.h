@@ -1,30 +1,31 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <utility>
 #include "inttypes.h"
 
 class Image {
     std::vector<char> imageData;
-    uint32_t width;
-    uint32_t height;
+    uint32_t width = 0U;
+    uint32_t height = 0U;
 
-    // The number o
-    uint32_t rowByteAlignment;
-    uint32_t bytesPerPixel;
+    // The alignment, in bytes, that every row is padded to (0 means rows are tightly packed)
+    uint32_t rowByteAlignment = 0U;
+    uint32_t bytesPerPixel = 4U;
     
 
 public:
-    // Sets this image's data
+    // Sets this image's data, taking ownership of it
     void setData(std::vector<char> imageData) {
-        this->imageData = imageData;
+        this->imageData = std::move(imageData);
     }
 
-    // Gets this image's data
-    std::vector<char> getData() {
+    // Gets this image's data, without copying it
+    const std::vector<char>& getData() const {
         return this->imageData;
     }
 
-    uint32_t getHeight() {
+    uint32_t getHeight() const {
         return this->height;
     }
 
@@ -32,7 +33,7 @@ public:
         this->height = height;
     }
 
-    uint32_t getWidth() {
+    uint32_t getWidth() const {
         return this->width;
     }
 
@@ -40,16 +41,36 @@ public:
         this->width = width;
     }
 
-    uint32_t getByteAlignment() {
+    uint32_t getByteAlignment() const {
         return this->rowByteAlignment;
     }
 
+    /**
+     * @brief Sets the row alignment of the image, repacking any existing data to the new pitch
+     */
     void setRowByteAlignment(uint32_t rowByteAlignment);
 
+    uint32_t getBytesPerPixel() const {
+        return this->bytesPerPixel;
+    }
+
+    void setBytesPerPixel(uint32_t bytesPerPixel) {
+        this->bytesPerPixel = bytesPerPixel;
+    }
+
     /**
      * @brief Gets the pitch (number of bytes per row) of the image
      */
-    uint32_t getPitch() {
-        return this->width * this->bytesPerPixel;
+    uint32_t getPitch() const {
+        return getAlignedPitch(this->width, this->bytesPerPixel, this->rowByteAlignment);
+    }
+
+    /**
+     * @brief Gets the number of bytes per row of an image with the given row alignment
+     */
+    static uint32_t getAlignedPitch(uint32_t width, uint32_t bytesPerPixel, uint32_t rowByteAlignment) {
+        uint32_t rowBytes = width * bytesPerPixel;
+        if (rowByteAlignment == 0U) return rowBytes;
+        return ((rowBytes + rowByteAlignment - 1U) / rowByteAlignment) * rowByteAlignment;
     }
 };
\ No newline at end of file
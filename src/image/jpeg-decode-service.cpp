@@ -0,0 +1,53 @@
+#include "jpeg-decode-service.h"
+#include "image-loader.h"
+#include <memory>
+
+void JPEGDecodeService::init()
+{
+    initialized = true;
+}
+
+std::future<Image> JPEGDecodeService::decode(const std::string &filePath, uint32_t alignment)
+{
+    if (!initialized) throw std::runtime_error("Failed to queue jpeg decode, decode service not initialized");
+
+    return JobSystem::shared().runAsync([filePath, alignment]() {
+        return ImageLoader::loadJPEGFromFile(filePath, alignment);
+    }, &decodeJobs);
+}
+
+std::future<void> JPEGDecodeService::decodeInto(std::vector<char> jpegFile, void* destination, uint32_t rowPitch)
+{
+    if (!initialized) throw std::runtime_error("Failed to queue jpeg decode, decode service not initialized");
+
+    // std::function must be copyable, so the file is shared with the job rather than moved into it
+    std::shared_ptr<std::vector<char>> file = std::make_shared<std::vector<char>>(std::move(jpegFile));
+    return JobSystem::shared().runAsync([file, destination, rowPitch]() {
+        ImageLoader::decodeJPEGInto(*file, destination, rowPitch);
+    }, &decodeJobs);
+}
+
+std::vector<Image> JPEGDecodeService::decodeAll(const std::vector<std::string> &filePaths, uint32_t alignment)
+{
+    if (!initialized) throw std::runtime_error("Failed to decode jpegs, decode service not initialized");
+
+    // Waiting on a counter rather than on futures keeps the calling thread decoding, even when it is a worker
+    std::vector<Image> images(filePaths.size());
+    JobCounter counter;
+    for (uint32_t i = 0U ; i < filePaths.size() ; i++) {
+        JobSystem::shared().run([&images, &filePaths, alignment, i]() {
+            images[i] = ImageLoader::loadJPEGFromFile(filePaths[i], alignment);
+        }, &counter);
+    }
+    JobSystem::shared().wait(counter);
+    return images;
+}
+
+void JPEGDecodeService::destroy()
+{
+    if (!initialized) return;
+    initialized = false;
+
+    // The jobs' exceptions are held by their futures, so waiting never throws
+    JobSystem::shared().wait(decodeJobs);
+}
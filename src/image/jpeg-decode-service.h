@@ -0,0 +1,67 @@
+#pragma once
+#include "image.h"
+#include "job-system.h"
+#include <future>
+#include <vector>
+
+/**
+ * @class JPEGDecodeService
+ * 
+ * @brief Decodes JPEG files as jobs on the shared job system
+ * 
+ * Each worker keeps its own turbojpeg decompressor for its whole lifetime (see ImageLoader::loadJPEGFromFile), so
+ * decodes never share a handle and never pay for handle creation. Decoded images are handed back through futures.
+ */
+class JPEGDecodeService {
+    bool initialized = false;
+
+    // Every decode queued since init, waited on by destroy
+    JobCounter decodeJobs;
+
+    public:
+    /**
+     * @brief Starts accepting decodes, which run on JobSystem::shared
+     */
+    void init();
+
+    /**
+     * @brief Queues a JPEG file to be decoded as a job
+     * 
+     * @param filePath The JPEG file to decode
+     * @param alignment The row alignment to decode with, see ImageLoader::loadJPEGFromFile
+     * 
+     * @return A future that holds the decoded image, or the exception thrown while decoding
+     */
+    std::future<Image> decode(const std::string &filePath, uint32_t alignment = 0U);
+
+    /**
+     * @brief Queues an encoded JPEG to be decoded as a job directly into caller-owned memory
+     * 
+     * @note The destination must stay valid until the returned future is ready
+     * 
+     * @param jpegFile The encoded JPEG file, owned by the request until it has been decoded
+     * @param destination The memory to decode into, see ImageLoader::decodeJPEGInto
+     * @param rowPitch The number of bytes between the start of consecutive rows in the destination
+     * 
+     * @return A future that is ready once the decode has finished, or holds the exception thrown while decoding
+     */
+    std::future<void> decodeInto(std::vector<char> jpegFile, void* destination, uint32_t rowPitch);
+
+    /**
+     * @brief Decodes a batch of JPEG files in parallel, running decodes on the calling thread until all of them are done
+     * 
+     * @note Rethrows the first exception thrown while decoding
+     * 
+     * @return The decoded images, in the same order as the file paths
+     */
+    std::vector<Image> decodeAll(const std::vector<std::string> &filePaths, uint32_t alignment = 0U);
+
+    uint32_t getThreadCount() { return JobSystem::shared().getThreadCount(); }
+
+    /**
+     * @brief Finishes any queued decodes
+     */
+    void destroy();
+
+    ~JPEGDecodeService() { destroy(); }
+};
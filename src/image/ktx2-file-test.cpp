@@ -0,0 +1,138 @@
+#include "ktx2-file.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <cstring>
+
+/**
+ * Writes KTX2 files of every supported format and checks they parse back to the same texture, in full and as mip
+ * tails, exits with a non-zero status if any check fails
+ *
+ * Usage: ktx2-file-test
+ */
+static uint32_t failedChecks = 0U;
+
+static void check(bool condition, const std::string &description)
+{
+    if (condition) return;
+    std::cerr << "FAILED: " << description << std::endl;
+    failedChecks++;
+}
+
+/**
+ * @brief Creates a texture with a full mip chain, every byte of it different from its neighbours
+ */
+static KTX2Texture createTexture(uint32_t format, uint32_t width, uint32_t height)
+{
+    KTX2Texture texture;
+    texture.format = format;
+    texture.width = width;
+    texture.height = height;
+
+    uint32_t levelCount = 1U;
+    while ((std::max(width, height) >> levelCount) > 0U) levelCount++;
+
+    for (uint32_t level = 0U ; level < levelCount ; level++) {
+        std::vector<char> data(KTX2File::getLevelByteSize(format, std::max(width >> level, 1U), std::max(height >> level, 1U)));
+        for (uint32_t i = 0U ; i < data.size() ; i++) data[i] = static_cast<char>(i * 7U + level * 31U);
+        texture.levels.push_back(data);
+    }
+    return texture;
+}
+
+static void checkTexture(const KTX2Texture &loaded, const KTX2Texture &written, uint32_t baseLevel, const std::string &name)
+{
+    check(loaded.format == written.format && loaded.width == written.width && loaded.height == written.height, name + ": format and size are read back");
+    check(loaded.baseLevel == baseLevel, name + ": base level is " + std::to_string(baseLevel));
+    check(loaded.levels.size() == written.levels.size() - baseLevel, name + ": every level from the base level is loaded");
+
+    for (uint32_t i = 0U ; i < loaded.levels.size() && baseLevel + i < written.levels.size() ; i++) {
+        check(loaded.levels[i] == written.levels[baseLevel + i], name + ": level " + std::to_string(baseLevel + i) + " holds the data that was written");
+    }
+}
+
+static void testRoundTrip(uint32_t format, uint32_t width, uint32_t height, const std::string &name)
+{
+    std::string filePath = (std::filesystem::temp_directory_path() / ("ktx2-file-test-" + name + ".ktx2")).string();
+    KTX2Texture texture = createTexture(format, width, height);
+    KTX2File::writeToFile(filePath, texture);
+
+    checkTexture(KTX2File::loadFromFile(filePath), texture, 0U, name);
+
+    uint32_t lastLevel = texture.levels.size() - 1U;
+    checkTexture(KTX2File::loadMipTailFromFile(filePath, 1U), texture, 1U, name + " mip tail");
+    checkTexture(KTX2File::loadMipTailFromFile(filePath, 100U), texture, lastLevel, name + " clamped mip tail");
+
+    std::ifstream input(filePath, std::ios::binary);
+    std::vector<char> file((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    input.close();
+
+    // The level index is after the 80 byte identifier, header and index, each entry starts with the level's offset
+    uint32_t alignment = format == KTX2_FORMAT_R8G8B8A8_UNORM ? 4U : 16U;
+    uint64_t previousOffset = UINT64_MAX;
+    for (uint32_t level = 0U ; level <= lastLevel ; level++) {
+        uint64_t byteOffset;
+        memcpy(&byteOffset, file.data() + 80U + level * 24U, sizeof(uint64_t));
+        check(byteOffset % alignment == 0U, name + ": level " + std::to_string(level) + " is aligned to its block size");
+        check(byteOffset < previousOffset, name + ": smaller levels are stored before larger ones");
+        previousOffset = byteOffset;
+    }
+
+    // A container cut off after the tail still parses as long as only the tail is asked for
+    uint64_t tailEnd;
+    memcpy(&tailEnd, file.data() + 80U + lastLevel * 24U, sizeof(uint64_t));
+    tailEnd += texture.levels[lastLevel].size();
+    std::vector<char> truncated(file.begin(), file.begin() + tailEnd);
+    checkTexture(KTX2File::parse(truncated, lastLevel), texture, lastLevel, name + " truncated tail");
+
+    bool threw = false;
+    try { KTX2File::parse(truncated, 0U); } catch (const std::runtime_error &) { threw = true; }
+    check(threw, name + ": parsing levels past the end of a truncated container throws");
+
+    std::filesystem::remove(filePath);
+}
+
+static void testInvalidContainers()
+{
+    KTX2Texture texture = createTexture(KTX2_FORMAT_R8G8B8A8_UNORM, 4U, 4U);
+    std::string filePath = (std::filesystem::temp_directory_path() / "ktx2-file-test-invalid.ktx2").string();
+    KTX2File::writeToFile(filePath, texture);
+    std::ifstream input(filePath, std::ios::binary);
+    std::vector<char> file((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    input.close();
+    std::filesystem::remove(filePath);
+
+    std::vector<char> badIdentifier = file;
+    badIdentifier[1] = 'X';
+    bool threw = false;
+    try { KTX2File::parse(badIdentifier); } catch (const std::runtime_error &) { threw = true; }
+    check(threw, "a container with the wrong identifier is rejected");
+
+    std::vector<char> badFormat = file;
+    uint32_t unsupportedFormat = 43U;
+    memcpy(badFormat.data() + 12U, &unsupportedFormat, sizeof(uint32_t));
+    threw = false;
+    try { KTX2File::parse(badFormat); } catch (const std::runtime_error &) { threw = true; }
+    check(threw, "a container of an unsupported format is rejected");
+
+    KTX2Texture mipTail = KTX2File::parse(file, 1U);
+    threw = false;
+    try { KTX2File::writeToFile(filePath, mipTail); } catch (const std::runtime_error &) { threw = true; }
+    check(threw, "a texture without its largest levels cannot be written");
+}
+
+int main()
+{
+    testRoundTrip(KTX2_FORMAT_R8G8B8A8_UNORM, 13U, 6U, "rgba8");
+    testRoundTrip(KTX2_FORMAT_BC7_UNORM_BLOCK, 64U, 32U, "bc7");
+    testRoundTrip(KTX2_FORMAT_BC5_UNORM_BLOCK, 20U, 12U, "bc5");
+    testInvalidContainers();
+
+    if (failedChecks > 0U) {
+        std::cerr << failedChecks << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All ktx2 file checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,255 @@
+#include "ktx2-file.h"
+#include "file-loader.h"
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+static const unsigned char ktx2Identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+// Byte sizes of the fixed parts of the container: identifier, header, index, and a single level index entry
+static const uint32_t identifierSize = 12U;
+static const uint32_t headerSize = 9U * sizeof(uint32_t);
+static const uint32_t indexSize = 4U * sizeof(uint32_t) + 2U * sizeof(uint64_t);
+static const uint32_t levelIndexEntrySize = 3U * sizeof(uint64_t);
+
+// Data format descriptor colour models and channels (see the Khronos Data Format Specification)
+static const uint8_t dfdModelRGBSDA = 1U;
+static const uint8_t dfdModelBC5 = 132U;
+static const uint8_t dfdModelBC7 = 134U;
+static const uint8_t dfdPrimariesBT709 = 1U;
+static const uint8_t dfdTransferLinear = 1U;
+
+struct DFDSample {
+    uint16_t bitOffset;
+    uint8_t bitLength;
+    uint8_t channelType;
+    uint32_t upper;
+};
+
+template <typename T>
+static void writeValue(std::vector<char> &data, uint32_t offset, T value)
+{
+    memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+static T readValue(const char* data, size_t dataSize, uint64_t offset)
+{
+    if (offset + sizeof(T) > dataSize) throw std::runtime_error("Failed to parse ktx2 file, unexpected end of file");
+    T value;
+    memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+static uint32_t alignUp(uint32_t value, uint32_t alignment)
+{
+    return ((value + alignment - 1U) / alignment) * alignment;
+}
+
+uint32_t KTX2File::getBlockByteSize(uint32_t format)
+{
+    switch (format) {
+        case KTX2_FORMAT_R8G8B8A8_UNORM : return 4U;
+        case KTX2_FORMAT_BC5_UNORM_BLOCK :
+        case KTX2_FORMAT_BC7_UNORM_BLOCK : return 16U;
+        default: throw std::runtime_error("Unsupported ktx2 format");
+    }
+}
+
+uint32_t KTX2File::getBlockDimension(uint32_t format)
+{
+    return format == KTX2_FORMAT_R8G8B8A8_UNORM ? 1U : 4U;
+}
+
+uint32_t KTX2File::getLevelByteSize(uint32_t format, uint32_t width, uint32_t height)
+{
+    uint32_t blockDimension = getBlockDimension(format);
+    uint32_t blocksWide = (width + blockDimension - 1U) / blockDimension;
+    uint32_t blocksHigh = (height + blockDimension - 1U) / blockDimension;
+    return blocksWide * blocksHigh * getBlockByteSize(format);
+}
+
+/**
+ * Builds the basic data format descriptor, which KTX2 requires to describe the format independently of Vulkan
+ */
+static std::vector<char> createDataFormatDescriptor(uint32_t format)
+{
+    uint8_t colorModel = dfdModelRGBSDA;
+    std::vector<DFDSample> samples = {};
+    switch (format) {
+        case KTX2_FORMAT_R8G8B8A8_UNORM :
+            //          {offset, length - 1, channel, upper}
+            samples = { {0U, 7U, 0U, 255U}, {8U, 7U, 1U, 255U}, {16U, 7U, 2U, 255U}, {24U, 7U, 15U, 255U} };
+            break;
+        case KTX2_FORMAT_BC5_UNORM_BLOCK :
+            colorModel = dfdModelBC5;
+            samples = { {0U, 63U, 0U, UINT32_MAX}, {64U, 63U, 1U, UINT32_MAX} };
+            break;
+        case KTX2_FORMAT_BC7_UNORM_BLOCK :
+            colorModel = dfdModelBC7;
+            samples = { {0U, 127U, 0U, UINT32_MAX} };
+            break;
+        default:
+            throw std::runtime_error("Unsupported ktx2 format");
+    }
+
+    uint32_t blockSize = 24U + 16U * samples.size();
+    std::vector<char> dfd(sizeof(uint32_t) + blockSize, 0);
+    uint32_t blockDimension = KTX2File::getBlockDimension(format) - 1U;
+
+    writeValue<uint32_t>(dfd, 0U, dfd.size());
+    writeValue<uint32_t>(dfd, 4U, 0U); // Khronos vendor, basic descriptor type
+    writeValue<uint16_t>(dfd, 8U, 2U); // Version 1.3
+    writeValue<uint16_t>(dfd, 10U, blockSize);
+    writeValue<uint8_t>(dfd, 12U, colorModel);
+    writeValue<uint8_t>(dfd, 13U, dfdPrimariesBT709);
+    writeValue<uint8_t>(dfd, 14U, dfdTransferLinear);
+    writeValue<uint8_t>(dfd, 15U, 0U); // Straight alpha
+    writeValue<uint8_t>(dfd, 16U, blockDimension);
+    writeValue<uint8_t>(dfd, 17U, blockDimension);
+    writeValue<uint8_t>(dfd, 20U, KTX2File::getBlockByteSize(format)); // Bytes in plane 0
+
+    for (uint32_t i = 0U ; i < samples.size() ; i++) {
+        uint32_t sampleOffset = 28U + 16U * i;
+        writeValue<uint16_t>(dfd, sampleOffset, samples[i].bitOffset);
+        writeValue<uint8_t>(dfd, sampleOffset + 2U, samples[i].bitLength);
+        writeValue<uint8_t>(dfd, sampleOffset + 3U, samples[i].channelType);
+        writeValue<uint32_t>(dfd, sampleOffset + 8U, 0U);
+        writeValue<uint32_t>(dfd, sampleOffset + 12U, samples[i].upper);
+    }
+    return dfd;
+}
+
+void KTX2File::writeToFile(const std::string &filePath, const KTX2Texture &texture)
+{
+    uint32_t levelCount = texture.levels.size();
+    if (levelCount == 0U) throw std::runtime_error("Failed to write ktx2 file, texture has no levels");
+    if (texture.baseLevel != 0U) throw std::runtime_error("Failed to write ktx2 file, texture is missing its largest levels");
+
+    std::vector<char> dfd = createDataFormatDescriptor(texture.format);
+
+    // Mip levels must be aligned to the least common multiple of the block size and 4
+    uint32_t levelAlignment = getBlockByteSize(texture.format) % 4U == 0U ? getBlockByteSize(texture.format) : 4U;
+    uint32_t levelIndexOffset = identifierSize + headerSize + indexSize;
+    uint32_t dfdOffset = levelIndexOffset + levelCount * levelIndexEntrySize;
+
+    // KTX2 stores the smallest level first, so that streaming readers get a usable image as early as possible
+    std::vector<uint32_t> levelOffsets(levelCount);
+    uint32_t fileSize = dfdOffset + dfd.size();
+    for (uint32_t level = levelCount ; level-- > 0U ; ) {
+        fileSize = alignUp(fileSize, levelAlignment);
+        levelOffsets[level] = fileSize;
+        fileSize += texture.levels[level].size();
+    }
+
+    std::vector<char> file(fileSize, 0);
+    memcpy(file.data(), ktx2Identifier, identifierSize);
+
+    uint32_t offset = identifierSize;
+    writeValue<uint32_t>(file, offset, texture.format); offset += 4U;
+    writeValue<uint32_t>(file, offset, 1U); offset += 4U; // typeSize
+    writeValue<uint32_t>(file, offset, texture.width); offset += 4U;
+    writeValue<uint32_t>(file, offset, texture.height); offset += 4U;
+    writeValue<uint32_t>(file, offset, 0U); offset += 4U; // pixelDepth
+    writeValue<uint32_t>(file, offset, 0U); offset += 4U; // layerCount, 0 for a non-array texture
+    writeValue<uint32_t>(file, offset, 1U); offset += 4U; // faceCount
+    writeValue<uint32_t>(file, offset, levelCount); offset += 4U;
+    writeValue<uint32_t>(file, offset, 0U); offset += 4U; // supercompressionScheme
+
+    writeValue<uint32_t>(file, offset, dfdOffset); offset += 4U;
+    writeValue<uint32_t>(file, offset, dfd.size()); offset += 4U;
+    writeValue<uint32_t>(file, offset, 0U); offset += 4U; // kvdByteOffset
+    writeValue<uint32_t>(file, offset, 0U); offset += 4U; // kvdByteLength
+    writeValue<uint64_t>(file, offset, 0U); offset += 8U; // sgdByteOffset
+    writeValue<uint64_t>(file, offset, 0U); offset += 8U; // sgdByteLength
+
+    for (uint32_t level = 0U ; level < levelCount ; level++) {
+        writeValue<uint64_t>(file, offset, levelOffsets[level]); offset += 8U;
+        writeValue<uint64_t>(file, offset, texture.levels[level].size()); offset += 8U;
+        writeValue<uint64_t>(file, offset, texture.levels[level].size()); offset += 8U;
+    }
+
+    memcpy(file.data() + dfdOffset, dfd.data(), dfd.size());
+    for (uint32_t level = 0U ; level < levelCount ; level++) {
+        memcpy(file.data() + levelOffsets[level], texture.levels[level].data(), texture.levels[level].size());
+    }
+
+    std::ofstream output(filePath, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) throw std::runtime_error("Failed to open ktx2 file for writing: " + filePath);
+    output.write(file.data(), file.size());
+    if (!output) throw std::runtime_error("Failed to write ktx2 file: " + filePath);
+}
+
+KTX2Texture KTX2File::loadFromFile(const std::string &filePath)
+{
+    MappedFile ktx2File = FileLoader::mapFile(filePath, FileAccessPattern::SEQUENTIAL);
+    return parse(ktx2File.data(), ktx2File.size());
+}
+
+KTX2Texture KTX2File::loadMipTailFromFile(const std::string &filePath, uint32_t baseLevel)
+{
+    // Only the pages that are touched are read, so mapping the whole file reads just the header and the tail
+    MappedFile ktx2File = FileLoader::mapFile(filePath, FileAccessPattern::RANDOM);
+    if (ktx2File.size() < identifierSize + headerSize + indexSize) throw std::runtime_error("Failed to parse ktx2 file, unexpected end of file: " + filePath);
+
+    uint32_t levelCount = std::max(readValue<uint32_t>(ktx2File.data(), ktx2File.size(), 40U), 1U);
+    baseLevel = std::min(baseLevel, levelCount - 1U);
+
+    // Random access stops the kernel reading ahead into the finer levels, so ask for the tail up front instead
+    uint64_t tailEnd = 0U;
+    uint64_t levelIndexOffset = identifierSize + headerSize + indexSize;
+    for (uint32_t level = baseLevel ; level < levelCount ; level++) {
+        uint64_t entryOffset = levelIndexOffset + level * levelIndexEntrySize;
+        tailEnd = std::max(tailEnd, readValue<uint64_t>(ktx2File.data(), ktx2File.size(), entryOffset) + readValue<uint64_t>(ktx2File.data(), ktx2File.size(), entryOffset + 8U));
+    }
+    ktx2File.advise(FileAccessPattern::WILL_NEED, 0U, tailEnd);
+
+    return parse(ktx2File.data(), ktx2File.size(), baseLevel);
+}
+
+KTX2Texture KTX2File::parse(const std::vector<char> &ktx2File, uint32_t baseLevel)
+{
+    return parse(ktx2File.data(), ktx2File.size(), baseLevel);
+}
+
+KTX2Texture KTX2File::parse(const char* ktx2File, size_t fileSize, uint32_t baseLevel)
+{
+    if (fileSize < identifierSize + headerSize + indexSize || memcmp(ktx2File, ktx2Identifier, identifierSize) != 0) {
+        throw std::runtime_error("Failed to parse ktx2 file, invalid identifier");
+    }
+
+    KTX2Texture texture;
+    texture.format = readValue<uint32_t>(ktx2File, fileSize, 12U);
+    texture.width = readValue<uint32_t>(ktx2File, fileSize, 20U);
+    texture.height = readValue<uint32_t>(ktx2File, fileSize, 24U);
+    uint32_t pixelDepth = readValue<uint32_t>(ktx2File, fileSize, 28U);
+    uint32_t layerCount = readValue<uint32_t>(ktx2File, fileSize, 32U);
+    uint32_t faceCount = readValue<uint32_t>(ktx2File, fileSize, 36U);
+    uint32_t levelCount = std::max(readValue<uint32_t>(ktx2File, fileSize, 40U), 1U);
+    uint32_t supercompressionScheme = readValue<uint32_t>(ktx2File, fileSize, 44U);
+
+    // Validates the format
+    getBlockByteSize(texture.format);
+    if (pixelDepth > 1U || layerCount > 1U || faceCount != 1U) throw std::runtime_error("Failed to parse ktx2 file, only single layer 2D textures are supported");
+    if (supercompressionScheme != 0U) throw std::runtime_error("Failed to parse ktx2 file, supercompression is not supported");
+
+    if (baseLevel >= levelCount) throw std::runtime_error("Failed to parse ktx2 file, the texture has fewer levels than requested");
+    texture.baseLevel = baseLevel;
+
+    uint64_t levelIndexOffset = identifierSize + headerSize + indexSize;
+    for (uint32_t level = baseLevel ; level < levelCount ; level++) {
+        uint64_t entryOffset = levelIndexOffset + level * levelIndexEntrySize;
+        uint64_t byteOffset = readValue<uint64_t>(ktx2File, fileSize, entryOffset);
+        uint64_t byteLength = readValue<uint64_t>(ktx2File, fileSize, entryOffset + 8U);
+
+        uint32_t levelWidth = std::max(texture.width >> level, 1U);
+        uint32_t levelHeight = std::max(texture.height >> level, 1U);
+        if (byteLength != getLevelByteSize(texture.format, levelWidth, levelHeight) || byteOffset + byteLength > fileSize) {
+            throw std::runtime_error("Failed to parse ktx2 file, invalid level index");
+        }
+
+        texture.levels.emplace_back(ktx2File + byteOffset, ktx2File + byteOffset + byteLength);
+    }
+    return texture;
+}
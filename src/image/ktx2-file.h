@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "inttypes.h"
+
+/**
+ * Vulkan format values as stored in KTX2 headers. The image library does not depend on Vulkan, so the values of
+ * the VkFormat enumerants it reads and writes are mirrored here.
+ */
+enum KTX2Format : uint32_t {
+    KTX2_FORMAT_R8G8B8A8_UNORM = 37U,
+    KTX2_FORMAT_BC5_UNORM_BLOCK = 141U,
+    KTX2_FORMAT_BC7_UNORM_BLOCK = 145U
+};
+
+/**
+ * A 2D texture with its mip chain, as stored in a KTX2 container
+ */
+struct KTX2Texture {
+    uint32_t format = KTX2_FORMAT_R8G8B8A8_UNORM;
+    uint32_t width = 0U;
+    uint32_t height = 0U;
+
+    // The mip level held by levels[0], non-zero when only the smaller levels (the mip tail) are loaded
+    uint32_t baseLevel = 0U;
+
+    // The data of every loaded mip level, from baseLevel down to the smallest level
+    std::vector<std::vector<char>> levels = {};
+};
+
+/**
+ * @class KTX2File
+ *
+ * @brief Reads and writes uncompressed (no supercompression) single layer 2D KTX2 containers
+ */
+class KTX2File {
+public:
+    /**
+     * @brief Gets the number of bytes in a texel block of a supported format (a single texel for uncompressed formats)
+     */
+    static uint32_t getBlockByteSize(uint32_t format);
+
+    /**
+     * @brief Gets the width and height, in texels, of a block of a supported format
+     */
+    static uint32_t getBlockDimension(uint32_t format);
+
+    /**
+     * @brief Gets the number of bytes a mip level of the given size occupies
+     */
+    static uint32_t getLevelByteSize(uint32_t format, uint32_t width, uint32_t height);
+
+    static void writeToFile(const std::string &filePath, const KTX2Texture &texture);
+
+    static KTX2Texture loadFromFile(const std::string &filePath);
+
+    /**
+     * @brief Loads only the mip levels from baseLevel down to the smallest
+     * 
+     * KTX2 stores the smallest levels first, so only the pages at the start of the mapped file are read.
+     * 
+     * @param baseLevel The largest level to load, clamped to the smallest level of the texture
+     */
+    static KTX2Texture loadMipTailFromFile(const std::string &filePath, uint32_t baseLevel);
+
+    /**
+     * @brief Parses a KTX2 container that is already in memory
+     * 
+     * @param ktx2File The container, it may be truncated after the end of the last level that is loaded
+     * @param baseLevel The largest level to load
+     */
+    static KTX2Texture parse(const std::vector<char> &ktx2File, uint32_t baseLevel = 0U);
+
+    /**
+     * @brief Parses a KTX2 container in place, such as a mapped file, copying out only the levels that are loaded
+     */
+    static KTX2Texture parse(const char* ktx2File, size_t fileSize, uint32_t baseLevel = 0U);
+};
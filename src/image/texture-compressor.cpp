@@ -0,0 +1,376 @@
+#include "texture-compressor.h"
+#include "job-system.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+#include "float4.h"
+
+// Below this many blocks per job, spreading the work across threads costs more than it saves
+static const uint32_t minBlocksPerJob = 1024U;
+
+// BC7 interpolation weights for 4-bit indices, out of 64
+static const uint32_t bc7Weights4[16] = {0U, 4U, 9U, 13U, 17U, 21U, 26U, 30U, 34U, 38U, 43U, 47U, 51U, 55U, 60U, 64U};
+
+namespace {
+
+/**
+ * Writes a 128-bit block least significant bit first, as BC7 is laid out
+ */
+struct BlockBitWriter {
+    uint8_t bytes[16] = {};
+    uint32_t position = 0U;
+
+    void write(uint32_t value, uint32_t bitCount) {
+        for (uint32_t bit = 0U ; bit < bitCount ; bit++, position++) {
+            if ((value >> bit) & 1U) bytes[position / 8U] |= static_cast<uint8_t>(1U << (position % 8U));
+        }
+    }
+};
+
+/**
+ * A mode 6 BC7 encoding of a block, endpoints are 7 bits per channel plus a shared p-bit per endpoint
+ */
+struct BC7Mode6Block {
+    uint32_t endpoints[2][4];
+    uint32_t pBits[2];
+    uint32_t indices[16];
+    float error;
+};
+
+}
+
+/**
+ * Reads a 4x4 block of RGBA8 texels, repeating the last row/column for blocks that overhang the image
+ */
+static void loadBlock(const Image &image, uint32_t blockX, uint32_t blockY, uint8_t texels[16][4])
+{
+    const std::vector<char> &data = image.getData();
+    for (uint32_t y = 0U ; y < 4U ; y++) {
+        uint32_t row = std::min(blockY * 4U + y, image.getHeight() - 1U);
+        for (uint32_t x = 0U ; x < 4U ; x++) {
+            uint32_t column = std::min(blockX * 4U + x, image.getWidth() - 1U);
+            memcpy(texels[y * 4U + x], data.data() + row * image.getPitch() + column * 4U, 4U);
+        }
+    }
+}
+
+static void encodeBC4(const uint8_t values[16], uint8_t output[8])
+{
+    uint8_t minValue = 255U, maxValue = 0U;
+    for (uint32_t i = 0U ; i < 16U ; i++) {
+        minValue = std::min(minValue, values[i]);
+        maxValue = std::max(maxValue, values[i]);
+    }
+
+    // With the first endpoint larger than the second, the block interpolates 6 values between them
+    uint64_t block = static_cast<uint64_t>(maxValue) | (static_cast<uint64_t>(minValue) << 8U);
+    if (maxValue != minValue) {
+        float palette[8] = {static_cast<float>(maxValue), static_cast<float>(minValue)};
+        for (uint32_t i = 2U ; i < 8U ; i++) palette[i] = ((8U - i) * maxValue + (i - 1U) * minValue) / 7.f;
+
+        for (uint32_t i = 0U ; i < 16U ; i++) {
+            uint64_t bestIndex = 0U;
+            float bestError = 256.f;
+            for (uint32_t p = 0U ; p < 8U ; p++) {
+                float error = std::fabs(palette[p] - values[i]);
+                if (error < bestError) {
+                    bestError = error;
+                    bestIndex = p;
+                }
+            }
+            block |= bestIndex << (16U + 3U * i);
+        }
+    }
+    memcpy(output, &block, 8U);
+}
+
+static void encodeBC5Block(const uint8_t texels[16][4], uint8_t output[16])
+{
+    uint8_t red[16], green[16];
+    for (uint32_t i = 0U ; i < 16U ; i++) {
+        red[i] = texels[i][0];
+        green[i] = texels[i][1];
+    }
+    encodeBC4(red, output);
+    encodeBC4(green, output + 8U);
+}
+
+/**
+ * Quantizes an endpoint to 7 bits per channel, choosing the p-bit that best reproduces it
+ */
+static void quantizeBC7Endpoint(const float endpoint[4], uint32_t quantized[4], uint32_t &pBit)
+{
+    float bestError = -1.f;
+    for (uint32_t p = 0U ; p < 2U ; p++) {
+        uint32_t candidate[4];
+        float error = 0.f;
+        for (uint32_t c = 0U ; c < 4U ; c++) {
+            float value = std::round((endpoint[c] - p) / 2.f);
+            candidate[c] = static_cast<uint32_t>(std::clamp(value, 0.f, 127.f));
+            float difference = static_cast<float>((candidate[c] << 1U) | p) - endpoint[c];
+            error += difference * difference;
+        }
+        if (bestError < 0.f || error < bestError) {
+            bestError = error;
+            pBit = p;
+            memcpy(quantized, candidate, sizeof(candidate));
+        }
+    }
+}
+
+/**
+ * Quantizes a pair of endpoints and picks the closest palette entry for every texel
+ */
+static BC7Mode6Block fitBC7Mode6(const uint8_t texels[16][4], const float endpoints[2][4])
+{
+    BC7Mode6Block block;
+    quantizeBC7Endpoint(endpoints[0], block.endpoints[0], block.pBits[0]);
+    quantizeBC7Endpoint(endpoints[1], block.endpoints[1], block.pBits[1]);
+
+    // Expand the palette in structure-of-arrays form, so that four entries are scored per operation
+    alignas(16) float palette[4][16];
+    for (uint32_t c = 0U ; c < 4U ; c++) {
+        uint32_t e0 = (block.endpoints[0][c] << 1U) | block.pBits[0];
+        uint32_t e1 = (block.endpoints[1][c] << 1U) | block.pBits[1];
+        for (uint32_t i = 0U ; i < 16U ; i++) {
+            palette[c][i] = static_cast<float>(((64U - bc7Weights4[i]) * e0 + bc7Weights4[i] * e1 + 32U) >> 6U);
+        }
+    }
+
+    block.error = 0.f;
+    for (uint32_t t = 0U ; t < 16U ; t++) {
+        Float4 texel[4] = {
+            Float4::splat(texels[t][0]), Float4::splat(texels[t][1]), Float4::splat(texels[t][2]), Float4::splat(texels[t][3])
+        };
+
+        alignas(16) float errors[16];
+        for (uint32_t i = 0U ; i < 16U ; i += 4U) {
+            Float4 error = Float4::splat(0.f);
+            for (uint32_t c = 0U ; c < 4U ; c++) {
+                Float4 difference = Float4::load(&palette[c][i]) - texel[c];
+                error = error + difference * difference;
+            }
+            error.store(&errors[i]);
+        }
+
+        uint32_t bestIndex = static_cast<uint32_t>(std::min_element(errors, errors + 16) - errors);
+        block.indices[t] = bestIndex;
+        block.error += errors[bestIndex];
+    }
+    return block;
+}
+
+/**
+ * Chooses initial endpoints at the extent of the texels along their principal axis
+ */
+static void selectBC7Endpoints(const uint8_t texels[16][4], float endpoints[2][4])
+{
+    float mean[4] = {};
+    for (uint32_t t = 0U ; t < 16U ; t++) {
+        for (uint32_t c = 0U ; c < 4U ; c++) mean[c] += texels[t][c] / 16.f;
+    }
+
+    float covariance[4][4] = {};
+    for (uint32_t t = 0U ; t < 16U ; t++) {
+        for (uint32_t i = 0U ; i < 4U ; i++) {
+            for (uint32_t j = 0U ; j < 4U ; j++) covariance[i][j] += (texels[t][i] - mean[i]) * (texels[t][j] - mean[j]);
+        }
+    }
+
+    // A few power iterations converge on the principal axis well enough for a 16 texel block
+    float axis[4] = {1.f, 1.f, 1.f, 1.f};
+    for (uint32_t iteration = 0U ; iteration < 8U ; iteration++) {
+        float next[4] = {};
+        float length = 0.f;
+        for (uint32_t i = 0U ; i < 4U ; i++) {
+            for (uint32_t j = 0U ; j < 4U ; j++) next[i] += covariance[i][j] * axis[j];
+            length += next[i] * next[i];
+        }
+        length = std::sqrt(length);
+        if (length < 1e-6f) break;
+        for (uint32_t i = 0U ; i < 4U ; i++) axis[i] = next[i] / length;
+    }
+
+    float minProjection = 0.f, maxProjection = 0.f;
+    for (uint32_t t = 0U ; t < 16U ; t++) {
+        float projection = 0.f;
+        for (uint32_t c = 0U ; c < 4U ; c++) projection += (texels[t][c] - mean[c]) * axis[c];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    for (uint32_t c = 0U ; c < 4U ; c++) {
+        endpoints[0][c] = std::clamp(mean[c] + axis[c] * minProjection, 0.f, 255.f);
+        endpoints[1][c] = std::clamp(mean[c] + axis[c] * maxProjection, 0.f, 255.f);
+    }
+}
+
+/**
+ * Refits the endpoints to the chosen indices with least squares
+ */
+static bool refitBC7Endpoints(const uint8_t texels[16][4], const BC7Mode6Block &block, float endpoints[2][4])
+{
+    float aa = 0.f, ab = 0.f, bb = 0.f;
+    float ax[4] = {}, bx[4] = {};
+    for (uint32_t t = 0U ; t < 16U ; t++) {
+        float b = bc7Weights4[block.indices[t]] / 64.f;
+        float a = 1.f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (uint32_t c = 0U ; c < 4U ; c++) {
+            ax[c] += a * texels[t][c];
+            bx[c] += b * texels[t][c];
+        }
+    }
+
+    float determinant = aa * bb - ab * ab;
+    if (std::fabs(determinant) < 1e-6f) return false;
+
+    for (uint32_t c = 0U ; c < 4U ; c++) {
+        endpoints[0][c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.f, 255.f);
+        endpoints[1][c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.f, 255.f);
+    }
+    return true;
+}
+
+static void encodeBC7Block(const uint8_t texels[16][4], uint8_t output[16])
+{
+    float endpoints[2][4];
+    selectBC7Endpoints(texels, endpoints);
+    BC7Mode6Block block = fitBC7Mode6(texels, endpoints);
+
+    if (refitBC7Endpoints(texels, block, endpoints)) {
+        BC7Mode6Block refitted = fitBC7Mode6(texels, endpoints);
+        if (refitted.error < block.error) block = refitted;
+    }
+
+    // The most significant bit of the first index is implied to be 0, flip the block around if it is set
+    if (block.indices[0] >= 8U) {
+        std::swap(block.endpoints[0], block.endpoints[1]);
+        std::swap(block.pBits[0], block.pBits[1]);
+        for (uint32_t t = 0U ; t < 16U ; t++) block.indices[t] = 15U - block.indices[t];
+    }
+
+    BlockBitWriter writer;
+    writer.write(1U << 6U, 7U); // Mode 6
+    for (uint32_t c = 0U ; c < 4U ; c++) {
+        writer.write(block.endpoints[0][c], 7U);
+        writer.write(block.endpoints[1][c], 7U);
+    }
+    writer.write(block.pBits[0], 1U);
+    writer.write(block.pBits[1], 1U);
+    writer.write(block.indices[0], 3U);
+    for (uint32_t t = 1U ; t < 16U ; t++) writer.write(block.indices[t], 4U);
+
+    memcpy(output, writer.bytes, 16U);
+}
+
+std::vector<char> TextureCompressor::compress(const Image &image, TextureCompression compression)
+{
+    if (image.getBytesPerPixel() != 4U) throw std::runtime_error("Failed to compress image, only RGBA8 images are supported");
+    if (compression == TextureCompression::NONE) throw std::runtime_error("Failed to compress image, no block compression was given");
+
+    uint32_t blocksWide = (image.getWidth() + 3U) / 4U;
+    uint32_t blocksHigh = (image.getHeight() + 3U) / 4U;
+    std::vector<char> output(blocksWide * blocksHigh * 16U);
+
+    auto compressRows = [&](uint32_t firstRow, uint32_t lastRow) {
+        uint8_t texels[16][4];
+        for (uint32_t blockY = firstRow ; blockY < lastRow ; blockY++) {
+            for (uint32_t blockX = 0U ; blockX < blocksWide ; blockX++) {
+                loadBlock(image, blockX, blockY, texels);
+                uint8_t* block = reinterpret_cast<uint8_t*>(output.data()) + (blockY * blocksWide + blockX) * 16U;
+                if (compression == TextureCompression::BC7) encodeBC7Block(texels, block);
+                else encodeBC5Block(texels, block);
+            }
+        }
+    };
+
+    // Blocks are independent, so bands of block rows of about minBlocksPerJob blocks are compressed in parallel
+    uint32_t rowsPerJob = std::max(1U, minBlocksPerJob / blocksWide);
+    if (blocksHigh <= rowsPerJob) {
+        compressRows(0U, blocksHigh);
+        return output;
+    }
+
+    JobSystem::shared().parallelFor(0U, blocksHigh, compressRows, rowsPerJob);
+    return output;
+}
+
+std::vector<Image> TextureCompressor::generateMipChain(const Image &image)
+{
+    if (image.getBytesPerPixel() != 4U) throw std::runtime_error("Failed to generate mip chain, only RGBA8 images are supported");
+
+    // Start from a tightly packed copy so that every level is addressed the same way
+    Image baseLevel = image;
+    baseLevel.setRowByteAlignment(0U);
+    std::vector<Image> levels = {baseLevel};
+
+    while (levels.back().getWidth() > 1U || levels.back().getHeight() > 1U) {
+        const Image &source = levels.back();
+        uint32_t sourceWidth = source.getWidth(), sourceHeight = source.getHeight();
+        uint32_t width = std::max(sourceWidth / 2U, 1U), height = std::max(sourceHeight / 2U, 1U);
+
+        const uint8_t* sourceData = reinterpret_cast<const uint8_t*>(source.getData().data());
+        std::vector<char> levelData(width * height * 4U);
+        for (uint32_t y = 0U ; y < height ; y++) {
+            uint32_t y0 = y * 2U, y1 = std::min(y * 2U + 1U, sourceHeight - 1U);
+            for (uint32_t x = 0U ; x < width ; x++) {
+                uint32_t x0 = x * 2U, x1 = std::min(x * 2U + 1U, sourceWidth - 1U);
+                for (uint32_t c = 0U ; c < 4U ; c++) {
+                    uint32_t sum = sourceData[(y0 * sourceWidth + x0) * 4U + c] + sourceData[(y0 * sourceWidth + x1) * 4U + c]
+                                 + sourceData[(y1 * sourceWidth + x0) * 4U + c] + sourceData[(y1 * sourceWidth + x1) * 4U + c];
+                    levelData[(y * width + x) * 4U + c] = static_cast<char>((sum + 2U) / 4U);
+                }
+            }
+        }
+
+        Image level;
+        level.setWidth(width);
+        level.setHeight(height);
+        level.setBytesPerPixel(4U);
+        level.setData(std::move(levelData));
+        levels.push_back(std::move(level));
+    }
+    return levels;
+}
+
+KTX2Texture TextureCompressor::compressWithMipChain(const Image &image, TextureCompression compression)
+{
+    KTX2Texture texture;
+    texture.format = getFormat(compression);
+    texture.width = image.getWidth();
+    texture.height = image.getHeight();
+
+    for (const Image &level : generateMipChain(image)) texture.levels.push_back(compress(level, compression));
+    return texture;
+}
+
+KTX2Texture TextureCompressor::compressMipTail(const Image &image, uint32_t imageLevel, uint32_t baseLevel, uint32_t width, uint32_t height, TextureCompression compression)
+{
+    if (baseLevel < imageLevel) throw std::runtime_error("Failed to compress mip tail, the image is smaller than the base level");
+    if (image.getWidth() != std::max(width >> imageLevel, 1U) || image.getHeight() != std::max(height >> imageLevel, 1U)) {
+        throw std::runtime_error("Failed to compress mip tail, the image does not match the size of its mip level");
+    }
+
+    KTX2Texture texture;
+    texture.format = getFormat(compression);
+    texture.width = width;
+    texture.height = height;
+    texture.baseLevel = baseLevel;
+
+    std::vector<Image> levels = generateMipChain(image);
+    for (uint32_t level = baseLevel - imageLevel ; level < levels.size() ; level++) texture.levels.push_back(compress(levels[level], compression));
+    return texture;
+}
+
+uint32_t TextureCompressor::getFormat(TextureCompression compression)
+{
+    switch (compression) {
+        case TextureCompression::BC7 : return KTX2_FORMAT_BC7_UNORM_BLOCK;
+        case TextureCompression::BC5 : return KTX2_FORMAT_BC5_UNORM_BLOCK;
+        default: return KTX2_FORMAT_R8G8B8A8_UNORM;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "image.h"
+#include "ktx2-file.h"
+
+enum class TextureCompression {
+    // Four channel colour, for albedo maps
+    BC7,
+    // Two channel, for tangent space normal maps whose z is reconstructed in the shader
+    BC5,
+    // Uncompressed RGBA8, for devices that cannot sample BC formats. Its mip chain is generated on the device
+    NONE
+};
+
+/**
+ * @class TextureCompressor
+ *
+ * @brief Encodes RGBA8 images into GPU block-compressed formats
+ *
+ * Every 4x4 block is independent, so the blocks of an image are split across one thread per core. Within a
+ * block, palette searches are evaluated four entries at a time with SSE2 when it is available.
+ */
+class TextureCompressor {
+public:
+    /**
+     * @brief Compresses a single RGBA8 image, edge blocks of images that are not a multiple of 4 repeat their last texels
+     *
+     * @return The compressed blocks, in row-major block order
+     */
+    static std::vector<char> compress(const Image &image, TextureCompression compression);
+
+    /**
+     * @brief Builds the full mip chain of an RGBA8 image with a 2x2 box filter, down to and including 1x1
+     *
+     * @return Every level of the chain, starting with a tightly packed copy of the source image
+     */
+    static std::vector<Image> generateMipChain(const Image &image);
+
+    /**
+     * @brief Generates the mip chain of an image and compresses every level of it
+     */
+    static KTX2Texture compressWithMipChain(const Image &image, TextureCompression compression);
+
+    /**
+     * @brief Compresses only the smaller levels of a texture's mip chain, from a source that is already downscaled
+     *
+     * @param image The texture at mip level imageLevel, such as a scaled JPEG decode
+     * @param imageLevel The mip level of the texture that the image holds
+     * @param baseLevel The largest level to compress, at or below imageLevel
+     * @param width The width of level 0 of the texture
+     * @param height The height of level 0 of the texture
+     *
+     * @return The texture with levels from baseLevel down to 1x1
+     */
+    static KTX2Texture compressMipTail(const Image &image, uint32_t imageLevel, uint32_t baseLevel, uint32_t width, uint32_t height, TextureCompression compression);
+
+    /**
+     * @brief Gets the KTX2 (Vulkan) format that a compression mode produces
+     */
+    static uint32_t getFormat(TextureCompression compression);
+};
@@ -1,16 +1,17 @@
 #include "material-blueprint.h"
 #include "pipeline-resource.h"
 #include "descriptor-set-layout-resource.h"
-#include "descriptor-pool-resource.h"
+#include "descriptor-allocator.h"
 #include "resource-utilities.h"
 #include "material-input.h"
 #include "app-base.h"
 #include "image/image.h"
 
-void MaterialBlueprint::init(AppBase* appBase, AppPipeline* pipeline) 
+void MaterialBlueprint::init(AppBase* appBase, AppPipeline* pipeline, DescriptorAllocator* descriptorAllocator) 
 {
     // Set the pipeline
     this->pipeline = pipeline;
+    this->descriptorAllocator = descriptorAllocator;
     
     std::vector<DescriptorItem> descriptorItems = {};
 
@@ -37,7 +38,7 @@ Material MaterialBlueprint::createMaterial(MaterialInput* materialInput)
     Material material{};
     // Allocate a descriptor set for the material
 
-    VkDescriptorSet materialDescriptorSet = descriptorPool->allocateDescriptorSet(descriptorSetLayout);
+    VkDescriptorSet materialDescriptorSet = descriptorAllocator->allocate(*descriptorSetLayout);
     material.setDescriptorSet(materialDescriptorSet);
 
     // Create the image array for all images
@@ -7,7 +7,9 @@ class MaterialBlueprint {
     // The pipeline associated with this material blueprint
     class AppPipeline* pipeline;
     class AppDescriptorSetLayout* descriptorSetLayout;
-    class AppDescriptorPool* descriptorPool;
+
+    // Material sets last as long as the material, so they come from a long-lived allocator that is never reset
+    class DescriptorAllocator* descriptorAllocator;
 
     public:
     /**
@@ -15,7 +17,7 @@ class MaterialBlueprint {
      * 
      * @note Creates a pipeline derivative that uses the specified fragment shader module
      */
-    void init(class AppBase* app, class AppPipeline* pipeline);
+    void init(class AppBase* app, class AppPipeline* pipeline, class DescriptorAllocator* descriptorAllocator);
     Material createMaterial(MaterialInput* materialInput);
 
 };
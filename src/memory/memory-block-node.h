@@ -10,6 +10,6 @@ struct MemoryBlockNode {
     uint32_t byteSize = -1;
     uint32_t byteOffset = -1;
 
-    bool getIsFree() {return nodeRef != nullptr;}
+    bool getIsFree() const {return nodeRef != nullptr;}
     RBTree<std::list<MemoryBlockNode>::iterator>::Node* nodeRef = nullptr;
 };
\ No newline at end of file
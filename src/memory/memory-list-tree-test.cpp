@@ -0,0 +1,229 @@
+#include "memory-list-tree.h"
+#include <iostream>
+#include <map>
+#include <algorithm>
+
+/**
+ * Checks the memory list tree's best fit reservations, free size accounting, growth and the block moves that
+ * compact it, exits with a non-zero status if any check fails
+ *
+ * Usage: memory-list-tree-test
+ */
+static uint32_t failedChecks = 0U;
+
+static void check(bool condition, const std::string &description)
+{
+    if (condition) return;
+    std::cerr << "FAILED: " << description << std::endl;
+    failedChecks++;
+}
+
+/**
+ * @brief Checks that the blocks tile the whole region and that the free size matches the free blocks
+ */
+static void checkConsistency(MemoryListTree &memoryListTree, const std::string &step)
+{
+    uint32_t expectedOffset = 0U;
+    uint32_t freeSize = 0U;
+    uint32_t largestFreeSize = 0U;
+    for (const MemoryBlockNode &block : memoryListTree.getBlocks()) {
+        check(block.byteOffset == expectedOffset, step + ": blocks are contiguous");
+        expectedOffset += block.byteSize;
+        if (block.getIsFree()) {
+            freeSize += block.byteSize;
+            largestFreeSize = std::max(largestFreeSize, block.byteSize);
+        }
+    }
+    check(expectedOffset == memoryListTree.getSize(), step + ": blocks cover the whole region");
+    check(freeSize == memoryListTree.getTotalFreeSize(), step + ": free size matches the free blocks");
+    check(largestFreeSize == memoryListTree.getLargestFreeBlockSize(), step + ": largest free block matches the free blocks");
+}
+
+static void testBestFit()
+{
+    MemoryListTree memoryListTree;
+    memoryListTree.init(1000U);
+
+    std::list<MemoryBlockNode>::iterator a = memoryListTree.reserve(100U);
+    std::list<MemoryBlockNode>::iterator b = memoryListTree.reserve(50U);
+    std::list<MemoryBlockNode>::iterator c = memoryListTree.reserve(200U);
+    std::list<MemoryBlockNode>::iterator d = memoryListTree.reserve(30U);
+    memoryListTree.reserve(20U);
+    check((*a).byteOffset == 0U && (*b).byteOffset == 100U && (*c).byteOffset == 150U && (*d).byteOffset == 350U, "reservations from a single free block are packed in order");
+    checkConsistency(memoryListTree, "reserve");
+
+    // Free blocks of 50 bytes at 100, 30 bytes at 350 and 600 bytes at 400
+    memoryListTree.free(b);
+    memoryListTree.free(d);
+    check(memoryListTree.getTotalFreeSize() == 680U, "freed blocks are added to the free size");
+    check(memoryListTree.getLargestFreeBlockSize() == 600U, "the largest free block is the tail");
+    checkConsistency(memoryListTree, "free");
+
+    check((*memoryListTree.reserve(25U)).byteOffset == 350U, "the smallest free block that fits is reserved from");
+    check((*memoryListTree.reserve(40U)).byteOffset == 100U, "a block too small for the request is skipped");
+    check((*memoryListTree.reserve(60U)).byteOffset == 400U, "the tail is used once the holes are too small");
+    check(memoryListTree.getTotalFreeSize() == 555U, "reservations are taken from the free size");
+    checkConsistency(memoryListTree, "best fit");
+
+    check(memoryListTree.canReserve(540U) && !memoryListTree.canReserve(541U), "canReserve looks at the largest free block only");
+    bool threw = false;
+    try { memoryListTree.reserve(541U); } catch (const std::runtime_error &) { threw = true; }
+    check(threw, "reserving more than the largest free block throws");
+
+    // Of several free blocks of the same size before the limit, the one with the lowest offset is found
+    MemoryListTree holes;
+    holes.init(100U);
+    std::list<MemoryBlockNode>::iterator blocks[5];
+    for (uint32_t i = 0U ; i < 5U ; i++) blocks[i] = holes.reserve(20U);
+    holes.free(blocks[3]);
+    holes.free(blocks[1]);
+    check((*holes.findBestFitBefore(20U, 80U)).byteOffset == 20U, "the lowest of equally sized free blocks is the best fit");
+    check(holes.findBestFitBefore(20U, 20U) == holes.getBlocks().end(), "free blocks at or after the offset limit are not found");
+    check(holes.findBestFitBefore(21U, 100U) == holes.getBlocks().end(), "free blocks that are too small are not found");
+}
+
+static void testMerge()
+{
+    MemoryListTree memoryListTree;
+    memoryListTree.init(300U);
+    std::list<MemoryBlockNode>::iterator a = memoryListTree.reserve(100U);
+    std::list<MemoryBlockNode>::iterator b = memoryListTree.reserve(100U);
+    std::list<MemoryBlockNode>::iterator c = memoryListTree.reserve(100U);
+
+    memoryListTree.free(a);
+    memoryListTree.free(c);
+    check(memoryListTree.getBlocks().size() == 3U, "free blocks that are not neighbours stay separate");
+
+    memoryListTree.free(b);
+    check(memoryListTree.getBlocks().size() == 1U, "freeing between two free blocks merges all three");
+    check(memoryListTree.getLargestFreeBlockSize() == 300U && memoryListTree.getTotalFreeSize() == 300U, "the merged block spans the region");
+    checkConsistency(memoryListTree, "merge");
+}
+
+static void testGrow()
+{
+    // The last block is free, so the added bytes extend it
+    MemoryListTree memoryListTree;
+    memoryListTree.init(100U);
+    std::list<MemoryBlockNode>::iterator a = memoryListTree.reserve(60U);
+    memoryListTree.grow(200U);
+    check(memoryListTree.getBlocks().size() == 2U, "growing merges the added bytes into a free last block");
+    check(memoryListTree.getLargestFreeBlockSize() == 140U && memoryListTree.getTotalFreeSize() == 140U, "the free last block is re-keyed by its new size");
+    check((*memoryListTree.reserve(140U)).byteOffset == 60U, "the grown free block can be reserved in full");
+    checkConsistency(memoryListTree, "grow into free block");
+
+    // The last block is reserved, so the added bytes become a new free block
+    memoryListTree.grow(250U);
+    check(memoryListTree.getBlocks().size() == 3U, "growing after a reserved block appends a free block");
+    check(memoryListTree.getTotalFreeSize() == 50U && memoryListTree.getSize() == 250U, "the appended block is counted as free");
+    check((*a).byteOffset == 0U && (*a).byteSize == 60U && !(*a).getIsFree(), "reserved blocks keep their place when the region grows");
+    checkConsistency(memoryListTree, "grow after reserved block");
+
+    bool threw = false;
+    try { memoryListTree.grow(250U); } catch (const std::runtime_error &) { threw = true; }
+    check(threw, "growing to the current size throws");
+}
+
+static void testCompactingMoves()
+{
+    // The contents of the region, each byte of a block holds the id of the block's owner
+    MemoryListTree memoryListTree;
+    memoryListTree.init(1000U);
+    std::vector<uint32_t> contents(1000U, 0U);
+    std::map<const MemoryBlockNode*, uint32_t> blockOwners = {};
+    std::map<uint32_t, std::list<MemoryBlockNode>::iterator> ownerBlocks = {};
+
+    const uint32_t sizes[] = {100U, 40U, 80U, 60U, 120U, 30U, 90U, 50U};
+    for (uint32_t owner = 1U ; owner <= 8U ; owner++) {
+        std::list<MemoryBlockNode>::iterator block = memoryListTree.reserve(sizes[owner - 1U]);
+        std::fill(contents.begin() + (*block).byteOffset, contents.begin() + (*block).byteOffset + (*block).byteSize, owner);
+        blockOwners[&*block] = owner;
+        ownerBlocks[owner] = block;
+    }
+
+    // A block without an owner, such as one awaiting release, cannot be patched and must stay in place
+    std::list<MemoryBlockNode>::iterator unowned = memoryListTree.reserve(70U);
+    uint32_t unownedOffset = (*unowned).byteOffset;
+
+    for (uint32_t owner : {1U, 3U, 6U}) {
+        blockOwners.erase(&*ownerBlocks[owner]);
+        memoryListTree.free(ownerBlocks[owner]);
+        ownerBlocks.erase(owner);
+    }
+    checkConsistency(memoryListTree, "before compacting");
+    uint32_t freeSize = memoryListTree.getTotalFreeSize();
+
+    auto canMove = [&blockOwners](std::list<MemoryBlockNode>::iterator block) { return blockOwners.count(&*block) > 0U; };
+
+    uint32_t byteBudget = 100U;
+    std::vector<MemoryListTree::BlockMove> moves = memoryListTree.selectCompactingMoves(byteBudget, canMove);
+    uint32_t movedBytes = 0U;
+    for (MemoryListTree::BlockMove &move : moves) movedBytes += (*move.oldBlock).byteSize;
+    check(moves.size() > 0U && movedBytes <= 100U && byteBudget == 100U - movedBytes, "moves stay within the byte budget and are taken from it");
+
+    for (uint32_t step = 0U ; step < 10U && moves.size() > 0U ; step++) {
+        for (MemoryListTree::BlockMove &move : moves) {
+            check((*move.newBlock).byteOffset < (*move.oldBlock).byteOffset, "blocks only move towards the start of the region");
+            check((*move.newBlock).byteSize == (*move.oldBlock).byteSize && !(*move.newBlock).getIsFree(), "the destination is reserved at the size of the block");
+            check(move.oldBlock != unowned, "blocks without an owner are not moved");
+        }
+
+        // Copy every block before patching any owner, as the copies of a batch are submitted together
+        for (MemoryListTree::BlockMove &move : moves) {
+            std::copy(contents.begin() + (*move.oldBlock).byteOffset, contents.begin() + (*move.oldBlock).byteOffset + (*move.oldBlock).byteSize, contents.begin() + (*move.newBlock).byteOffset);
+        }
+        for (MemoryListTree::BlockMove &move : moves) {
+            uint32_t owner = blockOwners[&*move.oldBlock];
+            blockOwners.erase(&*move.oldBlock);
+            blockOwners[&*move.newBlock] = owner;
+            ownerBlocks[owner] = move.newBlock;
+            memoryListTree.free(move.oldBlock);
+        }
+        checkConsistency(memoryListTree, "compacting step " + std::to_string(step));
+        check(memoryListTree.getTotalFreeSize() == freeSize, "moving blocks does not change the free size");
+
+        byteBudget = 1000U;
+        moves = memoryListTree.selectCompactingMoves(byteBudget, canMove);
+    }
+
+    for (auto &[owner, block] : ownerBlocks) {
+        bool isIntact = std::all_of(contents.begin() + (*block).byteOffset, contents.begin() + (*block).byteOffset + (*block).byteSize, [owner](uint32_t value) { return value == owner; });
+        check(isIntact, "the block of owner " + std::to_string(owner) + " holds its own contents after compacting");
+        check(blockOwners[&*block] == owner, "owner " + std::to_string(owner) + " is still found by its block");
+    }
+    check((*unowned).byteOffset == unownedOffset, "the block without an owner kept its offset");
+    check(moves.size() == 0U, "compacting finishes once no block can move to a lower offset");
+
+    // Once the unowned block is released, every block that fits a free block before it is moved there
+    memoryListTree.free(unowned);
+    for (uint32_t step = 0U ; step < 10U ; step++) {
+        byteBudget = 1000U;
+        moves = memoryListTree.selectCompactingMoves(byteBudget, canMove);
+        for (MemoryListTree::BlockMove &move : moves) {
+            blockOwners[&*move.newBlock] = blockOwners[&*move.oldBlock];
+            blockOwners.erase(&*move.oldBlock);
+            memoryListTree.free(move.oldBlock);
+        }
+    }
+    for (const MemoryBlockNode &block : memoryListTree.getBlocks()) {
+        if (block.getIsFree()) continue;
+        check(memoryListTree.findBestFitBefore(block.byteSize, block.byteOffset) == memoryListTree.getBlocks().end(), "no block is left that fits a free block before it");
+    }
+    check(memoryListTree.getLargestFreeBlockSize() >= 600U, "the free space at the end of the region is not split by compacting");
+    checkConsistency(memoryListTree, "compacted");
+}
+
+int main()
+{
+    testBestFit();
+    testMerge();
+    testGrow();
+    testCompactingMoves();
+
+    if (failedChecks > 0U) {
+        std::cerr << failedChecks << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All memory list tree checks passed" << std::endl;
+    return 0;
+}
@@ -3,6 +3,9 @@
 #include <list>
 #include "red-black-tree.h"
 #include <stdexcept>
+#include <string>
+#include <vector>
+#include <unordered_set>
 #include "memory-block-node.h"
 
 /**
@@ -10,11 +13,33 @@
  * sections of Memory. 
  */
 class MemoryListTree {
+    public:
+    /**
+     * A reserved block and the block reserved at a lower offset to move its contents to
+     */
+    struct BlockMove {
+        std::list<MemoryBlockNode>::iterator oldBlock;
+        std::list<MemoryBlockNode>::iterator newBlock;
+    };
+
     protected:
 
     std::list<MemoryBlockNode> memoryBlocks = {};
     RBTree<std::list<MemoryBlockNode>::iterator> freeBlocks;
 
+    // The total number of bytes (reserved and free) managed by this tree
+    uint32_t totalSize = 0U;
+
+    // The sum of the sizes of all free blocks
+    uint32_t freeSize = 0U;
+
+    /**
+     * @brief Reserves from the first free block stored in an RBTree node
+     */
+    std::list<MemoryBlockNode>::iterator reserveBlockHelper(RBTree<std::list<MemoryBlockNode>::iterator>::Node* node, uint32_t reserveSize) {
+        return reserveBlockHelper(node->data.front(), reserveSize);
+    }
+
     /**
      * @brief Takes a free block and either partially reserves it or fully reserves it depending on the size requested
      * 
@@ -25,9 +50,8 @@ class MemoryListTree {
      * 
      * @return An iterator to the reserved region is returned
      */
-    std::list<MemoryBlockNode>::iterator reserveBlockHelper(RBTree<std::list<MemoryBlockNode>::iterator>::Node* node, uint32_t reserveSize) {
-        MemoryBlockNode* memoryBlockNode = &(*(node->data.front()));
-        std::list<MemoryBlockNode>::iterator it = node->data.front();
+    std::list<MemoryBlockNode>::iterator reserveBlockHelper(std::list<MemoryBlockNode>::iterator it, uint32_t reserveSize) {
+        MemoryBlockNode* memoryBlockNode = &(*it);
         uint32_t blockSize = memoryBlockNode->byteSize;
 
         // The app has requested a larger size than is available, throw an exception
@@ -35,15 +59,17 @@ class MemoryListTree {
 
         // There is exactly enough space, delete the 'freeBlock' entry to now consider this region as reserved
         else if (blockSize == reserveSize) {
-            freeBlocks.remove(memoryBlockNode->nodeRef);
+            freeSize -= reserveSize;
+            freeBlocks.remove(memoryBlockNode->nodeRef, it);
             (*memoryBlockNode).nodeRef = nullptr;
             return it;
         }
 
         // There is more space than requested, split the free region into a reserved region (of size 'reserveSize') and a free region 
         else {
-            // Delete the free block in the RBTree
-            freeBlocks.remove(memoryBlockNode->nodeRef);
+            // Delete this block's entry in the RBTree (other free blocks of the same size may share the node)
+            freeSize -= reserveSize;
+            freeBlocks.remove(memoryBlockNode->nodeRef, it);
             
             // Insert a new block in front of the block referenced by (*it), this will be the new free block and takes the remaining size
             uint32_t oldOffset = memoryBlockNode->byteOffset;
@@ -69,6 +95,8 @@ class MemoryListTree {
      * @param size The size of the contiguous initial region size in bytes
      */
     void init(uint32_t size) {
+        totalSize = size;
+        freeSize = size;
 
         // Create an initial memory block
         memoryBlocks.push_front({size, 0U, nullptr});
@@ -89,6 +117,7 @@ class MemoryListTree {
      * @return An iterator to the free memory block
      */
     std::list<MemoryBlockNode>::iterator free(std::list<MemoryBlockNode>::iterator &it) {
+        freeSize += (*it).byteSize;
 
         bool isLeftFree = it != memoryBlocks.begin() && (*std::prev(it)).getIsFree();
         bool isRightFree = std::next(it) != memoryBlocks.end() && (*std::next(it)).getIsFree();
@@ -96,7 +125,7 @@ class MemoryListTree {
         if (isLeftFree){
             std::list<MemoryBlockNode>::iterator leftIt = std::prev(it);
             // Remove the leftmost block's free region, it will be merged at the end in a new free region
-            freeBlocks.remove((*leftIt).nodeRef);
+            freeBlocks.remove((*leftIt).nodeRef, leftIt);
 
             // Combine the size of the requested freed region with the free region on the left
             (*it).byteSize += (*leftIt).byteSize;
@@ -111,7 +140,7 @@ class MemoryListTree {
             std::list<MemoryBlockNode>::iterator rightIt = std::next(it);
 
             // Remove the rightmost block's free region, it will be merged at the end in a new free region
-            freeBlocks.remove((*rightIt).nodeRef);
+            freeBlocks.remove((*rightIt).nodeRef, rightIt);
             
             // Combine the size of the requested freed region (and the left region if also free) with the free region on the right
             (*it).byteSize += (*rightIt).byteSize;
@@ -132,8 +161,145 @@ class MemoryListTree {
      */
     std::list<MemoryBlockNode>::iterator reserve(uint32_t size) {
         RBTree<std::list<MemoryBlockNode>::iterator>::Node* nodeRef = freeBlocks.getSmallestNodeGreaterThan(size);
+        if (nodeRef == nullptr) throw std::runtime_error(std::string("No free block is large enough to reserve ") + std::to_string(size) + std::string(" bytes"));
         return reserveBlockHelper(nodeRef, size);
     }
 
+    /**
+     * @brief Reserves 'size' bytes at the start of a specific free block, rather than the best fitting one
+     * 
+     * @note Used when relocating blocks, where the destination must be chosen by offset rather than by size
+     * 
+     * @param freeIt An iterator to a free block that is at least 'size' bytes large
+     */
+    std::list<MemoryBlockNode>::iterator reserveFrom(std::list<MemoryBlockNode>::iterator freeIt, uint32_t size) {
+        if (!(*freeIt).getIsFree()) throw std::runtime_error("Attempted to reserve from a block that is not free");
+        return reserveBlockHelper(freeIt, size);
+    }
+
+    /**
+     * @brief Finds the smallest free block of at least 'size' bytes that starts before 'offsetLimit'
+     * 
+     * @note Free blocks are visited in order of increasing size, from the smallest that fits, so only blocks that are
+     * large enough are looked at. Of several equally sized blocks, the one with the lowest offset is chosen
+     * 
+     * @return An iterator to the free block, or the end of the block list if there is none
+     */
+    std::list<MemoryBlockNode>::iterator findBestFitBefore(uint32_t size, uint32_t offsetLimit) {
+        for (RBTree<std::list<MemoryBlockNode>::iterator>::Node* node = freeBlocks.getSmallestNodeGreaterThan(size) ; node != nullptr ; node = freeBlocks.successor(node)) {
+            std::list<MemoryBlockNode>::iterator bestFitIt = memoryBlocks.end();
+            for (std::list<MemoryBlockNode>::iterator freeIt : node->data) {
+                if ((*freeIt).byteOffset < offsetLimit && (bestFitIt == memoryBlocks.end() || (*freeIt).byteOffset < (*bestFitIt).byteOffset)) {
+                    bestFitIt = freeIt;
+                }
+            }
+            if (bestFitIt != memoryBlocks.end()) return bestFitIt;
+        }
+        return memoryBlocks.end();
+    }
+
+    /**
+     * @brief Reserves a destination at a lower offset for reserved blocks, until 'byteBudget' bytes are to be moved
+     * 
+     * Walks the reserved blocks from the end of the region, moving each into the best fitting free block that lies before
+     * it. Moving to a lower offset always makes progress towards a compacted region, and since source and destination are
+     * distinct blocks the copies never overlap. The old blocks stay reserved, the caller frees them once their contents
+     * have been copied.
+     * 
+     * @param byteBudget The most bytes to move, reduced by the size of every block that is moved
+     * @param canMove Called with a reserved block, blocks whose owner cannot be patched must stay in place
+     */
+    template <typename CanMove>
+    std::vector<BlockMove> selectCompactingMoves(uint32_t &byteBudget, CanMove canMove) {
+        std::vector<BlockMove> moves = {};
+
+        // Nothing to do if all free space is already contiguous
+        if (getLargestFreeBlockSize() == freeSize) return moves;
+
+        std::unordered_set<const MemoryBlockNode*> newBlocks = {};
+        for (std::list<MemoryBlockNode>::iterator blockIt = memoryBlocks.end() ; blockIt != memoryBlocks.begin() && byteBudget > 0U ; ) {
+            blockIt--;
+            MemoryBlockNode &block = *blockIt;
+
+            if (block.getIsFree() || block.byteSize > byteBudget) continue;
+            if (newBlocks.count(&block) > 0U || !canMove(blockIt)) continue;
+
+            std::list<MemoryBlockNode>::iterator bestFitIt = findBestFitBefore(block.byteSize, block.byteOffset);
+            if (bestFitIt == memoryBlocks.end()) continue;
+
+            std::list<MemoryBlockNode>::iterator newBlock = reserveBlockHelper(bestFitIt, block.byteSize);
+            newBlocks.insert(&*newBlock);
+            moves.push_back(BlockMove{blockIt, newBlock});
+            byteBudget -= block.byteSize;
+        }
+        return moves;
+    }
+
+    /**
+     * @brief Gets the sum of the sizes of all free blocks, in bytes
+     */
+    uint32_t getTotalFreeSize() {
+        return freeSize;
+    }
+
+    /**
+     * @brief Gets the size of the largest free block, in bytes
+     */
+    uint32_t getLargestFreeBlockSize() {
+        RBTree<std::list<MemoryBlockNode>::iterator>::Node* largestNode = freeBlocks.getLargestNode();
+        return largestNode == nullptr ? 0U : largestNode->key;
+    }
+
+    /**
+     * @brief Checks whether a contiguous region of 'size' bytes can currently be reserved
+     */
+    bool canReserve(uint32_t size) {
+        return freeBlocks.getSmallestNodeGreaterThan(size) != nullptr;
+    }
+
+    /**
+     * @brief Extends the managed region to 'newSize' bytes
+     * 
+     * @note Existing blocks keep their offsets, so iterators to reserved blocks remain valid. The added bytes
+     * are merged into the last block if it is free, otherwise they are appended as a new free block.
+     * 
+     * @param newSize The new total size in bytes, must be larger than the current size
+     */
+    void grow(uint32_t newSize) {
+        if (newSize <= totalSize) throw std::runtime_error("Attempted to grow a memory list tree to a smaller size");
+
+        uint32_t addedSize = newSize - totalSize;
+        freeSize += addedSize;
+        std::list<MemoryBlockNode>::iterator lastIt = std::prev(memoryBlocks.end());
+
+        if ((*lastIt).getIsFree()) {
+            // The free block changes size, so it must be re-keyed in the RBTree
+            freeBlocks.remove((*lastIt).nodeRef, lastIt);
+            (*lastIt).byteSize += addedSize;
+            (*lastIt).nodeRef = freeBlocks.insert((*lastIt).byteSize, lastIt);
+        }
+        else {
+            memoryBlocks.push_back({addedSize, totalSize, nullptr});
+            std::list<MemoryBlockNode>::iterator newBlock = std::prev(memoryBlocks.end());
+            (*newBlock).nodeRef = freeBlocks.insert((*newBlock).byteSize, newBlock);
+        }
+
+        totalSize = newSize;
+    }
+
+    /**
+     * @brief Gets the total number of bytes (reserved and free) managed by this tree
+     */
+    uint32_t getSize() {
+        return totalSize;
+    }
+
+    /**
+     * @brief Gets all memory blocks, in order of increasing offset
+     */
+    std::list<MemoryBlockNode>& getBlocks() {
+        return memoryBlocks;
+    }
+
 
 };
\ No newline at end of file
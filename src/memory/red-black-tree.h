@@ -253,6 +253,28 @@ class RBTree {
         return node;
     }
 
+    Node* maximum(Node* node) {
+        while (node->right != nullptr) {
+            node = node->right;
+        }
+        return node;
+    }
+
+    /**
+     * @brief Gets the node with the next larger key, nullptr if the node has the largest key
+     */
+    Node* successor(Node* node) {
+        if (node->right != nullptr) return minimum(node->right);
+
+        // The successor is the first ancestor reached from its left subtree
+        Node* parent = node->parent;
+        while (parent != nullptr && node == parent->right) {
+            node = parent;
+            parent = parent->parent;
+        }
+        return parent;
+    }
+
     void fixDeletionViolations(Node* x, Node* xParent) {
         while (x != root && (x == nullptr || x->color == RBTreeColor::BLACK)) {
             if (x == xParent->left) {
@@ -385,6 +407,29 @@ class RBTree {
         return data;
     }
 
+    /**
+     * @brief Removes one specific occurrence from a node, deleting the node if it was the last occurrence
+     * 
+     * @note remove(Node*) pops whichever occurrence is at the front of the node, this overload is used
+     * when the caller needs a particular value (e.g. a particular memory block) taken out of the tree
+     */
+    void remove(Node* node, const T& value) {
+        if (node == nullptr)
+            throw std::runtime_error("Attempted to remove a null node");
+
+        if (node->data.size() > 1) {
+            for (auto it = node->data.begin() ; it != node->data.end() ; it++) {
+                if (*it == value) {
+                    node->data.erase(it);
+                    return;
+                }
+            }
+            throw std::runtime_error("Attempted to remove a value that is not stored in the node");
+        }
+
+        remove(node);
+    }
+
     Node* findHelper(Node* node, uint32_t key) {
         if (node == nullptr) return nullptr;
         else if (node->key == key) return node;
@@ -400,4 +445,8 @@ class RBTree {
         return getSmallestNodeGreaterThanHelper(nullptr, root, minimum);
     }
 
+    Node* getLargestNode() {
+        return root == nullptr ? nullptr : maximum(root);
+    }
+
 };
\ No newline at end of file
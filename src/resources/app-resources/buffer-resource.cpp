@@ -33,7 +33,7 @@ static VkBufferCreateInfo getBufferCreateInfoFromTemplate(AppBufferTemplate t, u
            nullptr,
            0U,
            size,
-           VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+           VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
            VK_SHARING_MODE_EXCLUSIVE,
            0U,
            nullptr
@@ -55,7 +55,29 @@ static VkBufferCreateInfo getBufferCreateInfoFromTemplate(AppBufferTemplate t, u
            nullptr,
            0U,
            size,
-           VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+           VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+           VK_SHARING_MODE_EXCLUSIVE,
+           0U,
+           nullptr
+        };
+        case AppBufferTemplate::IMAGE_STAGING :
+        return {
+           VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+           nullptr,
+           0U,
+           size,
+           VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+           VK_SHARING_MODE_EXCLUSIVE,
+           0U,
+           nullptr
+        };
+        case AppBufferTemplate::STORAGE_BUFFER :
+        return {
+           VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+           nullptr,
+           0U,
+           size,
+           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
            VK_SHARING_MODE_EXCLUSIVE,
            0U,
            nullptr
@@ -138,6 +160,47 @@ void AppBuffer::copyBuffer(AppBuffer &src, AppBuffer &dst, VkCommandBuffer comma
    vkDestroyFence(resources->logicalDevice.get(), transferCompleteFence, nullptr);
 }
 
+void AppBuffer::copyBufferRegions(AppBuffer &src, AppBuffer &dst, VkCommandBuffer commandBuffer, std::vector<VkBufferCopy> regions)
+{
+   if (regions.size() == 0) return;
+
+   VkSubmitInfo submitInfo{};
+   submitInfo.pCommandBuffers = &(commandBuffer);
+   submitInfo.commandBufferCount = 1U;
+   submitInfo.pNext = nullptr;
+   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+   submitInfo.pSignalSemaphores = nullptr;
+   submitInfo.signalSemaphoreCount = 0U;
+   submitInfo.pWaitSemaphores = nullptr;
+   submitInfo.pWaitDstStageMask = nullptr;
+   submitInfo.waitSemaphoreCount = 0u;
+
+   VkCommandBufferBeginInfo beginInfo{};
+   beginInfo.pNext = nullptr;
+   beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+   beginInfo.pInheritanceInfo = nullptr;
+   beginInfo.flags = 0U;
+
+   vkBeginCommandBuffer(commandBuffer, &beginInfo);
+   vkCmdCopyBuffer(commandBuffer, src.get(), dst.get(), regions.size(), regions.data());
+   vkEndCommandBuffer(commandBuffer);
+
+   VkFenceCreateInfo transferCompleteFenceInfo{};
+   transferCompleteFenceInfo.pNext = nullptr;
+   transferCompleteFenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+   AppBase* appBase = src.appBase;
+
+   VkFence transferCompleteFence;
+   vkCreateFence(appBase->getDevice(), &transferCompleteFenceInfo, nullptr, &transferCompleteFence);
+
+   vkQueueSubmit(appBase->queues.graphicsQueue, 1U, &submitInfo, transferCompleteFence);
+
+   vkWaitForFences(appBase->getDevice(), 1U, &transferCompleteFence, true, UINT64_MAX);
+   
+   vkDestroyFence(appBase->getDevice(), transferCompleteFence, nullptr);
+}
+
 void AppBuffer::destroy()
 {
    appBase->resources.buffers.destroy(getIterator(), appBase->logicalDevice.get());
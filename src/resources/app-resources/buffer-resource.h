@@ -7,7 +7,11 @@ enum class AppBufferTemplate {
     VERTEX_BUFFER_DEVICE,
     INDEX_BUFFER_DEVICE,
     VERTEX_BUFFER_STAGING,
-    INDEX_BUFFER_STAGING
+    INDEX_BUFFER_STAGING,
+    // Host-visible source for uploads into images
+    IMAGE_STAGING,
+    // Host-visible shader storage, written through its persistent mapping
+    STORAGE_BUFFER
 };
 
 class AppBuffer : public AppResource<VkBuffer> {
@@ -18,10 +22,18 @@ class AppBuffer : public AppResource<VkBuffer> {
     public:
     void init(class AppBase* appBase, size_t size, AppBufferTemplate appBufferTemplate);
     AppBufferTemplate getTemplate() { return appBufferTemplate; }
+    size_t getSize() { return size; }
 
     void bindToMemory(class AppDeviceMemory *bufferMemory);
 
     static void copyBuffer(AppBuffer &src, AppBuffer &dst, VkCommandBuffer commandBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
 
+    /**
+     * @brief Copies several regions from one buffer to another in a single submission
+     * 
+     * @param regions The regions to copy, offsets are in bytes relative to the start of each buffer
+     */
+    static void copyBufferRegions(AppBuffer &src, AppBuffer &dst, VkCommandBuffer commandBuffer, std::vector<VkBufferCopy> regions);
+
     void destroy();
 };
\ No newline at end of file
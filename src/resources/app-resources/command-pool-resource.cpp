@@ -1,14 +1,14 @@
 #include "app-base.h"
 #include "command-pool-resource.h"
 
-void AppCommandPool::init(AppBase* appBase, uint32_t queueFamilyIndex)
+void AppCommandPool::init(AppBase* appBase, uint32_t queueFamilyIndex, VkCommandPoolCreateFlags flags)
 {
     this->queueFamilyIndex = queueFamilyIndex;
 
     VkCommandPoolCreateInfo createInfo{};
     createInfo.pNext = nullptr;
     createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    createInfo.flags = flags;
     createInfo.queueFamilyIndex = queueFamilyIndex;
 
     VkCommandPool commandPool;
@@ -32,6 +32,26 @@ VkCommandBuffer AppCommandPool::allocateCommandBuffer(VkCommandBufferLevel level
     return buffer;
 }
 
+std::vector<VkCommandBuffer> AppCommandPool::allocateCommandBuffers(VkCommandBufferLevel level, uint32_t count)
+{
+    VkCommandBufferAllocateInfo allocInfo{};
+
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.pNext = nullptr;
+    allocInfo.level = level;
+    allocInfo.commandPool = this->get();
+    allocInfo.commandBufferCount = count;
+
+    std::vector<VkCommandBuffer> buffers(count, VK_NULL_HANDLE);
+    THROW(vkAllocateCommandBuffers(appBase->getDevice(), &allocInfo, buffers.data()), "Failed to allocate command buffers");
+    return buffers;
+}
+
+void AppCommandPool::reset()
+{
+    THROW(vkResetCommandPool(appBase->getDevice(), get(), 0U), "Failed to reset command pool");
+}
+
 void AppCommandPool::destroy()
 {
     appBase->resources.commandPools.destroy(getIterator(), appBase->getDevice()); 
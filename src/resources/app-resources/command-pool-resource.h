@@ -4,9 +4,23 @@
 class AppCommandPool : public AppResource<VkCommandPool>{
     uint32_t queueFamilyIndex;
     public:
-    void init(class AppBase* baseResources, uint32_t queueFamilyIndex);
+    /**
+     * @param flags VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT lets each command buffer be reset on its own, pools
+     * that are only ever reset as a whole are created without it
+     */
+    void init(class AppBase* baseResources, uint32_t queueFamilyIndex, VkCommandPoolCreateFlags flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
 
     VkCommandBuffer allocateCommandBuffer(VkCommandBufferLevel level);
 
+    /**
+     * @brief Allocates a number of command buffers with a single call
+     */
+    std::vector<VkCommandBuffer> allocateCommandBuffers(VkCommandBufferLevel level, uint32_t count);
+
+    /**
+     * @brief Resets every command buffer allocated from the pool, none of them may be pending execution
+     */
+    void reset();
+
     void destroy();
 };
\ No newline at end of file
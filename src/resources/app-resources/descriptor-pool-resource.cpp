@@ -2,7 +2,7 @@
 #include "descriptor-pool-resource.h"
 #include "descriptor-set-layout-resource.h"
 
-void AppDescriptorPool::init(AppBase* appBase, uint32_t maxSetsCount, std::map<VkDescriptorType, uint32_t> descriptorTypeCounts)
+void AppDescriptorPool::init(AppBase* appBase, uint32_t maxSetsCount, std::map<VkDescriptorType, uint32_t> descriptorTypeCounts, VkDescriptorPoolCreateFlags flags)
 {
     this->maxSetsCount = maxSetsCount;
     this->descriptorTypeCounts = descriptorTypeCounts;
@@ -19,7 +19,7 @@ void AppDescriptorPool::init(AppBase* appBase, uint32_t maxSetsCount, std::map<V
     createInfo.pNext = nullptr;
     createInfo.poolSizeCount = poolSizes.size();
     createInfo.pPoolSizes = poolSizes.data();
-    createInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    createInfo.flags = flags;
     createInfo.maxSets = maxSetsCount;
 
     VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
@@ -44,6 +44,11 @@ VkDescriptorSet AppDescriptorPool::allocateDescriptorSet(AppDescriptorSetLayout*
     return descriptorSet;
 }
 
+void AppDescriptorPool::reset()
+{
+    THROW(vkResetDescriptorPool(appBase->getDevice(), get(), 0U), "Failed to reset descriptor pool");
+}
+
 void AppDescriptorPool::destroy()
 {
     appBase->resources.descriptorPools.destroy(getIterator(), appBase->getDevice());
@@ -21,8 +21,11 @@ class AppDescriptorPool : public AppResource<VkDescriptorPool> {
      * @param app The application object
      * @param maxSetsCount The total number of descriptors sets that can be allocated from this pool
      * @param descriptorTypeCounts A map specifying the total number of each descriptor type that can be allocated across all descriptor sets
+     * @param flags Additional creation flags, such as VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT
+     * 
+     * @note Sets are not freed individually, they are all returned at once by reset()
      */
-    void init(class AppBase* appBase, uint32_t maxSetsCount, std::map<VkDescriptorType, uint32_t> descriptorTypeCounts);
+    void init(class AppBase* appBase, uint32_t maxSetsCount, std::map<VkDescriptorType, uint32_t> descriptorTypeCounts, VkDescriptorPoolCreateFlags flags = 0U);
     
     /**
      * @brief Allocates a single descriptor set of the provided layout from the specified descriptor pool
@@ -32,5 +35,12 @@ class AppDescriptorPool : public AppResource<VkDescriptorPool> {
      */
     VkDescriptorSet allocateDescriptorSet(class AppDescriptorSetLayout* descriptorSetLayout);
 
+    /**
+     * @brief Returns every descriptor set allocated from this pool back to the pool
+     */
+    void reset();
+
+    uint32_t getMaxSetsCount() const { return maxSetsCount; }
+
     void destroy();
 };
\ No newline at end of file
@@ -1,10 +1,12 @@
 #include "app-base.h"
 #include "descriptor-set-layout-resource.h"
 
-void AppDescriptorSetLayout::init(AppBase* appBase, std::vector<DescriptorItem> descriptorItems)
+void AppDescriptorSetLayout::init(AppBase* appBase, std::vector<DescriptorItem> descriptorItems, VkDescriptorSetLayoutCreateFlags flags)
 {
     uint32_t index = 0U;
     std::vector<VkDescriptorSetLayoutBinding> layoutBindings = {};
+    std::vector<VkDescriptorBindingFlags> bindingFlags = {};
+    bool updateAfterBind = false;
     for (DescriptorItem descriptorItem : descriptorItems) {
         VkDescriptorType descriptorType = descriptorItem.descriptorType;
         if (layoutBindings.size() > 0 && layoutBindings[index - 1].descriptorType == descriptorType && false)
@@ -19,21 +21,36 @@ void AppDescriptorSetLayout::init(AppBase* appBase, std::vector<DescriptorItem>
              * pImmutableSamplers: Used if this descriptor set is a sampler resource (nullptr because UBO not sampler).
              */
             layoutBindings.push_back(VkDescriptorSetLayoutBinding{});
-            layoutBindings.back().binding = index;
-            layoutBindings.back().descriptorCount = 1U;
+            layoutBindings.back().binding = descriptorItem.binding == bindingInListOrder ? index : descriptorItem.binding;
+            layoutBindings.back().descriptorCount = descriptorItem.descriptorCount;
             layoutBindings.back().stageFlags = descriptorItem.shaderStage;
             layoutBindings.back().descriptorType = descriptorType;
             layoutBindings.back().pImmutableSamplers = nullptr;
+
+            bindingFlags.push_back(descriptorItem.bindingFlags);
+            updateAfterBind |= (descriptorItem.bindingFlags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) != 0U;
         }
         index++;
     }
 
+    for (uint32_t i = 0U ; i < layoutBindings.size() ; i++) {
+        for (uint32_t j = i + 1U ; j < layoutBindings.size() ; j++) {
+            if (layoutBindings[i].binding == layoutBindings[j].binding) throw std::runtime_error("Descriptor set layout declares binding " + std::to_string(layoutBindings[i].binding) + " twice");
+        }
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.pNext = nullptr;
+    bindingFlagsInfo.bindingCount = bindingFlags.size();
+    bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
     VkDescriptorSetLayoutCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    createInfo.pNext = nullptr;
+    createInfo.pNext = &bindingFlagsInfo;
     createInfo.bindingCount = layoutBindings.size();
     createInfo.pBindings = layoutBindings.data();
-    createInfo.flags = 0U;
+    createInfo.flags = flags | (updateAfterBind ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT : 0U);
 
 
     VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
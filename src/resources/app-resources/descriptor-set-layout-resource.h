@@ -2,14 +2,31 @@
 #include "app-resource.h"
 #include "descriptor-pool-resource.h"
 
+// Gives a descriptor item the binding number of its position in the list
+static const uint32_t bindingInListOrder = UINT32_MAX;
+
 struct DescriptorItem {
     VkDescriptorType descriptorType;
     VkShaderStageFlags shaderStage;
+
+    // The number of descriptors in the binding, greater than 1 for arrays
+    uint32_t descriptorCount = 1U;
+
+    // Descriptor indexing flags, a binding with VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT must be allocated from a
+    // pool created with VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT
+    VkDescriptorBindingFlags bindingFlags = 0U;
+
+    // The binding number in the shader, layouts reflected from SPIR-V may leave gaps between bindings
+    uint32_t binding = bindingInListOrder;
 };
 
 class AppDescriptorSetLayout : public AppResource<VkDescriptorSetLayout> {
     public:
-    void init(class AppBase* appBase, std::vector<DescriptorItem> descriptorItems);
+    /**
+     * @param flags Additional creation flags, such as VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR for sets
+     * whose descriptors are pushed rather than allocated
+     */
+    void init(class AppBase* appBase, std::vector<DescriptorItem> descriptorItems, VkDescriptorSetLayoutCreateFlags flags = 0U);
 
     void destroy();  
 };
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "app-base.h"
+#include "descriptor-update-template-resource.h"
+#include "descriptor-set-layout-resource.h"
+#include "pipeline-layout-resource.h"
+
+void AppDescriptorUpdateTemplate::init(AppBase* appBase, AppDescriptorSetLayout &descriptorSetLayout, std::vector<VkDescriptorUpdateTemplateEntry> entries)
+{
+    VkDescriptorUpdateTemplateCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+    createInfo.pNext = nullptr;
+    createInfo.flags = 0U;
+    createInfo.descriptorUpdateEntryCount = entries.size();
+    createInfo.pDescriptorUpdateEntries = entries.data();
+    createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+    createInfo.descriptorSetLayout = descriptorSetLayout.get();
+
+    VkDescriptorUpdateTemplate updateTemplate = VK_NULL_HANDLE;
+    THROW(vkCreateDescriptorUpdateTemplate(appBase->getDevice(), &createInfo, nullptr, &updateTemplate), "Failed to create descriptor update template");
+
+    pushDescriptors = false;
+    AppResource::init(appBase, appBase->resources.descriptorUpdateTemplates.create(updateTemplate));
+}
+
+void AppDescriptorUpdateTemplate::init(AppBase* appBase, AppDescriptorSetLayout &descriptorSetLayout, std::vector<VkDescriptorUpdateTemplateEntry> entries,
+    VkPipelineBindPoint pipelineBindPoint, AppPipelineLayout &pipelineLayout, uint32_t set)
+{
+    if (!appBase->logicalDevice.supportsPushDescriptors()) throw std::runtime_error("Failed to create push descriptor template, VK_KHR_push_descriptor is not supported");
+
+    VkDescriptorUpdateTemplateCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+    createInfo.pNext = nullptr;
+    createInfo.flags = 0U;
+    createInfo.descriptorUpdateEntryCount = entries.size();
+    createInfo.pDescriptorUpdateEntries = entries.data();
+    createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR;
+    createInfo.descriptorSetLayout = descriptorSetLayout.get();
+    createInfo.pipelineBindPoint = pipelineBindPoint;
+    createInfo.pipelineLayout = pipelineLayout.get();
+    createInfo.set = set;
+
+    VkDescriptorUpdateTemplate updateTemplate = VK_NULL_HANDLE;
+    THROW(vkCreateDescriptorUpdateTemplate(appBase->getDevice(), &createInfo, nullptr, &updateTemplate), "Failed to create descriptor update template");
+
+    this->pipelineLayout = pipelineLayout.get();
+    this->set = set;
+    pushDescriptors = true;
+    AppResource::init(appBase, appBase->resources.descriptorUpdateTemplates.create(updateTemplate));
+}
+
+void AppDescriptorUpdateTemplate::update(VkDescriptorSet descriptorSet, const void* data)
+{
+    if (pushDescriptors) throw std::runtime_error("Failed to update descriptor set, the template pushes descriptors");
+    vkUpdateDescriptorSetWithTemplate(appBase->getDevice(), descriptorSet, get(), data);
+}
+
+void AppDescriptorUpdateTemplate::push(VkCommandBuffer commandBuffer, const void* data)
+{
+    if (!pushDescriptors) throw std::runtime_error("Failed to push descriptors, the template updates descriptor sets");
+    appBase->logicalDevice.getCmdPushDescriptorSetWithTemplate()(commandBuffer, get(), pipelineLayout, set, data);
+}
+
+void AppDescriptorUpdateTemplate::destroy()
+{
+    appBase->resources.descriptorUpdateTemplates.destroy(getIterator(), appBase->getDevice());
+}
\ No newline at end of file
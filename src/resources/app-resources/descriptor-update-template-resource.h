@@ -0,0 +1,42 @@
+#pragma once
+#include "app-resource.h"
+
+/**
+ * A descriptor update template writes every binding of a set from one struct in a single call. Each entry says where
+ * in the struct the descriptor infos of one binding are, so the driver copies them without VkWriteDescriptorSet
+ * structures being built or parsed.
+ */
+class AppDescriptorUpdateTemplate : public AppResource<VkDescriptorUpdateTemplate> {
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    uint32_t set = 0U;
+    bool pushDescriptors = false;
+
+    public:
+    /**
+     * @brief Creates a template that updates allocated descriptor sets of the layout
+     *
+     * @param entries Where the infos of each binding are in the structs passed to update
+     */
+    void init(class AppBase* appBase, class AppDescriptorSetLayout &descriptorSetLayout, std::vector<VkDescriptorUpdateTemplateEntry> entries);
+
+    /**
+     * @brief Creates a template that pushes the descriptors of a set of the pipeline layout into command buffers
+     *
+     * @note Requires AppDevice::supportsPushDescriptors, the set's layout must have been created with
+     * VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR
+     */
+    void init(class AppBase* appBase, class AppDescriptorSetLayout &descriptorSetLayout, std::vector<VkDescriptorUpdateTemplateEntry> entries,
+        VkPipelineBindPoint pipelineBindPoint, class AppPipelineLayout &pipelineLayout, uint32_t set);
+
+    /**
+     * @brief Writes every binding of a descriptor set from the data, the set must not be in use by the device
+     */
+    void update(VkDescriptorSet descriptorSet, const void* data);
+
+    /**
+     * @brief Records the descriptors of the data into the command buffer, replacing those of the set bound before
+     */
+    void push(VkCommandBuffer commandBuffer, const void* data);
+
+    void destroy();
+};
\ No newline at end of file
@@ -19,17 +19,41 @@ uint32_t getSuitableMemoryTypeIndex(VkPhysicalDevice physicalDevice, VkMemoryReq
     throw std::runtime_error("Unable to find a suitable memory type");
 }
 
+void AppDeviceMemory::allocate(VkMemoryRequirements memoryRequirements, VkMemoryPropertyFlags memoryPropertyFlags)
+{
+    uint32_t memoryTypeIndex = getSuitableMemoryTypeIndex(appBase->physicalDevice, memoryRequirements, memoryPropertyFlags);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.pNext = nullptr;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+    allocInfo.allocationSize = memoryRequirements.size;
+    this->size = memoryRequirements.size;
+
+    VkDeviceMemory deviceMemory;
+    THROW(vkAllocateMemory(appBase->getDevice(), &allocInfo, nullptr, &deviceMemory), "Failed to allocate device memory");
+
+    // Map host-visible memory for its whole lifetime, rather than mapping and unmapping around every write.
+    // The mapping is released implicitly when the memory is freed.
+    this->mappedData = nullptr;
+    if (memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        THROW(vkMapMemory(appBase->getDevice(), deviceMemory, 0U, VK_WHOLE_SIZE, 0U, &mappedData), "Failed to map device memory");
+    }
+
+    AppResource::init(appBase, appBase->resources.deviceMemorySet.create(deviceMemory));
+}
+
 void AppDeviceMemory::init(AppBase* appBase, AppBuffer buffer)
 {
-   
-    AppDeviceMemory returnDeviceMemory{};
-    
+    this->appBase = appBase;
     VkMemoryPropertyFlags memoryPropertyFlags = 0U;
 
     switch (buffer.getTemplate()) {
         case AppBufferTemplate::UNIFORM_BUFFER :
         case AppBufferTemplate::VERTEX_BUFFER_STAGING :
         case AppBufferTemplate::INDEX_BUFFER_STAGING :
+        case AppBufferTemplate::IMAGE_STAGING :
+        case AppBufferTemplate::STORAGE_BUFFER :
             memoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
             break;
         case AppBufferTemplate::VERTEX_BUFFER_DEVICE :
@@ -40,28 +64,19 @@ void AppDeviceMemory::init(AppBase* appBase, AppBuffer buffer)
 
     VkMemoryRequirements bufferMemoryRequirements;
     vkGetBufferMemoryRequirements(appBase->getDevice(), buffer.get(), &bufferMemoryRequirements);
-    uint32_t memoryTypeIndex = getSuitableMemoryTypeIndex(appBase->physicalDevice, bufferMemoryRequirements, memoryPropertyFlags);
-
-    VkMemoryAllocateInfo memoryAllocateInfo {};
-    memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memoryAllocateInfo.pNext = nullptr;
-    memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
-    memoryAllocateInfo.allocationSize = bufferMemoryRequirements.size;
-    this->size = bufferMemoryRequirements.size;
-
-    VkDeviceMemory deviceMemory;
-    THROW(vkAllocateMemory(appBase->getDevice(), &memoryAllocateInfo, nullptr, &deviceMemory), "Failed to allocate buffer memory");
-    
-    AppResource::init(appBase, appBase->resources.deviceMemorySet.create(deviceMemory));
+    allocate(bufferMemoryRequirements, memoryPropertyFlags);
 }
 
 void AppDeviceMemory::init(AppBase* appBase, AppImage image)
 {
+    this->appBase = appBase;
     VkMemoryPropertyFlags memoryPropertyFlags = 0U;
 
     switch (image.getTemplate()) {
         case AppImageTemplate::DEPTH_STENCIL :
         case AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE :
+        case AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE_BC7 :
+        case AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE_BC5 :
             memoryPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
             break;
 
@@ -73,19 +88,7 @@ void AppDeviceMemory::init(AppBase* appBase, AppImage image)
 
     VkMemoryRequirements imageMemoryRequirements;
     vkGetImageMemoryRequirements(appBase->getDevice(), image.get(), &imageMemoryRequirements);
-    uint32_t memoryTypeIndex = getSuitableMemoryTypeIndex(appBase->physicalDevice, imageMemoryRequirements, memoryPropertyFlags);
-
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.pNext = nullptr;
-    allocInfo.memoryTypeIndex = memoryTypeIndex;
-    allocInfo.allocationSize = imageMemoryRequirements.size;
-    this->size = imageMemoryRequirements.size;
-
-    VkDeviceMemory deviceMemory;
-    THROW(vkAllocateMemory(appBase->getDevice(), &allocInfo, nullptr, &deviceMemory), "Failed to allocate image memory");
-
-    AppResource::init(appBase, appBase->resources.deviceMemorySet.create(deviceMemory));
+    allocate(imageMemoryRequirements, memoryPropertyFlags);
 }
 
 void AppDeviceMemory::destroy()
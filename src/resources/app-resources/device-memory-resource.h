@@ -5,10 +5,21 @@
 
 class AppDeviceMemory : public AppResource<VkDeviceMemory> {
     uint32_t size;
+
+    // Host-visible memory is mapped once when allocated and stays mapped until it is freed
+    void* mappedData = nullptr;
+    void allocate(VkMemoryRequirements memoryRequirements, VkMemoryPropertyFlags memoryPropertyFlags);
     public:
     void init(class AppBase* appBase, AppBuffer buffer);
     void init(class AppBase* appBase, AppImage image);
     uint32_t getSize() { return size; }
+
+    /**
+     * @brief Gets the persistent host mapping of this memory
+     * 
+     * @return A pointer to the start of the memory, or nullptr if the memory is not host-visible
+     */
+    void* getMappedData() { return mappedData; }
     
     void destroy();
 };
\ No newline at end of file
@@ -1,10 +1,15 @@
 #include "app-base.h"
 #include "device-resource.h"
+#include <cstring>
 
 void AppDevice::init(AppBase* appBase, VkPhysicalDevice physicalDevice, std::vector<const char*> layers, std::vector<const char*> extensions)
 {
     VkDevice device = VK_NULL_HANDLE;
 
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    limits = properties.limits;
+
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     createInfo.pNext = nullptr;
@@ -43,12 +48,71 @@ void AppDevice::init(AppBase* appBase, VkPhysicalDevice physicalDevice, std::vec
     createInfo.queueCreateInfoCount = queueCreateInfos.size();
     createInfo.enabledLayerCount = layers.size();
     createInfo.ppEnabledLayerNames = layers.data();
+
+    // VK_EXT_memory_budget only adds queries and VK_KHR_push_descriptor only adds commands, so each is enabled
+    // whenever the physical device has it
+    uint32_t extensionCount = 0U;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> supportedExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, supportedExtensions.data());
+
+    memoryBudgetEnabled = false;
+    pushDescriptorEnabled = false;
+    for (const VkExtensionProperties &extension : supportedExtensions) {
+        if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0) memoryBudgetEnabled = true;
+        if (strcmp(extension.extensionName, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME) == 0) pushDescriptorEnabled = true;
+    }
+    if (memoryBudgetEnabled) extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (pushDescriptorEnabled) extensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+
     createInfo.enabledExtensionCount = extensions.size();
     createInfo.ppEnabledExtensionNames = extensions.data();
 
+    // Query the descriptor indexing features, all of them are required for bindless textures
+    VkPhysicalDeviceVulkan12Features supportedVulkan12Features{};
+    supportedVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    supportedVulkan12Features.pNext = nullptr;
+    VkPhysicalDeviceFeatures2 supportedFeatures{};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures.pNext = &supportedVulkan12Features;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures);
+
+    descriptorIndexingEnabled = supportedVulkan12Features.descriptorIndexing
+        && supportedVulkan12Features.shaderSampledImageArrayNonUniformIndexing
+        && supportedVulkan12Features.descriptorBindingSampledImageUpdateAfterBind
+        && supportedVulkan12Features.descriptorBindingPartiallyBound
+        && supportedVulkan12Features.runtimeDescriptorArray;
+
+    VkPhysicalDeviceVulkan12Features enabledVulkan12Features{};
+    enabledVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    enabledVulkan12Features.pNext = nullptr;
+    enabledVulkan12Features.descriptorIndexing = descriptorIndexingEnabled;
+    enabledVulkan12Features.shaderSampledImageArrayNonUniformIndexing = descriptorIndexingEnabled;
+    enabledVulkan12Features.descriptorBindingSampledImageUpdateAfterBind = descriptorIndexingEnabled;
+    enabledVulkan12Features.descriptorBindingPartiallyBound = descriptorIndexingEnabled;
+    enabledVulkan12Features.runtimeDescriptorArray = descriptorIndexingEnabled;
+    createInfo.pNext = &enabledVulkan12Features;
+
+    // Fragment shader stores are used to write texture residency feedback
+    fragmentStoresEnabled = supportedFeatures.features.fragmentStoresAndAtomics;
+    VkPhysicalDeviceFeatures enabledFeatures{};
+    enabledFeatures.fragmentStoresAndAtomics = fragmentStoresEnabled;
+
+    // Textures are BC7 and BC5 compressed where the device can sample them, and uploaded uncompressed otherwise
+    textureCompressionBCEnabled = supportedFeatures.features.textureCompressionBC;
+    enabledFeatures.textureCompressionBC = textureCompressionBCEnabled;
+    createInfo.pEnabledFeatures = &enabledFeatures;
+
     VkDevice logicalDevice;
     THROW(vkCreateDevice(physicalDevice, &createInfo, nullptr, &logicalDevice), "Failed to create logical device");
 
+    // Extension commands are not exported by the loader, they are fetched from the device
+    if (pushDescriptorEnabled) {
+        cmdPushDescriptorSet = reinterpret_cast<PFN_vkCmdPushDescriptorSetKHR>(vkGetDeviceProcAddr(logicalDevice, "vkCmdPushDescriptorSetKHR"));
+        cmdPushDescriptorSetWithTemplate = reinterpret_cast<PFN_vkCmdPushDescriptorSetWithTemplateKHR>(vkGetDeviceProcAddr(logicalDevice, "vkCmdPushDescriptorSetWithTemplateKHR"));
+        pushDescriptorEnabled = cmdPushDescriptorSet != nullptr && cmdPushDescriptorSetWithTemplate != nullptr;
+    }
+
     AppResource::init(appBase, appBase->resources.devices.create(logicalDevice));
 }
 
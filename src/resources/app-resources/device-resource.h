@@ -2,8 +2,64 @@
 #include "app-resource.h"
 
 class AppDevice : public AppResource<VkDevice> {
+    bool descriptorIndexingEnabled = false;
+    bool fragmentStoresEnabled = false;
+    bool textureCompressionBCEnabled = false;
+    bool memoryBudgetEnabled = false;
+    bool pushDescriptorEnabled = false;
+    PFN_vkCmdPushDescriptorSetKHR cmdPushDescriptorSet = nullptr;
+    PFN_vkCmdPushDescriptorSetWithTemplateKHR cmdPushDescriptorSetWithTemplate = nullptr;
+    VkPhysicalDeviceLimits limits{};
     public:
+    /**
+     * @brief Creates the logical device
+     * 
+     * @note The descriptor indexing features needed for bindless textures (core in Vulkan 1.2) are enabled when the
+     * physical device supports them, as are fragment shader stores and atomics, BC texture compression,
+     * VK_EXT_memory_budget and VK_KHR_push_descriptor
+     */
     void init(class AppBase* appBase, VkPhysicalDevice physicalDevice, std::vector<const char*> layers = {}, std::vector<const char*> extensions = {});
     
+    /**
+     * @brief Checks whether update-after-bind, partially bound arrays of sampled images can be used
+     */
+    bool supportsDescriptorIndexing() { return descriptorIndexingEnabled; }
+
+    /**
+     * @brief Checks whether fragment shaders may write to storage buffers and perform atomics on them
+     */
+    bool supportsFragmentStores() { return fragmentStoresEnabled; }
+
+    /**
+     * @brief Checks whether BC block-compressed images can be sampled
+     */
+    bool supportsTextureCompressionBC() { return textureCompressionBCEnabled; }
+
+    /**
+     * @brief Checks whether VK_EXT_memory_budget is enabled, so heap budgets and usage can be queried
+     */
+    bool supportsMemoryBudget() { return memoryBudgetEnabled; }
+
+    /**
+     * @brief Checks whether VK_KHR_push_descriptor is enabled, so descriptors can be recorded into command buffers
+     * without allocating descriptor sets
+     */
+    bool supportsPushDescriptors() { return pushDescriptorEnabled; }
+
+    /**
+     * @brief Gets vkCmdPushDescriptorSetKHR, null unless push descriptors are supported
+     */
+    PFN_vkCmdPushDescriptorSetKHR getCmdPushDescriptorSet() { return cmdPushDescriptorSet; }
+
+    /**
+     * @brief Gets vkCmdPushDescriptorSetWithTemplateKHR, null unless push descriptors are supported
+     */
+    PFN_vkCmdPushDescriptorSetWithTemplateKHR getCmdPushDescriptorSetWithTemplate() { return cmdPushDescriptorSetWithTemplate; }
+
+    /**
+     * @brief Gets the limits of the physical device the logical device was created on
+     */
+    const VkPhysicalDeviceLimits &getLimits() { return limits; }
+
     void destroy();
-};
\ No newline at end of file
+};
@@ -2,9 +2,11 @@
 #include "image-resource.h"
 #include "device-resource.h"
 #include "device-memory-resource.h"
+#include "buffer-resource.h"
+#include <algorithm>
 
 
-VkImageCreateInfo getImageCreateInfoFromTemplate(AppImageTemplate t, uint32_t height, uint32_t width, uint32_t layerCount) { 
+VkImageCreateInfo getImageCreateInfoFromTemplate(AppImageTemplate t, uint32_t height, uint32_t width, uint32_t layerCount, uint32_t mipLevels) { 
     switch(t) {
         case AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE:
         return {
@@ -14,7 +16,43 @@ VkImageCreateInfo getImageCreateInfoFromTemplate(AppImageTemplate t, uint32_t he
             VK_IMAGE_TYPE_2D, //imageType
             VK_FORMAT_R8G8B8A8_UNORM, //format
             {height, width, 1U}, // extent {width, height, depth}
-            1U, // mipLevels
+            mipLevels, // mipLevels
+            layerCount, // arrayLayers
+            VK_SAMPLE_COUNT_1_BIT, //samples
+            VK_IMAGE_TILING_OPTIMAL, //tiling
+            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, //usage, blit mip generation (storage is added where the format supports it)
+            VK_SHARING_MODE_EXCLUSIVE, //sharingMode
+            0U, //queueFamilyIndexCount
+            nullptr, // pQueueFamilyIndices
+            VK_IMAGE_LAYOUT_UNDEFINED // initialLayout
+        };
+        case AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE_BC7:
+        return {
+            VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO, //sType
+            NULL, //pNext
+            0U, //flags
+            VK_IMAGE_TYPE_2D, //imageType
+            VK_FORMAT_BC7_UNORM_BLOCK, //format
+            {height, width, 1U}, // extent {width, height, depth}
+            mipLevels, // mipLevels
+            layerCount, // arrayLayers
+            VK_SAMPLE_COUNT_1_BIT, //samples
+            VK_IMAGE_TILING_OPTIMAL, //tiling
+            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, //usage
+            VK_SHARING_MODE_EXCLUSIVE, //sharingMode
+            0U, //queueFamilyIndexCount
+            nullptr, // pQueueFamilyIndices
+            VK_IMAGE_LAYOUT_UNDEFINED // initialLayout
+        };
+        case AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE_BC5:
+        return {
+            VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO, //sType
+            NULL, //pNext
+            0U, //flags
+            VK_IMAGE_TYPE_2D, //imageType
+            VK_FORMAT_BC5_UNORM_BLOCK, //format
+            {height, width, 1U}, // extent {width, height, depth}
+            mipLevels, // mipLevels
             layerCount, // arrayLayers
             VK_SAMPLE_COUNT_1_BIT, //samples
             VK_IMAGE_TILING_OPTIMAL, //tiling
@@ -40,7 +78,7 @@ VkImageCreateInfo getImageCreateInfoFromTemplate(AppImageTemplate t, uint32_t he
             VK_SHARING_MODE_EXCLUSIVE, //sharingMode
             0U, //queueFamilyIndexCount
             nullptr, // pQueueFamilyIndices
-            VK_IMAGE_LAYOUT_UNDEFINED // initialLayout
+            VK_IMAGE_LAYOUT_PREINITIALIZED // initialLayout, keeps host writes made before the first transition
         };
         case AppImageTemplate::DEVICE_WRITE_SAMPLED_TEXTURE:
         return {
@@ -83,6 +121,26 @@ VkImageCreateInfo getImageCreateInfoFromTemplate(AppImageTemplate t, uint32_t he
     };
 };
 
+uint32_t AppImage::getFullMipLevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t mipLevels = 1U;
+    for (uint32_t size = std::max(width, height) ; size > 1U ; size /= 2U) mipLevels++;
+    return mipLevels;
+}
+
+static bool formatSupportsStorage(VkPhysicalDevice physicalDevice, VkFormat format)
+{
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+    return formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+}
+
+static bool templateHasMipChain(AppImageTemplate t)
+{
+    return t == AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE || t == AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE_BC7
+        || t == AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE_BC5;
+}
+
 void AppImage::init(AppBase* appBase, AppImageTemplate appImageTemplate, uint32_t height, uint32_t width, uint32_t layerCount, VkImageLayout layout)
 {
     this->imageCreationTemplate = appImageTemplate;
@@ -90,8 +148,18 @@ void AppImage::init(AppBase* appBase, AppImageTemplate appImageTemplate, uint32_
     this->width = width;
     this->layout = layout;
     this->layerCount = layerCount;
+    this->mipLevels = templateHasMipChain(appImageTemplate) ? getFullMipLevelCount(height, width) : 1U;
+
+    VkImageCreateInfo createInfo{ getImageCreateInfoFromTemplate(appImageTemplate, height, width, layerCount, mipLevels) };
+    this->format = createInfo.format;
 
-    VkImageCreateInfo createInfo{ getImageCreateInfoFromTemplate(appImageTemplate, height, width, layerCount) };
+    // Mip chains that cannot be blitted are generated in a compute shader, which writes the levels as storage images,
+    // and uploads may be converted into the image by one. Storage usage is only requested where the format supports
+    // it, since an image cannot be created otherwise
+    if (appImageTemplate == AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE && formatSupportsStorage(appBase->physicalDevice, createInfo.format)) {
+        createInfo.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    }
+    this->usage = createInfo.usage;
 
     // Attempt to create the image
     VkImage image = VK_NULL_HANDLE;
@@ -107,6 +175,11 @@ void AppImage::init(AppBase* appBase, VkImage image, AppImageTemplate appImageTe
     this->width = width;
     this->layout = layout;
     this->layerCount = layerCount;
+    this->mipLevels = 1U;
+
+    VkImageCreateInfo createInfo{ getImageCreateInfoFromTemplate(appImageTemplate, height, width, layerCount, mipLevels) };
+    this->format = createInfo.format;
+    this->usage = createInfo.usage;
 
     AppResource::init(appBase, appBase->resources.images.create(image));
 }
@@ -117,7 +190,7 @@ void AppImage::transitionLayout(VkImageLayout newLayout, VkCommandBuffer command
     layoutTransitionBarrier.pNext = nullptr;
     layoutTransitionBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     //                                {aspect mask, mip level, mip level count, array layer, array layer count}
-    layoutTransitionBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, 1U, targetLayer, layerCount};
+    layoutTransitionBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, mipLevels, targetLayer, layerCount};
     layoutTransitionBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     layoutTransitionBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     layoutTransitionBarrier.srcAccessMask = VK_ACCESS_NONE; // We are not waiting for anything to occur prior to this barrier
@@ -166,6 +239,14 @@ void AppImage::transitionLayout(VkImageLayout newLayout, VkCommandBuffer command
     this->layout = newLayout;
 }
 
+VkSubresourceLayout AppImage::getSubresourceLayout(uint32_t layer)
+{
+    VkImageSubresource subresource {VK_IMAGE_ASPECT_COLOR_BIT, 0U, layer};
+    VkSubresourceLayout subresourceLayout {};
+    vkGetImageSubresourceLayout(appBase->getDevice(), get(), &subresource, &subresourceLayout);
+    return subresourceLayout;
+}
+
 void AppImage::bindToMemory(AppDeviceMemory* imageMemory)
 {
     VkImage img = get();
@@ -174,8 +255,12 @@ void AppImage::bindToMemory(AppDeviceMemory* imageMemory)
     THROW(vkBindImageMemory(appBase->getDevice(), img, memory, 0U), "Failed to bind image to memory");
 }
 
-void AppImage::copyImage(AppImage &src, AppImage &dst, VkCommandBuffer commandBuffer, uint32_t srcLayer, uint32_t dstLayer, uint32_t layerCount, VkImageAspectFlags srcAspect, VkImageAspectFlags dstAspect)
+void AppImage::copyImage(AppImage &src, AppImage &dst, VkCommandBuffer commandBuffer, uint32_t srcLayer, uint32_t dstLayer, uint32_t layerCount, VkImageAspectFlags srcAspect, VkImageAspectFlags dstAspect, uint32_t srcBaseLevel, uint32_t dstBaseLevel)
 {
+    if (srcBaseLevel >= src.mipLevels || dstBaseLevel >= dst.mipLevels) {
+        throw std::runtime_error("Failed to copy image, the base levels are outside of the images' mip chains");
+    }
+
     // Throw an error if the source and destination images are not in a valid layout for transfer
     if (!(src.layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL || src.layout == VK_IMAGE_LAYOUT_GENERAL)) {
         throw std::runtime_error("Source image must be in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL or VK_IMAGE_LAYOUT_GENERAL layout");
@@ -203,21 +288,24 @@ void AppImage::copyImage(AppImage &src, AppImage &dst, VkCommandBuffer commandBu
     beginInfo.pInheritanceInfo = nullptr;
     beginInfo.flags = 0U;
 
-    // Create the image copy struct
-    VkImageCopy imgCopy{};
-    //                  {x, y, z}
-    imgCopy.srcOffset = {0U, 0U, 0U};
-    imgCopy.dstOffset = {0U, 0U, 0U};
-    imgCopy.extent.width = src.width;
-    imgCopy.extent.height = src.height;
-    imgCopy.extent.depth = 1U; 
-    //                       {Aspect, Mip level, Array layer, Layer count}
-    imgCopy.srcSubresource = {srcAspect, 0U, srcLayer, layerCount};
-    imgCopy.dstSubresource = {dstAspect, 0U, dstLayer, layerCount};
+    // Create an image copy struct for every mip level both images have
+    std::vector<VkImageCopy> imgCopies(std::min(src.mipLevels - srcBaseLevel, dst.mipLevels - dstBaseLevel));
+    for (uint32_t level = 0U ; level < imgCopies.size() ; level++) {
+        VkImageCopy &imgCopy = imgCopies[level];
+        //                  {x, y, z}
+        imgCopy.srcOffset = {0U, 0U, 0U};
+        imgCopy.dstOffset = {0U, 0U, 0U};
+        imgCopy.extent.width = std::max(src.width >> (srcBaseLevel + level), 1U);
+        imgCopy.extent.height = std::max(src.height >> (srcBaseLevel + level), 1U);
+        imgCopy.extent.depth = 1U; 
+        //                       {Aspect, Mip level, Array layer, Layer count}
+        imgCopy.srcSubresource = {srcAspect, srcBaseLevel + level, srcLayer, layerCount};
+        imgCopy.dstSubresource = {dstAspect, dstBaseLevel + level, dstLayer, layerCount};
+    }
 
     // Write the command buffer copy operation
     vkBeginCommandBuffer(commandBuffer, &beginInfo);
-    vkCmdCopyImage(commandBuffer, src.get(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst.get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1U, &imgCopy);
+    vkCmdCopyImage(commandBuffer, src.get(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst.get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, imgCopies.size(), imgCopies.data());
     vkEndCommandBuffer(commandBuffer);
 
     VkFenceCreateInfo transferCompleteFenceInfo{};
@@ -239,6 +327,157 @@ void AppImage::copyImage(AppImage &src, AppImage &dst, VkCommandBuffer commandBu
     vkDestroyFence(device, transferCompleteFence, nullptr);
 }
 
+bool AppImage::supportsBlitMipmaps()
+{
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(appBase->physicalDevice, format, &formatProperties);
+
+    VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+
+void AppImage::generateMipmaps(VkCommandBuffer commandBuffer, uint32_t targetLayer)
+{
+    if (layout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        throw std::runtime_error("Image must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL layout to generate mipmaps");
+    }
+    if (!supportsBlitMipmaps()) {
+        throw std::runtime_error("Image format does not support linear blits, mipmaps must be generated with compute");
+    }
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = get();
+    //                        {aspect mask, mip level, mip level count, array layer, array layer count}
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, 1U, targetLayer, 1U};
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.pNext = nullptr;
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.pInheritanceInfo = nullptr;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    int32_t levelWidth = static_cast<int32_t>(width);
+    int32_t levelHeight = static_cast<int32_t>(height);
+
+    // Every level starts in transfer dst, each one is turned into a blit source once it has been written,
+    // downsampled into the next level, then handed to the shaders
+    for (uint32_t level = 1U ; level < mipLevels ; level++) {
+        barrier.subresourceRange.baseMipLevel = level - 1U;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0U, 0U, nullptr, 0U, nullptr, 1U, &barrier);
+
+        int32_t nextWidth = std::max(levelWidth / 2, 1);
+        int32_t nextHeight = std::max(levelHeight / 2, 1);
+
+        VkImageBlit blit{};
+        blit.srcOffsets[0] = {0, 0, 0};
+        blit.srcOffsets[1] = {levelWidth, levelHeight, 1};
+        blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1U, targetLayer, 1U};
+        blit.dstOffsets[0] = {0, 0, 0};
+        blit.dstOffsets[1] = {nextWidth, nextHeight, 1};
+        blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, targetLayer, 1U};
+        vkCmdBlitImage(commandBuffer, get(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1U, &blit, VK_FILTER_LINEAR);
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0U, 0U, nullptr, 0U, nullptr, 1U, &barrier);
+
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
+    }
+
+    // The last level is only ever written to
+    barrier.subresourceRange.baseMipLevel = mipLevels - 1U;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0U, 0U, nullptr, 0U, nullptr, 1U, &barrier);
+
+    vkEndCommandBuffer(commandBuffer);
+
+    VkFenceCreateInfo mipmapsCompleteFenceInfo{};
+    mipmapsCompleteFenceInfo.pNext = nullptr;
+    mipmapsCompleteFenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkFence mipmapsCompleteFence;
+    vkCreateFence(appBase->getDevice(), &mipmapsCompleteFenceInfo, nullptr, &mipmapsCompleteFence);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.pCommandBuffers = &(commandBuffer);
+    submitInfo.commandBufferCount = 1U;
+    submitInfo.pNext = nullptr;
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pSignalSemaphores = nullptr;
+    submitInfo.signalSemaphoreCount = 0U;
+    submitInfo.pWaitSemaphores = nullptr;
+    submitInfo.pWaitDstStageMask = nullptr;
+    submitInfo.waitSemaphoreCount = 0u;
+
+    vkQueueSubmit(appBase->queues.graphicsQueue, 1U, &submitInfo, mipmapsCompleteFence);
+
+    vkWaitForFences(appBase->getDevice(), 1U, &mipmapsCompleteFence, true, UINT64_MAX);
+    
+    vkDestroyFence(appBase->getDevice(), mipmapsCompleteFence, nullptr);
+
+    this->layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+void AppImage::copyFromBuffer(AppBuffer &src, VkCommandBuffer commandBuffer, std::vector<VkBufferImageCopy> regions)
+{
+    if (!(layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL || layout == VK_IMAGE_LAYOUT_GENERAL)) {
+        throw std::runtime_error("Destination image must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL or VK_IMAGE_LAYOUT_GENERAL layout");
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.pNext = nullptr;
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.pInheritanceInfo = nullptr;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    vkCmdCopyBufferToImage(commandBuffer, src.get(), get(), layout, regions.size(), regions.data());
+    vkEndCommandBuffer(commandBuffer);
+
+    VkFenceCreateInfo transferCompleteFenceInfo{};
+    transferCompleteFenceInfo.pNext = nullptr;
+    transferCompleteFenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkFence transferCompleteFence;
+    vkCreateFence(appBase->getDevice(), &transferCompleteFenceInfo, nullptr, &transferCompleteFence);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.pCommandBuffers = &(commandBuffer);
+    submitInfo.commandBufferCount = 1U;
+    submitInfo.pNext = nullptr;
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pSignalSemaphores = nullptr;
+    submitInfo.signalSemaphoreCount = 0U;
+    submitInfo.pWaitSemaphores = nullptr;
+    submitInfo.pWaitDstStageMask = nullptr;
+    submitInfo.waitSemaphoreCount = 0u;
+
+    vkQueueSubmit(appBase->queues.graphicsQueue, 1U, &submitInfo, transferCompleteFence);
+
+    vkWaitForFences(appBase->getDevice(), 1U, &transferCompleteFence, true, UINT64_MAX);
+
+    vkDestroyFence(appBase->getDevice(), transferCompleteFence, nullptr);
+}
+
 void AppImage::destroy()
 {
     appBase->resources.images.destroy(getIterator(), appBase->getDevice());
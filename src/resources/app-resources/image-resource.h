@@ -1,12 +1,16 @@
 #pragma once
 #include "app-resource.h"
+#include <vector>
 
 enum class AppImageTemplate {
     PREWRITTEN_SAMPLED_TEXTURE = 0U,
     STAGING_IMAGE_TEXTURE = 1U,
     DEVICE_WRITE_SAMPLED_TEXTURE = 2U,
     DEPTH_STENCIL,
-    SWAPCHAIN_FORMAT
+    SWAPCHAIN_FORMAT,
+    // Block-compressed counterparts of PREWRITTEN_SAMPLED_TEXTURE, their mip chains are uploaded rather than generated
+    PREWRITTEN_SAMPLED_TEXTURE_BC7,
+    PREWRITTEN_SAMPLED_TEXTURE_BC5
 };
 
 
@@ -15,9 +19,29 @@ class AppImage : public AppResource<VkImage> {
     uint32_t layerCount;
     uint32_t width;
     uint32_t height;
+    uint32_t mipLevels;
+    VkFormat format;
+    VkImageUsageFlags usage;
     VkImageLayout layout;
     public:
     AppImageTemplate getTemplate() { return imageCreationTemplate; }
+    uint32_t getMipLevels() { return mipLevels; }
+    uint32_t getLayerCount() { return layerCount; }
+    uint32_t getWidth() { return width; }
+    uint32_t getHeight() { return height; }
+    VkFormat getFormat() { return format; }
+    VkImageUsageFlags getUsage() { return usage; }
+    VkImageLayout getLayout() { return layout; }
+
+    /**
+     * @brief Records a layout change made by commands recorded outside of this class
+     */
+    void setLayout(VkImageLayout layout) { this->layout = layout; }
+
+    /**
+     * @brief Gets the number of levels in a full mip chain, down to and including 1x1
+     */
+    static uint32_t getFullMipLevelCount(uint32_t width, uint32_t height);
 
     /**
      * @brief Initializes an app-managed image using one of the defined templates
@@ -62,9 +86,49 @@ class AppImage : public AppResource<VkImage> {
      */
     void transitionLayout(VkImageLayout newLayout, VkCommandBuffer commandBuffer, uint32_t targetLayer = 0U, uint32_t layerCount = 1U);
 
+    /**
+     * @brief Gets the memory layout of a layer of a linearly tiled image
+     * 
+     * The returned row pitch is the one chosen by the device, which may be larger than width * bytes per pixel.
+     * 
+     * @param layer The array layer to query
+     */
+    VkSubresourceLayout getSubresourceLayout(uint32_t layer = 0U);
+
     void bindToMemory(class AppDeviceMemory *imageMemory);
 
-    static void copyImage(AppImage &src, AppImage &dst, VkCommandBuffer commandBuffer, uint32_t srcLayer, uint32_t dstLayer, uint32_t layerCount, VkImageAspectFlags srcAspect = VK_IMAGE_ASPECT_COLOR_BIT, VkImageAspectFlags dstAspect = VK_IMAGE_ASPECT_COLOR_BIT);
+    /**
+     * @brief Checks whether this image's format can be downsampled with linearly filtered blits
+     */
+    bool supportsBlitMipmaps();
+
+    /**
+     * @brief Fills the mip chain of a layer from its first level with a cascade of linearly filtered blits
+     * 
+     * The image must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL with level 0 written. Every level of the layer is
+     * left in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL. Formats that cannot be blitted must use MipmapGenerator.
+     * 
+     * @param commandBuffer The command buffer to record the blits on
+     * @param targetLayer The layer to generate the mip chain of
+     */
+    void generateMipmaps(VkCommandBuffer commandBuffer, uint32_t targetLayer = 0U);
+
+    /**
+     * @brief Copies buffer regions into the image, each region describes the mip level and layer it fills
+     * 
+     * @note The image must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL or VK_IMAGE_LAYOUT_GENERAL layout
+     */
+    void copyFromBuffer(class AppBuffer &src, VkCommandBuffer commandBuffer, std::vector<VkBufferImageCopy> regions);
+
+    /**
+     * @brief Copies layers of one image into another, including every mip level the two images have in common
+     * 
+     * Levels are copied pairwise from srcBaseLevel and dstBaseLevel onwards, so an image can be copied into a smaller
+     * or larger image holding the same mip chain from a different level.
+     * 
+     * @note The source must be in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL and the destination in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+     */
+    static void copyImage(AppImage &src, AppImage &dst, VkCommandBuffer commandBuffer, uint32_t srcLayer, uint32_t dstLayer, uint32_t layerCount, VkImageAspectFlags srcAspect = VK_IMAGE_ASPECT_COLOR_BIT, VkImageAspectFlags dstAspect = VK_IMAGE_ASPECT_COLOR_BIT, uint32_t srcBaseLevel = 0U, uint32_t dstBaseLevel = 0U);
 
     void destroy();
 };
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "app-base.h"
 #include "image-view-resource.h"
 
-static VkImageViewCreateInfo getImageViewCreateInfoFromTemplate(AppImageTemplate t, VkImage image, uint32_t layerCount, uint32_t baseLayer) {
+static VkImageViewCreateInfo getImageViewCreateInfoFromTemplate(AppImageTemplate t, VkImage image, uint32_t layerCount, uint32_t baseLayer, uint32_t baseMipLevel = 0U, uint32_t levelCount = 1U) {
     switch(t) {
         case AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE:
         case AppImageTemplate::DEVICE_WRITE_SAMPLED_TEXTURE:
@@ -21,8 +21,54 @@ static VkImageViewCreateInfo getImageViewCreateInfoFromTemplate(AppImageTemplate
             },
             { 
                 VK_IMAGE_ASPECT_COLOR_BIT, //aspectMask
-                0U, //baseMipLevel
-                1U, //levelCount
+                baseMipLevel, //baseMipLevel
+                levelCount, //levelCount
+                baseLayer, //baseArrayLayer
+                layerCount //layerCount
+            }
+        };
+
+        case AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE_BC7:
+        return {
+            VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO, // sType
+            NULL, //pNext
+            0U, //flags
+            image, //image
+            layerCount > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D, //viewType
+            VK_FORMAT_BC7_UNORM_BLOCK, //format
+            { 
+                VK_COMPONENT_SWIZZLE_IDENTITY, //r
+                VK_COMPONENT_SWIZZLE_IDENTITY, //g
+                VK_COMPONENT_SWIZZLE_IDENTITY, //b
+                VK_COMPONENT_SWIZZLE_IDENTITY //a
+            },
+            { 
+                VK_IMAGE_ASPECT_COLOR_BIT, //aspectMask
+                baseMipLevel, //baseMipLevel
+                levelCount, //levelCount
+                baseLayer, //baseArrayLayer
+                layerCount //layerCount
+            }
+        };
+
+        case AppImageTemplate::PREWRITTEN_SAMPLED_TEXTURE_BC5:
+        return {
+            VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO, // sType
+            NULL, //pNext
+            0U, //flags
+            image, //image
+            layerCount > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D, //viewType
+            VK_FORMAT_BC5_UNORM_BLOCK, //format
+            { 
+                VK_COMPONENT_SWIZZLE_IDENTITY, //r
+                VK_COMPONENT_SWIZZLE_IDENTITY, //g
+                VK_COMPONENT_SWIZZLE_IDENTITY, //b
+                VK_COMPONENT_SWIZZLE_IDENTITY //a
+            },
+            { 
+                VK_IMAGE_ASPECT_COLOR_BIT, //aspectMask
+                baseMipLevel, //baseMipLevel
+                levelCount, //levelCount
                 baseLayer, //baseArrayLayer
                 layerCount //layerCount
             }
@@ -81,7 +127,35 @@ static VkImageViewCreateInfo getImageViewCreateInfoFromTemplate(AppImageTemplate
 
 void AppImageView::init(AppBase* appBase, AppImage &image, uint32_t layerCount, uint32_t baseLayer)
 {
-    VkImageViewCreateInfo createInfo{ getImageViewCreateInfoFromTemplate(image.getTemplate(), image.get(), layerCount, baseLayer) };
+    init(appBase, image, layerCount, baseLayer, 0U, image.getMipLevels());
+}
+
+void AppImageView::init(AppBase* appBase, AppImage &image, uint32_t layerCount, uint32_t baseLayer, uint32_t baseMipLevel, uint32_t levelCount)
+{
+    VkImageViewCreateInfo createInfo{ getImageViewCreateInfoFromTemplate(image.getTemplate(), image.get(), layerCount, baseLayer, baseMipLevel, levelCount) };
+    imageCreationTemplate = image.getTemplate();
+    VkImageView imageView;
+    THROW(vkCreateImageView(appBase->getDevice(), &createInfo, nullptr, &imageView), "Failed to create image view");
+    
+    AppResource::init(appBase, appBase->resources.imageViews.create(imageView));
+}
+
+void AppImageView::initStorage(AppBase* appBase, AppImage &image, uint32_t baseLayer, uint32_t mipLevel)
+{
+    if (!(image.getUsage() & VK_IMAGE_USAGE_STORAGE_BIT)) throw std::runtime_error("Failed to create storage image view, the image was not created with storage usage");
+
+    VkImageViewCreateInfo createInfo{ getImageViewCreateInfoFromTemplate(image.getTemplate(), image.get(), 1U, baseLayer, mipLevel, 1U) };
+    imageCreationTemplate = image.getTemplate();
+    VkImageView imageView;
+    THROW(vkCreateImageView(appBase->getDevice(), &createInfo, nullptr, &imageView), "Failed to create image view");
+    
+    AppResource::init(appBase, appBase->resources.imageViews.create(imageView));
+}
+
+void AppImageView::init(AppBase* appBase, AppImage &image, VkImageViewType viewType)
+{
+    VkImageViewCreateInfo createInfo{ getImageViewCreateInfoFromTemplate(image.getTemplate(), image.get(), image.getLayerCount(), 0U, 0U, image.getMipLevels()) };
+    createInfo.viewType = viewType;
     imageCreationTemplate = image.getTemplate();
     VkImageView imageView;
     THROW(vkCreateImageView(appBase->getDevice(), &createInfo, nullptr, &imageView), "Failed to create image view");
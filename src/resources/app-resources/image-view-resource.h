@@ -7,8 +7,29 @@ class AppImageView : public AppResource<VkImageView> {
     public:
     AppImageTemplate getTemplate() { return imageCreationTemplate; }
 
+    /**
+     * @brief Creates a view of the given layers of an image, covering its whole mip chain
+     */
     void init(class AppBase* appBase, AppImage &image, uint32_t layerCount, uint32_t baseLayer);
+
+    /**
+     * @brief Creates a view of the given layers and mip levels of an image
+     */
+    void init(class AppBase* appBase, AppImage &image, uint32_t layerCount, uint32_t baseLayer, uint32_t baseMipLevel, uint32_t levelCount);
     void init(class AppBase* appBase, VkImage image, AppImageTemplate imageCreationTemplate, uint32_t layerCount, uint32_t baseLayer);
+
+    /**
+     * @brief Creates a view of one mip level of one layer that compute shaders can write as a storage image
+     *
+     * @note The image must have been created with storage usage
+     */
+    void initStorage(class AppBase* appBase, AppImage &image, uint32_t baseLayer, uint32_t mipLevel);
+
+    /**
+     * @brief Creates a view of every layer and mip level of an image with the given view type, such as a single layer
+     * image viewed as an array for shaders that sample arrays
+     */
+    void init(class AppBase* appBase, AppImage &image, VkImageViewType viewType);
     
     void destroy();
 };
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "app-base.h"
+#include "pipeline-cache-resource.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+
+/**
+ * Checks that pipeline cache data was written by this driver for this device, drivers are not required to reject
+ * data from another and some crash on it
+ */
+static bool isCompatibleCacheData(VkPhysicalDevice physicalDevice, const std::vector<char> &data)
+{
+    VkPipelineCacheHeaderVersionOne header{};
+    if (data.size() < sizeof(VkPipelineCacheHeaderVersionOne)) return false;
+    memcpy(&header, data.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    return header.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne) && header.headerSize <= data.size()
+        && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorID == properties.vendorID && header.deviceID == properties.deviceID
+        && memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void AppPipelineCache::init(AppBase* appBase, const std::string &cacheFilePath)
+{
+    std::vector<char> initialData = {};
+    std::ifstream cacheFile(cacheFilePath, std::ios::binary);
+    if (cacheFile.is_open()) initialData.assign(std::istreambuf_iterator<char>(cacheFile), std::istreambuf_iterator<char>());
+    if (!isCompatibleCacheData(appBase->getPhysicalDevice(), initialData)) initialData.clear();
+
+    VkPipelineCacheCreateInfo pipelineCacheInfo{};
+    pipelineCacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    pipelineCacheInfo.pNext = nullptr;
+    pipelineCacheInfo.flags = 0U;
+    pipelineCacheInfo.initialDataSize = initialData.size();
+    pipelineCacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    THROW(vkCreatePipelineCache(appBase->getDevice(), &pipelineCacheInfo, NULL, &pipelineCache), "Failed to create pipeline cache");
+
+    AppResource::init(appBase, appBase->resources.pipelineCaches.create(pipelineCache));
+}
+
+void AppPipelineCache::save(const std::string &cacheFilePath)
+{
+    size_t dataSize = 0U;
+    THROW(vkGetPipelineCacheData(appBase->getDevice(), get(), &dataSize, nullptr), "Failed to get pipeline cache size");
+    std::vector<char> data(dataSize);
+    THROW(vkGetPipelineCacheData(appBase->getDevice(), get(), &dataSize, data.data()), "Failed to get pipeline cache data");
+
+    // Written beside the cache file and renamed over it, so an interrupted save never leaves a truncated cache
+    std::string temporaryPath = cacheFilePath + ".tmp";
+    {
+        std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!output.is_open()) throw std::runtime_error("Failed to open pipeline cache for writing: " + temporaryPath);
+        output.write(data.data(), dataSize);
+        if (!output) throw std::runtime_error("Failed to write pipeline cache: " + temporaryPath);
+    }
+    std::filesystem::rename(temporaryPath, cacheFilePath);
+}
+
+void AppPipelineCache::destroy()
+{
+    appBase->resources.pipelineCaches.destroy(getIterator(), appBase->getDevice());
+}
\ No newline at end of file
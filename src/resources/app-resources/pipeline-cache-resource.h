@@ -0,0 +1,21 @@
+#pragma once
+#include "app-resource.h"
+#include <string>
+
+class AppPipelineCache : public AppResource<VkPipelineCache> {
+    public:
+    /**
+     * @brief Creates the pipeline cache, seeded with the data a previous run saved to the file
+     * 
+     * The saved data is only used when it was written by the same driver for the same device, a missing, truncated or
+     * foreign file starts an empty cache. Pipelines compiled through a warm cache skip most of their compilation.
+     */
+    void init(class AppBase* appBase, const std::string &cacheFilePath);
+
+    /**
+     * @brief Writes the cache's data to the file, for the next run to be seeded with
+     */
+    void save(const std::string &cacheFilePath);
+
+    void destroy();
+};
\ No newline at end of file
@@ -3,7 +3,8 @@
 #include "vertex.h"
 #include "app-config.h"
 
-void AppPipeline::init(AppBase* appBase, std::vector<AppShaderModule> shaderModules, AppPipelineLayout pipelineLayout, AppRenderPass renderPass, uint32_t flags)
+void AppPipeline::init(AppBase* appBase, std::vector<AppShaderModule> shaderModules, AppPipelineLayout pipelineLayout, AppRenderPass renderPass, uint32_t flags,
+    const VkSpecializationInfo* specializationInfo, VkPipelineCache pipelineCache)
 {
     // Configure vertex buffer binding
 
@@ -111,7 +112,7 @@ void AppPipeline::init(AppBase* appBase, std::vector<AppShaderModule> shaderModu
         shaderStageCreateInfos.back().module = appShaderModule.get();
         shaderStageCreateInfos.back().pName = "main";
         shaderStageCreateInfos.back().stage = appShaderModule.getShaderStage();
-        shaderStageCreateInfos.back().pSpecializationInfo = nullptr;
+        shaderStageCreateInfos.back().pSpecializationInfo = specializationInfo;
     }
 
     VkPipelineDepthStencilStateCreateInfo dsStateCreateInfo{};
@@ -144,7 +145,34 @@ void AppPipeline::init(AppBase* appBase, std::vector<AppShaderModule> shaderModu
     colorSubpassPipelineInfo.basePipelineIndex = -1; // Optional
     
     VkPipeline pipeline = VK_NULL_HANDLE;
-    THROW(vkCreateGraphicsPipelines(appBase->getDevice(), VK_NULL_HANDLE, 1, &colorSubpassPipelineInfo, NULL, &pipeline), "Failed to create graphics pipeline");
+    THROW(vkCreateGraphicsPipelines(appBase->getDevice(), pipelineCache, 1, &colorSubpassPipelineInfo, NULL, &pipeline), "Failed to create graphics pipeline");
+
+    AppResource::init(appBase, appBase->resources.pipelines.create(pipeline));
+}
+
+void AppPipeline::init(AppBase* appBase, AppShaderModule computeShaderModule, AppPipelineLayout pipelineLayout,
+    const VkSpecializationInfo* specializationInfo, VkPipelineCache pipelineCache)
+{
+    VkPipelineShaderStageCreateInfo shaderStageCreateInfo{};
+    shaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStageCreateInfo.pNext = nullptr;
+    shaderStageCreateInfo.flags = 0U;
+    shaderStageCreateInfo.module = computeShaderModule.get();
+    shaderStageCreateInfo.pName = "main";
+    shaderStageCreateInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    shaderStageCreateInfo.pSpecializationInfo = specializationInfo;
+
+    VkComputePipelineCreateInfo computePipelineInfo{};
+    computePipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    computePipelineInfo.pNext = nullptr;
+    computePipelineInfo.flags = 0U;
+    computePipelineInfo.stage = shaderStageCreateInfo;
+    computePipelineInfo.layout = pipelineLayout.get();
+    computePipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    computePipelineInfo.basePipelineIndex = -1;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    THROW(vkCreateComputePipelines(appBase->getDevice(), pipelineCache, 1, &computePipelineInfo, NULL, &pipeline), "Failed to create compute pipeline");
 
     AppResource::init(appBase, appBase->resources.pipelines.create(pipeline));
 }
@@ -6,6 +6,20 @@
 
 class AppPipeline : public AppResource<VkPipeline> {
     public:
-    void init(class AppBase* appBase, std::vector<AppShaderModule> shaderModules, AppPipelineLayout pipelineLayout, AppRenderPass renderPass, uint32_t flags = VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT);
+    /**
+     * @brief Creates a graphics pipeline
+     * 
+     * @param specializationInfo The values of the specialization constants, given to every stage, or nullptr to
+     * compile the stages with their constants' default values
+     * @param pipelineCache Speeds up compiling pipelines that were compiled before, may be VK_NULL_HANDLE
+     */
+    void init(class AppBase* appBase, std::vector<AppShaderModule> shaderModules, AppPipelineLayout pipelineLayout, AppRenderPass renderPass, uint32_t flags = VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT,
+        const VkSpecializationInfo* specializationInfo = nullptr, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+
+    /**
+     * @brief Creates a compute pipeline from a single compute shader module
+     */
+    void init(class AppBase* appBase, AppShaderModule computeShaderModule, AppPipelineLayout pipelineLayout,
+        const VkSpecializationInfo* specializationInfo = nullptr, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
     void destroy();
 };
\ No newline at end of file
@@ -20,7 +20,7 @@ static VkSamplerCreateInfo getSamplerCreateInfoFromTemplate(AppSamplerTemplate t
                 VK_TRUE,
                 VK_COMPARE_OP_ALWAYS,
                 0.f,
-                1.f,
+                VK_LOD_CLAMP_NONE, // maxLod, sample every level of the image view
                 VK_BORDER_COLOR_INT_OPAQUE_BLACK,
                 VK_FALSE,
             };
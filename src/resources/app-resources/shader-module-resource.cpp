@@ -2,13 +2,21 @@
 #include "shader-module-resource.h"
 
 void AppShaderModule::init(AppBase* appBase, std::vector<char> bytecode, VkShaderStageFlagBits shaderStageFlags)
+{
+    if (bytecode.size() % sizeof(uint32_t) != 0U) throw std::runtime_error("Failed to create shader module, SPIR-V must be a whole number of words");
+
+    // Vector storage is allocated with at least the alignment of a word
+    init(appBase, std::span<const uint32_t>(reinterpret_cast<const uint32_t*>(bytecode.data()), bytecode.size() / sizeof(uint32_t)), shaderStageFlags);
+}
+
+void AppShaderModule::init(AppBase* appBase, std::span<const uint32_t> spirv, VkShaderStageFlagBits shaderStageFlags)
 {
     this->shaderStageFlags = shaderStageFlags;
     
     VkShaderModuleCreateInfo shaderModuleCreateInfo{};
-    shaderModuleCreateInfo.codeSize = bytecode.size();
+    shaderModuleCreateInfo.codeSize = spirv.size_bytes();
     shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(bytecode.data());
+    shaderModuleCreateInfo.pCode = spirv.data();
 
     VkShaderModule shaderModule;
     THROW(vkCreateShaderModule(appBase->getDevice(), &shaderModuleCreateInfo, NULL, &shaderModule), "Failed to create shader module");
@@ -1,10 +1,16 @@
 #pragma once
 #include "app-resource.h"
+#include <span>
 
 class AppShaderModule : public AppResource<VkShaderModule> {
     VkShaderStageFlagBits shaderStageFlags;
     public:
     void init(class AppBase* appBase, std::vector<char> bytecode, VkShaderStageFlagBits shaderStageFlags);
+
+    /**
+     * @brief Creates the module from SPIR-V words, such as the arrays the build embeds in embedded-shaders.h
+     */
+    void init(class AppBase* appBase, std::span<const uint32_t> spirv, VkShaderStageFlagBits shaderStageFlags);
     VkShaderStageFlagBits getShaderStage() { return shaderStageFlags; }
     void destroy();
 };
\ No newline at end of file
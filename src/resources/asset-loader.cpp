@@ -0,0 +1,348 @@
+#include "asset-loader.h"
+#include "app-base.h"
+#include "geometry-manager.h"
+#include "mesh-cache.h"
+#include <algorithm>
+#include <iostream>
+
+AssetLoader::LoadSlot& AssetLoader::LoadSlot::operator=(LoadSlot &&other) noexcept
+{
+    if (this != &other) {
+        if (loader != nullptr) loader->releaseSlot();
+        loader = std::exchange(other.loader, nullptr);
+    }
+    return *this;
+}
+
+AssetLoader::LoadSlot::~LoadSlot()
+{
+    if (loader != nullptr) loader->releaseSlot();
+}
+
+bool AssetLoader::SlotAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    this->handle = handle;
+
+    std::lock_guard<std::mutex> lock(loader->slotMutex);
+    if (loader->activeLoads < loader->config.maxConcurrentLoads && loader->waitingLoads.empty()) {
+        loader->activeLoads++;
+        granted = true;
+        return false;
+    }
+
+    sequence = loader->nextSequence++;
+    loader->waitingLoads.push_back(this);
+
+    std::lock_guard<std::mutex> statsLock(loader->statsMutex);
+    loader->stats.maxQueuedLoads = std::max<uint32_t>(loader->stats.maxQueuedLoads, loader->waitingLoads.size());
+    return true;
+}
+
+AssetLoader::LoadSlot AssetLoader::SlotAwaiter::await_resume()
+{
+    // Taken before checking the token, so that a load cancelled after being granted a slot still releases it
+    LoadSlot slot = granted ? LoadSlot(loader) : LoadSlot();
+    token.throwIfCancelled();
+    return slot;
+}
+
+void AssetLoader::releaseSlot()
+{
+    SlotAwaiter* next = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        activeLoads--;
+        if (waitingLoads.empty()) return;
+
+        auto nextIt = std::min_element(waitingLoads.begin(), waitingLoads.end(), [](const SlotAwaiter* a, const SlotAwaiter* b) {
+            if (a->priority != b->priority) return a->priority > b->priority;
+            return a->sequence < b->sequence;
+        });
+        next = *nextIt;
+        waitingLoads.erase(nextIt);
+        activeLoads++;
+        next->granted = true;
+    }
+
+    // The slot may be released deep within another load, so the next load starts on a worker rather than on this stack
+    std::coroutine_handle<> handle = next->handle;
+    jobSystem->run([handle]() { handle.resume(); });
+}
+
+void AssetLoader::ReadAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    // The load may be resumed before read returns, so nothing may touch the awaiter once it has been queued
+    loader->fileReader->read(filePath, [this, handle](std::vector<char> data, std::exception_ptr error) {
+        this->data = std::move(data);
+        this->error = error;
+        loader->jobSystem->run([handle]() { handle.resume(); });
+    });
+}
+
+std::vector<char> AssetLoader::ReadAwaiter::await_resume()
+{
+    if (error) std::rethrow_exception(error);
+    token.throwIfCancelled();
+    return std::move(data);
+}
+
+void AssetLoader::MainThreadAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    this->handle = handle;
+
+    std::lock_guard<std::mutex> lock(loader->mainThreadMutex);
+    loader->mainThreadLoads.push_back(this);
+}
+
+void AssetLoader::UploadAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    this->handle = handle;
+
+    std::lock_guard<std::mutex> lock(loader->mainThreadMutex);
+    loader->queuedUploads.push_back(this);
+}
+
+void AssetLoader::init(AppBase* appBase, AsyncFileReader* fileReader, JobSystem* jobSystem, TextureRegistry* textureRegistry, VIBufferManager* viBufferManager, AssetLoaderConfig config)
+{
+    this->appBase = appBase;
+    this->fileReader = fileReader;
+    this->jobSystem = jobSystem;
+    this->textureRegistry = textureRegistry;
+    this->viBufferManager = viBufferManager;
+    this->config = config;
+    this->config.maxConcurrentLoads = std::max(this->config.maxConcurrentLoads, 1U);
+
+    // The vertex and index buffers are owned by the graphics family and ownership transfers are not recorded, so the
+    // uploads only use the transfer queue when it belongs to the same family
+    uploadQueue = appBase->queues.graphicsQueue;
+    if (appBase->queueFamilyIndices.transfer == appBase->queueFamilyIndices.graphics) uploadQueue = appBase->queues.transferQueue;
+
+    commandPool.init(appBase, appBase->queueFamilyIndices.graphics);
+    growthCommandBuffer = commandPool.allocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+}
+
+void AssetLoader::spawn(Task<void> load)
+{
+    runningLoads++;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.spawnedLoads++;
+    }
+    runLoad(std::move(load));
+}
+
+DetachedTask AssetLoader::runLoad(Task<void> load)
+{
+    try {
+        co_await load;
+
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.completedLoads++;
+    }
+    catch (const LoadCancelledError&) {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.cancelledLoads++;
+    }
+    catch (const std::exception &exception) {
+        std::cerr << "Asset load failed: " << exception.what() << std::endl;
+
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.failedLoads++;
+    }
+    runningLoads--;
+}
+
+Task<TextureHandle> AssetLoader::loadTexture(std::string filePath, TextureCompression compression, LoadPriority priority, CancellationToken token)
+{
+    LoadSlot slot = co_await acquireSlot(priority, token);
+
+    // Resumed on a worker, where the texture is decoded and compressed
+    std::vector<char> sourceFile = co_await readFile(filePath, token);
+    TextureRegistry::PendingAcquire pending = textureRegistry->beginAcquire(filePath, std::move(sourceFile), compression);
+
+    // The request is registered now and must be finished, however long it waits on a load of the same texture. That
+    // load may be queued behind this one, so the slot is given up first
+    slot = LoadSlot();
+    co_await resumeOnMainThreadWhen([&pending]() { return pending.isReady(); });
+
+    co_return textureRegistry->finishAcquire(pending);
+}
+
+Task<std::vector<Mesh*>> AssetLoader::importMesh(std::string filePath, LoadPriority priority, CancellationToken token, MeshUploadedFunction onMeshUploaded)
+{
+    LoadSlot slot = co_await acquireSlot(priority, token);
+
+    std::vector<Mesh> parsedMeshes = {};
+    std::vector<std::pair<std::vector<Vertex>, std::vector<uint32_t>>> vertexIndexData = {};
+    if (MeshCache::isCurrent(filePath)) {
+        // A cooked mesh is already in its final form, resumed on a worker only to expand the quantized vertices
+        std::vector<CookedMesh> cookedMeshes = MeshCache::parse(co_await readFile(MeshCache::getCachePath(filePath), token));
+        for (CookedMesh &cookedMesh : cookedMeshes) {
+            parsedMeshes.emplace_back();
+            parsedMeshes.back().setShapeName(cookedMesh.name);
+            vertexIndexData.emplace_back(std::move(cookedMesh.vertices), std::move(cookedMesh.indices));
+        }
+    } else {
+        // Resumed on a worker, where the meshes are parsed and their vertex data built
+        std::vector<char> objFile = co_await readFile(filePath, token);
+        std::string mtlPath = GeometryManager::findMaterialLibrary(filePath, objFile);
+        std::vector<char> mtlFile = {};
+        if (!mtlPath.empty()) mtlFile = co_await readFile(mtlPath, token);
+
+        parsedMeshes = GeometryManager::parseOBJ(filePath, objFile, mtlFile);
+        for (Mesh &mesh : parsedMeshes) vertexIndexData.push_back(mesh.getVertexAndIndexData());
+    }
+    if (parsedMeshes.empty()) throw std::runtime_error("Failed to import mesh: " + filePath);
+
+    co_await resumeOnMainThread(token);
+    std::vector<Mesh*> meshes = {};
+    for (Mesh &mesh : parsedMeshes) meshes.push_back(appBase->geometryManager.addMesh(std::move(mesh)));
+
+    // Each mesh is uploaded on its own, an upload that grows the arenas would otherwise strand the copies recorded
+    // before it in the buffers it replaced
+    for (uint32_t i = 0U ; i < meshes.size() ; i++) {
+        co_await upload([this, &meshes, &vertexIndexData, i](VkCommandBuffer commandBuffer) {
+            viBufferManager->recordGeometryUpload(meshes[i], vertexIndexData[i].first, vertexIndexData[i].second, commandBuffer, growthCommandBuffer);
+        });
+        viBufferManager->completeGeometryUpload(meshes[i]);
+        if (onMeshUploaded) onMeshUploaded(meshes[i]);
+    }
+    co_return meshes;
+}
+
+void AssetLoader::update()
+{
+    completeUploads();
+    resumeMainThreadLoads();
+    cancelWaitingLoads();
+
+    // Submitted last, so that the uploads queued by the loads resumed above do not wait for the next update
+    submitUploads();
+}
+
+void AssetLoader::completeUploads()
+{
+    for (auto it = inFlightUploads.begin() ; it != inFlightUploads.end() ; ) {
+        if (vkGetFenceStatus(appBase->getDevice(), it->fence->get()) != VK_SUCCESS) {
+            it++;
+            continue;
+        }
+
+        Upload upload = *it;
+        it = inFlightUploads.erase(it);
+        vkResetFences(appBase->getDevice(), 1U, upload.fence->getRef());
+        freeFences.push_back(upload.fence);
+        freeCommandBuffers.push_back(upload.commandBuffer);
+
+        // The load may queue another upload, which is submitted at the end of this update
+        upload.awaiter->handle.resume();
+    }
+}
+
+void AssetLoader::resumeMainThreadLoads()
+{
+    std::vector<MainThreadAwaiter*> loads;
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        loads.swap(mainThreadLoads);
+    }
+
+    std::vector<MainThreadAwaiter*> notReady = {};
+    for (MainThreadAwaiter* load : loads) {
+        // A cancelled load is resumed straight away, it throws as it resumes
+        if (load->isReady == nullptr || load->token.isCancelled() || load->isReady()) load->handle.resume();
+        else notReady.push_back(load);
+    }
+
+    std::lock_guard<std::mutex> lock(mainThreadMutex);
+    mainThreadLoads.insert(mainThreadLoads.end(), notReady.begin(), notReady.end());
+}
+
+void AssetLoader::cancelWaitingLoads()
+{
+    std::vector<SlotAwaiter*> cancelledLoads = {};
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        auto cancelledIt = std::stable_partition(waitingLoads.begin(), waitingLoads.end(), [](const SlotAwaiter* load) { return !load->token.isCancelled(); });
+        cancelledLoads.assign(cancelledIt, waitingLoads.end());
+        waitingLoads.erase(cancelledIt, waitingLoads.end());
+    }
+
+    // Resumed without a slot, they throw as they resume
+    for (SlotAwaiter* load : cancelledLoads) load->handle.resume();
+}
+
+void AssetLoader::submitUploads()
+{
+    std::vector<UploadAwaiter*> uploads;
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        uploads.swap(queuedUploads);
+    }
+
+    for (UploadAwaiter* awaiter : uploads) {
+        if (freeCommandBuffers.empty()) freeCommandBuffers.push_back(commandPool.allocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY));
+        if (freeFences.empty()) {
+            fences.push_back(std::make_unique<AppFence>());
+            fences.back()->init(appBase);
+            freeFences.push_back(fences.back().get());
+        }
+        VkCommandBuffer commandBuffer = freeCommandBuffers.back();
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.pNext = nullptr;
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.pInheritanceInfo = nullptr;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        try {
+            awaiter->record(commandBuffer);
+        }
+        catch (...) {
+            vkEndCommandBuffer(commandBuffer);
+            awaiter->error = std::current_exception();
+            awaiter->handle.resume();
+            continue;
+        }
+        vkEndCommandBuffer(commandBuffer);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.pCommandBuffers = &commandBuffer;
+        submitInfo.commandBufferCount = 1U;
+        submitInfo.pNext = nullptr;
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pSignalSemaphores = nullptr;
+        submitInfo.signalSemaphoreCount = 0U;
+        submitInfo.pWaitSemaphores = nullptr;
+        submitInfo.pWaitDstStageMask = nullptr;
+        submitInfo.waitSemaphoreCount = 0u;
+
+        AppFence* fence = freeFences.back();
+        THROW(vkQueueSubmit(uploadQueue, 1U, &submitInfo, fence->get()), "Failed to submit asset upload");
+        freeCommandBuffers.pop_back();
+        freeFences.pop_back();
+        inFlightUploads.push_back(Upload{awaiter, commandBuffer, fence});
+
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.submittedUploads++;
+    }
+}
+
+AssetLoaderStats AssetLoader::getStats()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return stats;
+}
+
+void AssetLoader::destroy()
+{
+    if (!inFlightUploads.empty()) vkQueueWaitIdle(uploadQueue);
+    inFlightUploads.clear();
+
+    for (std::unique_ptr<AppFence> &fence : fences) fence->destroy();
+    fences.clear();
+    freeFences.clear();
+    freeCommandBuffers.clear();
+    commandPool.destroy();
+}
@@ -0,0 +1,278 @@
+#pragma once
+#include "task.h"
+#include "async-file-reader.h"
+#include "texture-registry.h"
+#include "vertex-buffer-manager.h"
+#include "mesh.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+
+/**
+ * The order in which loads waiting for a slot are started, loads of the same priority start in the order they were
+ * requested
+ */
+enum class LoadPriority : uint32_t {
+    LOW = 0U,
+    NORMAL = 1U,
+    HIGH = 2U,
+    CRITICAL = 3U
+};
+
+/**
+ * Thrown by a cancelled load at the next stage it reaches
+ */
+class LoadCancelledError : public std::runtime_error {
+    public:
+    LoadCancelledError() : std::runtime_error("Load cancelled") {}
+};
+
+/**
+ * @class CancellationToken
+ *
+ * @brief Cancels the loads it is passed to, copies of a token share the same state
+ */
+class CancellationToken {
+    std::shared_ptr<std::atomic<bool>> cancelled = std::make_shared<std::atomic<bool>>(false);
+
+    public:
+    void cancel() { cancelled->store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return cancelled->load(std::memory_order_relaxed); }
+
+    void throwIfCancelled() const { if (isCancelled()) throw LoadCancelledError(); }
+};
+
+struct AssetLoaderConfig {
+    // The number of loads that may be running at once, the rest wait for a slot in order of priority
+    uint32_t maxConcurrentLoads = 4U;
+};
+
+struct AssetLoaderStats {
+    uint32_t spawnedLoads = 0U;
+    uint32_t completedLoads = 0U;
+    uint32_t failedLoads = 0U;
+    uint32_t cancelledLoads = 0U;
+    uint32_t submittedUploads = 0U;
+
+    // The most loads that have waited for a slot at once
+    uint32_t maxQueuedLoads = 0U;
+};
+
+/**
+ * @class AssetLoader
+ *
+ * @brief Loads assets with coroutines that move between threads rather than block them
+ *
+ * A load waits for a slot, reads its files on the file reader's threads, is resumed on a job system worker to decode
+ * them, then is resumed on the main thread to upload them. Uploads are submitted to the transfer queue and the load
+ * is resumed once their fence signals, so an asset is usable as soon as its own upload completes. The main thread
+ * owns every command buffer and queue submission, and resumes loads from update.
+ *
+ * Cancellation is checked whenever a load moves between threads, up until it starts its upload. An asset that has
+ * been handed to the device is always finished.
+ */
+class AssetLoader {
+    public:
+    // Held by a load while it runs, the next waiting load is started when it is destroyed
+    class LoadSlot {
+        AssetLoader* loader = nullptr;
+
+        public:
+        LoadSlot() = default;
+        explicit LoadSlot(AssetLoader* loader) : loader(loader) {}
+        LoadSlot(LoadSlot &&other) noexcept : loader(std::exchange(other.loader, nullptr)) {}
+        LoadSlot& operator=(LoadSlot &&other) noexcept;
+        LoadSlot(const LoadSlot&) = delete;
+        LoadSlot& operator=(const LoadSlot&) = delete;
+        ~LoadSlot();
+    };
+
+    class SlotAwaiter {
+        friend class AssetLoader;
+        AssetLoader* loader;
+        LoadPriority priority;
+        CancellationToken token;
+        uint64_t sequence = 0U;
+        std::coroutine_handle<> handle = nullptr;
+        bool granted = false;
+
+        public:
+        SlotAwaiter(AssetLoader* loader, LoadPriority priority, CancellationToken token) : loader(loader), priority(priority), token(token) {}
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        LoadSlot await_resume();
+    };
+
+    class ReadAwaiter {
+        AssetLoader* loader;
+        std::string filePath;
+        CancellationToken token;
+        std::vector<char> data = {};
+        std::exception_ptr error = nullptr;
+
+        public:
+        ReadAwaiter(AssetLoader* loader, std::string filePath, CancellationToken token) : loader(loader), filePath(std::move(filePath)), token(token) {}
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        std::vector<char> await_resume();
+    };
+
+    class MainThreadAwaiter {
+        friend class AssetLoader;
+        AssetLoader* loader;
+        std::function<bool()> isReady;
+        CancellationToken token;
+        std::coroutine_handle<> handle = nullptr;
+
+        public:
+        MainThreadAwaiter(AssetLoader* loader, std::function<bool()> isReady, CancellationToken token) : loader(loader), isReady(std::move(isReady)), token(token) {}
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() { token.throwIfCancelled(); }
+    };
+
+    class UploadAwaiter {
+        friend class AssetLoader;
+        AssetLoader* loader;
+        std::function<void(VkCommandBuffer)> record;
+        std::coroutine_handle<> handle = nullptr;
+        std::exception_ptr error = nullptr;
+
+        public:
+        UploadAwaiter(AssetLoader* loader, std::function<void(VkCommandBuffer)> record) : loader(loader), record(std::move(record)) {}
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() { if (error) std::rethrow_exception(error); }
+    };
+
+    private:
+    class AppBase* appBase;
+    AsyncFileReader* fileReader;
+    JobSystem* jobSystem;
+    TextureRegistry* textureRegistry;
+    VIBufferManager* viBufferManager;
+    AssetLoaderConfig config;
+
+    // Loads waiting for a slot, the highest priority (then the earliest) is started when a slot is released
+    std::mutex slotMutex;
+    std::vector<SlotAwaiter*> waitingLoads = {};
+    uint32_t activeLoads = 0U;
+    uint64_t nextSequence = 0U;
+
+    // Loads waiting to be resumed on the main thread, and the uploads they have queued
+    std::mutex mainThreadMutex;
+    std::vector<MainThreadAwaiter*> mainThreadLoads = {};
+    std::vector<UploadAwaiter*> queuedUploads = {};
+
+    // Uploads are recorded into command buffers from a pool only the main thread uses, and recycled once complete
+    struct Upload {
+        UploadAwaiter* awaiter;
+        VkCommandBuffer commandBuffer;
+        AppFence* fence;
+    };
+    std::vector<Upload> inFlightUploads = {};
+    std::vector<VkCommandBuffer> freeCommandBuffers = {};
+    std::vector<std::unique_ptr<AppFence>> fences = {};
+    std::vector<AppFence*> freeFences = {};
+    AppCommandPool commandPool;
+    VkQueue uploadQueue;
+
+    // Copies the vertex and index arenas when a mesh upload grows them
+    VkCommandBuffer growthCommandBuffer;
+
+    std::atomic<uint32_t> runningLoads {0U};
+    std::mutex statsMutex;
+    AssetLoaderStats stats {};
+
+    void releaseSlot();
+    DetachedTask runLoad(Task<void> load);
+    void completeUploads();
+    void resumeMainThreadLoads();
+    void cancelWaitingLoads();
+    void submitUploads();
+
+    public:
+    void init(class AppBase* appBase, AsyncFileReader* fileReader, JobSystem* jobSystem, TextureRegistry* textureRegistry, VIBufferManager* viBufferManager, AssetLoaderConfig config = AssetLoaderConfig{});
+
+    /**
+     * @brief Starts a load that nothing awaits, failures are reported and counted in the stats
+     */
+    void spawn(Task<void> load);
+
+    /**
+     * @brief Waits for one of the slots that limit how many loads run at once, the load runs until the slot is destroyed
+     */
+    SlotAwaiter acquireSlot(LoadPriority priority, CancellationToken token = CancellationToken()) { return SlotAwaiter(this, priority, token); }
+
+    /**
+     * @brief Reads a file on the file reader's threads, the awaiting load is resumed on a job system worker
+     */
+    ReadAwaiter readFile(const std::string &filePath, CancellationToken token = CancellationToken()) { return ReadAwaiter(this, filePath, token); }
+
+    /**
+     * @brief Resumes the awaiting load on the main thread during the next update
+     */
+    MainThreadAwaiter resumeOnMainThread(CancellationToken token = CancellationToken()) { return MainThreadAwaiter(this, nullptr, token); }
+
+    /**
+     * @brief Resumes the awaiting load on the main thread during the first update in which isReady returns true
+     *
+     * isReady is called on the main thread
+     */
+    MainThreadAwaiter resumeOnMainThreadWhen(std::function<bool()> isReady, CancellationToken token = CancellationToken()) { return MainThreadAwaiter(this, std::move(isReady), token); }
+
+    /**
+     * @brief Records commands on the main thread during the next update and submits them to the transfer queue,
+     * the awaiting load is resumed on the main thread once they have completed
+     *
+     * Rethrows any exception thrown by record, in which case nothing is submitted
+     */
+    UploadAwaiter upload(std::function<void(VkCommandBuffer)> record) { return UploadAwaiter(this, std::move(record)); }
+
+    /**
+     * @brief Loads a texture through the texture registry
+     *
+     * The source is read on the file reader's threads and decoded and compressed on a worker, and the texture is
+     * uploaded by the registry's upload function on the main thread
+     */
+    Task<TextureHandle> loadTexture(std::string filePath, TextureCompression compression, LoadPriority priority = LoadPriority::NORMAL, CancellationToken token = CancellationToken());
+
+    // Called on the main thread with each imported mesh as soon as its upload has completed
+    using MeshUploadedFunction = std::function<void(Mesh*)>;
+
+    /**
+     * @brief Imports the meshes of an OBJ file into the geometry manager and uploads them to the vertex and index buffers
+     *
+     * The files are read on the file reader's threads and parsed on a worker, and each mesh is uploaded on the transfer
+     * queue. A current cache written by the asset cooker (see MeshCache) is read in place of the OBJ. Each mesh may be
+     * drawn once its own upload has completed, which is when onMeshUploaded is called with it, and every mesh is
+     * returned once the last upload has completed.
+     */
+    Task<std::vector<Mesh*>> importMesh(std::string filePath, LoadPriority priority = LoadPriority::NORMAL, CancellationToken token = CancellationToken(),
+        MeshUploadedFunction onMeshUploaded = nullptr);
+
+    /**
+     * @brief Resumes the loads whose uploads have completed or that are waiting for the main thread, and submits the
+     * uploads they have queued
+     *
+     * @note Must be called on the main thread, regularly, while loads are running
+     */
+    void update();
+
+    /**
+     * @brief Whether every spawned load has finished
+     */
+    bool isIdle() { return runningLoads.load() == 0U; }
+
+    AssetLoaderStats getStats();
+
+    /**
+     * @brief Waits for the uploads in flight and frees the command buffers and fences
+     *
+     * @note Loads that are still suspended are never resumed, so any that were spawned should have finished first
+     */
+    void destroy();
+};
@@ -0,0 +1,139 @@
+#include "bindless-texture-table.h"
+#include "app-base.h"
+#include "app-config.h"
+#include <algorithm>
+#include <cstring>
+
+void BindlessSlotAllocator::init(uint32_t capacity)
+{
+    this->capacity = capacity;
+    freeSlots.clear();
+    pendingFrees.clear();
+    for (uint32_t slot = 0U ; slot < capacity ; slot++) freeSlots.insert(slot);
+}
+
+uint32_t BindlessSlotAllocator::allocate()
+{
+    if (freeSlots.empty()) throw std::runtime_error("Failed to allocate bindless slot, all " + std::to_string(capacity) + " slots are in use");
+
+    uint32_t slot = *freeSlots.begin();
+    freeSlots.erase(freeSlots.begin());
+    return slot;
+}
+
+void BindlessSlotAllocator::free(uint32_t slot, uint64_t frameIndex)
+{
+    if (slot >= capacity) throw std::runtime_error("Attempted to free a bindless slot outside of the table");
+    pendingFrees.push_back(PendingFree{slot, frameIndex});
+}
+
+void BindlessSlotAllocator::onFrameComplete(uint64_t frameIndex)
+{
+    // A slot released on frame N may be read by command buffers up to frame N + maxFramesInFlight
+    while (!pendingFrees.empty() && pendingFrees.front().releasedOnFrame + maxFramesInFlight <= frameIndex) {
+        freeSlots.insert(pendingFrees.front().slot);
+        pendingFrees.pop_front();
+    }
+}
+
+void BindlessTextureTable::init(AppBase* appBase, uint32_t maxTextureCount, uint32_t maxMaterialCount, uint32_t materialByteSize)
+{
+    if (!appBase->logicalDevice.supportsDescriptorIndexing()) {
+        throw std::runtime_error("Failed to create bindless texture table, the device does not support descriptor indexing");
+    }
+
+    this->appBase = appBase;
+    this->materialByteSize = materialByteSize;
+
+    // Update-after-bind descriptors have their own, separately reported, limits
+    VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+    vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+    vulkan12Properties.pNext = nullptr;
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &vulkan12Properties;
+    vkGetPhysicalDeviceProperties2(appBase->getPhysicalDevice(), &properties);
+
+    uint32_t textureCount = std::min({
+        maxTextureCount,
+        vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages,
+        vulkan12Properties.maxDescriptorSetUpdateAfterBindSamplers,
+        vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+        vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers
+    });
+
+    descriptorSetLayout.init(appBase, {
+        {
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            VK_SHADER_STAGE_FRAGMENT_BIT,
+            textureCount,
+            // Slots that are not in use are never written, and slots are written while the set is bound
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+        },
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT}
+    });
+
+    descriptorPool.init(appBase, 1U, {
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, textureCount},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1U}
+    }, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
+
+    descriptorSet = descriptorPool.allocateDescriptorSet(&descriptorSetLayout);
+
+    materialBuffer = createBufferAll(appBase, AppBufferTemplate::STORAGE_BUFFER, maxMaterialCount * materialByteSize);
+    updateDescriptor(materialBuffer.buffer, descriptorSet, maxMaterialCount * materialByteSize, materialBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+    textureSlots.init(textureCount);
+    materialSlots.init(maxMaterialCount);
+}
+
+uint32_t BindlessTextureTable::allocateTextureSlot()
+{
+    return textureSlots.allocate();
+}
+
+void BindlessTextureTable::writeTexture(uint32_t slot, AppImageView imageView, AppSampler sampler)
+{
+    updateDescriptor(imageView, descriptorSet, textureBinding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sampler, slot);
+}
+
+void BindlessTextureTable::freeTextureSlot(uint32_t slot)
+{
+    textureSlots.free(slot, frameIndex);
+}
+
+uint32_t BindlessTextureTable::createMaterial(const void* material)
+{
+    uint32_t materialIndex = materialSlots.allocate();
+    updateMaterial(materialIndex, material);
+    return materialIndex;
+}
+
+void BindlessTextureTable::updateMaterial(uint32_t materialIndex, const void* material)
+{
+    if (materialIndex >= materialSlots.getCapacity()) throw std::runtime_error("Failed to update material, index is outside of the material buffer");
+
+    // The buffer is host coherent, so the write is visible to the next submission without a flush
+    memcpy(static_cast<char*>(materialBuffer.deviceMemory.getMappedData()) + materialIndex * materialByteSize, material, materialByteSize);
+}
+
+void BindlessTextureTable::freeMaterial(uint32_t materialIndex)
+{
+    materialSlots.free(materialIndex, frameIndex);
+}
+
+void BindlessTextureTable::onFrameComplete()
+{
+    frameIndex++;
+    textureSlots.onFrameComplete(frameIndex);
+    materialSlots.onFrameComplete(frameIndex);
+}
+
+void BindlessTextureTable::destroy()
+{
+    materialBuffer.buffer.destroy();
+    materialBuffer.deviceMemory.destroy();
+    descriptorPool.destroy();
+    descriptorSetLayout.destroy();
+    descriptorSet = VK_NULL_HANDLE;
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "resource-utilities.h"
+#include <list>
+#include <set>
+
+/**
+ * @class BindlessSlotAllocator
+ *
+ * @brief Hands out indices into a fixed size table, lowest first
+ *
+ * Freed indices are only handed out again once the frames in flight that may still read them have completed.
+ */
+class BindlessSlotAllocator {
+    std::set<uint32_t> freeSlots = {};
+
+    struct PendingFree {
+        uint32_t slot;
+        uint64_t releasedOnFrame;
+    };
+    std::list<PendingFree> pendingFrees = {};
+    uint32_t capacity = 0U;
+
+    public:
+    void init(uint32_t capacity);
+
+    /**
+     * @brief Reserves the lowest free slot, throwing if the table is full
+     */
+    uint32_t allocate();
+
+    void free(uint32_t slot, uint64_t frameIndex);
+
+    /**
+     * @brief Returns the slots released at least maxFramesInFlight frames ago to the free list
+     */
+    void onFrameComplete(uint64_t frameIndex);
+
+    uint32_t getCapacity() { return capacity; }
+    uint32_t getAllocatedCount() { return capacity - freeSlots.size() - pendingFrees.size(); }
+};
+
+/**
+ * @class BindlessTextureTable
+ *
+ * @brief A single descriptor set holding every texture and material, for use with VK_EXT_descriptor_indexing (core in Vulkan 1.2)
+ *
+ * Binding 0 is a large, partially bound array of combined image samplers that may be updated after it is bound, so
+ * textures are added without allocating new sets or rebinding the set. Binding 1 is a storage buffer of materials,
+ * which reference their textures by slot. The set is bound once per command buffer and draws only push the index of
+ * their material, which also lets draws of different materials be batched together.
+ *
+ * @note Requires AppDevice::supportsDescriptorIndexing
+ */
+class BindlessTextureTable {
+    class AppBase* appBase;
+    AppDescriptorSetLayout descriptorSetLayout;
+    AppDescriptorPool descriptorPool;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+    // Materials are written through the buffer's persistent mapping
+    AppBufferBundle materialBuffer;
+    uint32_t materialByteSize = 0U;
+
+    BindlessSlotAllocator textureSlots;
+    BindlessSlotAllocator materialSlots;
+    uint64_t frameIndex = 0U;
+
+    public:
+    static const uint32_t textureBinding = 0U;
+    static const uint32_t materialBinding = 1U;
+
+    /**
+     * @brief Creates the descriptor set layout, the descriptor set and the material buffer
+     *
+     * @param maxTextureCount The size of the texture array, clamped to the device's update-after-bind sampler limits
+     * @param maxMaterialCount The number of materials the material buffer can hold
+     * @param materialByteSize The size of a material, it must match the std430 layout of the material struct in the shader
+     */
+    void init(class AppBase* appBase, uint32_t maxTextureCount, uint32_t maxMaterialCount, uint32_t materialByteSize);
+
+    /**
+     * @brief Reserves a slot in the texture array, slots that have not been written are never accessed by the device
+     */
+    uint32_t allocateTextureSlot();
+
+    /**
+     * @brief Writes a texture into a slot, this may be done while the set is bound by pending command buffers
+     */
+    void writeTexture(uint32_t slot, AppImageView imageView, AppSampler sampler);
+
+    /**
+     * @brief Releases a texture slot once the frames in flight that may sample it have completed
+     */
+    void freeTextureSlot(uint32_t slot);
+
+    /**
+     * @brief Reserves a slot in the material buffer and writes the material into it
+     *
+     * @param material A struct of materialByteSize bytes, laid out to match the shader
+     *
+     * @return The index of the material, to be pushed by draws that use it
+     */
+    uint32_t createMaterial(const void* material);
+
+    template <typename T>
+    uint32_t createMaterial(const T &material) {
+        if (sizeof(T) != materialByteSize) throw std::runtime_error("Failed to create material, material size does not match the material buffer");
+        return createMaterial(static_cast<const void*>(&material));
+    }
+
+    /**
+     * @brief Overwrites a material
+     *
+     * @note The material buffer is not duplicated per frame, so a material must not be updated while a frame in flight uses it
+     */
+    void updateMaterial(uint32_t materialIndex, const void* material);
+
+    /**
+     * @brief Releases a material slot once the frames in flight that may read it have completed
+     */
+    void freeMaterial(uint32_t materialIndex);
+
+    /**
+     * @brief Signals that the oldest frame in flight has completed, returning any slots it may have read to the free lists
+     *
+     * @note Must be called once per frame, after the in-flight fence has been waited on
+     */
+    void onFrameComplete();
+
+    AppDescriptorSetLayout& getDescriptorSetLayout() { return descriptorSetLayout; }
+    VkDescriptorSet getDescriptorSet() { return descriptorSet; }
+    uint32_t getTextureCapacity() { return textureSlots.getCapacity(); }
+    uint32_t getTextureCount() { return textureSlots.getAllocatedCount(); }
+    uint32_t getMaterialCount() { return materialSlots.getAllocatedCount(); }
+
+    void destroy();
+};
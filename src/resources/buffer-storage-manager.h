@@ -8,23 +8,39 @@
 template <typename T>
 struct BufferStorageManager {
     MemoryListTree memoryListTree;
-    AppDeviceMemory* bufferMemory;
     public:
 
-    void init(AppDeviceMemory* bufferMemory) {
-        this->bufferMemory = bufferMemory;
-        memoryListTree.init(bufferMemory->getSize());
+    /**
+     * @brief Initializes the storage manager to track a buffer of 'byteSize' bytes
+     */
+    void init(uint32_t byteSize) {
+        memoryListTree.init(byteSize);
     }
 
-    std::list<MemoryBlockNode>::iterator reserveMemory(std::vector<T> elements) {
+    std::list<MemoryBlockNode>::iterator reserveMemory(const std::vector<T> &elements) {
         // Find a free block in memory to store the vertices
         auto memoryBlock = memoryListTree.reserve(elements.size() * sizeof(T));
 
         return memoryBlock;
     }
 
+    bool canReserve(size_t elementCount) {
+        return memoryListTree.canReserve(elementCount * sizeof(T));
+    }
+
+    /**
+     * @brief Extends the tracked buffer to 'newByteSize' bytes, existing reservations keep their offsets
+     */
+    void grow(uint32_t newByteSize) {
+        memoryListTree.grow(newByteSize);
+    }
+
+    uint32_t getByteSize() {
+        return memoryListTree.getSize();
+    }
+
     void freeMemory(std::list<MemoryBlockNode>::iterator it) {
         memoryListTree.free(it);
     }
 
-};
\ No newline at end of file
+};
@@ -0,0 +1,64 @@
+#include "command-buffer-allocator.h"
+#include "app-base.h"
+
+void CommandBufferAllocator::init(AppBase* appBase, uint32_t queueFamilyIndex, uint32_t frameSlotCount)
+{
+    if (frameSlotCount == 0U) throw std::runtime_error("Failed to create command buffer allocator, there must be at least one frame slot");
+    this->appBase = appBase;
+    this->queueFamilyIndex = queueFamilyIndex;
+    this->frameSlotCount = frameSlotCount;
+}
+
+CommandBufferAllocator::ThreadPool &CommandBufferAllocator::getThreadPool(uint32_t frameSlot)
+{
+    if (frameSlot >= frameSlotCount) throw std::runtime_error("Failed to acquire command buffer, frame slot is out of range");
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    std::vector<std::unique_ptr<ThreadPool>> &framePools = threadPools[std::this_thread::get_id()];
+    if (framePools.empty()) {
+        // A thread's pools are created the first time it records, for every frame slot at once
+        for (uint32_t slot = 0U ; slot < frameSlotCount ; slot++) {
+            framePools.push_back(std::make_unique<ThreadPool>());
+            framePools.back()->commandPool.init(appBase, queueFamilyIndex, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+        }
+    }
+    return *framePools[frameSlot];
+}
+
+VkCommandBuffer CommandBufferAllocator::acquire(uint32_t frameSlot, VkCommandBufferLevel level)
+{
+    ThreadPool &threadPool = getThreadPool(frameSlot);
+    LevelBuffers &levelBuffers = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY ? threadPool.primary : threadPool.secondary;
+
+    // Buffers are allocated in batches that double, so a thread that records many buffers a frame allocates rarely
+    if (levelBuffers.usedCount == levelBuffers.buffers.size()) {
+        uint32_t batchSize = levelBuffers.buffers.empty() ? initialBatchSize : levelBuffers.buffers.size();
+        std::vector<VkCommandBuffer> batch = threadPool.commandPool.allocateCommandBuffers(level, batchSize);
+        levelBuffers.buffers.insert(levelBuffers.buffers.end(), batch.begin(), batch.end());
+    }
+    return levelBuffers.buffers[levelBuffers.usedCount++];
+}
+
+void CommandBufferAllocator::resetFrame(uint32_t frameSlot)
+{
+    if (frameSlot >= frameSlotCount) throw std::runtime_error("Failed to reset command buffers, frame slot is out of range");
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    for (auto &[threadId, framePools] : threadPools) {
+        ThreadPool &threadPool = *framePools[frameSlot];
+        if (threadPool.primary.usedCount == 0U && threadPool.secondary.usedCount == 0U) continue;
+
+        threadPool.commandPool.reset();
+        threadPool.primary.usedCount = 0U;
+        threadPool.secondary.usedCount = 0U;
+    }
+}
+
+void CommandBufferAllocator::destroy()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    for (auto &[threadId, framePools] : threadPools) {
+        for (std::unique_ptr<ThreadPool> &threadPool : framePools) threadPool->commandPool.destroy();
+    }
+    threadPools.clear();
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "resource-utilities.h"
+#include <map>
+#include <mutex>
+#include <thread>
+#include <memory>
+
+/**
+ * @class CommandBufferAllocator
+ *
+ * @brief Hands out command buffers from a pool per recording thread and frame slot, and recycles whole pools
+ *
+ * Command pools are externally synchronized, so each thread records into buffers of its own pool and threads never
+ * contend on a pool. Every frame slot, one per frame in flight, has its own pools. Once the fence of the frame that
+ * last used a slot signals, resetFrame resets each of the slot's pools with a single vkResetCommandPool and its
+ * buffers are handed out again, no buffer is ever reset on its own. Pools are created without
+ * VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, which lets drivers allocate command memory linearly.
+ */
+class CommandBufferAllocator {
+    class AppBase* appBase;
+    uint32_t queueFamilyIndex;
+    uint32_t frameSlotCount;
+
+    // The buffers a pool has allocated, the first usedCount of which were handed out since the pool was reset
+    struct LevelBuffers {
+        std::vector<VkCommandBuffer> buffers = {};
+        uint32_t usedCount = 0U;
+    };
+
+    struct ThreadPool {
+        AppCommandPool commandPool;
+        LevelBuffers primary;
+        LevelBuffers secondary;
+    };
+
+    // Guards the maps only, a thread's pool is used without the lock once found
+    std::mutex poolMutex;
+    std::map<std::thread::id, std::vector<std::unique_ptr<ThreadPool>>> threadPools = {};
+
+    ThreadPool &getThreadPool(uint32_t frameSlot);
+
+    public:
+    // The number of buffers allocated together the first time a pool runs out, doubled each time after
+    static const uint32_t initialBatchSize = 4U;
+
+    /**
+     * @param frameSlotCount The number of frames in flight, each frame slot's pools are reset on their own
+     */
+    void init(class AppBase* appBase, uint32_t queueFamilyIndex, uint32_t frameSlotCount);
+
+    /**
+     * @brief Gets a command buffer of the calling thread's pool for the frame slot, ready to begin
+     *
+     * The buffer stays valid until the slot is reset, it may only be recorded on the calling thread.
+     */
+    VkCommandBuffer acquire(uint32_t frameSlot, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+    /**
+     * @brief Resets every pool of the frame slot, for all threads
+     *
+     * @note The work submitted from the slot's buffers must have completed and no thread may be recording into them
+     */
+    void resetFrame(uint32_t frameSlot);
+
+    void destroy();
+};
@@ -0,0 +1,88 @@
+#include "descriptor-allocator.h"
+#include "app-base.h"
+#include <algorithm>
+
+void DescriptorAllocator::init(AppBase* appBase, uint32_t setsPerPool, std::map<VkDescriptorType, uint32_t> descriptorsPerSet, VkDescriptorPoolCreateFlags poolFlags)
+{
+    this->appBase = appBase;
+    this->descriptorsPerSet = descriptorsPerSet;
+    this->poolFlags = poolFlags;
+    nextPoolSetCount = std::clamp(setsPerPool, 1U, maxSetsPerPool);
+}
+
+AppDescriptorPool DescriptorAllocator::createPool(uint32_t minSetCount)
+{
+    uint32_t setCount = std::max(nextPoolSetCount, minSetCount);
+    nextPoolSetCount = std::min(2U * nextPoolSetCount, maxSetsPerPool);
+
+    std::map<VkDescriptorType, uint32_t> descriptorCounts = {};
+    for (const auto &[descriptorType, count] : descriptorsPerSet) descriptorCounts[descriptorType] = count * setCount;
+
+    AppDescriptorPool descriptorPool;
+    descriptorPool.init(appBase, setCount, descriptorCounts, poolFlags);
+    return descriptorPool;
+}
+
+void DescriptorAllocator::nextPool(uint32_t minSetCount)
+{
+    auto freePool = std::find_if(freePools.begin(), freePools.end(), [minSetCount](AppDescriptorPool &descriptorPool) {
+        return descriptorPool.getMaxSetsCount() >= minSetCount;
+    });
+    if (freePool != freePools.end()) {
+        usedPools.push_back(*freePool);
+        freePools.erase(freePool);
+        return;
+    }
+    usedPools.push_back(createPool(minSetCount));
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(AppDescriptorSetLayout &descriptorSetLayout)
+{
+    return allocate(std::vector<VkDescriptorSetLayout> {descriptorSetLayout.get()})[0];
+}
+
+std::vector<VkDescriptorSet> DescriptorAllocator::allocate(const std::vector<VkDescriptorSetLayout> &descriptorSetLayouts)
+{
+    std::vector<VkDescriptorSet> descriptorSets(descriptorSetLayouts.size(), VK_NULL_HANDLE);
+    if (descriptorSetLayouts.empty()) return descriptorSets;
+
+    auto tryAllocate = [&]() {
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.pNext = nullptr;
+        allocInfo.descriptorPool = usedPools.back().get();
+        allocInfo.descriptorSetCount = descriptorSetLayouts.size();
+        allocInfo.pSetLayouts = descriptorSetLayouts.data();
+        return vkAllocateDescriptorSets(appBase->getDevice(), &allocInfo, descriptorSets.data());
+    };
+
+    uint32_t setCount = descriptorSetLayouts.size();
+    if (usedPools.empty()) nextPool(setCount);
+
+    // An exhausted pool is left as it is until the next reset, the sets are allocated from the next pool of the chain
+    VkResult result = tryAllocate();
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+        nextPool(setCount);
+        result = tryAllocate();
+    }
+    THROW(result, "Failed to allocate descriptor sets, the sets need more descriptors than a pool of the allocator holds");
+
+    return descriptorSets;
+}
+
+void DescriptorAllocator::reset()
+{
+    for (AppDescriptorPool &descriptorPool : usedPools) {
+        descriptorPool.reset();
+        freePools.push_back(descriptorPool);
+    }
+    usedPools.clear();
+}
+
+void DescriptorAllocator::destroy()
+{
+    for (AppDescriptorPool &descriptorPool : usedPools) descriptorPool.destroy();
+    for (AppDescriptorPool &descriptorPool : freePools) descriptorPool.destroy();
+    usedPools.clear();
+    freePools.clear();
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "resource-utilities.h"
+#include <map>
+
+/**
+ * @class DescriptorAllocator
+ *
+ * @brief Allocates descriptor sets from a chain of pools that grows when a pool is exhausted
+ *
+ * Sets are never freed one at a time. Every set allocated since the last reset is returned at once by resetting
+ * whole pools with vkResetDescriptorPool, and the pools are kept for the allocations that follow. A transient
+ * allocator is reset once the work that used its sets has completed, such as when a frame's fence signals. A
+ * long-lived allocator, for material sets that last as long as the application, is never reset.
+ *
+ * Each pool the chain grows by holds twice as many sets as the one before, up to maxSetsPerPool.
+ */
+class DescriptorAllocator {
+    class AppBase* appBase;
+
+    // The average number of descriptors of each type in a set, each pool holds this many per set it can allocate
+    std::map<VkDescriptorType, uint32_t> descriptorsPerSet;
+    VkDescriptorPoolCreateFlags poolFlags;
+    uint32_t nextPoolSetCount;
+
+    // The pool sets are currently allocated from is the last one in use, reset pools wait in freePools
+    std::vector<AppDescriptorPool> usedPools = {};
+    std::vector<AppDescriptorPool> freePools = {};
+
+    AppDescriptorPool createPool(uint32_t minSetCount);
+
+    /**
+     * @brief Moves on to a reset pool, or a new pool if none is left, that holds at least minSetCount sets
+     */
+    void nextPool(uint32_t minSetCount);
+
+    public:
+    static const uint32_t maxSetsPerPool = 4096U;
+
+    /**
+     * @param setsPerPool The number of sets the first pool holds
+     * @param descriptorsPerSet The number of descriptors of each type in one set, a pool of n sets holds n times as many
+     * @param poolFlags Additional pool creation flags, such as VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT
+     */
+    void init(class AppBase* appBase, uint32_t setsPerPool, std::map<VkDescriptorType, uint32_t> descriptorsPerSet, VkDescriptorPoolCreateFlags poolFlags = 0U);
+
+    VkDescriptorSet allocate(AppDescriptorSetLayout &descriptorSetLayout);
+
+    /**
+     * @brief Allocates a set of each layout with a single vkAllocateDescriptorSets call, every set is from the same pool
+     */
+    std::vector<VkDescriptorSet> allocate(const std::vector<VkDescriptorSetLayout> &descriptorSetLayouts);
+
+    /**
+     * @brief Returns every set allocated since the last reset, the sets must no longer be in use by the device
+     */
+    void reset();
+
+    uint32_t getPoolCount() const { return usedPools.size() + freePools.size(); }
+
+    void destroy();
+};
@@ -0,0 +1,82 @@
+#include "descriptor-writer.h"
+#include "app-base.h"
+
+void DescriptorWriter::addWrite(VkDescriptorSet set, uint32_t binding, VkDescriptorType descriptorType, uint32_t arrayElement, bool isImage)
+{
+    // The info just added directly follows the infos of the last write when that write is of the same kind
+    if (!writes.empty()) {
+        VkWriteDescriptorSet &last = writes.back();
+        bool lastIsImage = last.pImageInfo != nullptr;
+        if (last.dstSet == set && last.dstBinding == binding && last.descriptorType == descriptorType
+            && last.dstArrayElement + last.descriptorCount == arrayElement && lastIsImage == isImage) {
+            last.descriptorCount++;
+            return;
+        }
+    }
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = nullptr;
+    write.dstSet = set;
+    write.dstBinding = binding;
+    write.dstArrayElement = arrayElement;
+    write.descriptorCount = 1U;
+    write.descriptorType = descriptorType;
+
+    // Marks which infos the write reads until resolveInfos points it at them
+    write.pImageInfo = isImage ? &imageInfos.back() : nullptr;
+    write.pBufferInfo = isImage ? nullptr : &bufferInfos.back();
+    write.pTexelBufferView = nullptr;
+
+    writes.push_back(write);
+    firstInfos.push_back(isImage ? imageInfos.size() - 1U : bufferInfos.size() - 1U);
+}
+
+DescriptorWriter &DescriptorWriter::writeBuffer(VkDescriptorSet set, uint32_t binding, VkDescriptorType descriptorType, AppBuffer buffer, VkDeviceSize range,
+    VkDeviceSize offset, uint32_t arrayElement)
+{
+    bufferInfos.push_back(VkDescriptorBufferInfo {buffer.get(), offset, range});
+    addWrite(set, binding, descriptorType, arrayElement, false);
+    return *this;
+}
+
+DescriptorWriter &DescriptorWriter::writeImage(VkDescriptorSet set, uint32_t binding, VkDescriptorType descriptorType, AppImageView imageView, VkImageLayout imageLayout,
+    AppSampler sampler, uint32_t arrayElement)
+{
+    imageInfos.push_back(VkDescriptorImageInfo {sampler.get(), imageView.get(), imageLayout});
+    addWrite(set, binding, descriptorType, arrayElement, true);
+    return *this;
+}
+
+void DescriptorWriter::resolveInfos()
+{
+    for (uint32_t i = 0U ; i < writes.size() ; i++) {
+        if (writes[i].pImageInfo != nullptr) writes[i].pImageInfo = &imageInfos[firstInfos[i]];
+        else writes[i].pBufferInfo = &bufferInfos[firstInfos[i]];
+    }
+}
+
+void DescriptorWriter::flush()
+{
+    if (writes.empty()) return;
+    resolveInfos();
+    vkUpdateDescriptorSets(appBase->getDevice(), writes.size(), writes.data(), 0U, nullptr);
+    clear();
+}
+
+void DescriptorWriter::push(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, AppPipelineLayout &pipelineLayout, uint32_t set)
+{
+    if (!appBase->logicalDevice.supportsPushDescriptors()) throw std::runtime_error("Failed to push descriptors, VK_KHR_push_descriptor is not supported");
+    if (writes.empty()) return;
+    resolveInfos();
+    appBase->logicalDevice.getCmdPushDescriptorSet()(commandBuffer, pipelineBindPoint, pipelineLayout.get(), set, writes.size(), writes.data());
+    clear();
+}
+
+void DescriptorWriter::clear()
+{
+    writes.clear();
+    imageInfos.clear();
+    bufferInfos.clear();
+    firstInfos.clear();
+}
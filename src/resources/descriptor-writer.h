@@ -0,0 +1,66 @@
+#pragma once
+#include "resource-utilities.h"
+
+/**
+ * @class DescriptorWriter
+ *
+ * @brief Accumulates descriptor writes for any number of sets and bindings, then applies them with one call
+ *
+ * flush() updates every set with a single vkUpdateDescriptorSets, and push() records the writes of one set into a
+ * command buffer with vkCmdPushDescriptorSetKHR, without a descriptor set being allocated. A write that continues the
+ * array elements of the previous write to the same binding is merged into it.
+ *
+ * @note Descriptor sets must not be updated while the device uses them or after they are bound in a command buffer
+ * being recorded, unless their bindings are update-after-bind
+ */
+class DescriptorWriter {
+    class AppBase* appBase;
+
+    std::vector<VkWriteDescriptorSet> writes = {};
+    std::vector<VkDescriptorImageInfo> imageInfos = {};
+    std::vector<VkDescriptorBufferInfo> bufferInfos = {};
+
+    // The index of the first info of each write, the infos are only pointed to once the vectors stop growing
+    std::vector<size_t> firstInfos = {};
+
+    /**
+     * @brief Extends the last write by one element if the new one continues it, otherwise starts a new write
+     */
+    void addWrite(VkDescriptorSet set, uint32_t binding, VkDescriptorType descriptorType, uint32_t arrayElement, bool isImage);
+
+    /**
+     * @brief Points the writes at their infos
+     */
+    void resolveInfos();
+
+    public:
+    explicit DescriptorWriter(class AppBase* appBase) : appBase(appBase) {}
+
+    DescriptorWriter &writeBuffer(VkDescriptorSet set, uint32_t binding, VkDescriptorType descriptorType, AppBuffer buffer, VkDeviceSize range,
+        VkDeviceSize offset = 0U, uint32_t arrayElement = 0U);
+
+    /**
+     * @param sampler Only read by sampler and combined image sampler bindings
+     */
+    DescriptorWriter &writeImage(VkDescriptorSet set, uint32_t binding, VkDescriptorType descriptorType, AppImageView imageView, VkImageLayout imageLayout,
+        AppSampler sampler = AppSampler{}, uint32_t arrayElement = 0U);
+
+    uint32_t getWriteCount() const { return writes.size(); }
+
+    /**
+     * @brief Applies every accumulated write with one vkUpdateDescriptorSets call and clears them
+     */
+    void flush();
+
+    /**
+     * @brief Records every accumulated write into the command buffer as the descriptors of a set, and clears them
+     *
+     * The set each write was given is ignored, the set number of the pipeline layout is written instead.
+     *
+     * @note Requires AppDevice::supportsPushDescriptors, the set's layout must have been created with
+     * VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR
+     */
+    void push(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, AppPipelineLayout &pipelineLayout, uint32_t set);
+
+    void clear();
+};
@@ -0,0 +1,65 @@
+#include "layout-cache.h"
+#include "app-base.h"
+#include <algorithm>
+
+void LayoutCache::init(AppBase* appBase)
+{
+    this->appBase = appBase;
+}
+
+AppDescriptorSetLayout LayoutCache::getDescriptorSetLayout(const std::vector<DescriptorItem> &descriptorItems)
+{
+    // Items are keyed in binding order, so layouts that list the same bindings in another order are shared
+    std::vector<std::vector<uint64_t>> bindingKeys = {};
+    for (uint32_t i = 0U ; i < descriptorItems.size() ; i++) {
+        const DescriptorItem &item = descriptorItems[i];
+        uint32_t binding = item.binding == bindingInListOrder ? i : item.binding;
+        bindingKeys.push_back({binding, static_cast<uint64_t>(item.descriptorType), item.shaderStage, item.descriptorCount, item.bindingFlags});
+    }
+    std::sort(bindingKeys.begin(), bindingKeys.end());
+
+    std::vector<uint64_t> key = {};
+    for (const std::vector<uint64_t> &bindingKey : bindingKeys) key.insert(key.end(), bindingKey.begin(), bindingKey.end());
+
+    std::lock_guard<std::mutex> lock(layoutMutex);
+    auto layout = descriptorSetLayouts.find(key);
+    if (layout != descriptorSetLayouts.end()) return layout->second;
+
+    AppDescriptorSetLayout descriptorSetLayout;
+    descriptorSetLayout.init(appBase, descriptorItems);
+    descriptorSetLayouts.emplace(std::move(key), descriptorSetLayout);
+    return descriptorSetLayout;
+}
+
+AppPipelineLayout LayoutCache::getPipelineLayout(const std::vector<VkDescriptorSetLayout> &descriptorSetLayouts, const std::vector<VkPushConstantRange> &pushConstantRanges)
+{
+    std::vector<uint64_t> key = {descriptorSetLayouts.size()};
+    for (VkDescriptorSetLayout descriptorSetLayout : descriptorSetLayouts) key.push_back(getHandleKey(descriptorSetLayout));
+    for (const VkPushConstantRange &range : pushConstantRanges) {
+        key.insert(key.end(), {range.stageFlags, range.offset, range.size});
+    }
+
+    std::lock_guard<std::mutex> lock(layoutMutex);
+    auto layout = pipelineLayouts.find(key);
+    if (layout != pipelineLayouts.end()) return layout->second;
+
+    AppPipelineLayout pipelineLayout;
+    pipelineLayout.init(appBase, descriptorSetLayouts, pushConstantRanges);
+    pipelineLayouts.emplace(std::move(key), pipelineLayout);
+    return pipelineLayout;
+}
+
+uint32_t LayoutCache::getLayoutCount()
+{
+    std::lock_guard<std::mutex> lock(layoutMutex);
+    return descriptorSetLayouts.size() + pipelineLayouts.size();
+}
+
+void LayoutCache::destroy()
+{
+    std::lock_guard<std::mutex> lock(layoutMutex);
+    for (auto &[key, pipelineLayout] : pipelineLayouts) pipelineLayout.destroy();
+    for (auto &[key, descriptorSetLayout] : descriptorSetLayouts) descriptorSetLayout.destroy();
+    pipelineLayouts.clear();
+    descriptorSetLayouts.clear();
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "resource-utilities.h"
+#include <map>
+#include <mutex>
+
+/**
+ * @class LayoutCache
+ *
+ * @brief Creates descriptor set layouts and pipeline layouts once per distinct shape
+ *
+ * Layouts derived from shader reflection are requested by every pipeline that uses them. Two requests for a layout
+ * with the same bindings, or a pipeline layout with the same set layouts and push constant ranges, return the same
+ * handle, so pipelines of identical shape are layout compatible and may share descriptor sets.
+ *
+ * Layouts may be requested from several threads at once.
+ */
+class LayoutCache {
+    class AppBase* appBase;
+
+    std::mutex layoutMutex;
+    std::map<std::vector<uint64_t>, AppDescriptorSetLayout> descriptorSetLayouts = {};
+    std::map<std::vector<uint64_t>, AppPipelineLayout> pipelineLayouts = {};
+
+    public:
+    void init(class AppBase* appBase);
+
+    /**
+     * @brief Gets the descriptor set layout of the items, creating it the first time items of its shape are requested
+     */
+    AppDescriptorSetLayout getDescriptorSetLayout(const std::vector<DescriptorItem> &descriptorItems);
+
+    /**
+     * @brief Gets the pipeline layout of the set layouts and push constant ranges, creating it the first time
+     */
+    AppPipelineLayout getPipelineLayout(const std::vector<VkDescriptorSetLayout> &descriptorSetLayouts, const std::vector<VkPushConstantRange> &pushConstantRanges);
+
+    uint32_t getLayoutCount();
+
+    /**
+     * @brief Destroys every layout created by the cache
+     */
+    void destroy();
+};
@@ -0,0 +1,11 @@
+#pragma once
+#include "resource-list.h"
+
+class DescriptorUpdateTemplateList : public ResourceList<VkDescriptorUpdateTemplate> {
+    public:
+    virtual void destroy(std::list<VkDescriptorUpdateTemplate>::iterator it, VkDevice device) {
+        vkDestroyDescriptorUpdateTemplate(device, *it, nullptr);
+        ResourceList::destroy(it);
+    }
+    void destroyAll(VkDevice device) { while (!resourceList.empty()) destroy(resourceList.begin(), device);}
+};
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+#include "resource-list.h"
+
+class PipelineCacheList : public ResourceList<VkPipelineCache> {
+    public:
+    virtual void destroy(std::list<VkPipelineCache>::iterator it, VkDevice device) {
+        vkDestroyPipelineCache(device, *it, nullptr);
+        ResourceList::destroy(it);
+    }
+    void destroyAll(VkDevice device) { while (!resourceList.empty()) destroy(resourceList.begin(), device);}
+};
\ No newline at end of file
@@ -1,18 +1,27 @@
 #pragma once
 #include <list>
+#include <mutex>
 #include "vulkan/vulkan.hpp"
 
+/**
+ * Tracks the resources of one type so they can all be destroyed at cleanup. Resources may be created and destroyed
+ * from several threads at once, startup creates them from the job system's workers
+ */
 template <typename T>
 class ResourceList {
+    std::mutex listMutex;
+
 protected:
     typename std::list<T> resourceList = {};
     virtual void destroy(typename std::list<T>::iterator it) {
+        std::lock_guard<std::mutex> lock(listMutex);
         resourceList.erase(it);
     }
 
 public:
     typename std::list<T>::iterator create(T resource){
+        std::lock_guard<std::mutex> lock(listMutex);
         resourceList.push_front(resource);
         return resourceList.begin();
     };
-};
\ No newline at end of file
+};
@@ -0,0 +1,192 @@
+#include "mipmap-generator.h"
+#include "shader-specialization.h"
+#include "app-base.h"
+#include <algorithm>
+#include <cstddef>
+
+void MipmapGenerator::init(AppBase* appBase, std::span<const uint32_t> downsampleSpirv)
+{
+    this->appBase = appBase;
+
+    downsampleShaderModule.init(appBase, downsampleSpirv, VK_SHADER_STAGE_COMPUTE_BIT);
+
+    // Binding 0 is the level being read, binding 1 is the level being written
+    pushDescriptors = appBase->logicalDevice.supportsPushDescriptors();
+    descriptorSetLayout.init(appBase, {
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT}
+    }, pushDescriptors ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0U);
+    pipelineLayout.init(appBase, {descriptorSetLayout.get()}, {});
+
+    //                                                          {binding, array element, count, type, offset, stride}
+    std::vector<VkDescriptorUpdateTemplateEntry> templateEntries = {
+        VkDescriptorUpdateTemplateEntry {0U, 0U, 1U, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, offsetof(DownsampleDescriptors, source), sizeof(VkDescriptorImageInfo)},
+        VkDescriptorUpdateTemplateEntry {1U, 0U, 1U, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, offsetof(DownsampleDescriptors, destination), sizeof(VkDescriptorImageInfo)}
+    };
+    if (pushDescriptors) descriptorUpdateTemplate.init(appBase, descriptorSetLayout, templateEntries, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0U);
+    else descriptorUpdateTemplate.init(appBase, descriptorSetLayout, templateEntries);
+
+    workgroupSize = ShaderSpecialization::chooseWorkgroupSize(appBase->logicalDevice.getLimits(), preferredWorkgroupSize);
+    ShaderSpecialization specialization;
+    specialization.setWorkgroupSize(workgroupSize);
+    VkSpecializationInfo specializationInfo = specialization.getInfo();
+    pipeline.init(appBase, downsampleShaderModule, pipelineLayout, &specializationInfo);
+
+    descriptorAllocator.init(appBase, maxMipLevels, {
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2U}
+    });
+}
+
+static bool isSRGBFormat(VkFormat format)
+{
+    switch (format) {
+        case VK_FORMAT_R8_SRGB:
+        case VK_FORMAT_R8G8_SRGB:
+        case VK_FORMAT_R8G8B8_SRGB:
+        case VK_FORMAT_B8G8R8_SRGB:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void MipmapGenerator::generate(AppImage &image, VkCommandBuffer commandBuffer, uint32_t targetLayer)
+{
+    if (image.supportsBlitMipmaps()) {
+        image.generateMipmaps(commandBuffer, targetLayer);
+    } else if (isSRGBFormat(image.getFormat())) {
+        // The kernel averages the stored values, which for sRGB texels would darken every level
+        throw std::runtime_error("Failed to generate mipmaps, sRGB formats can only be downsampled by blits");
+    } else if (image.getUsage() & VK_IMAGE_USAGE_STORAGE_BIT) {
+        generateWithCompute(image, commandBuffer, targetLayer);
+    } else {
+        throw std::runtime_error("Failed to generate mipmaps, the image's format can neither be blitted nor written as a storage image");
+    }
+}
+
+void MipmapGenerator::generateWithCompute(AppImage &image, VkCommandBuffer commandBuffer, uint32_t targetLayer)
+{
+    if (image.getLayout() != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        throw std::runtime_error("Image must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL layout to generate mipmaps");
+    }
+    uint32_t mipLevels = image.getMipLevels();
+
+    // Create a single level view of every level of the layer, each one is written and then read by the next dispatch
+    std::vector<AppImageView> levelViews(mipLevels);
+    for (uint32_t level = 0U ; level < mipLevels ; level++) {
+        levelViews[level].initStorage(appBase, image, targetLayer, level);
+    }
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image.get();
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.pNext = nullptr;
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.pInheritanceInfo = nullptr;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    // Storage images must be in the general layout, wait for the upload of level 0 before reading it
+    //                        {aspect mask, mip level, mip level count, array layer, array layer count}
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, mipLevels, targetLayer, 1U};
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0U, 0U, nullptr, 0U, nullptr, 1U, &barrier);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.get());
+
+    // The sets of every level are allocated together, set i downsamples level i into level i + 1
+    std::vector<VkDescriptorSet> descriptorSets = {};
+    if (!pushDescriptors) descriptorSets = descriptorAllocator.allocate(std::vector<VkDescriptorSetLayout>(mipLevels - 1U, descriptorSetLayout.get()));
+
+    uint32_t levelWidth = image.getWidth();
+    uint32_t levelHeight = image.getHeight();
+    for (uint32_t level = 1U ; level < mipLevels ; level++) {
+        levelWidth = std::max(levelWidth / 2U, 1U);
+        levelHeight = std::max(levelHeight / 2U, 1U);
+
+        DownsampleDescriptors descriptors {
+            {VK_NULL_HANDLE, levelViews[level - 1U].get(), VK_IMAGE_LAYOUT_GENERAL},
+            {VK_NULL_HANDLE, levelViews[level].get(), VK_IMAGE_LAYOUT_GENERAL}
+        };
+        if (pushDescriptors) {
+            descriptorUpdateTemplate.push(commandBuffer, &descriptors);
+        } else {
+            descriptorUpdateTemplate.update(descriptorSets[level - 1U], &descriptors);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout.get(), 0U, 1U, &descriptorSets[level - 1U], 0U, nullptr);
+        }
+        vkCmdDispatch(commandBuffer, (levelWidth + workgroupSize.width - 1U) / workgroupSize.width, (levelHeight + workgroupSize.height - 1U) / workgroupSize.height, 1U);
+
+        // The level just written is read by the next dispatch
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1U, targetLayer, 1U};
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0U, 0U, nullptr, 0U, nullptr, 1U, &barrier);
+    }
+
+    // Hand the whole chain to the fragment shaders
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, mipLevels, targetLayer, 1U};
+    barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0U, 0U, nullptr, 0U, nullptr, 1U, &barrier);
+
+    vkEndCommandBuffer(commandBuffer);
+
+    VkFenceCreateInfo mipmapsCompleteFenceInfo{};
+    mipmapsCompleteFenceInfo.pNext = nullptr;
+    mipmapsCompleteFenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkFence mipmapsCompleteFence;
+    vkCreateFence(appBase->getDevice(), &mipmapsCompleteFenceInfo, nullptr, &mipmapsCompleteFence);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.pCommandBuffers = &(commandBuffer);
+    submitInfo.commandBufferCount = 1U;
+    submitInfo.pNext = nullptr;
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pSignalSemaphores = nullptr;
+    submitInfo.signalSemaphoreCount = 0U;
+    submitInfo.pWaitSemaphores = nullptr;
+    submitInfo.pWaitDstStageMask = nullptr;
+    submitInfo.waitSemaphoreCount = 0u;
+
+    vkQueueSubmit(appBase->queues.graphicsQueue, 1U, &submitInfo, mipmapsCompleteFence);
+
+    vkWaitForFences(appBase->getDevice(), 1U, &mipmapsCompleteFence, true, UINT64_MAX);
+
+    vkDestroyFence(appBase->getDevice(), mipmapsCompleteFence, nullptr);
+
+    // The views and descriptor sets were only needed by this chain
+    for (AppImageView &levelView : levelViews) levelView.destroy();
+    descriptorAllocator.reset();
+
+    image.setLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+void MipmapGenerator::destroy()
+{
+    descriptorAllocator.destroy();
+    descriptorUpdateTemplate.destroy();
+    pipeline.destroy();
+    pipelineLayout.destroy();
+    descriptorSetLayout.destroy();
+    downsampleShaderModule.destroy();
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "resource-utilities.h"
+#include "descriptor-allocator.h"
+
+/**
+ * @class MipmapGenerator
+ * 
+ * @brief Fills the mip chains of sampled textures on the GPU
+ * 
+ * Formats that support linearly filtered blits are downsampled with a vkCmdBlitImage cascade (see
+ * AppImage::generateMipmaps). Any other format falls back to a compute shader that box filters each level into
+ * the next through storage image views, which requires the image to have been created with storage usage. The kernel
+ * averages texels as stored, so sRGB formats are only supported through blits.
+ */
+class MipmapGenerator {
+    class AppBase* appBase;
+    AppShaderModule downsampleShaderModule;
+    AppDescriptorSetLayout descriptorSetLayout;
+    AppPipelineLayout pipelineLayout;
+    AppPipeline pipeline;
+
+    // Each level's descriptors are written from a DownsampleDescriptors through the template, and pushed into the
+    // command buffer when the device supports it. Otherwise a set is allocated per downsampled level, the sets are
+    // reset after every generated chain
+    AppDescriptorUpdateTemplate descriptorUpdateTemplate;
+    DescriptorAllocator descriptorAllocator;
+    bool pushDescriptors = false;
+
+    struct DownsampleDescriptors {
+        VkDescriptorImageInfo source;
+        VkDescriptorImageInfo destination;
+    };
+
+    // The kernels are specialized to the preferred workgroup size, shrunk to fit the device's limits
+    const VkExtent2D preferredWorkgroupSize = {8U, 8U};
+    VkExtent2D workgroupSize = preferredWorkgroupSize;
+
+    // The first pool holds enough levels for a 65536x65536 image
+    const uint32_t maxMipLevels = 17U;
+
+    void generateWithCompute(AppImage &image, VkCommandBuffer commandBuffer, uint32_t targetLayer);
+
+    public:
+    /**
+     * @brief Creates the compute fallback pipeline
+     * 
+     * @param downsampleSpirv The SPIR-V of shaders/src/downsample.comp, downsampleSpirv in embedded-shaders.h
+     */
+    void init(class AppBase* appBase, std::span<const uint32_t> downsampleSpirv);
+
+    /**
+     * @brief Fills the mip chain of a layer from its first level
+     * 
+     * The image must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL with level 0 written. Every level of the layer is
+     * left in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+     */
+    void generate(AppImage &image, VkCommandBuffer commandBuffer, uint32_t targetLayer);
+
+    void destroy();
+};
@@ -0,0 +1,80 @@
+#include "pipeline-variant-cache.h"
+#include "app-base.h"
+
+static void appendSpecializationKey(std::vector<uint64_t> &key, const ShaderSpecialization &specialization)
+{
+    for (uint32_t word : specialization.getKey()) key.push_back(word);
+}
+
+void PipelineVariantCache::init(AppBase* appBase, const std::string &cacheFilePath)
+{
+    this->appBase = appBase;
+    this->cacheFilePath = cacheFilePath;
+    pipelineCache.init(appBase, cacheFilePath);
+}
+
+template <typename Compile>
+AppPipeline PipelineVariantCache::findOrCompile(std::vector<uint64_t> key, Compile compile)
+{
+    {
+        std::lock_guard<std::mutex> lock(variantMutex);
+        auto variant = variants.find(key);
+        if (variant != variants.end()) return variant->second;
+    }
+
+    // Compiled outside the lock, vkCreate*Pipelines synchronizes access to the pipeline cache itself
+    AppPipeline pipeline = compile();
+
+    std::lock_guard<std::mutex> lock(variantMutex);
+    auto [variant, inserted] = variants.emplace(std::move(key), pipeline);
+
+    // Another thread compiled the same variant meanwhile, every caller gets the pipeline that was kept
+    if (!inserted) pipeline.destroy();
+    return variant->second;
+}
+
+AppPipeline PipelineVariantCache::getGraphicsPipeline(std::vector<AppShaderModule> shaderModules, AppPipelineLayout pipelineLayout, AppRenderPass renderPass, const ShaderSpecialization &specialization)
+{
+    std::vector<uint64_t> key = {VK_PIPELINE_BIND_POINT_GRAPHICS, getHandleKey(pipelineLayout.get()), getHandleKey(renderPass.get()), shaderModules.size()};
+    for (AppShaderModule &shaderModule : shaderModules) key.push_back(getHandleKey(shaderModule.get()));
+    appendSpecializationKey(key, specialization);
+
+    return findOrCompile(std::move(key), [&]() {
+        VkSpecializationInfo specializationInfo = specialization.getInfo();
+        AppPipeline pipeline;
+        pipeline.init(appBase, shaderModules, pipelineLayout, renderPass, VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT, &specializationInfo, pipelineCache.get());
+        return pipeline;
+    });
+}
+
+AppPipeline PipelineVariantCache::getComputePipeline(AppShaderModule computeShaderModule, AppPipelineLayout pipelineLayout, const ShaderSpecialization &specialization)
+{
+    std::vector<uint64_t> key = {VK_PIPELINE_BIND_POINT_COMPUTE, getHandleKey(pipelineLayout.get()), getHandleKey(computeShaderModule.get())};
+    appendSpecializationKey(key, specialization);
+
+    return findOrCompile(std::move(key), [&]() {
+        VkSpecializationInfo specializationInfo = specialization.getInfo();
+        AppPipeline pipeline;
+        pipeline.init(appBase, computeShaderModule, pipelineLayout, &specializationInfo, pipelineCache.get());
+        return pipeline;
+    });
+}
+
+uint32_t PipelineVariantCache::getVariantCount()
+{
+    std::lock_guard<std::mutex> lock(variantMutex);
+    return variants.size();
+}
+
+void PipelineVariantCache::save()
+{
+    pipelineCache.save(cacheFilePath);
+}
+
+void PipelineVariantCache::destroy()
+{
+    std::lock_guard<std::mutex> lock(variantMutex);
+    for (auto &[key, pipeline] : variants) pipeline.destroy();
+    variants.clear();
+    pipelineCache.destroy();
+}
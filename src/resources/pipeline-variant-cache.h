@@ -0,0 +1,52 @@
+#pragma once
+#include "resource-utilities.h"
+#include "pipeline-cache-resource.h"
+#include "shader-specialization.h"
+#include <map>
+#include <mutex>
+
+/**
+ * @class PipelineVariantCache
+ *
+ * @brief Compiles each permutation of a pipeline once, keyed by its shader modules, layout and specialization
+ *
+ * Features that differ between materials, counts known when the pipeline is compiled and compute workgroup sizes are
+ * specialization constants rather than uniforms or push constants, so each permutation compiles to a shader without
+ * the branches. Asking for a permutation that was compiled before returns the same pipeline. Permutations are
+ * compiled through a VkPipelineCache that is saved to disk, so a later run recompiles them from the driver's cache.
+ *
+ * Variants may be requested from several threads at once. Compiling a variant does not block requests for others.
+ */
+class PipelineVariantCache {
+    class AppBase* appBase;
+    AppPipelineCache pipelineCache;
+    std::string cacheFilePath;
+
+    std::mutex variantMutex;
+    std::map<std::vector<uint64_t>, AppPipeline> variants = {};
+
+    template <typename Compile>
+    AppPipeline findOrCompile(std::vector<uint64_t> key, Compile compile);
+
+    public:
+    /**
+     * @param cacheFilePath Where the driver's pipeline cache is loaded from and saved to
+     */
+    void init(class AppBase* appBase, const std::string &cacheFilePath);
+
+    AppPipeline getGraphicsPipeline(std::vector<AppShaderModule> shaderModules, AppPipelineLayout pipelineLayout, AppRenderPass renderPass, const ShaderSpecialization &specialization);
+
+    AppPipeline getComputePipeline(AppShaderModule computeShaderModule, AppPipelineLayout pipelineLayout, const ShaderSpecialization &specialization);
+
+    uint32_t getVariantCount();
+
+    /**
+     * @brief Saves the driver's pipeline cache, best called once the permutations in use have been compiled
+     */
+    void save();
+
+    /**
+     * @brief Destroys every compiled variant and the pipeline cache, without saving it
+     */
+    void destroy();
+};
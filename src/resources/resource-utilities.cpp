@@ -1,66 +1,141 @@
 #include "resource-utilities.h"
 #include "app-base.h"
-#include "turbojpeg.h"
 #include "GLFW/glfw3.h"
 #include "file-utilities.h"
 #include "device-memory-resource.h"
+#include "image/image-loader.h"
+#include "file-loader.h"
+#include "mipmap-generator.h"
+#include "texture-upload-converter.h"
+#include <algorithm>
 
 
 void copyDataToStagingMemory(AppDeviceMemory stagingMemory, void *data, size_t size)
 {
-    void* mappedMemory = nullptr;
-    vkMapMemory(stagingMemory.getAppBase()->getDevice(), stagingMemory.get(), 0U, size, 0U, &mappedMemory);
-    memcpy(mappedMemory, data, size);
-    vkUnmapMemory(stagingMemory.getAppBase()->getDevice(), stagingMemory.get());
+    // Staging memory is persistently mapped when allocated
+    memcpy(stagingMemory.getMappedData(), data, size);
 }
 
-void loadImage(AppBase *app, Image srcImage, AppImage appImage, VkCommandBuffer commandBuffer, uint32_t targetLayer)
+AppStagingImageBundle createStagingImage(AppBase *app, uint32_t width, uint32_t height)
 {
-    VkDevice device = app->logicalDevice.get();
-    
-    // Create a dummy staging image to fetch image requirements from (particularly, the alignment)
-    AppImage dummyImage;
-    dummyImage.init(app, AppImageTemplate::STAGING_IMAGE_TEXTURE, 1U, 1U);
-    VkMemoryRequirements imageMemoryRequirements{};
-    vkGetImageMemoryRequirements(app->logicalDevice.get(), dummyImage.get(), &imageMemoryRequirements);
+    AppStagingImageBundle bundle {};
 
-    uint32_t width = 0, height = 0;
+    // The staging image starts preinitialized so the texels written by the CPU survive its first transition
+    bundle.image.init(app, AppImageTemplate::STAGING_IMAGE_TEXTURE, width, height, 1U, VK_IMAGE_LAYOUT_PREINITIALIZED);
+    bundle.deviceMemory.init(app, bundle.image);
+    bundle.image.bindToMemory(&bundle.deviceMemory);
 
-    // Specify the pixel format to retrieve the JPEG with
-    int pixelFormat = TJPF_RGBA;
-    tjhandle turboJpegHandle = tj3Init(TJINIT_DECOMPRESS);
+    bundle.layout = bundle.image.getSubresourceLayout(0U);
+    bundle.mappedData = static_cast<char*>(bundle.deviceMemory.getMappedData()) + bundle.layout.offset;
+    return bundle;
+}
 
-    // Read in the jpeg image file
+void uploadStagingImage(AppStagingImageBundle stagingImage, AppImage appImage, VkCommandBuffer commandBuffer, uint32_t targetLayer, MipmapGenerator* mipmapGenerator)
+{
+    if (stagingImage.image.getWidth() != appImage.getWidth() || stagingImage.image.getHeight() != appImage.getHeight()) {
+        stagingImage.image.destroy();
+        stagingImage.deviceMemory.destroy();
+        throw std::runtime_error("Failed to upload staging image, the image it is uploaded into is a different size");
+    }
 
-    // Define the staging image and memory that the CPU will write into
-    AppImage stagingImage;
-    AppDeviceMemory stagingImageMemory;
+    // Push the staging image contents to the first level of the device-local image
+    stagingImage.image.transitionLayout(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, commandBuffer, 0U);
+    appImage.transitionLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, commandBuffer, targetLayer);
+    AppImage::copyImage(stagingImage.image, appImage, commandBuffer, 0U, targetLayer, 1U, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+    // Downsample the rest of the mip chain, leaving every level ready to be used as a shader resource
+    if (appImage.getMipLevels() > 1U) {
+        if (mipmapGenerator != nullptr) mipmapGenerator->generate(appImage, commandBuffer, targetLayer);
+        else appImage.generateMipmaps(commandBuffer, targetLayer);
+    } else {
+        appImage.transitionLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandBuffer, targetLayer);
+    }
 
-    // Initialize the actual staging image
-    stagingImage.init(app, AppImageTemplate::STAGING_IMAGE_TEXTURE, width, height);
-    
-    VkMemoryRequirements stagingImageMemoryRequirements;
-    vkGetImageMemoryRequirements(app->logicalDevice.get(), stagingImage.get(), &stagingImageMemoryRequirements);
+    // Destroy the staging image and its memory
+    stagingImage.image.destroy();
+    stagingImage.deviceMemory.destroy();
+}
 
-    stagingImageMemory.init(app, stagingImage);
+void loadImage(AppBase *app, const Image &srcImage, AppImage appImage, VkCommandBuffer commandBuffer, uint32_t targetLayer, MipmapGenerator* mipmapGenerator)
+{
+    uint32_t width = srcImage.getWidth(), height = srcImage.getHeight();
+    AppStagingImageBundle stagingImage = createStagingImage(app, width, height);
+
+    // Copy the decoded rows into the staging image, the device's row pitch may differ from the image's
+    uint32_t rowBytes = width * srcImage.getBytesPerPixel();
+    const char* srcData = srcImage.getData().data();
+    char* dstData = static_cast<char*>(stagingImage.mappedData);
+    for (uint32_t row = 0U ; row < height ; row++) {
+        memcpy(dstData + row * stagingImage.layout.rowPitch, srcData + row * srcImage.getPitch(), rowBytes);
+    }
 
-    stagingImage.bindToMemory(&stagingImageMemory);
+    uploadStagingImage(stagingImage, appImage, commandBuffer, targetLayer, mipmapGenerator);
+}
 
-    void* mappedImageMemory = nullptr;
+void loadImage(AppBase *app, const std::string &jpegFilePath, AppImage appImage, VkCommandBuffer commandBuffer, uint32_t targetLayer, MipmapGenerator* mipmapGenerator,
+    TextureUploadConverter* uploadConverter)
+{
+    std::vector<char> jpegFile = FileLoader::loadFile(jpegFilePath);
+    if (jpegFile.size() == 0) throw std::runtime_error("Failed to open jpeg image");
 
-    // Copy the image into the staging image resource
-    copyDataToStagingMemory(stagingImageMemory, jpegImage.data(), stagingImageMemoryRequirements.size);
+    loadJPEGImage(app, jpegFile, appImage, commandBuffer, targetLayer, mipmapGenerator, uploadConverter);
+}
 
-    // Push the staging image contents to the device-local image
-    stagingImage.transitionLayout(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, commandBuffer, 0U);
-    image.transitionLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, commandBuffer, targetLayer);
-    AppImage::copyImage(stagingImage, image, commandBuffer, 0U, targetLayer, 1U, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+void loadJPEGImage(AppBase *app, const std::vector<char> &jpegFile, AppImage appImage, VkCommandBuffer commandBuffer, uint32_t targetLayer, MipmapGenerator* mipmapGenerator,
+    TextureUploadConverter* uploadConverter)
+{
+    if (uploadConverter != nullptr && (appImage.getUsage() & VK_IMAGE_USAGE_STORAGE_BIT)) {
+        uploadConverter->loadJPEG(jpegFile, appImage, commandBuffer, targetLayer, mipmapGenerator);
+        return;
+    }
+
+    // Size the staging image from the header, then decode straight into its mapped memory
+    Image header = ImageLoader::loadJPEGHeader(jpegFile);
+    AppStagingImageBundle stagingImage = createStagingImage(app, header.getWidth(), header.getHeight());
+    ImageLoader::decodeJPEGInto(jpegFile, stagingImage.mappedData, stagingImage.layout.rowPitch);
+
+    uploadStagingImage(stagingImage, appImage, commandBuffer, targetLayer, mipmapGenerator);
+}
+
+void loadKTX2Image(AppBase *app, const KTX2Texture &texture, AppImage appImage, VkCommandBuffer commandBuffer, uint32_t targetLayer)
+{
+    if (texture.width != appImage.getWidth() || texture.height != appImage.getHeight() || texture.levels.empty() || texture.baseLevel >= appImage.getMipLevels()) {
+        throw std::runtime_error("Failed to load ktx2 image, the texture does not match the image it is loaded into");
+    }
+
+    // Pack every level into one staging buffer, block-compressed levels must start on a block boundary
+    uint32_t levelAlignment = KTX2File::getBlockByteSize(texture.format);
+    uint32_t levelCount = std::min<uint32_t>(texture.levels.size(), appImage.getMipLevels() - texture.baseLevel);
+    std::vector<VkBufferImageCopy> regions = {};
+    size_t stagingSize = 0U;
+    for (uint32_t i = 0U ; i < levelCount ; i++) {
+        uint32_t level = texture.baseLevel + i;
+        stagingSize = ((stagingSize + levelAlignment - 1U) / levelAlignment) * levelAlignment;
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = stagingSize;
+        region.bufferRowLength = 0U; // Tightly packed
+        region.bufferImageHeight = 0U;
+        //                         {aspect, mip level, array layer, layer count}
+        region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, targetLayer, 1U};
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {std::max(texture.width >> level, 1U), std::max(texture.height >> level, 1U), 1U};
+        regions.push_back(region);
+
+        stagingSize += texture.levels[i].size();
+    }
+
+    AppBufferBundle stagingBuffer = createBufferAll(app, AppBufferTemplate::IMAGE_STAGING, stagingSize);
+    for (uint32_t i = 0U ; i < regions.size() ; i++) {
+        memcpy(static_cast<char*>(stagingBuffer.deviceMemory.getMappedData()) + regions[i].bufferOffset, texture.levels[i].data(), texture.levels[i].size());
+    }
 
-    // Transition the image to be used as a shader resource
-    image.transitionLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandBuffer, targetLayer);
+    appImage.transitionLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, commandBuffer, targetLayer);
+    appImage.copyFromBuffer(stagingBuffer.buffer, commandBuffer, regions);
+    appImage.transitionLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandBuffer, targetLayer);
 
-    // Destroy the staging image
-    stagingImage.destroy();
+    stagingBuffer.buffer.destroy();
+    stagingBuffer.deviceMemory.destroy();
 }
 
 void renderCubeMap(AppImage imageArray)
@@ -104,7 +179,7 @@ static VkImageLayout getImageLayoutFromTemplate(AppImageTemplate t) {
     }
 }
 
-void updateDescriptor(AppImageView imageView, VkDescriptorSet set, uint32_t binding, VkDescriptorType descriptorType, AppSampler sampler)
+void updateDescriptor(AppImageView imageView, VkDescriptorSet set, uint32_t binding, VkDescriptorType descriptorType, AppSampler sampler, uint32_t arrayElement)
 {   
     VkDescriptorImageInfo imageInfo{};
     imageInfo.imageLayout = getImageLayoutFromTemplate(imageView.getTemplate());
@@ -119,7 +194,7 @@ void updateDescriptor(AppImageView imageView, VkDescriptorSet set, uint32_t bind
     descriptorWriteImg.descriptorType = descriptorType;
     descriptorWriteImg.dstSet = set;
     descriptorWriteImg.dstBinding = binding;
-    descriptorWriteImg.dstArrayElement = 0;
+    descriptorWriteImg.dstArrayElement = arrayElement;
     descriptorWriteImg.pImageInfo = &imageInfo;
     descriptorWriteImg.pTexelBufferView = nullptr;
 
@@ -11,6 +11,7 @@
 #include "shader-module-resource.h"
 #include "descriptor-pool-resource.h"
 #include "descriptor-set-layout-resource.h"
+#include "descriptor-update-template-resource.h"
 #include "render-pass-resource.h"
 #include "framebuffer-resource.h"
 #include "pipeline-layout-resource.h"
@@ -18,11 +19,79 @@
 #include "semaphore-resource.h"
 #include "fence-resource.h"
 #include "device-memory-resource.h"
+#include "image/image.h"
+#include "image/ktx2-file.h"
+#include <type_traits>
 
+/**
+ * @brief Converts a Vulkan handle to a key for caches, handles are pointers on 64-bit platforms and integers on others
+ */
+template <typename T>
+uint64_t getHandleKey(T handle)
+{
+    if constexpr (std::is_pointer_v<T>) return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(handle));
+    else return static_cast<uint64_t>(handle);
+}
 
 void copyDataToStagingMemory(AppDeviceMemory stagingMemory, void *data, size_t size);
 
-void loadImage(AppBase* appBase, Image srcImage, AppImage appImage, VkCommandBuffer commandBuffer, uint32_t targetLayer);
+/**
+ * @brief A linear, host-visible staging image whose memory stays mapped for its whole lifetime
+ */
+struct AppStagingImageBundle {
+    AppImage image;
+    AppDeviceMemory deviceMemory;
+
+    // The device's layout of the image, the row pitch may be larger than width * bytes per pixel
+    VkSubresourceLayout layout;
+
+    // Points to the first texel of the image in the mapped memory
+    void* mappedData;
+};
+
+/**
+ * @brief Creates a staging image that the CPU can write texels into directly, at the device's row pitch
+ */
+AppStagingImageBundle createStagingImage(class AppBase* app, uint32_t width, uint32_t height);
+
+/**
+ * @brief Copies a filled staging image into a layer of a device-local image, then destroys the staging image
+ * 
+ * If the image has a mip chain, the remaining levels are generated from the uploaded level, with mipmapGenerator
+ * when one is given (so formats that cannot be blitted fall back to compute) or with blits otherwise.
+ * 
+ * @note The target layer is left ready to be sampled
+ */
+void uploadStagingImage(AppStagingImageBundle stagingImage, AppImage appImage, VkCommandBuffer commandBuffer, uint32_t targetLayer, class MipmapGenerator* mipmapGenerator = nullptr);
+
+void loadImage(AppBase* appBase, const Image &srcImage, AppImage appImage, VkCommandBuffer commandBuffer, uint32_t targetLayer, class MipmapGenerator* mipmapGenerator = nullptr);
+
+/**
+ * @brief Loads a JPEG file into a layer of a device-local image, see loadJPEGImage
+ */
+void loadImage(AppBase* appBase, const std::string &jpegFilePath, AppImage appImage, VkCommandBuffer commandBuffer, uint32_t targetLayer, class MipmapGenerator* mipmapGenerator = nullptr,
+    class TextureUploadConverter* uploadConverter = nullptr);
+
+/**
+ * @brief Loads a JPEG that has already been read into memory into a layer of a device-local image
+ *
+ * When an upload converter is given and the image has storage usage, the JPEG is uploaded as planes or packed RGB
+ * and expanded to RGBA on the device. Otherwise it is decoded to RGBA straight into the staging image's memory.
+ *
+ * @note The JPEG must be the size of the image
+ */
+void loadJPEGImage(AppBase* appBase, const std::vector<char> &jpegFile, AppImage appImage, VkCommandBuffer commandBuffer, uint32_t targetLayer, class MipmapGenerator* mipmapGenerator = nullptr,
+    class TextureUploadConverter* uploadConverter = nullptr);
+
+/**
+ * @brief Uploads the mip levels of a KTX2 texture into a layer of a device-local image
+ * 
+ * Only the levels the texture holds are written (see KTX2Texture::baseLevel), the other levels of the layer keep
+ * their contents, so a texture can be uploaded a few levels at a time.
+ * 
+ * @note The image's format and size must match the texture, the target layer is left ready to be sampled
+ */
+void loadKTX2Image(AppBase* appBase, const KTX2Texture &texture, AppImage appImage, VkCommandBuffer commandBuffer, uint32_t targetLayer);
 
 /**
  * @brief Renders a cube map to image array with 6 layers
@@ -65,7 +134,9 @@ AppBufferBundle createBufferAll(class AppBase* app, AppBufferTemplate bufferTemp
 
 /**
  * @brief Updates an image descriptor for a particular descriptor set
+ * 
+ * @param arrayElement The element to write when the binding is an array of descriptors
  */
-void updateDescriptor(AppImageView imageView, VkDescriptorSet set, uint32_t binding, VkDescriptorType descriptorType, AppSampler sampler = AppSampler{});
+void updateDescriptor(AppImageView imageView, VkDescriptorSet set, uint32_t binding, VkDescriptorType descriptorType, AppSampler sampler = AppSampler{}, uint32_t arrayElement = 0U);
 void updateDescriptor(AppBuffer buffer, VkDescriptorSet set, uint32_t size,  uint32_t binding, VkDescriptorType descriptorType);
 
@@ -3,6 +3,7 @@
 #include "lists/command-pool-list.h"
 #include "lists/descriptor-pool-list.h"
 #include "lists/descriptor-set-layout-list.h"
+#include "lists/descriptor-update-template-list.h"
 #include "lists/device-list.h"
 #include "lists/device-memory-list.h"
 #include "lists/fence-list.h"
@@ -17,6 +18,7 @@
 #include "lists/surface-list.h"
 #include "lists/swapchain-list.h"
 #include "lists/pipeline-list.h"
+#include "lists/pipeline-cache-list.h"
 #include "lists/framebuffer-list.h"
 
 class Resources {
@@ -31,6 +33,7 @@ class Resources {
     SamplerList samplers;
     DescriptorSetLayoutList descriptorSetLayouts;
     DescriptorPoolList descriptorPools;
+    DescriptorUpdateTemplateList descriptorUpdateTemplates;
     CommandPoolList commandPools;
     FenceList fences;
     SemaphoreList semaphores;
@@ -39,6 +42,7 @@ class Resources {
     ShaderModuleList shaderModules;
     SwapchainList swapchains;
     PipelineList pipelines;
+    PipelineCacheList pipelineCaches;
     FramebufferList framebuffers;
 
     void destroyAll(VkDevice device, VkInstance instance) {
@@ -47,6 +51,7 @@ class Resources {
         buffers.destroyAll(device);
         deviceMemorySet.destroyAll(device);
         samplers.destroyAll(device);
+        descriptorUpdateTemplates.destroyAll(device);
         descriptorSetLayouts.destroyAll(device);
         descriptorPools.destroyAll(device);
         commandPools.destroyAll(device);
@@ -59,6 +64,7 @@ class Resources {
         swapchains.destroyAll(device);
         surfaces.destroyAll(instance);
         pipelines.destroyAll(device);
+        pipelineCaches.destroyAll(device);
         devices.destroyAll();
         instances.destroyAll();
     }
@@ -0,0 +1,308 @@
+#include "shader-reflection.h"
+#include <iostream>
+#include <initializer_list>
+
+/**
+ * Reflects hand assembled SPIR-V modules of a vertex and a fragment stage and checks the bindings, push constants
+ * and vertex inputs derived from them, exits with a non-zero status if any check fails
+ *
+ * Usage: shader-reflection-test
+ */
+static uint32_t failedChecks = 0U;
+
+static void check(bool condition, const std::string &description)
+{
+    if (condition) return;
+    std::cerr << "FAILED: " << description << std::endl;
+    failedChecks++;
+}
+
+template <typename Function>
+static void checkThrows(Function function, const std::string &description)
+{
+    bool threw = false;
+    try { function(); } catch (const std::runtime_error &) { threw = true; }
+    check(threw, description);
+}
+
+// The SPIR-V opcodes, decorations and enumerants the test modules are assembled from
+enum TestOp : uint32_t {
+    ENTRY_POINT = 15U, TYPE_INT = 21U, TYPE_FLOAT = 22U, TYPE_VECTOR = 23U, TYPE_MATRIX = 24U, TYPE_IMAGE = 25U,
+    TYPE_SAMPLED_IMAGE = 27U, TYPE_ARRAY = 28U, TYPE_RUNTIME_ARRAY = 29U, TYPE_STRUCT = 30U, TYPE_POINTER = 32U,
+    CONSTANT = 43U, VARIABLE = 59U, DECORATE = 71U, MEMBER_DECORATE = 72U
+};
+enum TestDecoration : uint32_t { BUILT_IN = 11U, LOCATION = 30U, BINDING = 33U, DESCRIPTOR_SET = 34U, OFFSET = 35U, MATRIX_STRIDE = 7U };
+enum TestStorageClass : uint32_t { UNIFORM_CONSTANT = 0U, INPUT = 1U, UNIFORM = 2U, PUSH_CONSTANT = 9U, STORAGE_BUFFER = 12U };
+
+// "main", nul-terminated and padded to whole words
+static const uint32_t mainName[] = {0x6E69616DU, 0U};
+
+/**
+ * Assembles a SPIR-V module one instruction at a time, ids are handed out in order from 1
+ */
+class SpirvAssembler {
+    std::vector<uint32_t> words = {0x07230203U, 0x00010300U, 0U, 0U, 0U};
+    uint32_t nextId = 1U;
+
+    public:
+    uint32_t id() { return nextId++; }
+
+    void op(uint32_t opcode, std::initializer_list<uint32_t> operands) {
+        words.push_back(static_cast<uint32_t>(operands.size() + 1U) << 16U | opcode);
+        words.insert(words.end(), operands.begin(), operands.end());
+    }
+
+    void entryPoint(uint32_t executionModel, uint32_t function, std::initializer_list<uint32_t> interfaceIds) {
+        words.push_back(static_cast<uint32_t>(5U + interfaceIds.size()) << 16U | ENTRY_POINT);
+        words.insert(words.end(), {executionModel, function, mainName[0], mainName[1]});
+        words.insert(words.end(), interfaceIds.begin(), interfaceIds.end());
+    }
+
+    void decorate(uint32_t target, uint32_t decoration, uint32_t literal) { op(DECORATE, {target, decoration, literal}); }
+
+    void bind(uint32_t variable, uint32_t set, uint32_t binding) {
+        decorate(variable, DESCRIPTOR_SET, set);
+        decorate(variable, BINDING, binding);
+    }
+
+    std::vector<uint32_t> finish() {
+        words[3] = nextId;
+        return words;
+    }
+};
+
+/**
+ * A vertex stage with a uniform buffer, a push constant block, two float inputs, a uint input and gl_VertexIndex
+ */
+static std::vector<uint32_t> assembleVertexStage()
+{
+    SpirvAssembler spirv;
+    uint32_t main = spirv.id(), inPosition = spirv.id(), inUV = spirv.id(), inIndex = spirv.id(), vertexIndex = spirv.id();
+    spirv.entryPoint(0U, main, {inPosition, inUV, inIndex, vertexIndex});
+
+    uint32_t floatType = spirv.id(), intType = spirv.id(), uintType = spirv.id();
+    uint32_t vec2 = spirv.id(), vec3 = spirv.id(), vec4 = spirv.id(), mat4 = spirv.id();
+    spirv.op(TYPE_FLOAT, {floatType, 32U});
+    spirv.op(TYPE_INT, {intType, 32U, 1U});
+    spirv.op(TYPE_INT, {uintType, 32U, 0U});
+    spirv.op(TYPE_VECTOR, {vec2, floatType, 2U});
+    spirv.op(TYPE_VECTOR, {vec3, floatType, 3U});
+    spirv.op(TYPE_VECTOR, {vec4, floatType, 4U});
+    spirv.op(TYPE_MATRIX, {mat4, vec4, 4U});
+
+    // uniform Camera { mat4 view; mat4 projection; } at set 0, binding 0
+    uint32_t camera = spirv.id(), cameraPointer = spirv.id(), cameraVariable = spirv.id();
+    spirv.op(TYPE_STRUCT, {camera, mat4, mat4});
+    spirv.op(MEMBER_DECORATE, {camera, 0U, OFFSET, 0U});
+    spirv.op(MEMBER_DECORATE, {camera, 1U, OFFSET, 64U});
+    spirv.op(TYPE_POINTER, {cameraPointer, UNIFORM, camera});
+    spirv.op(VARIABLE, {cameraPointer, cameraVariable, UNIFORM});
+    spirv.bind(cameraVariable, 0U, 0U);
+
+    // push_constant { mat4 model; } at offset 0
+    uint32_t pushBlock = spirv.id(), pushPointer = spirv.id(), pushVariable = spirv.id();
+    spirv.op(TYPE_STRUCT, {pushBlock, mat4});
+    spirv.op(MEMBER_DECORATE, {pushBlock, 0U, OFFSET, 0U});
+    spirv.op(MEMBER_DECORATE, {pushBlock, 0U, MATRIX_STRIDE, 16U});
+    spirv.op(TYPE_POINTER, {pushPointer, PUSH_CONSTANT, pushBlock});
+    spirv.op(VARIABLE, {pushPointer, pushVariable, PUSH_CONSTANT});
+
+    uint32_t vec2Input = spirv.id(), vec3Input = spirv.id(), uintInput = spirv.id(), intInput = spirv.id();
+    spirv.op(TYPE_POINTER, {vec2Input, INPUT, vec2});
+    spirv.op(TYPE_POINTER, {vec3Input, INPUT, vec3});
+    spirv.op(TYPE_POINTER, {uintInput, INPUT, uintType});
+    spirv.op(TYPE_POINTER, {intInput, INPUT, intType});
+
+    // Declared out of location order, the reflected inputs are sorted by location
+    spirv.op(VARIABLE, {uintInput, inIndex, INPUT});
+    spirv.op(VARIABLE, {vec2Input, inUV, INPUT});
+    spirv.op(VARIABLE, {vec3Input, inPosition, INPUT});
+    spirv.op(VARIABLE, {intInput, vertexIndex, INPUT});
+    spirv.decorate(inPosition, LOCATION, 0U);
+    spirv.decorate(inUV, LOCATION, 1U);
+    spirv.decorate(inIndex, LOCATION, 2U);
+    spirv.decorate(vertexIndex, BUILT_IN, 42U);
+    return spirv.finish();
+}
+
+/**
+ * A fragment stage that shares the uniform buffer and adds sampler arrays, a storage buffer, a storage image and a
+ * push constant member after the vertex stage's
+ */
+static std::vector<uint32_t> assembleFragmentStage()
+{
+    SpirvAssembler spirv;
+    uint32_t main = spirv.id(), inUV = spirv.id();
+    spirv.entryPoint(4U, main, {inUV});
+
+    uint32_t floatType = spirv.id(), uintType = spirv.id(), vec2 = spirv.id(), vec4 = spirv.id(), mat4 = spirv.id();
+    spirv.op(TYPE_FLOAT, {floatType, 32U});
+    spirv.op(TYPE_INT, {uintType, 32U, 0U});
+    spirv.op(TYPE_VECTOR, {vec2, floatType, 2U});
+    spirv.op(TYPE_VECTOR, {vec4, floatType, 4U});
+    spirv.op(TYPE_MATRIX, {mat4, vec4, 4U});
+
+    uint32_t camera = spirv.id(), cameraPointer = spirv.id(), cameraVariable = spirv.id();
+    spirv.op(TYPE_STRUCT, {camera, mat4, mat4});
+    spirv.op(MEMBER_DECORATE, {camera, 1U, OFFSET, 64U});
+    spirv.op(TYPE_POINTER, {cameraPointer, UNIFORM, camera});
+    spirv.op(VARIABLE, {cameraPointer, cameraVariable, UNIFORM});
+    spirv.bind(cameraVariable, 0U, 0U);
+
+    // uniform sampler2D shadowMaps[4] at set 0, binding 1, and sampler2D textures[] at set 1, binding 0
+    uint32_t image = spirv.id(), sampledImage = spirv.id(), four = spirv.id(), fixedArray = spirv.id(), runtimeArray = spirv.id();
+    spirv.op(TYPE_IMAGE, {image, floatType, 1U, 0U, 0U, 0U, 1U, 0U});
+    spirv.op(TYPE_SAMPLED_IMAGE, {sampledImage, image});
+    spirv.op(CONSTANT, {uintType, four, 4U});
+    spirv.op(TYPE_ARRAY, {fixedArray, sampledImage, four});
+    spirv.op(TYPE_RUNTIME_ARRAY, {runtimeArray, sampledImage});
+
+    uint32_t fixedPointer = spirv.id(), runtimePointer = spirv.id(), shadowMaps = spirv.id(), textures = spirv.id();
+    spirv.op(TYPE_POINTER, {fixedPointer, UNIFORM_CONSTANT, fixedArray});
+    spirv.op(TYPE_POINTER, {runtimePointer, UNIFORM_CONSTANT, runtimeArray});
+    spirv.op(VARIABLE, {fixedPointer, shadowMaps, UNIFORM_CONSTANT});
+    spirv.op(VARIABLE, {runtimePointer, textures, UNIFORM_CONSTANT});
+    spirv.bind(shadowMaps, 0U, 1U);
+    spirv.bind(textures, 1U, 0U);
+
+    // buffer Lights { float values[]; } at set 1, binding 1
+    uint32_t floatArray = spirv.id(), lights = spirv.id(), lightsPointer = spirv.id(), lightsVariable = spirv.id();
+    spirv.op(TYPE_RUNTIME_ARRAY, {floatArray, floatType});
+    spirv.op(TYPE_STRUCT, {lights, floatArray});
+    spirv.op(TYPE_POINTER, {lightsPointer, STORAGE_BUFFER, lights});
+    spirv.op(VARIABLE, {lightsPointer, lightsVariable, STORAGE_BUFFER});
+    spirv.bind(lightsVariable, 1U, 1U);
+
+    // uniform image2D feedback at set 2, binding 0
+    uint32_t storageImage = spirv.id(), storageImagePointer = spirv.id(), feedback = spirv.id();
+    spirv.op(TYPE_IMAGE, {storageImage, floatType, 1U, 0U, 0U, 0U, 2U, 1U});
+    spirv.op(TYPE_POINTER, {storageImagePointer, UNIFORM_CONSTANT, storageImage});
+    spirv.op(VARIABLE, {storageImagePointer, feedback, UNIFORM_CONSTANT});
+    spirv.bind(feedback, 2U, 0U);
+
+    // push_constant { layout(offset = 64) uint material; }
+    uint32_t pushBlock = spirv.id(), pushPointer = spirv.id(), pushVariable = spirv.id();
+    spirv.op(TYPE_STRUCT, {pushBlock, uintType});
+    spirv.op(MEMBER_DECORATE, {pushBlock, 0U, OFFSET, 64U});
+    spirv.op(TYPE_POINTER, {pushPointer, PUSH_CONSTANT, pushBlock});
+    spirv.op(VARIABLE, {pushPointer, pushVariable, PUSH_CONSTANT});
+
+    // Fragment inputs are not vertex inputs
+    uint32_t vec2Input = spirv.id();
+    spirv.op(TYPE_POINTER, {vec2Input, INPUT, vec2});
+    spirv.op(VARIABLE, {vec2Input, inUV, INPUT});
+    spirv.decorate(inUV, LOCATION, 0U);
+    return spirv.finish();
+}
+
+static void testVertexStage(const ShaderReflection &vertex)
+{
+    check(vertex.getStageFlags() == VK_SHADER_STAGE_VERTEX_BIT, "the vertex stage is read from the entry point");
+
+    std::vector<ReflectedVertexInput> inputs = vertex.getVertexInputs();
+    check(inputs.size() == 3U, "built in vertex inputs are skipped");
+    if (inputs.size() == 3U) {
+        check(inputs[0].location == 0U && inputs[0].format == VK_FORMAT_R32G32B32_SFLOAT, "a vec3 input is R32G32B32_SFLOAT");
+        check(inputs[1].location == 1U && inputs[1].format == VK_FORMAT_R32G32_SFLOAT, "a vec2 input is R32G32_SFLOAT");
+        check(inputs[2].location == 2U && inputs[2].format == VK_FORMAT_R32_UINT, "a uint input is R32_UINT");
+    }
+
+    std::vector<VkVertexInputAttributeDescription> attributes = {
+        {0U, 0U, VK_FORMAT_R32G32B32_SFLOAT, 0U}, {1U, 0U, VK_FORMAT_R32G32_SFLOAT, 12U}
+    };
+    checkThrows([&]() { vertex.checkVertexAttributes(attributes); }, "an input without an attribute is reported");
+    attributes.push_back({2U, 0U, VK_FORMAT_R32_UINT, 20U});
+    vertex.checkVertexAttributes(attributes);
+}
+
+static void testMergedStages(const ShaderReflection &vertex, const ShaderReflection &fragment)
+{
+    ShaderReflection merged = vertex;
+    merged.merge(fragment);
+    VkShaderStageFlags bothStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    check(merged.getStageFlags() == bothStages, "merging combines the stage flags");
+    check(merged.getSetCount() == 3U, "the set count is one more than the highest set");
+
+    std::vector<ReflectedBinding> set0 = merged.getBindings(0U);
+    check(set0.size() == 2U, "set 0 has the shared uniform buffer and the shadow maps");
+    if (set0.size() == 2U) {
+        check(set0[0].binding == 0U && set0[0].descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER && set0[0].descriptorCount == 1U, "a uniform block is a uniform buffer");
+        check(set0[0].stageFlags == bothStages, "a binding declared by both stages is given both stage flags");
+        check(set0[1].binding == 1U && set0[1].descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER && set0[1].descriptorCount == 4U, "a fixed sampler array keeps its length");
+        check(set0[1].stageFlags == VK_SHADER_STAGE_FRAGMENT_BIT, "a binding of one stage keeps that stage only");
+    }
+
+    std::vector<DescriptorItem> set1 = merged.getDescriptorItems(1U, 16U, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT);
+    check(set1.size() == 2U, "set 1 has the texture array and the storage buffer");
+    if (set1.size() == 2U) {
+        check(set1[0].descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER && set1[0].descriptorCount == 16U, "a runtime sized array is given the runtime array count");
+        check(set1[0].bindingFlags == VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT, "a runtime sized array is given the runtime array flags");
+        check(set1[1].binding == 1U && set1[1].descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER && set1[1].bindingFlags == 0U, "a StorageBuffer block is a storage buffer");
+    }
+
+    std::vector<ReflectedBinding> set2 = merged.getBindings(2U);
+    check(set2.size() == 1U && set2[0].descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, "an image without a sampler is a storage image");
+
+    std::map<VkDescriptorType, uint32_t> poolSizes = merged.getPoolSizes(1U, 3U, 16U);
+    check(poolSizes[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER] == 48U && poolSizes[VK_DESCRIPTOR_TYPE_STORAGE_BUFFER] == 3U, "pool sizes cover every set of the layout");
+
+    std::vector<VkPushConstantRange> ranges = merged.getPushConstantRanges();
+    check(ranges.size() == 1U, "the push constant blocks are merged into a single range");
+    if (ranges.size() == 1U) {
+        check(ranges[0].offset == 0U && ranges[0].size == 68U, "the range covers the push constants of both stages");
+        check(ranges[0].stageFlags == bothStages, "the range is given the stage flags of both stages");
+    }
+}
+
+static void testMalformedModules(const std::vector<uint32_t> &vertexSpirv)
+{
+    std::vector<uint32_t> badMagic = vertexSpirv;
+    badMagic[0] = 0U;
+    checkThrows([&]() { ShaderReflection::reflect(badMagic); }, "a module with the wrong magic number is rejected");
+
+    std::vector<uint32_t> truncated(vertexSpirv.begin(), vertexSpirv.end() - 1);
+    checkThrows([&]() { ShaderReflection::reflect(truncated); }, "a truncated instruction is rejected");
+
+    std::vector<uint32_t> noEntryPoint(vertexSpirv.begin(), vertexSpirv.begin() + 5);
+    checkThrows([&]() { ShaderReflection::reflect(noEntryPoint); }, "a module without an entry point is rejected");
+
+    // A stage that declares the uniform buffer's binding as a storage image cannot share its layout
+    SpirvAssembler spirv;
+    uint32_t main = spirv.id(), floatType = spirv.id(), image = spirv.id(), pointer = spirv.id(), variable = spirv.id();
+    spirv.entryPoint(4U, main, {});
+    spirv.op(TYPE_FLOAT, {floatType, 32U});
+    spirv.op(TYPE_IMAGE, {image, floatType, 1U, 0U, 0U, 0U, 2U, 1U});
+    spirv.op(TYPE_POINTER, {pointer, UNIFORM_CONSTANT, image});
+    spirv.op(VARIABLE, {pointer, variable, UNIFORM_CONSTANT});
+    spirv.bind(variable, 0U, 0U);
+    std::vector<uint32_t> conflictingSpirv = spirv.finish();
+
+    ShaderReflection vertex = ShaderReflection::reflect(vertexSpirv);
+    ShaderReflection conflicting = ShaderReflection::reflect(conflictingSpirv);
+    checkThrows([&]() { vertex.merge(conflicting); }, "merging a binding declared with different types throws");
+}
+
+int main()
+{
+    std::vector<uint32_t> vertexSpirv = assembleVertexStage();
+    std::vector<uint32_t> fragmentSpirv = assembleFragmentStage();
+
+    try {
+        ShaderReflection vertex = ShaderReflection::reflect(vertexSpirv);
+        ShaderReflection fragment = ShaderReflection::reflect(fragmentSpirv);
+        testVertexStage(vertex);
+        testMergedStages(vertex, fragment);
+        testMalformedModules(vertexSpirv);
+    } catch (const std::exception &exception) {
+        std::cerr << "FAILED: " << exception.what() << std::endl;
+        failedChecks++;
+    }
+
+    if (failedChecks > 0U) {
+        std::cerr << failedChecks << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All shader reflection checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,420 @@
+#include "shader-reflection.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+static const uint32_t spirvMagic = 0x07230203U;
+static const uint32_t spirvHeaderWords = 5U;
+
+// The SPIR-V opcodes, decorations and enumerants that reflection reads
+enum SpirvOp : uint32_t {
+    OP_ENTRY_POINT = 15U,
+    OP_TYPE_BOOL = 20U,
+    OP_TYPE_INT = 21U,
+    OP_TYPE_FLOAT = 22U,
+    OP_TYPE_VECTOR = 23U,
+    OP_TYPE_MATRIX = 24U,
+    OP_TYPE_IMAGE = 25U,
+    OP_TYPE_SAMPLER = 26U,
+    OP_TYPE_SAMPLED_IMAGE = 27U,
+    OP_TYPE_ARRAY = 28U,
+    OP_TYPE_RUNTIME_ARRAY = 29U,
+    OP_TYPE_STRUCT = 30U,
+    OP_TYPE_POINTER = 32U,
+    OP_CONSTANT = 43U,
+    OP_SPEC_CONSTANT = 50U,
+    OP_VARIABLE = 59U,
+    OP_DECORATE = 71U,
+    OP_MEMBER_DECORATE = 72U
+};
+
+enum SpirvDecoration : uint32_t {
+    DECORATION_BUFFER_BLOCK = 3U,
+    DECORATION_ARRAY_STRIDE = 6U,
+    DECORATION_MATRIX_STRIDE = 7U,
+    DECORATION_BUILT_IN = 11U,
+    DECORATION_LOCATION = 30U,
+    DECORATION_BINDING = 33U,
+    DECORATION_DESCRIPTOR_SET = 34U,
+    DECORATION_OFFSET = 35U
+};
+
+enum SpirvStorageClass : uint32_t {
+    STORAGE_UNIFORM_CONSTANT = 0U,
+    STORAGE_INPUT = 1U,
+    STORAGE_UNIFORM = 2U,
+    STORAGE_PUSH_CONSTANT = 9U,
+    STORAGE_STORAGE_BUFFER = 12U
+};
+
+static const uint32_t imageDimBuffer = 5U;
+static const uint32_t imageDimSubpassData = 6U;
+static const uint32_t imageSampledStorage = 2U;
+static const uint32_t notDecorated = UINT32_MAX;
+
+/**
+ * What reflection needs to know of a result id, the instruction that defined it and the decorations it was given
+ */
+struct SpirvId {
+    std::span<const uint32_t> instruction = {};
+
+    uint32_t set = notDecorated;
+    uint32_t binding = notDecorated;
+    uint32_t location = notDecorated;
+    uint32_t arrayStride = 0U;
+    bool builtIn = false;
+    bool bufferBlock = false;
+
+    // Struct member decorations, indexed by member
+    std::vector<uint32_t> memberOffsets = {};
+    std::vector<uint32_t> memberMatrixStrides = {};
+
+    uint32_t getOpcode() const { return instruction.empty() ? 0U : instruction[0] & 0xFFFFU; }
+};
+
+class SpirvModule {
+    std::vector<SpirvId> ids;
+
+    public:
+    uint32_t executionModel = UINT32_MAX;
+    std::vector<uint32_t> interfaceIds = {};
+    std::vector<uint32_t> variableIds = {};
+
+    explicit SpirvModule(std::span<const uint32_t> spirv);
+
+    const SpirvId &get(uint32_t id) const
+    {
+        if (id >= ids.size()) throw std::runtime_error("Failed to reflect shader, id " + std::to_string(id) + " is out of bounds");
+        return ids[id];
+    }
+
+    /**
+     * @brief Gets an operand of the instruction that defined an id, checking it exists
+     */
+    uint32_t getOperand(uint32_t id, uint32_t word) const
+    {
+        const SpirvId &spirvId = get(id);
+        if (word >= spirvId.instruction.size()) throw std::runtime_error("Failed to reflect shader, id " + std::to_string(id) + " is missing operands");
+        return spirvId.instruction[word];
+    }
+
+    uint32_t getConstantValue(uint32_t id) const;
+    uint32_t getTypeSize(uint32_t typeId, uint32_t matrixStride) const;
+};
+
+SpirvModule::SpirvModule(std::span<const uint32_t> spirv)
+{
+    if (spirv.size() < spirvHeaderWords || spirv[0] != spirvMagic) throw std::runtime_error("Failed to reflect shader, not a SPIR-V module");
+    ids.resize(spirv[3]);
+
+    auto getDecorated = [this](uint32_t id) -> SpirvId& {
+        if (id >= ids.size()) throw std::runtime_error("Failed to reflect shader, decorated id is out of bounds");
+        return ids[id];
+    };
+
+    for (size_t offset = spirvHeaderWords ; offset < spirv.size() ; ) {
+        uint32_t wordCount = spirv[offset] >> 16U;
+        if (wordCount == 0U || offset + wordCount > spirv.size()) throw std::runtime_error("Failed to reflect shader, truncated instruction");
+        std::span<const uint32_t> instruction = spirv.subspan(offset, wordCount);
+        offset += wordCount;
+
+        uint32_t opcode = instruction[0] & 0xFFFFU;
+        switch (opcode) {
+            case OP_ENTRY_POINT : {
+                // Only the first entry point is reflected, its name is a nul-terminated string padded to whole words
+                if (executionModel != UINT32_MAX || wordCount < 4U) break;
+                executionModel = instruction[1];
+                uint32_t word = 3U;
+                while (word < wordCount && (instruction[word] >> 24U) != 0U) word++;
+                interfaceIds.assign(instruction.begin() + std::min(word + 1U, wordCount), instruction.end());
+                break;
+            }
+            case OP_TYPE_BOOL : case OP_TYPE_INT : case OP_TYPE_FLOAT : case OP_TYPE_VECTOR : case OP_TYPE_MATRIX :
+            case OP_TYPE_IMAGE : case OP_TYPE_SAMPLER : case OP_TYPE_SAMPLED_IMAGE : case OP_TYPE_ARRAY :
+            case OP_TYPE_RUNTIME_ARRAY : case OP_TYPE_STRUCT : case OP_TYPE_POINTER :
+                if (wordCount >= 2U) getDecorated(instruction[1]).instruction = instruction;
+                break;
+            case OP_CONSTANT : case OP_SPEC_CONSTANT : case OP_VARIABLE :
+                if (wordCount < 4U) throw std::runtime_error("Failed to reflect shader, truncated instruction");
+                getDecorated(instruction[2]).instruction = instruction;
+                if (opcode == OP_VARIABLE) variableIds.push_back(instruction[2]);
+                break;
+            case OP_DECORATE : {
+                if (wordCount < 3U) break;
+                SpirvId &target = getDecorated(instruction[1]);
+                uint32_t literal = wordCount > 3U ? instruction[3] : 0U;
+                switch (instruction[2]) {
+                    case DECORATION_DESCRIPTOR_SET : target.set = literal; break;
+                    case DECORATION_BINDING : target.binding = literal; break;
+                    case DECORATION_LOCATION : target.location = literal; break;
+                    case DECORATION_ARRAY_STRIDE : target.arrayStride = literal; break;
+                    case DECORATION_BUILT_IN : target.builtIn = true; break;
+                    case DECORATION_BUFFER_BLOCK : target.bufferBlock = true; break;
+                }
+                break;
+            }
+            case OP_MEMBER_DECORATE : {
+                if (wordCount < 5U) break;
+                SpirvId &target = getDecorated(instruction[1]);
+                uint32_t member = instruction[2];
+                if (member >= target.memberOffsets.size()) {
+                    target.memberOffsets.resize(member + 1U, 0U);
+                    target.memberMatrixStrides.resize(member + 1U, 0U);
+                }
+                if (instruction[3] == DECORATION_OFFSET) target.memberOffsets[member] = instruction[4];
+                if (instruction[3] == DECORATION_MATRIX_STRIDE) target.memberMatrixStrides[member] = instruction[4];
+                if (instruction[3] == DECORATION_BUILT_IN) target.builtIn = true;
+                break;
+            }
+        }
+    }
+    if (executionModel == UINT32_MAX) throw std::runtime_error("Failed to reflect shader, the module has no entry point");
+}
+
+uint32_t SpirvModule::getConstantValue(uint32_t id) const
+{
+    // Arrays sized by a specialization constant are reflected at the constant's default size
+    uint32_t opcode = get(id).getOpcode();
+    if (opcode != OP_CONSTANT && opcode != OP_SPEC_CONSTANT) throw std::runtime_error("Failed to reflect shader, array length is not a constant");
+    return getOperand(id, 3U);
+}
+
+uint32_t SpirvModule::getTypeSize(uint32_t typeId, uint32_t matrixStride) const
+{
+    switch (get(typeId).getOpcode()) {
+        case OP_TYPE_BOOL : return 4U;
+        case OP_TYPE_INT : case OP_TYPE_FLOAT : return getOperand(typeId, 2U) / 8U;
+        case OP_TYPE_VECTOR : return getOperand(typeId, 3U) * getTypeSize(getOperand(typeId, 2U), 0U);
+        case OP_TYPE_MATRIX : {
+            uint32_t columnSize = matrixStride != 0U ? matrixStride : getTypeSize(getOperand(typeId, 2U), 0U);
+            return getOperand(typeId, 3U) * columnSize;
+        }
+        case OP_TYPE_ARRAY : {
+            uint32_t stride = get(typeId).arrayStride;
+            if (stride == 0U) stride = getTypeSize(getOperand(typeId, 2U), matrixStride);
+            return getConstantValue(getOperand(typeId, 3U)) * stride;
+        }
+        case OP_TYPE_RUNTIME_ARRAY : return 0U;
+        case OP_TYPE_STRUCT : {
+            const SpirvId &structId = get(typeId);
+            uint32_t size = 0U;
+            for (uint32_t member = 0U ; member + 2U < structId.instruction.size() ; member++) {
+                uint32_t memberOffset = member < structId.memberOffsets.size() ? structId.memberOffsets[member] : 0U;
+                uint32_t memberMatrixStride = member < structId.memberMatrixStrides.size() ? structId.memberMatrixStrides[member] : 0U;
+                size = std::max(size, memberOffset + getTypeSize(structId.instruction[member + 2U], memberMatrixStride));
+            }
+            return size;
+        }
+        default :
+            throw std::runtime_error("Failed to reflect shader, unsupported type in a block");
+    }
+}
+
+static VkShaderStageFlags getExecutionModelStage(uint32_t executionModel)
+{
+    switch (executionModel) {
+        case 0U : return VK_SHADER_STAGE_VERTEX_BIT;
+        case 1U : return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case 2U : return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case 3U : return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case 4U : return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case 5U : return VK_SHADER_STAGE_COMPUTE_BIT;
+        default :
+            throw std::runtime_error("Failed to reflect shader, unsupported execution model " + std::to_string(executionModel));
+    }
+}
+
+static VkDescriptorType getDescriptorType(const SpirvModule &module, uint32_t typeId, uint32_t storageClass)
+{
+    const SpirvId &type = module.get(typeId);
+    switch (type.getOpcode()) {
+        case OP_TYPE_SAMPLER :
+            return VK_DESCRIPTOR_TYPE_SAMPLER;
+        case OP_TYPE_SAMPLED_IMAGE : {
+            uint32_t imageTypeId = module.getOperand(typeId, 2U);
+            return module.getOperand(imageTypeId, 3U) == imageDimBuffer ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        }
+        case OP_TYPE_IMAGE : {
+            uint32_t dim = module.getOperand(typeId, 3U);
+            bool storage = module.getOperand(typeId, 7U) == imageSampledStorage;
+            if (dim == imageDimSubpassData) return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            if (dim == imageDimBuffer) return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        }
+        case OP_TYPE_STRUCT :
+            // SPIR-V before 1.3 declares storage buffers as uniform blocks decorated BufferBlock
+            if (storageClass == STORAGE_STORAGE_BUFFER || type.bufferBlock) return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        default :
+            throw std::runtime_error("Failed to reflect shader, unsupported descriptor type");
+    }
+}
+
+static VkFormat getVertexInputFormat(const SpirvModule &module, uint32_t typeId)
+{
+    uint32_t componentCount = 1U;
+    if (module.get(typeId).getOpcode() == OP_TYPE_VECTOR) {
+        componentCount = module.getOperand(typeId, 3U);
+        typeId = module.getOperand(typeId, 2U);
+    }
+
+    uint32_t opcode = module.get(typeId).getOpcode();
+    if ((opcode != OP_TYPE_FLOAT && opcode != OP_TYPE_INT) || module.getOperand(typeId, 2U) != 32U || componentCount > 4U) {
+        throw std::runtime_error("Failed to reflect shader, vertex inputs must be 32-bit scalars or vectors");
+    }
+
+    static const VkFormat floatFormats[] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+    static const VkFormat sintFormats[] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+    static const VkFormat uintFormats[] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+    if (opcode == OP_TYPE_FLOAT) return floatFormats[componentCount - 1U];
+    return module.getOperand(typeId, 3U) != 0U ? sintFormats[componentCount - 1U] : uintFormats[componentCount - 1U];
+}
+
+ShaderReflection ShaderReflection::reflect(std::span<const uint32_t> spirv)
+{
+    SpirvModule module(spirv);
+
+    ShaderReflection reflection;
+    reflection.stageFlags = getExecutionModelStage(module.executionModel);
+
+    for (uint32_t variableId : module.variableIds) {
+        const SpirvId &variable = module.get(variableId);
+        uint32_t storageClass = variable.instruction[3];
+        uint32_t pointerTypeId = variable.instruction[1];
+        if (module.get(pointerTypeId).getOpcode() != OP_TYPE_POINTER) throw std::runtime_error("Failed to reflect shader, variable is not a pointer");
+        uint32_t typeId = module.getOperand(pointerTypeId, 3U);
+
+        if (storageClass == STORAGE_UNIFORM_CONSTANT || storageClass == STORAGE_UNIFORM || storageClass == STORAGE_STORAGE_BUFFER) {
+            if (variable.binding == notDecorated) continue;
+
+            // Arrays of descriptors are unwrapped to their element type, runtime sized arrays have no count
+            uint32_t descriptorCount = 1U;
+            while (true) {
+                uint32_t opcode = module.get(typeId).getOpcode();
+                if (opcode == OP_TYPE_ARRAY) {
+                    descriptorCount *= module.getConstantValue(module.getOperand(typeId, 3U));
+                } else if (opcode == OP_TYPE_RUNTIME_ARRAY) {
+                    descriptorCount = 0U;
+                } else {
+                    break;
+                }
+                typeId = module.getOperand(typeId, 2U);
+            }
+
+            uint32_t set = variable.set == notDecorated ? 0U : variable.set;
+            reflection.sets[set][variable.binding] = ReflectedBinding {
+                set, variable.binding, getDescriptorType(module, typeId, storageClass), descriptorCount, reflection.stageFlags
+            };
+        }
+        else if (storageClass == STORAGE_PUSH_CONSTANT) {
+            const SpirvId &block = module.get(typeId);
+            if (block.getOpcode() != OP_TYPE_STRUCT || block.memberOffsets.empty()) continue;
+            reflection.pushConstantBegin = *std::min_element(block.memberOffsets.begin(), block.memberOffsets.end());
+            reflection.pushConstantEnd = module.getTypeSize(typeId, 0U);
+            reflection.pushConstantStageFlags = reflection.stageFlags;
+        }
+        else if (storageClass == STORAGE_INPUT && reflection.stageFlags == VK_SHADER_STAGE_VERTEX_BIT) {
+            // Built in inputs such as gl_VertexIndex are not fed by vertex attributes
+            if (variable.builtIn || module.get(typeId).builtIn) continue;
+            if (variable.location == notDecorated) throw std::runtime_error("Failed to reflect shader, vertex input has no location");
+            reflection.vertexInputs.push_back(ReflectedVertexInput {variable.location, getVertexInputFormat(module, typeId)});
+        }
+    }
+
+    std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [](const ReflectedVertexInput &a, const ReflectedVertexInput &b) {
+        return a.location < b.location;
+    });
+    return reflection;
+}
+
+ShaderReflection &ShaderReflection::merge(const ShaderReflection &other)
+{
+    stageFlags |= other.stageFlags;
+
+    for (const auto &[set, bindings] : other.sets) {
+        for (const auto &[binding, otherBinding] : bindings) {
+            auto existing = sets[set].find(binding);
+            if (existing == sets[set].end()) {
+                sets[set][binding] = otherBinding;
+                continue;
+            }
+            if (existing->second.descriptorType != otherBinding.descriptorType) {
+                throw std::runtime_error("Failed to merge shader stages, set " + std::to_string(set) + " binding " + std::to_string(binding) + " is declared with different types");
+            }
+            existing->second.stageFlags |= otherBinding.stageFlags;
+            if (existing->second.descriptorCount != 0U && otherBinding.descriptorCount != 0U) {
+                existing->second.descriptorCount = std::max(existing->second.descriptorCount, otherBinding.descriptorCount);
+            } else {
+                existing->second.descriptorCount = 0U;
+            }
+        }
+    }
+
+    if (other.pushConstantStageFlags != 0U) {
+        pushConstantBegin = pushConstantStageFlags != 0U ? std::min(pushConstantBegin, other.pushConstantBegin) : other.pushConstantBegin;
+        pushConstantEnd = std::max(pushConstantEnd, other.pushConstantEnd);
+        pushConstantStageFlags |= other.pushConstantStageFlags;
+    }
+
+    vertexInputs.insert(vertexInputs.end(), other.vertexInputs.begin(), other.vertexInputs.end());
+    return *this;
+}
+
+uint32_t ShaderReflection::getSetCount() const
+{
+    return sets.empty() ? 0U : sets.rbegin()->first + 1U;
+}
+
+std::vector<ReflectedBinding> ShaderReflection::getBindings(uint32_t set) const
+{
+    std::vector<ReflectedBinding> bindings = {};
+    auto setBindings = sets.find(set);
+    if (setBindings == sets.end()) return bindings;
+    for (const auto &[binding, reflectedBinding] : setBindings->second) bindings.push_back(reflectedBinding);
+    return bindings;
+}
+
+std::vector<DescriptorItem> ShaderReflection::getDescriptorItems(uint32_t set, uint32_t runtimeArrayCount, VkDescriptorBindingFlags runtimeArrayFlags) const
+{
+    std::vector<DescriptorItem> descriptorItems = {};
+    for (const ReflectedBinding &binding : getBindings(set)) {
+        bool runtimeArray = binding.descriptorCount == 0U;
+        descriptorItems.push_back(DescriptorItem {
+            binding.descriptorType,
+            binding.stageFlags,
+            runtimeArray ? runtimeArrayCount : binding.descriptorCount,
+            runtimeArray ? runtimeArrayFlags : 0U,
+            binding.binding
+        });
+    }
+    return descriptorItems;
+}
+
+std::map<VkDescriptorType, uint32_t> ShaderReflection::getPoolSizes(uint32_t set, uint32_t setCount, uint32_t runtimeArrayCount) const
+{
+    std::map<VkDescriptorType, uint32_t> poolSizes = {};
+    for (const ReflectedBinding &binding : getBindings(set)) {
+        uint32_t descriptorCount = binding.descriptorCount == 0U ? runtimeArrayCount : binding.descriptorCount;
+        poolSizes[binding.descriptorType] += descriptorCount * setCount;
+    }
+    return poolSizes;
+}
+
+std::vector<VkPushConstantRange> ShaderReflection::getPushConstantRanges() const
+{
+    if (pushConstantStageFlags == 0U) return {};
+
+    // Push constant ranges are whole words
+    uint32_t size = (pushConstantEnd - pushConstantBegin + 3U) & ~3U;
+    return {VkPushConstantRange {pushConstantStageFlags, pushConstantBegin, size}};
+}
+
+void ShaderReflection::checkVertexAttributes(const std::vector<VkVertexInputAttributeDescription> &attributes) const
+{
+    for (const ReflectedVertexInput &input : vertexInputs) {
+        bool fed = std::any_of(attributes.begin(), attributes.end(), [&input](const VkVertexInputAttributeDescription &attribute) {
+            return attribute.location == input.location;
+        });
+        if (!fed) throw std::runtime_error("Vertex shader input at location " + std::to_string(input.location) + " is not fed by any vertex attribute");
+    }
+}
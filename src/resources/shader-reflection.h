@@ -0,0 +1,105 @@
+#pragma once
+#include "descriptor-set-layout-resource.h"
+#include <span>
+#include <map>
+#include <vector>
+#include <cstdint>
+
+/**
+ * A descriptor binding declared by one or more shader stages
+ */
+struct ReflectedBinding {
+    uint32_t set;
+    uint32_t binding;
+    VkDescriptorType descriptorType;
+
+    // The number of descriptors in the binding, 0 for a runtime sized array such as textures[]
+    uint32_t descriptorCount;
+
+    VkShaderStageFlags stageFlags;
+};
+
+/**
+ * A vertex shader input, matrices and arrays are not supported as vertex inputs
+ */
+struct ReflectedVertexInput {
+    uint32_t location;
+    VkFormat format;
+};
+
+/**
+ * @class ShaderReflection
+ *
+ * @brief The interface of one or more shader stages, read from their SPIR-V
+ *
+ * Reflects the descriptor bindings of every set, the push constant block and the vertex inputs, so descriptor set
+ * layouts, pool sizes and pipeline layouts are derived from the shaders rather than written to match them by hand.
+ * The stages of a pipeline are reflected one at a time and merged, a binding declared by several stages is given all
+ * of their stage flags.
+ *
+ * @note Dynamic uniform and storage buffers cannot be told apart from plain ones in SPIR-V, they are reflected as
+ * plain buffers.
+ */
+class ShaderReflection {
+    VkShaderStageFlags stageFlags = 0U;
+
+    // Keyed by set, then by binding
+    std::map<uint32_t, std::map<uint32_t, ReflectedBinding>> sets = {};
+
+    // The push constant block's extent in bytes, and the stages that declare it
+    uint32_t pushConstantBegin = 0U;
+    uint32_t pushConstantEnd = 0U;
+    VkShaderStageFlags pushConstantStageFlags = 0U;
+
+    std::vector<ReflectedVertexInput> vertexInputs = {};
+
+    public:
+    /**
+     * @brief Reflects the first entry point of a SPIR-V module, throwing if the module is malformed
+     */
+    static ShaderReflection reflect(std::span<const uint32_t> spirv);
+
+    /**
+     * @brief Merges the interface of another stage of the same pipeline into this one
+     *
+     * Throws if both declare the same binding with different descriptor types.
+     */
+    ShaderReflection &merge(const ShaderReflection &other);
+
+    VkShaderStageFlags getStageFlags() const { return stageFlags; }
+
+    /**
+     * @brief The number of descriptor sets a pipeline layout for the stages needs, one more than the highest set used
+     */
+    uint32_t getSetCount() const;
+
+    std::vector<ReflectedBinding> getBindings(uint32_t set) const;
+
+    /**
+     * @brief Gets the items of a descriptor set layout for one of the sets, each with its binding number
+     *
+     * @param runtimeArrayCount The number of descriptors given to runtime sized arrays, whose count is not in the SPIR-V
+     * @param runtimeArrayFlags The binding flags of runtime sized arrays, such as VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+     */
+    std::vector<DescriptorItem> getDescriptorItems(uint32_t set, uint32_t runtimeArrayCount = 0U, VkDescriptorBindingFlags runtimeArrayFlags = 0U) const;
+
+    /**
+     * @brief Gets the exact number of descriptors of each type needed to allocate a number of sets of one layout
+     */
+    std::map<VkDescriptorType, uint32_t> getPoolSizes(uint32_t set, uint32_t setCount, uint32_t runtimeArrayCount = 0U) const;
+
+    /**
+     * @brief Gets the push constant range, empty if no stage declares push constants
+     *
+     * The range covers the blocks of every stage and is given all of their stage flags, so vkCmdPushConstants must be
+     * passed the same stage flags.
+     */
+    std::vector<VkPushConstantRange> getPushConstantRanges() const;
+
+    std::vector<ReflectedVertexInput> getVertexInputs() const { return vertexInputs; }
+
+    /**
+     * @brief Throws unless every vertex input is fed by one of the attributes
+     */
+    void checkVertexAttributes(const std::vector<VkVertexInputAttributeDescription> &attributes) const;
+};
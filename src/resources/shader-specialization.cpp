@@ -0,0 +1,87 @@
+#include "shader-specialization.h"
+#include <algorithm>
+#include <cstring>
+
+ShaderSpecialization &ShaderSpecialization::setWord(uint32_t constantId, uint32_t word)
+{
+    auto entry = std::lower_bound(mapEntries.begin(), mapEntries.end(), constantId, [](const VkSpecializationMapEntry &mapEntry, uint32_t id) {
+        return mapEntry.constantID < id;
+    });
+    size_t index = entry - mapEntries.begin();
+    if (entry != mapEntries.end() && entry->constantID == constantId) {
+        values[index] = word;
+        return *this;
+    }
+
+    mapEntries.insert(entry, VkSpecializationMapEntry {constantId, 0U, sizeof(uint32_t)});
+    values.insert(values.begin() + index, word);
+
+    // The values are packed in constant id order, so the entries after the inserted one move up a word
+    for (uint32_t i = 0U ; i < mapEntries.size() ; i++) mapEntries[i].offset = i * sizeof(uint32_t);
+    return *this;
+}
+
+ShaderSpecialization &ShaderSpecialization::set(uint32_t constantId, uint32_t value)
+{
+    return setWord(constantId, value);
+}
+
+ShaderSpecialization &ShaderSpecialization::set(uint32_t constantId, int32_t value)
+{
+    return setWord(constantId, static_cast<uint32_t>(value));
+}
+
+ShaderSpecialization &ShaderSpecialization::set(uint32_t constantId, float value)
+{
+    uint32_t word;
+    memcpy(&word, &value, sizeof(uint32_t));
+    return setWord(constantId, word);
+}
+
+ShaderSpecialization &ShaderSpecialization::set(uint32_t constantId, bool value)
+{
+    return setWord(constantId, value ? VK_TRUE : VK_FALSE);
+}
+
+ShaderSpecialization &ShaderSpecialization::setWorkgroupSize(VkExtent2D workgroupSize)
+{
+    setWord(workgroupSizeXConstantId, workgroupSize.width);
+    return setWord(workgroupSizeYConstantId, workgroupSize.height);
+}
+
+VkSpecializationInfo ShaderSpecialization::getInfo() const
+{
+    VkSpecializationInfo info{};
+    info.mapEntryCount = mapEntries.size();
+    info.pMapEntries = mapEntries.data();
+    info.dataSize = values.size() * sizeof(uint32_t);
+    info.pData = values.data();
+    return info;
+}
+
+std::vector<uint32_t> ShaderSpecialization::getKey() const
+{
+    std::vector<uint32_t> key = {};
+    key.reserve(2U * values.size());
+    for (uint32_t i = 0U ; i < values.size() ; i++) {
+        key.push_back(mapEntries[i].constantID);
+        key.push_back(values[i]);
+    }
+    return key;
+}
+
+VkExtent2D ShaderSpecialization::chooseWorkgroupSize(const VkPhysicalDeviceLimits &limits, VkExtent2D preferredSize)
+{
+    VkExtent2D size = {std::max(preferredSize.width, 1U), std::max(preferredSize.height, 1U)};
+    while (size.width > 1U || size.height > 1U) {
+        bool widthFits = size.width <= limits.maxComputeWorkGroupSize[0];
+        bool heightFits = size.height <= limits.maxComputeWorkGroupSize[1];
+        if (widthFits && heightFits && size.width * size.height <= limits.maxComputeWorkGroupInvocations) break;
+
+        // A dimension over its own limit is shrunk first, otherwise the larger one so the workgroup stays square
+        bool shrinkWidth = !widthFits || (heightFits && size.width >= size.height);
+        if (shrinkWidth) size.width = std::max(size.width / 2U, 1U);
+        else size.height = std::max(size.height / 2U, 1U);
+    }
+    return size;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "vulkan/vulkan.hpp"
+#include <vector>
+#include <cstdint>
+
+/**
+ * @class ShaderSpecialization
+ *
+ * @brief The values of a pipeline's specialization constants, which select the permutation its shaders compile to
+ *
+ * Specialization constants are folded into the shaders when the pipeline is compiled, so branches on them are removed
+ * and loops over them are unrolled, at no cost per draw. A stage ignores the constants it does not declare, so one
+ * specialization is given to every stage of a pipeline.
+ *
+ * Every constant is 32 bits wide, bools are stored as VkBool32. Compute shaders declare their workgroup size with
+ * local_size_x_id = 0 and local_size_y_id = 1 (see setWorkgroupSize).
+ */
+class ShaderSpecialization {
+    // Sorted by constant id, so equal specializations have equal keys whatever order their constants were set in
+    std::vector<VkSpecializationMapEntry> mapEntries = {};
+    std::vector<uint32_t> values = {};
+
+    ShaderSpecialization &setWord(uint32_t constantId, uint32_t word);
+
+    public:
+    static const uint32_t workgroupSizeXConstantId = 0U;
+    static const uint32_t workgroupSizeYConstantId = 1U;
+
+    ShaderSpecialization &set(uint32_t constantId, uint32_t value);
+    ShaderSpecialization &set(uint32_t constantId, int32_t value);
+    ShaderSpecialization &set(uint32_t constantId, float value);
+    ShaderSpecialization &set(uint32_t constantId, bool value);
+
+    ShaderSpecialization &setWorkgroupSize(VkExtent2D workgroupSize);
+
+    /**
+     * @brief Gets the specialization info for the pipeline's shader stages, which points into this object and is only
+     * valid while it is alive and unchanged
+     */
+    VkSpecializationInfo getInfo() const;
+
+    /**
+     * @brief Gets the constant ids and values as a flat list, equal only for specializations that compile alike
+     */
+    std::vector<uint32_t> getKey() const;
+
+    /**
+     * @brief Shrinks a 2D workgroup size until the device can dispatch it
+     *
+     * The larger dimension is halved until both fit maxComputeWorkGroupSize and their product fits
+     * maxComputeWorkGroupInvocations, which is as low as 128 on some devices.
+     */
+    static VkExtent2D chooseWorkgroupSize(const VkPhysicalDeviceLimits &limits, VkExtent2D preferredSize);
+};
@@ -0,0 +1,103 @@
+#include "texture-array-pool.h"
+#include "app-base.h"
+#include "app-config.h"
+#include "descriptor-writer.h"
+#include <algorithm>
+
+void TextureArrayPool::init(AppBase* appBase, AppImageTemplate imageTemplate, uint32_t width, uint32_t height, uint32_t initialLayerCount, VkCommandBuffer commandBuffer)
+{
+    this->appBase = appBase;
+    this->imageTemplate = imageTemplate;
+    this->width = width;
+    this->height = height;
+
+    textureArray = createImageAll(appBase, width, height, imageTemplate, initialLayerCount);
+
+    // Layers that have not been written yet may still be covered by descriptors, so they are made readable up front
+    textureArray.image.transitionLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandBuffer, 0U, initialLayerCount);
+
+    for (uint32_t layer = 0U ; layer < initialLayerCount ; layer++) freeLayers.insert(layer);
+}
+
+uint32_t TextureArrayPool::allocateLayer(VkCommandBuffer commandBuffer)
+{
+    if (freeLayers.empty()) grow(commandBuffer);
+
+    uint32_t layer = *freeLayers.begin();
+    freeLayers.erase(freeLayers.begin());
+
+    stats.allocatedLayers++;
+    stats.peakAllocatedLayers = std::max(stats.peakAllocatedLayers, stats.allocatedLayers);
+    return layer;
+}
+
+void TextureArrayPool::freeLayer(uint32_t layer)
+{
+    if (layer >= getLayerCount()) throw std::runtime_error("Attempted to free a layer outside of the texture array");
+    pendingFrees.push_back(PendingFree{layer, frameIndex});
+    stats.allocatedLayers--;
+}
+
+void TextureArrayPool::grow(VkCommandBuffer commandBuffer)
+{
+    uint32_t oldLayerCount = getLayerCount();
+    uint32_t newLayerCount = std::max(oldLayerCount * growthFactor, oldLayerCount + 1U);
+
+    AppImageBundle newArray = createImageAll(appBase, width, height, imageTemplate, newLayerCount);
+
+    // Copy every layer, free ones included, so that each layer keeps its index (and its layout) in the new array
+    textureArray.image.transitionLayout(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, commandBuffer, 0U, oldLayerCount);
+    newArray.image.transitionLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, commandBuffer, 0U, newLayerCount);
+    AppImage::copyImage(textureArray.image, newArray.image, commandBuffer, 0U, 0U, oldLayerCount);
+    newArray.image.transitionLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandBuffer, 0U, newLayerCount);
+
+    /**
+     * The copy waits for the device to become idle, so no command buffer is pending that still uses the descriptors
+     * or the old array. The descriptors can be rewritten and the old array destroyed straight away.
+     */
+    DescriptorWriter descriptorWriter(appBase);
+    for (const DescriptorBinding &descriptorBinding : descriptorBindings) {
+        descriptorWriter.writeImage(descriptorBinding.set, descriptorBinding.binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, newArray.imageView,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, descriptorBinding.sampler, descriptorBinding.arrayElement);
+    }
+    descriptorWriter.flush();
+
+    textureArray.imageView.destroy();
+    textureArray.image.destroy();
+    textureArray.deviceMemory.destroy();
+    textureArray = newArray;
+
+    for (uint32_t layer = oldLayerCount ; layer < newLayerCount ; layer++) freeLayers.insert(layer);
+    stats.growthCount++;
+}
+
+void TextureArrayPool::bindDescriptor(VkDescriptorSet set, uint32_t binding, AppSampler sampler, uint32_t arrayElement, DescriptorWriter* descriptorWriter)
+{
+    descriptorBindings.push_back(DescriptorBinding{set, binding, arrayElement, sampler});
+    if (descriptorWriter == nullptr) {
+        updateDescriptor(textureArray.imageView, set, binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sampler, arrayElement);
+        return;
+    }
+    descriptorWriter->writeImage(set, binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, textureArray.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sampler, arrayElement);
+}
+
+void TextureArrayPool::onFrameComplete()
+{
+    frameIndex++;
+
+    // A layer released on frame N may be sampled by command buffers up to frame N + maxFramesInFlight
+    while (!pendingFrees.empty() && pendingFrees.front().releasedOnFrame + maxFramesInFlight <= frameIndex) {
+        freeLayers.insert(pendingFrees.front().layer);
+        pendingFrees.pop_front();
+    }
+}
+
+void TextureArrayPool::destroy()
+{
+    textureArray.imageView.destroy();
+    textureArray.image.destroy();
+    textureArray.deviceMemory.destroy();
+    freeLayers.clear();
+    pendingFrees.clear();
+    descriptorBindings.clear();
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include "resource-utilities.h"
+#include <list>
+#include <set>
+
+struct TextureArrayPoolStats {
+    uint32_t growthCount = 0U;
+    uint32_t allocatedLayers = 0U;
+    uint32_t peakAllocatedLayers = 0U;
+};
+
+/**
+ * @class TextureArrayPool
+ *
+ * @brief Hands out the layers of a texture array of one format and size class, growing the array when it is full
+ *
+ * Growing creates a larger array, copies every existing layer (with its mip chain) into the same layer of the new
+ * array and rewrites the bound descriptors to the new view, so layer indices held by materials remain valid.
+ *
+ * Every layer is kept in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL between operations, whether or not it holds a texture.
+ *
+ * @note The pool is not thread safe, callers that allocate from several threads must serialize access
+ */
+class TextureArrayPool {
+    class AppBase* appBase;
+    AppImageTemplate imageTemplate;
+    uint32_t width;
+    uint32_t height;
+    AppImageBundle textureArray;
+
+    // When the array grows, its layer count is multiplied by this factor
+    const uint32_t growthFactor = 2U;
+
+    // Free layers, the lowest is handed out first so that allocated layers stay packed towards the start
+    std::set<uint32_t> freeLayers = {};
+
+    /**
+     * A layer that is no longer referenced by any material, but may still be sampled by frames in flight
+     */
+    struct PendingFree {
+        uint32_t layer;
+        uint64_t releasedOnFrame;
+    };
+    std::list<PendingFree> pendingFrees = {};
+    uint64_t frameIndex = 0U;
+
+    /**
+     * A descriptor that samples the array, it is rewritten whenever the array is replaced
+     */
+    struct DescriptorBinding {
+        VkDescriptorSet set;
+        uint32_t binding;
+        uint32_t arrayElement;
+        AppSampler sampler;
+    };
+    std::vector<DescriptorBinding> descriptorBindings = {};
+
+    TextureArrayPoolStats stats {};
+
+    void grow(VkCommandBuffer commandBuffer);
+
+    public:
+    /**
+     * @brief Creates the texture array
+     *
+     * @param imageTemplate The template of the array, which decides its format and whether it has a mip chain
+     * @param width The width of every texture in the pool
+     * @param height The height of every texture in the pool
+     * @param initialLayerCount The number of layers to create the array with
+     * @param commandBuffer The command buffer used to transition the array's layers
+     */
+    void init(class AppBase* appBase, AppImageTemplate imageTemplate, uint32_t width, uint32_t height, uint32_t initialLayerCount, VkCommandBuffer commandBuffer);
+
+    /**
+     * @brief Reserves a layer, growing the array if no layer is free
+     *
+     * @param commandBuffer The command buffer used to copy the existing layers when the array grows
+     *
+     * @return The index of the reserved layer, it stays the same for as long as the layer is reserved
+     */
+    uint32_t allocateLayer(VkCommandBuffer commandBuffer);
+
+    /**
+     * @brief Releases a layer previously returned by allocateLayer
+     *
+     * @note The layer is returned to the free list once the frames in flight that may sample it have completed
+     */
+    void freeLayer(uint32_t layer);
+
+    /**
+     * @brief Writes the array's view to a descriptor, and keeps that descriptor pointing at the array as it grows
+     * 
+     * @param arrayElement The element to write when the binding is an array of descriptors
+     * @param descriptorWriter Queues the first write in the writer rather than applying it straight away
+     */
+    void bindDescriptor(VkDescriptorSet set, uint32_t binding, AppSampler sampler, uint32_t arrayElement = 0U, class DescriptorWriter* descriptorWriter = nullptr);
+
+    /**
+     * @brief Signals that the oldest frame in flight has completed, returning any layers it may have sampled to the free list
+     *
+     * @note Must be called once per frame, after the in-flight fence has been waited on
+     */
+    void onFrameComplete();
+
+    AppImageBundle& getTextureArray() { return textureArray; }
+    uint32_t getWidth() { return width; }
+    uint32_t getHeight() { return height; }
+    uint32_t getLayerCount() { return textureArray.image.getLayerCount(); }
+    TextureArrayPoolStats getStats() { return stats; }
+
+    void destroy();
+};
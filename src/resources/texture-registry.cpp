@@ -0,0 +1,247 @@
+#include "texture-registry.h"
+#include "image/image-loader.h"
+#include "image/ktx2-file.h"
+#include "file-loader.h"
+#include <chrono>
+#include <algorithm>
+
+void TextureRegistry::init(UploadFunction upload, ReleaseFunction releaseLayer)
+{
+    this->upload = upload;
+    this->releaseLayer = releaseLayer;
+}
+
+void TextureRegistry::enableStreaming(StreamFunction stream, uint32_t mipTailSize)
+{
+    this->stream = stream;
+    this->mipTailSize = mipTailSize;
+}
+
+uint32_t TextureRegistry::getMipTailLevel(uint32_t width, uint32_t height, uint32_t mipTailSize)
+{
+    uint32_t level = 0U;
+    while (std::max(width >> level, height >> level) > mipTailSize && std::max(width >> level, height >> level) > 1U) level++;
+    return level;
+}
+
+uint64_t TextureRegistry::hashContent(const std::vector<char> &data)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (char byte : data) {
+        hash ^= static_cast<uint8_t>(byte);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+KTX2Texture TextureRegistry::loadCompressedTexture(const std::string &filePath, const std::vector<char> &sourceFile, TextureCompression compression)
+{
+    std::string cachePath = filePath + ".ktx2";
+    bool cacheIsCurrent = FileLoader::isCurrent(cachePath, filePath);
+    if (cacheIsCurrent) {
+        KTX2Texture texture = KTX2File::loadFromFile(cachePath);
+        if (texture.format == TextureCompressor::getFormat(compression)) {
+            std::lock_guard<std::mutex> lock(entryMutex);
+            stats.cachedLoads++;
+            return texture;
+        }
+    }
+
+    // A source served from an archive has no directory on disk to write the cache into
+    KTX2Texture texture = TextureCompressor::compressWithMipChain(ImageLoader::loadJPEGFromMemory(sourceFile, 0U), compression);
+    if (!FileLoader::isArchived(filePath)) KTX2File::writeToFile(cachePath, texture);
+
+    std::lock_guard<std::mutex> lock(entryMutex);
+    stats.compressedLoads++;
+    return texture;
+}
+
+KTX2Texture TextureRegistry::loadMipTail(const std::string &filePath, const std::vector<char> &sourceFile, TextureCompression compression)
+{
+    Image header = ImageLoader::loadJPEGHeader(sourceFile);
+    uint32_t tailLevel = getMipTailLevel(header.getWidth(), header.getHeight(), mipTailSize);
+
+    std::string cachePath = filePath + ".ktx2";
+    bool cacheIsCurrent = FileLoader::isCurrent(cachePath, filePath);
+    if (cacheIsCurrent) {
+        KTX2Texture texture = KTX2File::loadMipTailFromFile(cachePath, tailLevel);
+        if (texture.format == TextureCompressor::getFormat(compression) && texture.width == header.getWidth() && texture.height == header.getHeight()) {
+            return texture;
+        }
+    }
+
+    // Decode at the largest power of two reduction turbojpeg supports, up to the size of the tail
+    uint32_t decodeLevel = std::min(tailLevel, 3U);
+    Image scaledImage = ImageLoader::loadJPEGScaledFromMemory(sourceFile, 1U << decodeLevel);
+
+    // Scaled decodes round up while mip levels round down, so odd sizes fall back to a full decode
+    if (scaledImage.getWidth() != std::max(header.getWidth() >> decodeLevel, 1U) || scaledImage.getHeight() != std::max(header.getHeight() >> decodeLevel, 1U)) {
+        decodeLevel = 0U;
+        scaledImage = ImageLoader::loadJPEGScaledFromMemory(sourceFile, 1U);
+    }
+
+    return TextureCompressor::compressMipTail(scaledImage, decodeLevel, tailLevel, header.getWidth(), header.getHeight(), compression);
+}
+
+KTX2Texture TextureRegistry::loadLevels(const std::string &filePath, const std::vector<char> &sourceFile, TextureCompression compression, uint32_t baseLevel)
+{
+    // A current cache stores the finest level last, so only the file's prefix up to baseLevel is read
+    std::string cachePath = filePath + ".ktx2";
+    bool cacheIsCurrent = FileLoader::isCurrent(cachePath, filePath);
+    if (cacheIsCurrent && baseLevel > 0U) {
+        KTX2Texture texture = KTX2File::loadMipTailFromFile(cachePath, baseLevel);
+        if (texture.format == TextureCompressor::getFormat(compression)) {
+            std::lock_guard<std::mutex> lock(entryMutex);
+            stats.cachedLoads++;
+            return texture;
+        }
+    }
+
+    return loadCompressedTexture(filePath, sourceFile, compression);
+}
+
+TextureHandle TextureRegistry::acquire(const std::string &filePath, TextureCompression compression)
+{
+    std::vector<char> sourceFile = FileLoader::loadFile(filePath);
+    if (sourceFile.size() == 0) throw std::runtime_error("Failed to open texture: " + filePath);
+
+    return acquire(filePath, std::move(sourceFile), compression);
+}
+
+TextureHandle TextureRegistry::acquire(const std::string &filePath, std::vector<char> sourceFile, TextureCompression compression)
+{
+    PendingAcquire pending = beginAcquire(filePath, std::move(sourceFile), compression);
+    return finishAcquire(pending);
+}
+
+TextureRegistry::PendingAcquire TextureRegistry::beginAcquire(const std::string &filePath, std::vector<char> sourceFile, TextureCompression compression)
+{
+    PendingAcquire pending {};
+    pending.key = TextureKey {hashContent(sourceFile), sourceFile.size(), compression};
+    {
+        std::lock_guard<std::mutex> lock(entryMutex);
+        stats.requests++;
+
+        auto entry = entries.find(pending.key);
+        if (entry == entries.end()) {
+            // First request for this texture, this request loads it
+            pending.loadResult = std::make_shared<std::promise<TextureLayer>>();
+            entry = entries.emplace(pending.key, Entry{pending.loadResult->get_future().share(), 0U}).first;
+        } else if (entry->second.layer.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            stats.residentHits++;
+        } else {
+            stats.coalescedRequests++;
+        }
+
+        entry->second.referenceCount++;
+        pending.layer = entry->second.layer;
+    }
+    if (pending.loadResult == nullptr) return pending;
+
+    try {
+        // Uncompressed textures are decoded by the upload, straight into the memory the device reads them from
+        if (compression != TextureCompression::NONE) {
+            pending.texture = stream ? loadMipTail(filePath, sourceFile, compression) : loadCompressedTexture(filePath, sourceFile, compression);
+        }
+    }
+    catch (...) {
+        // Forget the failed load so that a later request can retry it, requests waiting on it see the exception
+        {
+            std::lock_guard<std::mutex> lock(entryMutex);
+            entries.erase(pending.key);
+        }
+        pending.loadResult->set_exception(std::current_exception());
+        throw;
+    }
+    pending.filePath = filePath;
+    pending.sourceFile = std::move(sourceFile);
+    return pending;
+}
+
+TextureHandle TextureRegistry::finishAcquire(PendingAcquire &pending)
+{
+    if (pending.loadResult != nullptr) {
+        TextureCompression compression = pending.key.compression;
+        try {
+            TextureLayer uploadedLayer;
+            {
+                std::lock_guard<std::mutex> lock(uploadMutex);
+                uploadedLayer = upload(pending.texture, pending.sourceFile, compression);
+            }
+
+            if (compression == TextureCompression::NONE) {
+                std::lock_guard<std::mutex> lock(entryMutex);
+                stats.uncompressedLoads++;
+            }
+            else if (stream) {
+                std::string filePath = pending.filePath;
+                std::vector<char> sourceFile = std::move(pending.sourceFile);
+                stream(uploadedLayer, pending.texture.baseLevel, [this, filePath, sourceFile, compression](uint32_t baseLevel) {
+                    return loadLevels(filePath, sourceFile, compression, baseLevel);
+                });
+
+                std::lock_guard<std::mutex> lock(entryMutex);
+                stats.mipTailLoads++;
+            }
+            pending.loadResult->set_value(uploadedLayer);
+        }
+        catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(entryMutex);
+                entries.erase(pending.key);
+            }
+            pending.loadResult->set_exception(std::current_exception());
+        }
+        pending.loadResult = nullptr;
+        pending.texture = KTX2Texture {};
+    }
+
+    return TextureHandle {pending.key, pending.layer.get()};
+}
+
+void TextureRegistry::release(const TextureHandle &handle)
+{
+    TextureLayer layer;
+    {
+        std::lock_guard<std::mutex> lock(entryMutex);
+        auto entry = entries.find(handle.key);
+        if (entry == entries.end()) throw std::runtime_error("Failed to release texture, texture is not registered");
+
+        if (--entry->second.referenceCount > 0U) return;
+
+        // A texture with no references cannot still be loading, its loader holds a reference until the load finishes
+        layer = entry->second.layer.get();
+        entries.erase(entry);
+        stats.evictions++;
+    }
+
+    std::lock_guard<std::mutex> lock(uploadMutex);
+    releaseLayer(layer, handle.key.compression);
+}
+
+TextureRegistryStats TextureRegistry::getStats()
+{
+    std::lock_guard<std::mutex> lock(entryMutex);
+    return stats;
+}
+
+uint32_t TextureRegistry::getResidentCount()
+{
+    std::lock_guard<std::mutex> lock(entryMutex);
+    return entries.size();
+}
+
+void TextureRegistry::destroy()
+{
+    std::map<TextureKey, Entry> residentEntries;
+    {
+        std::lock_guard<std::mutex> lock(entryMutex);
+        residentEntries.swap(entries);
+    }
+
+    std::lock_guard<std::mutex> lock(uploadMutex);
+    for (auto &entry : residentEntries) {
+        if (entry.second.layer.wait_for(std::chrono::seconds(0)) != std::future_status::ready) continue;
+        releaseLayer(entry.second.layer.get(), entry.first.compression);
+    }
+}
@@ -0,0 +1,204 @@
+#pragma once
+#include "texture-array-pool.h"
+#include "image/texture-compressor.h"
+#include <functional>
+#include <future>
+#include <mutex>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <chrono>
+
+/**
+ * Where a registered texture resides on the device. The pool's array may be replaced as it grows, but the layer
+ * index stays the same. Textures that own their image (see TextureResidencyManager) have no pool, their layer is
+ * then the texture's residency id.
+ */
+struct TextureLayer {
+    TextureArrayPool* pool = nullptr;
+    uint32_t layer = 0U;
+};
+
+/**
+ * Identifies a texture by the content of its source file and the parameters it is decoded with, so the same
+ * image referenced through different paths (or by different materials) is only decoded and uploaded once
+ */
+struct TextureKey {
+    uint64_t contentHash;
+    uint64_t sourceByteSize;
+    TextureCompression compression;
+
+    bool operator<(const TextureKey &other) const {
+        return std::tie(contentHash, sourceByteSize, compression) < std::tie(other.contentHash, other.sourceByteSize, other.compression);
+    }
+};
+
+/**
+ * A reference to a resident texture, it must be given back to TextureRegistry::release once no longer used
+ */
+struct TextureHandle {
+    TextureKey key;
+    TextureLayer layer;
+};
+
+struct TextureRegistryStats {
+    // Calls to acquire
+    uint32_t requests = 0U;
+    // Requests satisfied by an already resident texture
+    uint32_t residentHits = 0U;
+    // Requests that arrived while the same texture was being loaded, and waited on that load
+    uint32_t coalescedRequests = 0U;
+    // Textures decoded and compressed from their source
+    uint32_t compressedLoads = 0U;
+    // Textures loaded from a compressed cache file
+    uint32_t cachedLoads = 0U;
+    // Textures uploaded uncompressed, straight from their source
+    uint32_t uncompressedLoads = 0U;
+    // Textures first uploaded with only their mip tail, to be streamed
+    uint32_t mipTailLoads = 0U;
+    // Textures released back to their owner once unreferenced
+    uint32_t evictions = 0U;
+};
+
+/**
+ * @class TextureRegistry
+ *
+ * @brief Deduplicates texture decodes and uploads, keyed by the content of the source file
+ *
+ * Textures are reference counted, the first request for a key loads and uploads the texture while any request for
+ * the same key that arrives in the meantime waits on that load instead of starting its own. Acquire may be called
+ * from several threads at once, decoding and compression run in parallel while uploads are serialized.
+ *
+ * Where a texture is placed on the device is decided by the owner of the registry through the upload and release
+ * functions given to init.
+ */
+class TextureRegistry {
+public:
+    // Uploads a texture to the device and returns where it now resides. Uncompressed textures are not decoded by the
+    // registry, their texture is empty and they are uploaded from their source file
+    using UploadFunction = std::function<TextureLayer(const KTX2Texture &texture, const std::vector<char> &sourceFile, TextureCompression compression)>;
+
+    // Frees the device storage of a texture that is no longer referenced
+    using ReleaseFunction = std::function<void(TextureLayer layer, TextureCompression compression)>;
+
+    // Loads the levels of a texture from baseLevel down to 1x1, the returned texture may also hold finer levels
+    using LevelLoadFunction = std::function<KTX2Texture(uint32_t baseLevel)>;
+
+    // Hands a texture whose mip tail was uploaded over to be streamed, loadLevels may be called from any thread
+    using StreamFunction = std::function<void(TextureLayer layer, uint32_t residentLevel, LevelLoadFunction loadLevels)>;
+
+    /**
+     * A request started by beginAcquire. The request that loads a texture holds its decoded texture until
+     * finishAcquire uploads it, requests for a texture that is resident or being loaded only hold its future layer.
+     */
+    struct PendingAcquire {
+        TextureKey key;
+        std::shared_future<TextureLayer> layer;
+
+        // Only set for the request that loads the texture
+        std::shared_ptr<std::promise<TextureLayer>> loadResult = nullptr;
+        KTX2Texture texture {};
+        std::string filePath;
+        std::vector<char> sourceFile = {};
+
+        /**
+         * @brief Whether finishAcquire can be called without blocking
+         */
+        bool isReady() const { return loadResult != nullptr || layer.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+    };
+
+private:
+    struct Entry {
+        std::shared_future<TextureLayer> layer;
+        uint32_t referenceCount = 0U;
+    };
+
+    std::map<TextureKey, Entry> entries = {};
+    std::mutex entryMutex;
+
+    // Uploads share a command buffer and queue, so only one runs at a time
+    std::mutex uploadMutex;
+
+    UploadFunction upload;
+    ReleaseFunction releaseLayer;
+    StreamFunction stream;
+    uint32_t mipTailSize = 0U;
+
+    TextureRegistryStats stats {};
+
+    KTX2Texture loadCompressedTexture(const std::string &filePath, const std::vector<char> &sourceFile, TextureCompression compression);
+    KTX2Texture loadMipTail(const std::string &filePath, const std::vector<char> &sourceFile, TextureCompression compression);
+    KTX2Texture loadLevels(const std::string &filePath, const std::vector<char> &sourceFile, TextureCompression compression, uint32_t baseLevel);
+
+public:
+    void init(UploadFunction upload, ReleaseFunction releaseLayer);
+
+    /**
+     * @brief Makes acquire upload only the mip tail of a texture and hand the rest to a streamer
+     *
+     * The mip tail is read from the start of the compressed cache, or compressed from a scaled (1/2, 1/4 or 1/8) decode
+     * of the source when the cache is stale, either of which is far cheaper than loading the full texture.
+     *
+     * @param stream Receives every texture whose finer levels are missing
+     * @param mipTailSize The largest width or height of the levels uploaded up front
+     */
+    void enableStreaming(StreamFunction stream, uint32_t mipTailSize);
+
+    /**
+     * @brief Gets the level at which a texture's mip tail starts, the largest level that fits within mipTailSize
+     */
+    static uint32_t getMipTailLevel(uint32_t width, uint32_t height, uint32_t mipTailSize);
+
+    /**
+     * @brief Gets a reference to a texture, loading and uploading it only if it is not already resident or loading
+     *
+     * Compressed textures are cached next to their source as <filePath>.ktx2, and the cache is used whenever it is
+     * at least as new as the source. Uncompressed textures are neither cached nor streamed.
+     *
+     * @param filePath The source JPEG file
+     * @param compression The block compression the texture is stored with, or NONE
+     *
+     * @return A handle to the resident texture
+     */
+    TextureHandle acquire(const std::string &filePath, TextureCompression compression);
+
+    /**
+     * @brief Gets a reference to a texture whose source file has already been read
+     */
+    TextureHandle acquire(const std::string &filePath, std::vector<char> sourceFile, TextureCompression compression);
+
+    /**
+     * @brief Performs the part of acquire that runs on the CPU, registering the request and, if it is the first for
+     * its texture, decoding and compressing the texture
+     *
+     * Every pending request must be passed to finishAcquire, including those whose texture is loaded by another
+     * request. Splitting acquire lets the decode run on one thread and the upload on another.
+     */
+    PendingAcquire beginAcquire(const std::string &filePath, std::vector<char> sourceFile, TextureCompression compression);
+
+    /**
+     * @brief Uploads the texture of the request that loads it, or waits for the request that does
+     *
+     * @return A handle to the resident texture
+     */
+    TextureHandle finishAcquire(PendingAcquire &pending);
+
+    /**
+     * @brief Drops a reference to a texture, releasing its device storage once no references remain
+     */
+    void release(const TextureHandle &handle);
+
+    /**
+     * @brief Hashes the content of a file (64-bit FNV-1a)
+     */
+    static uint64_t hashContent(const std::vector<char> &data);
+
+    TextureRegistryStats getStats();
+
+    uint32_t getResidentCount();
+
+    /**
+     * @brief Releases every resident texture, regardless of its references
+     */
+    void destroy();
+};
@@ -0,0 +1,444 @@
+#include "texture-residency-manager.h"
+#include "app-base.h"
+#include "app-config.h"
+#include "descriptor-writer.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+void TextureResidencyManager::init(AppBase* appBase, BindlessTextureTable* textureTable, AppSampler sampler, uint32_t maxTextureCount, TextureResidencyBudget budget)
+{
+    if (!appBase->logicalDevice.supportsDescriptorIndexing() || !appBase->logicalDevice.supportsFragmentStores()) {
+        throw std::runtime_error("Failed to create texture residency manager, the device does not support descriptor indexing and fragment stores");
+    }
+
+    this->appBase = appBase;
+    this->textureTable = textureTable;
+    this->sampler = sampler;
+    this->budget = budget;
+
+    residencyIds.init(maxTextureCount);
+
+    feedbackSetLayout.init(appBase, {
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT}
+    });
+    feedbackDescriptorPool.init(appBase, maxFramesInFlight, {
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxFramesInFlight}
+    });
+
+    // Each frame in flight writes its own buffer, so a buffer is only read back once the frame that wrote it has completed
+    uint32_t feedbackByteSize = maxTextureCount * sizeof(uint32_t);
+    DescriptorWriter descriptorWriter(appBase);
+    for (uint32_t frame = 0U ; frame < maxFramesInFlight ; frame++) {
+        feedbackBuffers.push_back(createBufferAll(appBase, AppBufferTemplate::STORAGE_BUFFER, feedbackByteSize));
+        memset(feedbackBuffers[frame].deviceMemory.getMappedData(), 0xFF, feedbackByteSize);
+
+        feedbackSets.push_back(feedbackDescriptorPool.allocateDescriptorSet(&feedbackSetLayout));
+        descriptorWriter.writeBuffer(feedbackSets[frame], feedbackBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, feedbackBuffers[frame].buffer, feedbackByteSize);
+    }
+    descriptorWriter.flush();
+}
+
+uint64_t TextureResidencyManager::getLevelByteSize(const ResidentTexture &texture, uint32_t level)
+{
+    return KTX2File::getLevelByteSize(texture.format, std::max(texture.width >> level, 1U), std::max(texture.height >> level, 1U));
+}
+
+uint32_t TextureResidencyManager::addTexture(const KTX2Texture &mipTail, AppImageTemplate imageTemplate, VkCommandBuffer commandBuffer)
+{
+    if (mipTail.levels.empty()) throw std::runtime_error("Failed to add texture to residency manager, the texture has no levels");
+
+    std::lock_guard<std::mutex> lock(textureMutex);
+    uint32_t residencyId = residencyIds.allocate();
+
+    ResidentTexture &texture = textures[residencyId];
+    texture.imageTemplate = imageTemplate;
+    texture.format = mipTail.format;
+    texture.width = mipTail.width;
+    texture.height = mipTail.height;
+    texture.tailLevel = mipTail.baseLevel;
+    texture.requestedLevel = mipTail.baseLevel;
+    texture.lastRequestedFrame = frameIndex;
+    texture.lastFullyUsedFrame = frameIndex;
+
+    // No level is resident until the mip tail is uploaded
+    texture.residentLevel = AppImage::getFullMipLevelCount(texture.width, texture.height);
+
+    try {
+        texture.textureSlot = textureTable->allocateTextureSlot();
+    }
+    catch (...) {
+        textures.erase(residencyId);
+        residencyIds.free(residencyId, frameIndex);
+        throw;
+    }
+
+    try {
+        setResidentLevel(texture, mipTail.baseLevel, &mipTail, commandBuffer);
+    }
+    catch (...) {
+        textureTable->freeTextureSlot(texture.textureSlot);
+        textures.erase(residencyId);
+        residencyIds.free(residencyId, frameIndex);
+        throw;
+    }
+    return residencyId;
+}
+
+void TextureResidencyManager::setLoader(uint32_t residencyId, LoadFunction load)
+{
+    std::lock_guard<std::mutex> lock(textureMutex);
+    auto texture = textures.find(residencyId);
+    if (texture == textures.end()) throw std::runtime_error("Failed to set texture loader, the texture is not managed");
+    texture->second.load = load;
+}
+
+void TextureResidencyManager::removeTexture(uint32_t residencyId)
+{
+    std::lock_guard<std::mutex> lock(textureMutex);
+    auto texture = textures.find(residencyId);
+    if (texture == textures.end()) throw std::runtime_error("Failed to remove texture, the texture is not managed");
+
+    // The load's future does not wait for the job, so removal never blocks
+    textureTable->freeTextureSlot(texture->second.textureSlot);
+    residentBytes -= texture->second.image.deviceMemory.getSize();
+    retiredImages.push_back(RetiredImage{texture->second.image, frameIndex});
+
+    textures.erase(texture);
+    residencyIds.free(residencyId, frameIndex);
+}
+
+void TextureResidencyManager::setResidentLevel(ResidentTexture &texture, uint32_t newLevel, const KTX2Texture* levels, VkCommandBuffer commandBuffer)
+{
+    uint32_t levelCount = AppImage::getFullMipLevelCount(texture.width, texture.height);
+    newLevel = std::min(newLevel, levelCount - 1U);
+    if (newLevel == texture.residentLevel) return;
+
+    // The levels the current image does not hold must be in the loaded texture
+    bool hasImage = texture.residentLevel < levelCount;
+    uint32_t uploadEnd = std::min(texture.residentLevel, levelCount);
+    if (newLevel < uploadEnd && (levels == nullptr || levels->baseLevel > newLevel || levels->baseLevel + levels->levels.size() < uploadEnd)) {
+        throw std::runtime_error("Failed to make texture levels resident, the levels have not been loaded");
+    }
+
+    uint32_t width = std::max(texture.width >> newLevel, 1U);
+    uint32_t height = std::max(texture.height >> newLevel, 1U);
+
+    AppImageBundle newImage {};
+    newImage.image.init(appBase, texture.imageTemplate, height, width, 1U);
+    newImage.deviceMemory.init(appBase, newImage.image);
+    newImage.image.bindToMemory(&newImage.deviceMemory);
+
+    // Shaders sample every bindless texture as an array, so the single layer is viewed as one
+    newImage.imageView.init(appBase, newImage.image, VK_IMAGE_VIEW_TYPE_2D_ARRAY);
+
+    // The levels both images hold are copied on the device rather than loaded again
+    if (hasImage) {
+        uint32_t sharedLevel = std::max(newLevel, texture.residentLevel);
+        texture.image.image.transitionLayout(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, commandBuffer);
+        newImage.image.transitionLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, commandBuffer);
+        AppImage::copyImage(texture.image.image, newImage.image, commandBuffer, 0U, 0U, 1U, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_ASPECT_COLOR_BIT, sharedLevel - texture.residentLevel, sharedLevel - newLevel);
+    }
+    newImage.image.transitionLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandBuffer);
+
+    if (newLevel < uploadEnd) {
+        KTX2Texture uploadedLevels;
+        uploadedLevels.format = texture.format;
+        uploadedLevels.width = width;
+        uploadedLevels.height = height;
+        for (uint32_t level = newLevel ; level < uploadEnd ; level++) {
+            uploadedLevels.levels.push_back(levels->levels[level - levels->baseLevel]);
+            stats.loadedBytes += uploadedLevels.levels.back().size();
+        }
+        loadKTX2Image(appBase, uploadedLevels, newImage.image, commandBuffer, 0U);
+        stats.loadedLevels += uploadEnd - newLevel;
+    }
+
+    for (uint32_t level = texture.residentLevel ; level < newLevel ; level++) {
+        stats.evictedLevels++;
+        stats.evictedBytes += getLevelByteSize(texture, level);
+    }
+
+    textureTable->writeTexture(texture.textureSlot, newImage.imageView, sampler);
+
+    // Frames in flight may still sample the old image through the slot, it is destroyed once they have completed
+    if (hasImage) {
+        residentBytes -= texture.image.deviceMemory.getSize();
+        retiredImages.push_back(RetiredImage{texture.image, frameIndex});
+    }
+
+    texture.image = newImage;
+    texture.residentLevel = newLevel;
+    residentBytes += newImage.deviceMemory.getSize();
+    residencyChanged = true;
+}
+
+uint64_t TextureResidencyManager::queryBudget()
+{
+    stats.usesHeapBudget = appBase->logicalDevice.supportsMemoryBudget();
+    if (!stats.usesHeapBudget) return budget.maxResidentBytes;
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT memoryBudget{};
+    memoryBudget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    memoryBudget.pNext = nullptr;
+    VkPhysicalDeviceMemoryProperties2 memoryProperties{};
+    memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memoryProperties.pNext = &memoryBudget;
+    vkGetPhysicalDeviceMemoryProperties2(appBase->getPhysicalDevice(), &memoryProperties);
+
+    uint64_t heapBudget = 0U;
+    uint64_t heapUsage = 0U;
+    for (uint32_t heap = 0U ; heap < memoryProperties.memoryProperties.memoryHeapCount ; heap++) {
+        if (!(memoryProperties.memoryProperties.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) continue;
+        heapBudget += memoryBudget.heapBudget[heap];
+        heapUsage += memoryBudget.heapUsage[heap];
+    }
+
+    // The heaps' usage includes the resident textures, the rest is taken by other allocations of this and other processes
+    uint64_t otherUsage = heapUsage > residentBytes ? heapUsage - residentBytes : 0U;
+    uint64_t availableBytes = heapBudget > otherUsage ? heapBudget - otherUsage : 0U;
+    uint64_t textureShare = static_cast<uint64_t>(heapBudget * budget.heapBudgetFraction);
+
+    return std::min({budget.maxResidentBytes, availableBytes, textureShare});
+}
+
+void TextureResidencyManager::readFeedback()
+{
+    uint32_t* requestedLevels = static_cast<uint32_t*>(feedbackBuffers[feedbackIndex].deviceMemory.getMappedData());
+
+    stats.requestedTextures = 0U;
+    stats.starvedTextures = 0U;
+    for (auto &entry : textures) {
+        uint32_t requestedLevel = requestedLevels[entry.first];
+        if (requestedLevel == noFeedback) continue;
+
+        // Levels coarser than the mip tail are always resident
+        ResidentTexture &texture = entry.second;
+        texture.requestedLevel = std::min(requestedLevel, texture.tailLevel);
+        texture.lastRequestedFrame = frameIndex;
+        if (texture.requestedLevel <= texture.residentLevel) texture.lastFullyUsedFrame = frameIndex;
+
+        stats.requestedTextures++;
+        if (texture.requestedLevel < texture.residentLevel) stats.starvedTextures++;
+    }
+
+    // The buffer is host coherent, so the reset is visible to the next frame that writes it without a flush
+    memset(requestedLevels, 0xFF, residencyIds.getCapacity() * sizeof(uint32_t));
+}
+
+uint64_t TextureResidencyManager::evict(uint64_t bytesNeeded, uint64_t lastRequestedBefore, uint32_t excludedId, VkCommandBuffer commandBuffer)
+{
+    // Least recently requested first
+    std::vector<std::pair<uint64_t, uint32_t>> candidates = {};
+    for (auto &entry : textures) {
+        const ResidentTexture &texture = entry.second;
+        if (entry.first == excludedId || texture.residentLevel >= texture.tailLevel || texture.lastRequestedFrame >= lastRequestedBefore) continue;
+        candidates.push_back({texture.lastRequestedFrame, entry.first});
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    uint64_t freedBytes = 0U;
+    for (const auto &candidate : candidates) {
+        if (freedBytes >= bytesNeeded) break;
+
+        // Drop as many levels of this texture as are needed, in a single replacement of its image
+        ResidentTexture &texture = textures[candidate.second];
+        uint32_t level = texture.residentLevel;
+        while (freedBytes < bytesNeeded && level < texture.tailLevel) {
+            freedBytes += getLevelByteSize(texture, level);
+            level++;
+        }
+        setResidentLevel(texture, level, nullptr, commandBuffer);
+    }
+    return freedBytes;
+}
+
+void TextureResidencyManager::shedUnusedLevels(VkCommandBuffer commandBuffer)
+{
+    for (auto &entry : textures) {
+        ResidentTexture &texture = entry.second;
+        if (texture.residentLevel >= texture.tailLevel || texture.lastFullyUsedFrame + budget.evictionDelayFrames >= frameIndex) continue;
+
+        // Textures that are still sampled keep the levels they are sampled at, the others fall back to their mip tail
+        bool isRequested = texture.lastRequestedFrame + budget.evictionDelayFrames >= frameIndex;
+        setResidentLevel(texture, isRequested ? texture.requestedLevel : texture.tailLevel, nullptr, commandBuffer);
+    }
+}
+
+void TextureResidencyManager::applyLoads(uint64_t budgetBytes, VkCommandBuffer commandBuffer)
+{
+    for (auto &entry : textures) {
+        ResidentTexture &texture = entry.second;
+        if (!texture.pendingLoad.valid() || texture.pendingLoad.wait_for(std::chrono::seconds(0)) != std::future_status::ready) continue;
+
+        KTX2Texture levels;
+        try {
+            levels = texture.pendingLoad.get();
+            if (levels.format != texture.format || levels.width != texture.width || levels.height != texture.height) {
+                throw std::runtime_error("the loaded levels do not match the texture");
+            }
+        }
+        catch (const std::exception &exception) {
+            // The texture keeps the levels it has, and is not loaded again
+            std::cerr << "Failed to load texture levels: " << exception.what() << std::endl;
+            texture.load = nullptr;
+            stats.failedLoads++;
+            continue;
+        }
+
+        // Feedback may have moved on while the levels were loading
+        uint32_t targetLevel = std::max(texture.requestedLevel, levels.baseLevel);
+        if (targetLevel >= texture.residentLevel) continue;
+
+        // Make room by dropping levels of textures requested less recently than this one
+        uint64_t neededBytes = 0U;
+        for (uint32_t level = targetLevel ; level < texture.residentLevel ; level++) neededBytes += getLevelByteSize(texture, level);
+        if (residentBytes + neededBytes > budgetBytes) {
+            evict(residentBytes + neededBytes - budgetBytes, texture.lastRequestedFrame, entry.first, commandBuffer);
+        }
+
+        // If that is not enough, load only the levels that fit
+        while (targetLevel < texture.residentLevel && residentBytes + neededBytes > budgetBytes) {
+            neededBytes -= getLevelByteSize(texture, targetLevel);
+            targetLevel++;
+        }
+        if (targetLevel > texture.requestedLevel) texture.retryFrame = frameIndex + budget.evictionDelayFrames;
+
+        if (targetLevel < texture.residentLevel) setResidentLevel(texture, targetLevel, &levels, commandBuffer);
+    }
+}
+
+void TextureResidencyManager::startLoads()
+{
+    uint32_t activeLoads = 0U;
+    std::vector<std::pair<uint64_t, uint32_t>> candidates = {};
+    for (auto &entry : textures) {
+        ResidentTexture &texture = entry.second;
+        if (texture.pendingLoad.valid()) {
+            activeLoads++;
+            continue;
+        }
+
+        bool isStarved = texture.requestedLevel < texture.residentLevel && texture.lastRequestedFrame + budget.evictionDelayFrames >= frameIndex;
+        if (isStarved && texture.load && texture.retryFrame <= frameIndex) candidates.push_back({texture.lastRequestedFrame, entry.first});
+    }
+
+    // Most recently requested first
+    std::sort(candidates.rbegin(), candidates.rend());
+    for (const auto &candidate : candidates) {
+        if (activeLoads >= budget.maxConcurrentLoads) break;
+
+        ResidentTexture &texture = textures[candidate.second];
+        LoadFunction load = texture.load;
+        uint32_t requestedLevel = texture.requestedLevel;
+        texture.pendingLoad = JobSystem::shared().runAsync([load, requestedLevel]() { return load(requestedLevel); }, &loadJobs);
+        activeLoads++;
+    }
+}
+
+void TextureResidencyManager::onFrameComplete()
+{
+    std::lock_guard<std::mutex> lock(textureMutex);
+    frameIndex++;
+    feedbackIndex = frameIndex % feedbackBuffers.size();
+    residencyIds.onFrameComplete(frameIndex);
+
+    // An image retired on frame N may be sampled by command buffers up to frame N + maxFramesInFlight
+    while (!retiredImages.empty() && retiredImages.front().retiredOnFrame + maxFramesInFlight <= frameIndex) {
+        retiredImages.front().image.imageView.destroy();
+        retiredImages.front().image.image.destroy();
+        retiredImages.front().image.deviceMemory.destroy();
+        retiredImages.pop_front();
+    }
+}
+
+bool TextureResidencyManager::update(VkCommandBuffer commandBuffer)
+{
+    std::lock_guard<std::mutex> lock(textureMutex);
+    residencyChanged = false;
+
+    readFeedback();
+    uint64_t budgetBytes = queryBudget();
+    stats.budgetBytes = budgetBytes;
+
+    shedUnusedLevels(commandBuffer);
+
+    // The budget may have shrunk, for example when another process allocated memory
+    if (residentBytes > budgetBytes) evict(residentBytes - budgetBytes, UINT64_MAX, noFeedback, commandBuffer);
+
+    applyLoads(budgetBytes, commandBuffer);
+    startLoads();
+
+    return residencyChanged;
+}
+
+void TextureResidencyManager::writeFeedbackBarrier(VkCommandBuffer commandBuffer)
+{
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0U, 1U, &barrier, 0U, nullptr, 0U, nullptr);
+}
+
+uint32_t TextureResidencyManager::getTextureSlot(uint32_t residencyId)
+{
+    std::lock_guard<std::mutex> lock(textureMutex);
+    auto texture = textures.find(residencyId);
+    if (texture == textures.end()) throw std::runtime_error("Failed to get texture slot, the texture is not managed");
+    return texture->second.textureSlot;
+}
+
+uint32_t TextureResidencyManager::getResidentLevel(uint32_t residencyId)
+{
+    std::lock_guard<std::mutex> lock(textureMutex);
+    auto texture = textures.find(residencyId);
+    if (texture == textures.end()) throw std::runtime_error("Failed to get resident level, the texture is not managed");
+    return texture->second.residentLevel;
+}
+
+TextureResidencyStats TextureResidencyManager::getStats()
+{
+    std::lock_guard<std::mutex> lock(textureMutex);
+    stats.residentTextures = textures.size();
+    stats.residentBytes = residentBytes;
+    stats.pendingLoads = 0U;
+    for (const auto &entry : textures) {
+        if (entry.second.pendingLoad.valid()) stats.pendingLoads++;
+    }
+    return stats;
+}
+
+void TextureResidencyManager::destroy()
+{
+    // Waited on outside the lock, the thread runs other jobs meanwhile and those may add textures. The loads' exceptions
+    // are held by their futures, so waiting never throws
+    JobSystem::shared().wait(loadJobs);
+
+    std::lock_guard<std::mutex> lock(textureMutex);
+    for (auto &entry : textures) {
+        entry.second.image.imageView.destroy();
+        entry.second.image.image.destroy();
+        entry.second.image.deviceMemory.destroy();
+    }
+    textures.clear();
+
+    for (RetiredImage &retiredImage : retiredImages) {
+        retiredImage.image.imageView.destroy();
+        retiredImage.image.image.destroy();
+        retiredImage.image.deviceMemory.destroy();
+    }
+    retiredImages.clear();
+
+    for (AppBufferBundle &feedbackBuffer : feedbackBuffers) {
+        feedbackBuffer.buffer.destroy();
+        feedbackBuffer.deviceMemory.destroy();
+    }
+    feedbackBuffers.clear();
+    feedbackSets.clear();
+    feedbackDescriptorPool.destroy();
+    feedbackSetLayout.destroy();
+    residentBytes = 0U;
+}
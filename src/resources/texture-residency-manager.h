@@ -0,0 +1,225 @@
+#pragma once
+#include "bindless-texture-table.h"
+#include "job-system.h"
+#include <functional>
+#include <future>
+#include <mutex>
+#include <list>
+#include <map>
+
+struct TextureResidencyBudget {
+    // The most device memory resident textures may occupy, lowered to what the device reports as available when it supports VK_EXT_memory_budget
+    uint64_t maxResidentBytes = 256U * 1024U * 1024U;
+
+    // The share of the device-local heaps' budget that textures may take, leaving the rest to other allocations
+    float heapBudgetFraction = 0.5f;
+
+    // The number of textures whose levels may be loaded at once
+    uint32_t maxConcurrentLoads = 2U;
+
+    // The number of frames a texture keeps levels that feedback no longer requests, unless memory is needed sooner
+    uint32_t evictionDelayFrames = 120U;
+};
+
+struct TextureResidencyStats {
+    uint32_t residentTextures = 0U;
+    uint64_t residentBytes = 0U;
+    uint64_t budgetBytes = 0U;
+
+    // Textures whose levels were requested by the last feedback read back
+    uint32_t requestedTextures = 0U;
+    // Textures sampled at a finer level than they hold by the last feedback read back
+    uint32_t starvedTextures = 0U;
+    uint32_t pendingLoads = 0U;
+
+    uint32_t loadedLevels = 0U;
+    uint64_t loadedBytes = 0U;
+    uint32_t evictedLevels = 0U;
+    uint64_t evictedBytes = 0U;
+    uint32_t failedLoads = 0U;
+
+    // Whether budgetBytes accounts for the heap budget reported through VK_EXT_memory_budget
+    bool usesHeapBudget = false;
+};
+
+/**
+ * @class TextureResidencyManager
+ *
+ * @brief Keeps the mip levels of textures resident according to the levels the fragment shader samples, within a memory budget
+ *
+ * Each texture owns an image that holds only its resident levels, from its resident level down to 1x1, so dropping
+ * levels frees their memory. The image is sampled through its own slot of the bindless texture table, viewed as a
+ * single layer array. Whenever the resident level changes the image is replaced by one of the new size, the levels
+ * both images hold are copied over on the device and the slot is rewritten.
+ *
+ * Fragment shaders atomically write the finest level they sample each texture at into a feedback buffer, indexed by the
+ * texture's residency id. There is one feedback buffer per frame in flight, read back once the frame that wrote it has
+ * completed. Textures sampled finer than they are resident have the missing levels loaded in the background (at most
+ * maxConcurrentLoads at a time), textures whose finer levels are no longer sampled drop them after evictionDelayFrames,
+ * and when the resident levels would exceed the budget the least recently sampled textures drop levels first. Every
+ * texture keeps its mip tail, the levels it was added with.
+ *
+ * @note Requires AppDevice::supportsDescriptorIndexing and AppDevice::supportsFragmentStores
+ */
+class TextureResidencyManager {
+    public:
+    // Loads the levels of a texture from baseLevel down to 1x1, called as a job on JobSystem::shared
+    using LoadFunction = std::function<KTX2Texture(uint32_t baseLevel)>;
+
+    static const uint32_t feedbackBinding = 0U;
+
+    // The feedback id of textures that are not managed, shaders skip writing feedback for them
+    static const uint32_t noFeedback = 0xFFFFFFFFU;
+
+    private:
+    class AppBase* appBase;
+    BindlessTextureTable* textureTable;
+    AppSampler sampler;
+    TextureResidencyBudget budget;
+
+    struct ResidentTexture {
+        AppImageTemplate imageTemplate;
+        // The texture's KTX2 format, which its loaded levels must match
+        uint32_t format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t tailLevel;
+
+        // The image holds the texture's levels from residentLevel down to 1x1
+        AppImageBundle image;
+        uint32_t residentLevel;
+        uint32_t textureSlot;
+
+        // The finest level feedback requested, the frame of the last feedback that requested any level and the
+        // frame of the last feedback that requested the resident level or a finer one
+        uint32_t requestedLevel;
+        uint64_t lastRequestedFrame = 0U;
+        uint64_t lastFullyUsedFrame = 0U;
+
+        LoadFunction load;
+        std::future<KTX2Texture> pendingLoad;
+
+        // Loads that did not fit within the budget are not retried before this frame, so they are not repeated every frame
+        uint64_t retryFrame = 0U;
+    };
+    std::map<uint32_t, ResidentTexture> textures = {};
+    std::mutex textureMutex;
+
+    // Ids index the feedback buffers, an id is reused only once no frame in flight can still write feedback for it
+    BindlessSlotAllocator residencyIds;
+
+    // Every load started, including those of textures removed while loading, so destroy can wait for them
+    JobCounter loadJobs;
+
+    /**
+     * The image of a removed texture, or one replaced when its resident level changed, which may still be sampled by frames in flight
+     */
+    struct RetiredImage {
+        AppImageBundle image;
+        uint64_t retiredOnFrame;
+    };
+    std::list<RetiredImage> retiredImages = {};
+
+    AppDescriptorSetLayout feedbackSetLayout;
+    AppDescriptorPool feedbackDescriptorPool;
+    std::vector<VkDescriptorSet> feedbackSets = {};
+    std::vector<AppBufferBundle> feedbackBuffers = {};
+    uint32_t feedbackIndex = 0U;
+
+    uint64_t frameIndex = 0U;
+    uint64_t residentBytes = 0U;
+    bool residencyChanged = false;
+    TextureResidencyStats stats {};
+
+    uint64_t getLevelByteSize(const ResidentTexture &texture, uint32_t level);
+    uint64_t queryBudget();
+    void readFeedback();
+
+    /**
+     * Replaces a texture's image with one holding the levels from newLevel down, levels the old image does not hold are
+     * uploaded from levels
+     */
+    void setResidentLevel(ResidentTexture &texture, uint32_t newLevel, const KTX2Texture* levels, VkCommandBuffer commandBuffer);
+
+    /**
+     * Drops levels of the least recently requested textures until bytesNeeded bytes are freed, only textures last
+     * requested before lastRequestedBefore are considered
+     */
+    uint64_t evict(uint64_t bytesNeeded, uint64_t lastRequestedBefore, uint32_t excludedId, VkCommandBuffer commandBuffer);
+
+    void shedUnusedLevels(VkCommandBuffer commandBuffer);
+    void applyLoads(uint64_t budgetBytes, VkCommandBuffer commandBuffer);
+    void startLoads();
+
+    public:
+    /**
+     * @brief Creates the feedback buffers and their descriptor sets
+     *
+     * @param textureTable The table that managed textures take their slots from
+     * @param sampler The sampler written with every managed texture
+     * @param maxTextureCount The number of textures that can be managed at once, which sizes the feedback buffers
+     */
+    void init(class AppBase* appBase, BindlessTextureTable* textureTable, AppSampler sampler, uint32_t maxTextureCount, TextureResidencyBudget budget);
+
+    /**
+     * @brief Starts managing a texture, creating its image with the given levels resident
+     *
+     * @param mipTail The levels the texture is resident with, they are never evicted
+     * @param imageTemplate The template of the texture's image, which must match the texture's format
+     *
+     * @return The texture's residency id, which is also its feedback id
+     */
+    uint32_t addTexture(const KTX2Texture &mipTail, AppImageTemplate imageTemplate, VkCommandBuffer commandBuffer);
+
+    /**
+     * @brief Sets how the levels finer than a texture's mip tail are loaded, textures without a loader keep their mip tail
+     */
+    void setLoader(uint32_t residencyId, LoadFunction load);
+
+    /**
+     * @brief Stops managing a texture and destroys its image
+     */
+    void removeTexture(uint32_t residencyId);
+
+    /**
+     * @brief Signals that the oldest frame in flight has completed, moving on to the feedback buffer it wrote
+     *
+     * @note Must be called once per frame, after the in-flight fence has been waited on
+     */
+    void onFrameComplete();
+
+    /**
+     * @brief Reads back the completed frame's feedback, loads and evicts levels, then clears the feedback buffer for the next frame
+     *
+     * @return True if any texture's resident level changed
+     */
+    bool update(VkCommandBuffer commandBuffer);
+
+    /**
+     * @brief Makes the fragment shader's feedback writes visible to the host once the frame's fence is signalled
+     *
+     * @note Must be recorded after the last render pass that writes feedback
+     */
+    void writeFeedbackBarrier(VkCommandBuffer commandBuffer);
+
+    AppDescriptorSetLayout& getFeedbackDescriptorSetLayout() { return feedbackSetLayout; }
+
+    /**
+     * @brief Gets the descriptor set holding the feedback buffer the next frame writes
+     */
+    VkDescriptorSet getFeedbackDescriptorSet() { return feedbackSets[feedbackIndex]; }
+
+    /**
+     * @brief Gets the bindless slot of a texture's image
+     */
+    uint32_t getTextureSlot(uint32_t residencyId);
+
+    /**
+     * @brief Gets the texture level held by level 0 of a texture's image
+     */
+    uint32_t getResidentLevel(uint32_t residencyId);
+
+    TextureResidencyStats getStats();
+
+    void destroy();
+};
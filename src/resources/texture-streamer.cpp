@@ -0,0 +1,157 @@
+#include "texture-streamer.h"
+#include "app-base.h"
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+
+void TextureStreamer::init(AppBase* appBase, TextureStreamingBudget budget)
+{
+    this->appBase = appBase;
+    this->budget = budget;
+}
+
+std::list<TextureStreamer::StreamingTexture>::iterator TextureStreamer::find(const TextureLayer &layer)
+{
+    for (auto texture = textures.begin() ; texture != textures.end() ; texture++) {
+        if (texture->layer.pool == layer.pool && texture->layer.layer == layer.layer) return texture;
+    }
+    return textures.end();
+}
+
+void TextureStreamer::addTexture(TextureLayer layer, uint32_t residentLevel, LoadFunction load)
+{
+    if (residentLevel == 0U) return;
+
+    std::lock_guard<std::mutex> lock(textureMutex);
+    StreamingTexture texture {layer, residentLevel, load};
+    textures.push_back(std::move(texture));
+}
+
+void TextureStreamer::removeTexture(const TextureLayer &layer)
+{
+    std::lock_guard<std::mutex> lock(textureMutex);
+    auto texture = find(layer);
+    if (texture == textures.end()) return;
+
+    // The load's future does not wait for the job, so removal never blocks
+    textures.erase(texture);
+}
+
+void TextureStreamer::startLoads()
+{
+    uint32_t activeLoads = 0U;
+    for (const StreamingTexture &texture : textures) {
+        if (texture.pendingLoad.valid()) activeLoads++;
+    }
+
+    // Textures are loaded in the order they were added
+    for (StreamingTexture &texture : textures) {
+        if (activeLoads >= budget.maxConcurrentLoads) break;
+        if (texture.isLoaded || texture.isFailed || texture.pendingLoad.valid()) continue;
+
+        texture.pendingLoad = JobSystem::shared().runAsync(texture.load, &loadJobs);
+        activeLoads++;
+    }
+}
+
+void TextureStreamer::collectLoads()
+{
+    for (auto texture = textures.begin() ; texture != textures.end() ; ) {
+        if (!texture->pendingLoad.valid() || texture->pendingLoad.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            texture++;
+            continue;
+        }
+
+        try {
+            texture->fullTexture = texture->pendingLoad.get();
+            if (texture->fullTexture.baseLevel != 0U || texture->fullTexture.levels.size() <= texture->residentLevel) {
+                throw std::runtime_error("the loaded texture does not have a full mip chain");
+            }
+            texture->isLoaded = true;
+            texture++;
+        }
+        catch (const std::exception &exception) {
+            // The texture stays at its mip tail, which is still a valid (if blurry) texture. It is kept rather than
+            // erased so that its levels finer than the tail, which hold no data, are still clamped away
+            std::cerr << "Failed to stream texture: " << exception.what() << std::endl;
+            stats.failedTextures++;
+            texture->isFailed = true;
+            texture->fullTexture = KTX2Texture{};
+            texture++;
+        }
+    }
+}
+
+bool TextureStreamer::update(VkCommandBuffer commandBuffer)
+{
+    std::lock_guard<std::mutex> lock(textureMutex);
+
+    collectLoads();
+    startLoads();
+
+    bool residencyChanged = false;
+    uint32_t uploadedBytes = 0U;
+    while (uploadedBytes < budget.uploadBytesPerUpdate) {
+        // Refine the coarsest loaded texture first, so that every texture sharpens at the same rate
+        auto next = textures.end();
+        for (auto texture = textures.begin() ; texture != textures.end() ; texture++) {
+            if (texture->isLoaded && (next == textures.end() || texture->residentLevel > next->residentLevel)) next = texture;
+        }
+        if (next == textures.end()) break;
+
+        uint32_t level = next->residentLevel - 1U;
+        uint32_t levelBytes = next->fullTexture.levels[level].size();
+        if (uploadedBytes > 0U && uploadedBytes + levelBytes > budget.uploadBytesPerUpdate) break;
+
+        KTX2Texture levelTexture;
+        levelTexture.format = next->fullTexture.format;
+        levelTexture.width = next->fullTexture.width;
+        levelTexture.height = next->fullTexture.height;
+        levelTexture.baseLevel = level;
+        levelTexture.levels.push_back(std::move(next->fullTexture.levels[level]));
+
+        // Uploaded into whichever array currently backs the pool, the layer index is stable across growth
+        loadKTX2Image(appBase, levelTexture, next->layer.pool->getTextureArray().image, commandBuffer, next->layer.layer);
+
+        next->residentLevel = level;
+        uploadedBytes += levelBytes;
+        residencyChanged = true;
+        stats.streamedLevels++;
+        stats.streamedBytes += levelBytes;
+
+        if (level == 0U) {
+            textures.erase(next);
+            stats.completedTextures++;
+        }
+    }
+    return residencyChanged;
+}
+
+uint32_t TextureStreamer::getResidentLevel(const TextureLayer &layer)
+{
+    std::lock_guard<std::mutex> lock(textureMutex);
+    auto texture = find(layer);
+    return texture == textures.end() ? 0U : texture->residentLevel;
+}
+
+uint32_t TextureStreamer::getStreamingCount()
+{
+    std::lock_guard<std::mutex> lock(textureMutex);
+    return std::count_if(textures.begin(), textures.end(), [](const StreamingTexture &texture) { return !texture.isFailed; });
+}
+
+TextureStreamerStats TextureStreamer::getStats()
+{
+    std::lock_guard<std::mutex> lock(textureMutex);
+    return stats;
+}
+
+void TextureStreamer::destroy()
+{
+    // Waited on outside the lock, the thread runs other jobs meanwhile and those may add textures. The loads' exceptions
+    // are held by their futures, so waiting never throws
+    JobSystem::shared().wait(loadJobs);
+
+    std::lock_guard<std::mutex> lock(textureMutex);
+    textures.clear();
+}
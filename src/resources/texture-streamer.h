@@ -0,0 +1,107 @@
+#pragma once
+#include "texture-registry.h"
+#include "job-system.h"
+#include <functional>
+#include <future>
+#include <mutex>
+#include <list>
+
+struct TextureStreamingBudget {
+    // The number of textures whose full mip chain may be loaded (read, decoded and compressed) at once
+    uint32_t maxConcurrentLoads = 2U;
+
+    // The number of bytes uploaded per call to update, at least one level is always uploaded so that large levels still progress
+    uint32_t uploadBytesPerUpdate = 4U * 1024U * 1024U;
+};
+
+struct TextureStreamerStats {
+    uint32_t streamedLevels = 0U;
+    uint64_t streamedBytes = 0U;
+    uint32_t completedTextures = 0U;
+    uint32_t failedTextures = 0U;
+};
+
+/**
+ * @class TextureStreamer
+ *
+ * @brief Streams the finer mip levels of textures whose mip tail is already resident
+ *
+ * Textures are first uploaded with only their smallest levels so that they can be drawn immediately. The streamer then
+ * loads each full mip chain in the background, at most maxConcurrentLoads at a time, and uploads the missing levels
+ * one at a time from coarse to fine, spread across textures and limited to uploadBytesPerUpdate bytes per update.
+ *
+ * Levels finer than the resident level hold no data, so shaders must clamp the level of detail they sample to
+ * getResidentLevel. Textures may be added from any thread, update must be called from the thread that records uploads.
+ */
+class TextureStreamer {
+    public:
+    // Loads the full mip chain of a texture, called as a job on JobSystem::shared
+    using LoadFunction = std::function<KTX2Texture()>;
+
+    private:
+    class AppBase* appBase;
+    TextureStreamingBudget budget;
+
+    struct StreamingTexture {
+        TextureLayer layer;
+        uint32_t residentLevel;
+        LoadFunction load;
+        std::future<KTX2Texture> pendingLoad;
+        KTX2Texture fullTexture;
+        bool isLoaded = false;
+
+        // A texture whose load failed is kept at its mip tail, so getResidentLevel still clamps sampling to it
+        bool isFailed = false;
+    };
+    std::list<StreamingTexture> textures = {};
+    std::mutex textureMutex;
+
+    // Every load started, including those of textures removed while loading, so destroy can wait for them
+    JobCounter loadJobs;
+
+    TextureStreamerStats stats {};
+
+    std::list<StreamingTexture>::iterator find(const TextureLayer &layer);
+    void startLoads();
+    void collectLoads();
+
+    public:
+    void init(class AppBase* appBase, TextureStreamingBudget budget);
+
+    /**
+     * @brief Starts streaming the finer levels of a texture
+     *
+     * @param layer Where the texture resides
+     * @param residentLevel The finest level that has already been uploaded
+     * @param load Loads the full mip chain of the texture
+     */
+    void addTexture(TextureLayer layer, uint32_t residentLevel, LoadFunction load);
+
+    /**
+     * @brief Stops streaming a texture, which must be done before its layer is freed
+     */
+    void removeTexture(const TextureLayer &layer);
+
+    /**
+     * @brief Starts pending loads and uploads the next levels of loaded textures, within the budget
+     *
+     * @return True if any texture's resident level changed
+     */
+    bool update(VkCommandBuffer commandBuffer);
+
+    /**
+     * @brief Gets the finest level of a texture that holds data, 0 once the texture is fully streamed (or was never streamed)
+     *
+     * A texture whose load failed stays at the level it had reached until it is removed
+     */
+    uint32_t getResidentLevel(const TextureLayer &layer);
+
+    /**
+     * @brief Gets the number of textures that are still missing levels, not counting those whose load failed
+     */
+    uint32_t getStreamingCount();
+
+    TextureStreamerStats getStats();
+
+    void destroy();
+};
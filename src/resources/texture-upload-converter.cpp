@@ -0,0 +1,203 @@
+#include "texture-upload-converter.h"
+#include "shader-specialization.h"
+#include "mipmap-generator.h"
+#include "descriptor-writer.h"
+#include "app-base.h"
+#include "image/image-loader.h"
+
+void TextureUploadConverter::init(AppBase* appBase, std::span<const uint32_t> rgbSpirv, std::span<const uint32_t> ycbcrSpirv)
+{
+    this->appBase = appBase;
+
+    rgbShaderModule.init(appBase, rgbSpirv, VK_SHADER_STAGE_COMPUTE_BIT);
+    ycbcrShaderModule.init(appBase, ycbcrSpirv, VK_SHADER_STAGE_COMPUTE_BIT);
+
+    // Binding 0 is the staging buffer being read, binding 1 is the level being written. Each upload's descriptors are
+    // pushed into its command buffer when the device supports it, rather than written to an allocated set
+    pushDescriptors = appBase->logicalDevice.supportsPushDescriptors();
+    descriptorSetLayout.init(appBase, {
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT}
+    }, pushDescriptors ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0U);
+    pipelineLayout.init(appBase, {descriptorSetLayout.get()}, {
+        {VK_SHADER_STAGE_COMPUTE_BIT, 0U, sizeof(ConversionPushConst)}
+    });
+
+    // Both kernels share the layout and workgroup size, only the pipeline bound for an upload differs
+    workgroupSize = ShaderSpecialization::chooseWorkgroupSize(appBase->logicalDevice.getLimits(), preferredWorkgroupSize);
+    ShaderSpecialization specialization;
+    specialization.setWorkgroupSize(workgroupSize);
+    VkSpecializationInfo specializationInfo = specialization.getInfo();
+    rgbPipeline.init(appBase, rgbShaderModule, pipelineLayout, &specializationInfo);
+    ycbcrPipeline.init(appBase, ycbcrShaderModule, pipelineLayout, &specializationInfo);
+
+    descriptorAllocator.init(appBase, 1U, {
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1U},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1U}
+    });
+}
+
+UploadConversion TextureUploadConverter::chooseConversion(const std::vector<char> &jpegFile)
+{
+    return ImageLoader::getJPEGPlaneLayout(jpegFile).planeCount > 0U ? UploadConversion::YCBCR_TO_RGBA : UploadConversion::RGB_TO_RGBA;
+}
+
+void TextureUploadConverter::loadJPEG(const std::vector<char> &jpegFile, AppImage &image, VkCommandBuffer commandBuffer, uint32_t targetLayer, MipmapGenerator* mipmapGenerator)
+{
+    JPEGPlaneLayout layout = ImageLoader::getJPEGPlaneLayout(jpegFile);
+    if (layout.width != image.getWidth() || layout.height != image.getHeight()) {
+        throw std::runtime_error("Failed to upload jpeg image, the image does not match the size of the jpeg");
+    }
+
+    ConversionPushConst pushConst {};
+    pushConst.width = layout.width;
+    pushConst.height = layout.height;
+
+    UploadConversion conversion = layout.planeCount > 0U ? UploadConversion::YCBCR_TO_RGBA : UploadConversion::RGB_TO_RGBA;
+    uint32_t stagingSize = layout.width * layout.height * 3U;
+    if (conversion == UploadConversion::YCBCR_TO_RGBA) {
+        for (uint32_t plane = 0U ; plane < 3U ; plane++) {
+            pushConst.planeOffsets[plane] = layout.planeOffsets[plane];
+            pushConst.planeWidths[plane] = layout.planeWidths[plane];
+            pushConst.planeHeights[plane] = layout.planeHeights[plane];
+        }
+        pushConst.chromaScaleX = layout.chromaScaleX;
+        pushConst.chromaScaleY = layout.chromaScaleY;
+        pushConst.planeCount = layout.planeCount;
+        stagingSize = layout.byteSize;
+    }
+
+    // The kernels read the buffer a word at a time
+    stagingSize = (stagingSize + 3U) & ~3U;
+
+    // Decode straight into the mapped buffer the kernel reads, there is no intermediate copy
+    AppBufferBundle stagingBuffer = createBufferAll(appBase, AppBufferTemplate::STORAGE_BUFFER, stagingSize);
+    try {
+        if (conversion == UploadConversion::YCBCR_TO_RGBA) ImageLoader::decodeJPEGPlanesInto(jpegFile, stagingBuffer.deviceMemory.getMappedData());
+        else ImageLoader::decodeJPEGRGBInto(jpegFile, stagingBuffer.deviceMemory.getMappedData());
+
+        convert(stagingBuffer, image, commandBuffer, targetLayer, conversion, pushConst);
+    }
+    catch (...) {
+        stagingBuffer.buffer.destroy();
+        stagingBuffer.deviceMemory.destroy();
+        throw;
+    }
+    stagingBuffer.buffer.destroy();
+    stagingBuffer.deviceMemory.destroy();
+
+    if (conversion == UploadConversion::YCBCR_TO_RGBA) stats.ycbcrUploads++;
+    else stats.rgbUploads++;
+    stats.uploadedBytes += stagingSize;
+    stats.rgbaBytes += static_cast<uint64_t>(layout.width) * layout.height * 4U;
+
+    // The converted level is left in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL when the rest of the chain is generated from it
+    if (image.getMipLevels() > 1U) {
+        if (mipmapGenerator != nullptr) mipmapGenerator->generate(image, commandBuffer, targetLayer);
+        else image.generateMipmaps(commandBuffer, targetLayer);
+    }
+}
+
+void TextureUploadConverter::convert(AppBufferBundle &stagingBuffer, AppImage &image, VkCommandBuffer commandBuffer, uint32_t targetLayer, UploadConversion conversion, const ConversionPushConst &pushConst)
+{
+    if (image.getFormat() != VK_FORMAT_R8G8B8A8_UNORM) throw std::runtime_error("Failed to convert upload, the target image is not R8G8B8A8_UNORM");
+    if (!(image.getUsage() & VK_IMAGE_USAGE_STORAGE_BIT)) throw std::runtime_error("Failed to convert upload, the target image was not created with storage usage");
+
+    AppImageView levelView;
+    levelView.initStorage(appBase, image, targetLayer, 0U);
+
+    // Both bindings are written with one call, pushed descriptors are not written to a set
+    VkDescriptorSet descriptorSet = pushDescriptors ? VK_NULL_HANDLE : descriptorAllocator.allocate(descriptorSetLayout);
+    DescriptorWriter descriptorWriter(appBase);
+    descriptorWriter.writeBuffer(descriptorSet, 0U, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stagingBuffer.buffer, stagingBuffer.buffer.getSize());
+
+    // Storage images are written in the general layout
+    descriptorWriter.writeImage(descriptorSet, 1U, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, levelView, VK_IMAGE_LAYOUT_GENERAL);
+    if (!pushDescriptors) descriptorWriter.flush();
+
+    // The rest of the chain is generated from level 0 with transfers, otherwise the layer is sampled straight away
+    bool hasMipChain = image.getMipLevels() > 1U;
+    VkImageLayout finalLayout = hasMipChain ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image.get();
+    //                        {aspect mask, mip level, mip level count, array layer, array layer count}
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, image.getMipLevels(), targetLayer, 1U};
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.pNext = nullptr;
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.pInheritanceInfo = nullptr;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    // The previous contents of the layer are overwritten, so they need not be preserved
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcAccessMask = 0U;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0U, 0U, nullptr, 0U, nullptr, 1U, &barrier);
+
+    VkPipeline pipeline = conversion == UploadConversion::YCBCR_TO_RGBA ? ycbcrPipeline.get() : rgbPipeline.get();
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    if (pushDescriptors) descriptorWriter.push(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0U);
+    else vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout.get(), 0U, 1U, &descriptorSet, 0U, nullptr);
+    vkCmdPushConstants(commandBuffer, pipelineLayout.get(), VK_SHADER_STAGE_COMPUTE_BIT, 0U, sizeof(ConversionPushConst), &pushConst);
+    vkCmdDispatch(commandBuffer, (pushConst.width + workgroupSize.width - 1U) / workgroupSize.width, (pushConst.height + workgroupSize.height - 1U) / workgroupSize.height, 1U);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.newLayout = finalLayout;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = hasMipChain ? VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, hasMipChain ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0U, 0U, nullptr, 0U, nullptr, 1U, &barrier);
+
+    vkEndCommandBuffer(commandBuffer);
+
+    VkFenceCreateInfo conversionCompleteFenceInfo{};
+    conversionCompleteFenceInfo.pNext = nullptr;
+    conversionCompleteFenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkFence conversionCompleteFence;
+    vkCreateFence(appBase->getDevice(), &conversionCompleteFenceInfo, nullptr, &conversionCompleteFence);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.pCommandBuffers = &(commandBuffer);
+    submitInfo.commandBufferCount = 1U;
+    submitInfo.pNext = nullptr;
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pSignalSemaphores = nullptr;
+    submitInfo.signalSemaphoreCount = 0U;
+    submitInfo.pWaitSemaphores = nullptr;
+    submitInfo.pWaitDstStageMask = nullptr;
+    submitInfo.waitSemaphoreCount = 0u;
+
+    vkQueueSubmit(appBase->queues.graphicsQueue, 1U, &submitInfo, conversionCompleteFence);
+
+    vkWaitForFences(appBase->getDevice(), 1U, &conversionCompleteFence, true, UINT64_MAX);
+
+    vkDestroyFence(appBase->getDevice(), conversionCompleteFence, nullptr);
+
+    // The view and descriptor set were only needed by this upload
+    levelView.destroy();
+    descriptorAllocator.reset();
+
+    image.setLayout(finalLayout);
+}
+
+void TextureUploadConverter::destroy()
+{
+    descriptorAllocator.destroy();
+    ycbcrPipeline.destroy();
+    rgbPipeline.destroy();
+    pipelineLayout.destroy();
+    descriptorSetLayout.destroy();
+    ycbcrShaderModule.destroy();
+    rgbShaderModule.destroy();
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include "resource-utilities.h"
+#include "descriptor-allocator.h"
+
+/**
+ * How the texels of an upload are laid out in the staging buffer, each layout has its own conversion kernel
+ */
+enum class UploadConversion {
+    // Tightly packed 8-bit RGB, expanded to RGBA on the device
+    RGB_TO_RGBA,
+    // The JPEG's Y, Cb and Cr planes at its chroma subsampling, upsampled and converted to RGBA on the device
+    YCBCR_TO_RGBA
+};
+
+struct TextureUploadStats {
+    uint32_t rgbUploads = 0U;
+    uint32_t ycbcrUploads = 0U;
+
+    // The bytes written to staging buffers, and the bytes the same images would have taken as RGBA
+    uint64_t uploadedBytes = 0U;
+    uint64_t rgbaBytes = 0U;
+};
+
+/**
+ * @class TextureUploadConverter
+ *
+ * @brief Uploads JPEGs without a padding byte per texel, expanding them to RGBA in a compute shader
+ *
+ * JPEGs that are YCbCr or grayscale are decoded to their planes, which skips colour conversion and chroma upsampling
+ * on the CPU and, for 4:2:0 subsampling, uploads 1.5 bytes per texel. Other JPEGs are decoded to packed RGB, 3 bytes
+ * per texel. Either is decoded straight into a host-visible storage buffer that the conversion kernel reads and
+ * writes level 0 of the target layer from, through a storage image view.
+ *
+ * @note The target image must be R8G8B8A8_UNORM with storage usage, such as PREWRITTEN_SAMPLED_TEXTURE on devices that
+ * support storage for that format. JPEG texels are written as they were decoded.
+ */
+class TextureUploadConverter {
+    class AppBase* appBase;
+    AppShaderModule rgbShaderModule;
+    AppShaderModule ycbcrShaderModule;
+    AppDescriptorSetLayout descriptorSetLayout;
+    AppPipelineLayout pipelineLayout;
+    AppPipeline rgbPipeline;
+    AppPipeline ycbcrPipeline;
+
+    // Allocates the descriptor set of the conversion being recorded, reset after every upload. Unused when the
+    // descriptors are pushed
+    DescriptorAllocator descriptorAllocator;
+    bool pushDescriptors = false;
+
+    // The kernels are specialized to the preferred workgroup size, shrunk to fit the device's limits
+    const VkExtent2D preferredWorkgroupSize = {8U, 8U};
+    VkExtent2D workgroupSize = preferredWorkgroupSize;
+
+    /**
+     * Must match the push constants of expand-rgb.comp and convert-ycbcr.comp, the packed RGB kernel only reads the
+     * width and height
+     */
+    struct ConversionPushConst {
+        uint32_t width;
+        uint32_t height;
+        uint32_t planeOffsets[3];
+        uint32_t planeWidths[3];
+        uint32_t planeHeights[3];
+        uint32_t chromaScaleX;
+        uint32_t chromaScaleY;
+        uint32_t planeCount;
+    };
+
+    TextureUploadStats stats {};
+
+    void convert(AppBufferBundle &stagingBuffer, AppImage &image, VkCommandBuffer commandBuffer, uint32_t targetLayer, UploadConversion conversion, const ConversionPushConst &pushConst);
+
+    public:
+    /**
+     * @brief Creates a pipeline for each conversion kernel
+     *
+     * @param rgbSpirv The SPIR-V of shaders/src/expand-rgb.comp, expandRGBSpirv in embedded-shaders.h
+     * @param ycbcrSpirv The SPIR-V of shaders/src/convert-ycbcr.comp, convertYCbCrSpirv in embedded-shaders.h
+     */
+    void init(class AppBase* appBase, std::span<const uint32_t> rgbSpirv, std::span<const uint32_t> ycbcrSpirv);
+
+    /**
+     * @brief Chooses the conversion a JPEG is uploaded with, its planes whenever turbojpeg can decode them
+     */
+    static UploadConversion chooseConversion(const std::vector<char> &jpegFile);
+
+    /**
+     * @brief Decodes a JPEG into a staging buffer and converts it into a layer of an RGBA image on the device
+     *
+     * If the image has a mip chain, the remaining levels are generated from the converted level, with mipmapGenerator
+     * when one is given or with blits otherwise.
+     *
+     * @note The target layer is left ready to be sampled
+     */
+    void loadJPEG(const std::vector<char> &jpegFile, AppImage &image, VkCommandBuffer commandBuffer, uint32_t targetLayer, class MipmapGenerator* mipmapGenerator = nullptr);
+
+    TextureUploadStats getStats() { return stats; }
+
+    void destroy();
+};
@@ -0,0 +1,319 @@
+#include "vertex-buffer-manager.h"
+#include "app-base.h"
+#include <algorithm>
+
+void VIBufferManager::init(AppBase* appBase, AppBufferBundle vertexBuffer, AppBufferBundle indexBuffer, AppBufferBundle stagingVertexBuffer, AppBufferBundle stagingIndexBuffer)
+{
+    this->appBase = appBase;
+    this->stagingVertexBuffer = stagingVertexBuffer;
+    this->stagingIndexBuffer = stagingIndexBuffer;
+    this->vertexBuffer = vertexBuffer;
+    this->indexBuffer = indexBuffer;
+
+    // Track the buffer sizes rather than the memory sizes, the memory may be larger due to alignment requirements
+    vbStorageManager.init(this->vertexBuffer.buffer.getSize());
+    ibStorageManager.init(this->indexBuffer.buffer.getSize());
+
+    defragFence.init(appBase);
+
+    // The arenas are addressed with 32 bit offsets, and an arena cannot be larger than the device local heap it is allocated from
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(appBase->getPhysicalDevice(), &memoryProperties);
+    VkDeviceSize largestHeapSize = 0U;
+    for (uint32_t heap = 0U ; heap < memoryProperties.memoryHeapCount ; heap++) {
+        if (!(memoryProperties.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) continue;
+        largestHeapSize = std::max(largestHeapSize, memoryProperties.memoryHeaps[heap].size);
+    }
+    maxArenaBytes = std::min<uint64_t>(largestHeapSize, UINT32_MAX);
+}
+
+void VIBufferManager::addGeometry(GeometryBase* geometry, VkCommandBuffer commandBuffer)
+{
+    std::pair<std::vector<Vertex>, std::vector<uint32_t>> vertexIndexData = geometry->getVertexAndIndexData();
+    uint32_t vertexBytes = vertexIndexData.first.size() * sizeof(Vertex);
+    uint32_t indexBytes = vertexIndexData.second.size() * sizeof(uint32_t);
+
+    // Grow the device arenas if the geometry does not fit in any free block
+    if (!vbStorageManager.canReserve(vertexIndexData.first.size())) {
+        growDeviceBuffer(vertexBuffer, vbStorageManager, AppBufferTemplate::VERTEX_BUFFER_DEVICE, vertexBytes, commandBuffer);
+        stats.vertexBufferGrowthCount++;
+    }
+    if (!ibStorageManager.canReserve(vertexIndexData.second.size())) {
+        growDeviceBuffer(indexBuffer, ibStorageManager, AppBufferTemplate::INDEX_BUFFER_DEVICE, indexBytes, commandBuffer);
+        stats.indexBufferGrowthCount++;
+    }
+
+    // The staging buffers hold a single geometry at a time, they only need to fit the current upload
+    if (stagingVertexBuffer.buffer.getSize() < vertexBytes) {
+        growStagingBuffer(stagingVertexBuffer, AppBufferTemplate::VERTEX_BUFFER_STAGING, vertexBytes);
+        stats.stagingBufferGrowthCount++;
+    }
+    if (stagingIndexBuffer.buffer.getSize() < indexBytes) {
+        growStagingBuffer(stagingIndexBuffer, AppBufferTemplate::INDEX_BUFFER_STAGING, indexBytes);
+        stats.stagingBufferGrowthCount++;
+    }
+
+    geometry->setVertexBufferBlock(vbStorageManager.reserveMemory(vertexIndexData.first));
+    geometry->setIndexBufferBlock(ibStorageManager.reserveMemory(vertexIndexData.second));
+    trackGeometry(geometry);
+
+    // Copy the data to the staging buffers
+    copyDataToStagingMemory(stagingVertexBuffer.deviceMemory, vertexIndexData.first.data(), vertexBytes);
+    copyDataToStagingMemory(stagingIndexBuffer.deviceMemory, vertexIndexData.second.data(), indexBytes);
+
+    // Copy the data to the vertex and index buffers
+    AppBuffer::copyBuffer(stagingVertexBuffer.buffer, vertexBuffer.buffer, commandBuffer, geometry->getVertexCount() * sizeof(Vertex), 0U, geometry->getVertexOffset() * sizeof(Vertex));
+    AppBuffer::copyBuffer(stagingIndexBuffer.buffer, indexBuffer.buffer, commandBuffer, geometry->getIndexCount() * sizeof(uint32_t), 0U, geometry->getIndexOffset() * sizeof(uint32_t));
+}
+
+void VIBufferManager::recordGeometryUpload(GeometryBase* geometry, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, VkCommandBuffer uploadCommandBuffer, VkCommandBuffer growthCommandBuffer)
+{
+    uint32_t vertexBytes = vertices.size() * sizeof(Vertex);
+    uint32_t indexBytes = indices.size() * sizeof(uint32_t);
+
+    if (!vbStorageManager.canReserve(vertices.size())) {
+        growDeviceBuffer(vertexBuffer, vbStorageManager, AppBufferTemplate::VERTEX_BUFFER_DEVICE, vertexBytes, growthCommandBuffer);
+        stats.vertexBufferGrowthCount++;
+    }
+    if (!ibStorageManager.canReserve(indices.size())) {
+        growDeviceBuffer(indexBuffer, ibStorageManager, AppBufferTemplate::INDEX_BUFFER_DEVICE, indexBytes, growthCommandBuffer);
+        stats.indexBufferGrowthCount++;
+    }
+
+    PendingUpload upload {geometry};
+    upload.stagingVertexBuffer = createBufferAll(appBase, AppBufferTemplate::VERTEX_BUFFER_STAGING, vertexBytes);
+    upload.stagingIndexBuffer = createBufferAll(appBase, AppBufferTemplate::INDEX_BUFFER_STAGING, indexBytes);
+    copyDataToStagingMemory(upload.stagingVertexBuffer.deviceMemory, const_cast<Vertex*>(vertices.data()), vertexBytes);
+    copyDataToStagingMemory(upload.stagingIndexBuffer.deviceMemory, const_cast<uint32_t*>(indices.data()), indexBytes);
+
+    // The geometry is not tracked until its upload completes, so the defragmenter leaves its blocks where they are
+    geometry->setVertexBufferBlock(vbStorageManager.reserveMemory(vertices));
+    geometry->setIndexBufferBlock(ibStorageManager.reserveMemory(indices));
+
+    VkBufferCopy vertexCopy {0U, geometry->getVertexOffset() * sizeof(Vertex), vertexBytes};
+    VkBufferCopy indexCopy {0U, geometry->getIndexOffset() * sizeof(uint32_t), indexBytes};
+    vkCmdCopyBuffer(uploadCommandBuffer, upload.stagingVertexBuffer.buffer.get(), vertexBuffer.buffer.get(), 1U, &vertexCopy);
+    vkCmdCopyBuffer(uploadCommandBuffer, upload.stagingIndexBuffer.buffer.get(), indexBuffer.buffer.get(), 1U, &indexCopy);
+
+    pendingUploads.push_back(upload);
+}
+
+void VIBufferManager::completeGeometryUpload(GeometryBase* geometry)
+{
+    auto it = std::find_if(pendingUploads.begin(), pendingUploads.end(), [geometry](const PendingUpload &upload) { return upload.geometry == geometry; });
+    if (it == pendingUploads.end()) throw std::runtime_error("Attempted to complete the upload of geometry that has no upload recorded");
+
+    it->stagingVertexBuffer.buffer.destroy();
+    it->stagingVertexBuffer.deviceMemory.destroy();
+    it->stagingIndexBuffer.buffer.destroy();
+    it->stagingIndexBuffer.deviceMemory.destroy();
+    pendingUploads.erase(it);
+
+    trackGeometry(geometry);
+}
+
+void VIBufferManager::trackGeometry(GeometryBase* geometry)
+{
+    vertexBlockOwners[&*geometry->getVertexBufferBlock()] = geometry;
+    indexBlockOwners[&*geometry->getIndexBufferBlock()] = geometry;
+}
+
+template <typename T>
+void VIBufferManager::growDeviceBuffer(AppBufferBundle &deviceBuffer, BufferStorageManager<T> &storageManager, AppBufferTemplate bufferTemplate, uint32_t requiredBytes, VkCommandBuffer commandBuffer)
+{
+    // The old buffer is about to be copied and retired, pending defragmentation copies into it must land first
+    completePendingMoves(true);
+
+    // As must any uploads in flight, which may have been submitted to any queue. Growth is rare enough to wait for the device
+    if (!pendingUploads.empty()) vkDeviceWaitIdle(appBase->getDevice());
+
+    uint64_t oldSize = storageManager.getByteSize();
+
+    // Grow geometrically so that repeated insertions have an amortized constant copy cost. Growing by at least
+    // 'requiredBytes' guarantees the request fits, since the added bytes always form (or extend) the last free block
+    uint64_t minSize = oldSize + requiredBytes;
+    if (minSize > maxArenaBytes) throw std::runtime_error("Failed to grow geometry arena, the geometry does not fit in the largest arena the device supports");
+    uint32_t newSize = static_cast<uint32_t>(std::min(std::max(oldSize * growthFactor, minSize), maxArenaBytes));
+
+    AppBufferBundle newBuffer = createBufferAll(appBase, bufferTemplate, newSize);
+
+    /**
+     * Growing keeps every existing block at its offset, so each GeometryBase's block iterator remains valid and
+     * only the live (reserved) ranges need to be copied. Adjacent reserved blocks are merged into one copy region.
+     */
+    std::vector<VkBufferCopy> copyRegions = {};
+    for (const MemoryBlockNode &block : storageManager.memoryListTree.getBlocks()) {
+        if (block.getIsFree()) continue;
+
+        if (copyRegions.size() > 0 && copyRegions.back().srcOffset + copyRegions.back().size == block.byteOffset) {
+            copyRegions.back().size += block.byteSize;
+        }
+        else {
+            copyRegions.push_back(VkBufferCopy{block.byteOffset, block.byteOffset, block.byteSize});
+        }
+    }
+    AppBuffer::copyBufferRegions(deviceBuffer.buffer, newBuffer.buffer, commandBuffer, copyRegions);
+
+    storageManager.grow(newSize);
+
+    retireBuffer(deviceBuffer);
+    deviceBuffer = newBuffer;
+}
+
+void VIBufferManager::growStagingBuffer(AppBufferBundle &stagingBuffer, AppBufferTemplate bufferTemplate, uint32_t requiredBytes)
+{
+    uint64_t grownSize = std::max<uint64_t>(stagingBuffer.buffer.getSize() * growthFactor, requiredBytes);
+    uint32_t newSize = static_cast<uint32_t>(std::min(grownSize, std::max<uint64_t>(maxArenaBytes, requiredBytes)));
+
+    // Staging contents are transient, so the old buffer does not need to be copied
+    retireBuffer(stagingBuffer);
+    stagingBuffer = createBufferAll(appBase, bufferTemplate, newSize);
+}
+
+void VIBufferManager::retireBuffer(AppBufferBundle bufferBundle)
+{
+    retiredBuffers.push_back(RetiredBuffer{bufferBundle, frameIndex});
+}
+
+void VIBufferManager::onFrameComplete()
+{
+    frameIndex++;
+
+    // A buffer retired on frame N may be referenced by command buffers up to frame N + maxFramesInFlight
+    while (!retiredBuffers.empty() && retiredBuffers.front().retiredOnFrame + maxFramesInFlight <= frameIndex) {
+        retiredBuffers.front().bufferBundle.buffer.destroy();
+        retiredBuffers.front().bufferBundle.deviceMemory.destroy();
+        retiredBuffers.pop_front();
+    }
+
+    // Likewise, blocks released on frame N may still be read until frame N + maxFramesInFlight
+    while (!pendingFrees.empty() && pendingFrees.front().releasedOnFrame + maxFramesInFlight <= frameIndex) {
+        if (pendingFrees.front().isVertexBlock) vbStorageManager.freeMemory(pendingFrees.front().block);
+        else ibStorageManager.freeMemory(pendingFrees.front().block);
+        pendingFrees.pop_front();
+    }
+}
+
+void VIBufferManager::releaseBlock(std::list<MemoryBlockNode>::iterator block, bool isVertexBlock)
+{
+    pendingFrees.push_back(PendingFree{isVertexBlock, block, frameIndex});
+}
+
+void VIBufferManager::removeGeometry(GeometryBase* geometry)
+{
+    // The geometry's blocks may be the source of a pending move, finish it so the right blocks are released
+    completePendingMoves(true);
+
+    if (findBlockOwner(geometry->getVertexBufferBlock(), true) != geometry) throw std::runtime_error("Attempted to remove geometry that was not added to the buffer manager");
+    vertexBlockOwners.erase(&*geometry->getVertexBufferBlock());
+    indexBlockOwners.erase(&*geometry->getIndexBufferBlock());
+
+    releaseBlock(geometry->getVertexBufferBlock(), true);
+    releaseBlock(geometry->getIndexBufferBlock(), false);
+}
+
+GeometryBase* VIBufferManager::findBlockOwner(std::list<MemoryBlockNode>::iterator block, bool isVertexBlock)
+{
+    std::unordered_map<const MemoryBlockNode*, GeometryBase*> &blockOwners = isVertexBlock ? vertexBlockOwners : indexBlockOwners;
+    auto ownerIt = blockOwners.find(&*block);
+    return ownerIt == blockOwners.end() ? nullptr : ownerIt->second;
+}
+
+template <typename T>
+void VIBufferManager::selectBlockMoves(BufferStorageManager<T> &storageManager, bool isVertexBlock, uint32_t &byteBudget, std::vector<VkBufferCopy> &copyRegions)
+{
+    // Blocks not owned by tracked geometry (e.g. awaiting release) cannot be patched, so they stay in place
+    std::vector<MemoryListTree::BlockMove> moves = storageManager.memoryListTree.selectCompactingMoves(byteBudget, [this, isVertexBlock](std::list<MemoryBlockNode>::iterator block) {
+        return findBlockOwner(block, isVertexBlock) != nullptr;
+    });
+
+    for (MemoryListTree::BlockMove &move : moves) {
+        uint32_t byteSize = (*move.oldBlock).byteSize;
+        pendingMoves.push_back(BlockMove{findBlockOwner(move.oldBlock, isVertexBlock), isVertexBlock, move.oldBlock, move.newBlock});
+        copyRegions.push_back(VkBufferCopy{(*move.oldBlock).byteOffset, (*move.newBlock).byteOffset, byteSize});
+
+        stats.defragmentedBytes += byteSize;
+        stats.defragmentedBlocks++;
+    }
+}
+
+void VIBufferManager::defragment(VkCommandBuffer commandBuffer, uint32_t byteBudget)
+{
+    // Only one batch of moves is in flight at a time, the next batch is selected once the previous one is patched
+    if (!completePendingMoves(false)) return;
+
+    std::vector<VkBufferCopy> vertexCopyRegions = {};
+    std::vector<VkBufferCopy> indexCopyRegions = {};
+    selectBlockMoves(vbStorageManager, true, byteBudget, vertexCopyRegions);
+    selectBlockMoves(ibStorageManager, false, byteBudget, indexCopyRegions);
+
+    if (pendingMoves.size() == 0) return;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.pNext = nullptr;
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.pInheritanceInfo = nullptr;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    if (vertexCopyRegions.size() > 0)
+        vkCmdCopyBuffer(commandBuffer, vertexBuffer.buffer.get(), vertexBuffer.buffer.get(), vertexCopyRegions.size(), vertexCopyRegions.data());
+    if (indexCopyRegions.size() > 0)
+        vkCmdCopyBuffer(commandBuffer, indexBuffer.buffer.get(), indexBuffer.buffer.get(), indexCopyRegions.size(), indexCopyRegions.data());
+    vkEndCommandBuffer(commandBuffer);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.pCommandBuffers = &(commandBuffer);
+    submitInfo.commandBufferCount = 1U;
+    submitInfo.pNext = nullptr;
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pSignalSemaphores = nullptr;
+    submitInfo.signalSemaphoreCount = 0U;
+    submitInfo.pWaitSemaphores = nullptr;
+    submitInfo.pWaitDstStageMask = nullptr;
+    submitInfo.waitSemaphoreCount = 0u;
+
+    vkResetFences(appBase->getDevice(), 1U, defragFence.getRef());
+    THROW(vkQueueSubmit(appBase->queues.graphicsQueue, 1U, &submitInfo, defragFence.get()), "Failed to submit defragmentation copies");
+}
+
+bool VIBufferManager::completePendingMoves(bool wait)
+{
+    if (pendingMoves.size() == 0) return true;
+
+    if (wait) vkWaitForFences(appBase->getDevice(), 1U, defragFence.getRef(), true, UINT64_MAX);
+    else if (vkGetFenceStatus(appBase->getDevice(), defragFence.get()) != VK_SUCCESS) return false;
+
+    // The data now lives in the new blocks, point the geometry at them and release the old blocks
+    for (BlockMove &move : pendingMoves) {
+        if (move.isVertexBlock) move.geometry->setVertexBufferBlock(move.newBlock);
+        else move.geometry->setIndexBufferBlock(move.newBlock);
+
+        std::unordered_map<const MemoryBlockNode*, GeometryBase*> &blockOwners = move.isVertexBlock ? vertexBlockOwners : indexBlockOwners;
+        blockOwners.erase(&*move.oldBlock);
+        blockOwners[&*move.newBlock] = move.geometry;
+        releaseBlock(move.oldBlock, move.isVertexBlock);
+    }
+    pendingMoves.clear();
+
+    return true;
+}
+
+static VIFragmentationMetrics getFragmentationMetrics(MemoryListTree &memoryListTree)
+{
+    VIFragmentationMetrics metrics {};
+    metrics.totalFreeBytes = memoryListTree.getTotalFreeSize();
+    metrics.largestFreeBlockBytes = memoryListTree.getLargestFreeBlockSize();
+    metrics.largestFreeBlockRatio = metrics.totalFreeBytes == 0U ? 1.f : static_cast<float>(metrics.largestFreeBlockBytes) / metrics.totalFreeBytes;
+    return metrics;
+}
+
+VIFragmentationMetrics VIBufferManager::getVertexFragmentation()
+{
+    return getFragmentationMetrics(vbStorageManager.memoryListTree);
+}
+
+VIFragmentationMetrics VIBufferManager::getIndexFragmentation()
+{
+    return getFragmentationMetrics(ibStorageManager.memoryListTree);
+}
@@ -1,41 +1,178 @@
 #pragma once
 #include "buffer-storage-manager.h"
+#include "resource-utilities.h"
 #include "app-config.h"
 #include "geometry-base.h"
+#include <unordered_map>
+
+/**
+ * Counts of the geometric growth and defragmentation work performed by the vertex/index buffer manager
+ */
+struct VIBufferStats {
+    uint32_t vertexBufferGrowthCount = 0U;
+    uint32_t indexBufferGrowthCount = 0U;
+    uint32_t stagingBufferGrowthCount = 0U;
+    uint32_t defragmentedBytes = 0U;
+    uint32_t defragmentedBlocks = 0U;
+};
+
+/**
+ * Fragmentation of a single arena. The ratio is the largest free block divided by the total free space, a ratio
+ * of 1 means all free space is contiguous, while a ratio approaching 0 means the free space is scattered in small holes.
+ */
+struct VIFragmentationMetrics {
+    uint32_t totalFreeBytes = 0U;
+    uint32_t largestFreeBlockBytes = 0U;
+    float largestFreeBlockRatio = 1.f;
+};
 
 class VIBufferManager {
+    class AppBase* appBase;
     BufferStorageManager<Vertex> vbStorageManager;
     BufferStorageManager<uint32_t> ibStorageManager;
     AppBufferBundle stagingVertexBuffer;
     AppBufferBundle stagingIndexBuffer;
     AppBufferBundle vertexBuffer;
     AppBufferBundle indexBuffer;
+
+    // When an arena grows, its capacity is multiplied by this factor (or grown to fit the request, whichever is larger)
+    const uint32_t growthFactor = 2U;
+
+    // The largest size an arena may grow to, limited by the 32 bit block offsets and the device local heap size
+    uint64_t maxArenaBytes = UINT32_MAX;
+
+    /**
+     * A buffer that has been replaced by a larger one. It may still be referenced by command buffers
+     * of frames in flight, so it is only destroyed once those frames have completed
+     */
+    struct RetiredBuffer {
+        AppBufferBundle bufferBundle;
+        uint64_t retiredOnFrame;
+    };
+    std::list<RetiredBuffer> retiredBuffers = {};
+    uint64_t frameIndex = 0U;
+
+    VIBufferStats stats {};
+
+    // The geometry that holds each reserved block of the vertex and index buffers, keyed by the block's node. Blocks
+    // awaiting release and blocks of uploads in flight have no owner
+    std::unordered_map<const MemoryBlockNode*, GeometryBase*> vertexBlockOwners = {};
+    std::unordered_map<const MemoryBlockNode*, GeometryBase*> indexBlockOwners = {};
+
+    /**
+     * A block relocation issued by the defragmenter. The geometry keeps referencing the old block until the
+     * copy's fence signals, at which point it is patched to reference the new block.
+     */
+    struct BlockMove {
+        GeometryBase* geometry;
+        bool isVertexBlock;
+        std::list<MemoryBlockNode>::iterator oldBlock;
+        std::list<MemoryBlockNode>::iterator newBlock;
+    };
+    std::vector<BlockMove> pendingMoves = {};
+    AppFence defragFence;
+
+    /**
+     * A block that is no longer referenced by any geometry, but may still be read by frames in flight
+     */
+    struct PendingFree {
+        bool isVertexBlock;
+        std::list<MemoryBlockNode>::iterator block;
+        uint64_t releasedOnFrame;
+    };
+    std::list<PendingFree> pendingFrees = {};
+
+    /**
+     * Geometry whose upload has been recorded but has not yet been completed. Each upload has staging buffers of its own,
+     * since several may be in flight at once
+     */
+    struct PendingUpload {
+        GeometryBase* geometry;
+        AppBufferBundle stagingVertexBuffer;
+        AppBufferBundle stagingIndexBuffer;
+    };
+    std::vector<PendingUpload> pendingUploads = {};
+
+    template <typename T>
+    void growDeviceBuffer(AppBufferBundle &deviceBuffer, BufferStorageManager<T> &storageManager, AppBufferTemplate bufferTemplate, uint32_t requiredBytes, VkCommandBuffer commandBuffer);
+    void growStagingBuffer(AppBufferBundle &stagingBuffer, AppBufferTemplate bufferTemplate, uint32_t requiredBytes);
+    void retireBuffer(AppBufferBundle bufferBundle);
+
+    template <typename T>
+    void selectBlockMoves(BufferStorageManager<T> &storageManager, bool isVertexBlock, uint32_t &byteBudget, std::vector<VkBufferCopy> &copyRegions);
+    GeometryBase* findBlockOwner(std::list<MemoryBlockNode>::iterator block, bool isVertexBlock);
+    void trackGeometry(GeometryBase* geometry);
+    void releaseBlock(std::list<MemoryBlockNode>::iterator block, bool isVertexBlock);
     
     public:
-    void init(AppBufferBundle vertexBuffer, AppBufferBundle indexBuffer, AppBufferBundle stagingVertexBuffer, AppBufferBundle stagingIndexBuffer) {
-        vbStorageManager.init(&vertexBuffer.deviceMemory);
-        ibStorageManager.init(&indexBuffer.deviceMemory);
-        this->stagingVertexBuffer = stagingVertexBuffer;
-        this->stagingIndexBuffer = stagingIndexBuffer;
-        this->vertexBuffer = vertexBuffer;
-        this->indexBuffer = indexBuffer;
-    }
+    void init(class AppBase* appBase, AppBufferBundle vertexBuffer, AppBufferBundle indexBuffer, AppBufferBundle stagingVertexBuffer, AppBufferBundle stagingIndexBuffer);
 
-    void addGeometry(GeometryBase* geometry, VkCommandBuffer commandBuffer) {
-        std::pair<std::vector<Vertex>, std::vector<uint32_t>> vertexIndexData = geometry->getVertexAndIndexData();
-        geometry->setVertexBufferBlock(vbStorageManager.reserveMemory(vertexIndexData.first));
-        geometry->setIndexBufferBlock(ibStorageManager.reserveMemory(vertexIndexData.second));
+    /**
+     * @brief Reserves space for the geometry in the vertex and index buffers and uploads its data
+     * 
+     * @note If either buffer cannot fit the geometry, it is grown geometrically and the existing contents are copied over
+     */
+    void addGeometry(GeometryBase* geometry, VkCommandBuffer commandBuffer);
 
-        // Copy the data to the staging buffers
-        copyDataToStagingMemory(stagingVertexBuffer.deviceMemory, vertexIndexData.first.data(), vertexIndexData.first.size() * sizeof(Vertex));
-        copyDataToStagingMemory(stagingIndexBuffer.deviceMemory, vertexIndexData.second.data(), vertexIndexData.second.size() * sizeof(uint32_t));
+    /**
+     * @brief Reserves space for the geometry and records the upload of its data, without waiting for the upload
+     * 
+     * The geometry must not be drawn until completeGeometryUpload has been called for it, once the command buffer has
+     * finished executing. Several uploads may be in flight at once.
+     * 
+     * @param vertices The geometry's vertex data, as returned by getVertexAndIndexData
+     * @param indices The geometry's index data, as returned by getVertexAndIndexData
+     * @param uploadCommandBuffer A command buffer in the recording state, which the caller submits
+     * @param growthCommandBuffer Copies the arenas if either has to grow, the copy completes before this returns
+     */
+    void recordGeometryUpload(GeometryBase* geometry, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, VkCommandBuffer uploadCommandBuffer, VkCommandBuffer growthCommandBuffer);
 
-        // Copy the data to the vertex and index buffers
-        AppBuffer::copyBuffer(stagingVertexBuffer.buffer, vertexBuffer.buffer, commandBuffer, geometry->getVertexCount() * sizeof(Vertex), 0U, geometry->getVertexOffset() * sizeof(Vertex));
-        AppBuffer::copyBuffer(stagingIndexBuffer.buffer, indexBuffer.buffer, commandBuffer, geometry->getIndexCount() * sizeof(uint32_t), 0U, geometry->getIndexOffset() * sizeof(uint32_t));
-    }
+    /**
+     * @brief Starts tracking a geometry whose recorded upload has finished executing, and frees its staging buffers
+     */
+    void completeGeometryUpload(GeometryBase* geometry);
 
     void freeMemory(std::list<MemoryBlockNode>::iterator it) {
         vbStorageManager.freeMemory(it);
     }
-};
\ No newline at end of file
+
+    /**
+     * @brief Releases the vertex and index blocks of a geometry previously added with addGeometry
+     * 
+     * @note The blocks are returned to the free list once the frames in flight that may draw the geometry have completed
+     */
+    void removeGeometry(GeometryBase* geometry);
+
+    /**
+     * @brief Performs one incremental defragmentation step
+     * 
+     * Moves reserved blocks into free blocks at lower offsets, compacting both arenas towards their start. The copies are
+     * submitted asynchronously, and the geometry is patched on a later call once the copy's fence has signalled.
+     * 
+     * @param commandBuffer A command buffer dedicated to defragmentation copies, it must not be pending when this is called
+     * @param byteBudget The maximum number of bytes to copy in this step
+     */
+    void defragment(VkCommandBuffer commandBuffer, uint32_t byteBudget);
+
+    /**
+     * @brief Patches the geometry of completed defragmentation copies
+     * 
+     * @param wait Whether to block until any pending copies have completed
+     * 
+     * @return True if no copies remain pending
+     */
+    bool completePendingMoves(bool wait);
+
+    /**
+     * @brief Signals that the oldest frame in flight has completed, destroying any retired buffers it may have used
+     * 
+     * @note Must be called once per frame, after the in-flight fence has been waited on
+     */
+    void onFrameComplete();
+
+    AppBufferBundle& getVertexBuffer() { return vertexBuffer; }
+    AppBufferBundle& getIndexBuffer() { return indexBuffer; }
+    VIBufferStats getStats() { return stats; }
+    VIFragmentationMetrics getVertexFragmentation();
+    VIFragmentationMetrics getIndexFragmentation();
+};